@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * RDRAND-based entropy source
+ *
+ * Samples are obtained from the CPU's hardware random number
+ * generator via RDSEED (if available) or RDRAND.  If neither
+ * instruction is supported, the platform's native entropy source is
+ * used instead.  In either case, the samples are subject to the
+ * usual entropy source health tests.
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/entropy.h>
+
+/** Maximum number of attempts to obtain a value via RDSEED
+ *
+ * RDSEED may legitimately fail if the CPU's entropy conditioner is
+ * temporarily exhausted, so we allow a large number of attempts.
+ */
+#define RDSEED_MAX_RETRY 1024
+
+/** Maximum number of attempts to obtain a value via RDRAND
+ *
+ * Intel recommend that RDRAND be retried up to ten times before
+ * assuming that the hardware has failed.
+ */
+#define RDRAND_MAX_RETRY 10
+
+/** A hardware random number generator instruction */
+struct rdrand_instruction {
+	/** Name */
+	const char *name;
+	/** Make a single attempt to obtain a random value
+	 *
+	 * @v value		Random value to fill in
+	 * @ret ok		Value is valid
+	 */
+	int ( * attempt ) ( uint32_t *value );
+	/** Maximum number of attempts */
+	unsigned int max_retry;
+};
+
+/* Provide declarations for the fallback entropy source */
+extern typeof ( entropy_enable ) RDRAND_FALLBACK ( entropy_enable );
+extern typeof ( entropy_disable ) RDRAND_FALLBACK ( entropy_disable );
+#ifdef PLATFORM_efi
+extern typeof ( get_noise ) RDRAND_FALLBACK ( get_noise );
+#endif
+
+/** Instruction in use, or NULL to use the fallback entropy source */
+static struct rdrand_instruction *rdrand_insn;
+
+/** Unused bytes from the most recently obtained random value */
+static uint32_t rdrand_value;
+
+/** Number of unused bytes remaining in the random value */
+static unsigned int rdrand_remaining;
+
+/**
+ * Make a single attempt to obtain a random value via RDSEED
+ *
+ * @v value		Random value to fill in
+ * @ret ok		Value is valid
+ */
+static int rdrand_attempt_rdseed ( uint32_t *value ) {
+	uint8_t ok;
+
+	__asm__ __volatile__ ( "rdseed %0\n\t"
+			       "setc %1\n\t"
+			       : "=r" ( *value ), "=qm" ( ok ) );
+	return ok;
+}
+
+/**
+ * Make a single attempt to obtain a random value via RDRAND
+ *
+ * @v value		Random value to fill in
+ * @ret ok		Value is valid
+ */
+static int rdrand_attempt_rdrand ( uint32_t *value ) {
+	uint8_t ok;
+
+	__asm__ __volatile__ ( "rdrand %0\n\t"
+			       "setc %1\n\t"
+			       : "=r" ( *value ), "=qm" ( ok ) );
+	return ok;
+}
+
+/** RDSEED instruction */
+static struct rdrand_instruction rdrand_rdseed = {
+	.name = "RDSEED",
+	.attempt = rdrand_attempt_rdseed,
+	.max_retry = RDSEED_MAX_RETRY,
+};
+
+/** RDRAND instruction */
+static struct rdrand_instruction rdrand_rdrand = {
+	.name = "RDRAND",
+	.attempt = rdrand_attempt_rdrand,
+	.max_retry = RDRAND_MAX_RETRY,
+};
+
+/**
+ * Obtain random value
+ *
+ * @v insn		Instruction
+ * @v value		Random value to fill in
+ * @ret rc		Return status code
+ */
+static int rdrand_get ( struct rdrand_instruction *insn, uint32_t *value ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < insn->max_retry ; i++ ) {
+		if ( insn->attempt ( value ) )
+			return 0;
+	}
+
+	DBGC ( &rdrand_insn, "RDRAND %s failed after %d attempts\n",
+	       insn->name, insn->max_retry );
+	return -EBUSY;
+}
+
+/**
+ * Check that instruction is functional
+ *
+ * @v insn		Instruction
+ * @ret rc		Return status code
+ */
+static int rdrand_check ( struct rdrand_instruction *insn ) {
+	uint32_t first;
+	uint32_t second;
+	int rc;
+
+	/* Check that two values can be obtained */
+	if ( ( ( rc = rdrand_get ( insn, &first ) ) != 0 ) ||
+	     ( ( rc = rdrand_get ( insn, &second ) ) != 0 ) )
+		return rc;
+
+	/* Some CPUs are known to return a constant value (typically
+	 * all ones) after resuming from suspend.  Reject the
+	 * instruction if this is observed, rather than waiting for
+	 * the health tests to fail.
+	 */
+	if ( first == second ) {
+		DBGC ( &rdrand_insn, "RDRAND %s returned repeated value "
+		       "%#08x\n", insn->name, first );
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * Enable entropy gathering
+ *
+ * @ret rc		Return status code
+ */
+static int rdrand_entropy_enable ( void ) {
+	struct x86_features features;
+	uint32_t discard_a;
+	uint32_t ebx;
+	uint32_t discard_c;
+	uint32_t discard_d;
+
+	/* Reset state */
+	rdrand_insn = NULL;
+	rdrand_remaining = 0;
+
+	/* Prefer RDSEED, which provides output directly from the
+	 * entropy conditioner rather than from a DRBG.
+	 */
+	if ( cpuid_supported ( CPUID_STRUCTURED_FEATURES ) == 0 ) {
+		cpuid ( CPUID_STRUCTURED_FEATURES, 0, &discard_a, &ebx,
+			&discard_c, &discard_d );
+		if ( ( ebx & CPUID_STRUCTURED_FEATURES_EBX_RDSEED ) &&
+		     ( rdrand_check ( &rdrand_rdseed ) == 0 ) ) {
+			rdrand_insn = &rdrand_rdseed;
+		}
+	}
+
+	/* Otherwise, use RDRAND if available */
+	x86_features ( &features );
+	if ( ( ! rdrand_insn ) &&
+	     ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_RDRAND ) &&
+	     ( rdrand_check ( &rdrand_rdrand ) == 0 ) ) {
+		rdrand_insn = &rdrand_rdrand;
+	}
+
+	/* Use instruction, if available */
+	if ( rdrand_insn ) {
+		DBGC ( &rdrand_insn, "RDRAND using %s\n", rdrand_insn->name );
+		return 0;
+	}
+
+	/* Otherwise, use the fallback entropy source */
+	DBGC ( &rdrand_insn, "RDRAND using fallback entropy source\n" );
+	return RDRAND_FALLBACK ( entropy_enable ) ();
+}
+
+/**
+ * Disable entropy gathering
+ *
+ */
+static void rdrand_entropy_disable ( void ) {
+
+	/* Disable fallback entropy source, if applicable */
+	if ( ! rdrand_insn )
+		RDRAND_FALLBACK ( entropy_disable ) ();
+}
+
+/**
+ * Get noise sample
+ *
+ * @ret noise		Noise sample
+ * @ret rc		Return status code
+ */
+static int rdrand_get_noise ( noise_sample_t *noise ) {
+	int rc;
+
+	/* Use fallback entropy source, if applicable */
+	if ( ! rdrand_insn )
+		return RDRAND_FALLBACK ( get_noise ) ( noise );
+
+	/* Obtain a new random value, if applicable */
+	if ( ! rdrand_remaining ) {
+		if ( ( rc = rdrand_get ( rdrand_insn, &rdrand_value ) ) != 0 )
+			return rc;
+		rdrand_remaining = sizeof ( rdrand_value );
+	}
+
+	/* Consume one byte of the random value */
+	*noise = rdrand_value;
+	rdrand_value >>= 8;
+	rdrand_remaining--;
+
+	return 0;
+}
+
+PROVIDE_ENTROPY_INLINE ( rdrand, min_entropy_per_sample );
+PROVIDE_ENTROPY ( rdrand, entropy_enable, rdrand_entropy_enable );
+PROVIDE_ENTROPY ( rdrand, entropy_disable, rdrand_entropy_disable );
+PROVIDE_ENTROPY ( rdrand, get_noise, rdrand_get_noise );
@@ -39,6 +39,9 @@ struct x86_features {
 /** Get standard features */
 #define CPUID_FEATURES 0x00000001UL
 
+/** RDRAND instruction is present */
+#define CPUID_FEATURES_INTEL_ECX_RDRAND 0x40000000UL
+
 /** Hypervisor is present */
 #define CPUID_FEATURES_INTEL_ECX_HYPERVISOR 0x80000000UL
 
@@ -48,6 +51,12 @@ struct x86_features {
 /** FXSAVE and FXRSTOR are supported */
 #define CPUID_FEATURES_INTEL_EDX_FXSR 0x01000000UL
 
+/** Get structured extended features */
+#define CPUID_STRUCTURED_FEATURES 0x00000007UL
+
+/** RDSEED instruction is present */
+#define CPUID_STRUCTURED_FEATURES_EBX_RDSEED 0x00040000UL
+
 /** Get largest extended function */
 #define CPUID_AMD_MAX_FN 0x80000000UL
 
@@ -0,0 +1,53 @@
+#ifndef _IPXE_RDRAND_ENTROPY_H
+#define _IPXE_RDRAND_ENTROPY_H
+
+/** @file
+ *
+ * RDRAND-based entropy source
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+#ifdef ENTROPY_RDRAND
+#define ENTROPY_PREFIX_rdrand
+#else
+#define ENTROPY_PREFIX_rdrand __rdrand_
+#endif
+
+/**
+ * Fallback entropy source API function
+ *
+ * @v _api_func		API function
+ * @ret _subsys_func	Fallback entropy source API function
+ *
+ * The platform's native entropy source is used if the CPU does not
+ * support RDSEED or RDRAND.
+ */
+#ifdef PLATFORM_efi
+#define RDRAND_FALLBACK( _api_func ) ENTROPY_INLINE ( efi, _api_func )
+#else
+#define RDRAND_FALLBACK( _api_func ) ENTROPY_INLINE ( rtc, _api_func )
+#endif
+
+/**
+ * min-entropy per sample
+ *
+ * @ret min_entropy	min-entropy of each sample
+ */
+static inline __always_inline min_entropy_t
+ENTROPY_INLINE ( rdrand, min_entropy_per_sample ) ( void ) {
+
+	/* The number of samples required must be a compile-time
+	 * constant, and so cannot depend upon whether or not the CPU
+	 * supports RDSEED or RDRAND.  We therefore claim only the
+	 * min-entropy of the fallback source.  Samples are still
+	 * obtained several orders of magnitude faster than from the
+	 * fallback source.
+	 */
+	return RDRAND_FALLBACK ( min_entropy_per_sample ) ();
+}
+
+#endif /* _IPXE_RDRAND_ENTROPY_H */
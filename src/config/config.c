@@ -188,6 +188,12 @@ REQUIRE_OBJECT ( zlib );
 #ifdef IMAGE_GZIP
 REQUIRE_OBJECT ( gzip );
 #endif
+#ifdef IMAGE_ZSTD
+REQUIRE_OBJECT ( zstd );
+#endif
+#ifdef IMAGE_LZ4
+REQUIRE_OBJECT ( lz4 );
+#endif
 
 /*
  * Drag in all requested commands
@@ -281,9 +287,18 @@ REQUIRE_OBJECT ( ipstat_cmd );
 #ifdef PROFSTAT_CMD
 REQUIRE_OBJECT ( profstat_cmd );
 #endif
+#ifdef TIMELINE_CMD
+#ifndef TIMELINE
+#error "TIMELINE_CMD requires TIMELINE"
+#endif
+REQUIRE_OBJECT ( timeline_cmd );
+#endif
 #ifdef NTP_CMD
 REQUIRE_OBJECT ( ntp_cmd );
 #endif
+#ifdef IPERF_CMD
+REQUIRE_OBJECT ( iperf_cmd );
+#endif
 #ifdef CERT_CMD
 REQUIRE_OBJECT ( cert_cmd );
 #endif
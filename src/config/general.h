@@ -29,6 +29,16 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define BANNER_TIMEOUT		20
 #define ROM_BANNER_TIMEOUT	( 2 * BANNER_TIMEOUT )
 
+/*
+ * Autoboot configuration
+ *
+ * Setting AUTOBOOT_PARALLEL to a non-zero value causes autoboot to
+ * open and configure all candidate network devices concurrently, and
+ * to boot from the first device that obtains a boot filename or root
+ * path.  The default is to try each network device in turn.
+ */
+#define AUTOBOOT_PARALLEL	0
+
 /*
  * Network protocols
  *
@@ -80,6 +90,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define HTTP_AUTH_DIGEST	/* Digest authentication */
 //#define HTTP_AUTH_NTLM	/* NTLM authentication */
 //#define HTTP_ENC_PEERDIST	/* PeerDist content encoding */
+//#define HTTP_SRV_PEERDIST	/* PeerDist content hosting */
 //#define HTTP_HACK_GCE		/* Google Compute Engine hacks */
 
 /*
@@ -119,6 +130,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define	IMAGE_PEM		/* PEM image support */
 //#define	IMAGE_ZLIB		/* ZLIB image support */
 //#define	IMAGE_GZIP		/* GZIP image support */
+//#define	IMAGE_ZSTD		/* Zstandard image support */
+//#define	IMAGE_LZ4		/* LZ4 image support */
 
 /*
  * Command-line commands to include
@@ -155,7 +168,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 //#define CONSOLE_CMD		/* Console command */
 //#define IPSTAT_CMD		/* IP statistics commands */
 //#define PROFSTAT_CMD		/* Profiling commands */
+//#define TIMELINE_CMD		/* Boot timeline commands */
 //#define NTP_CMD		/* NTP commands */
+//#define IPERF_CMD		/* iperf3 network throughput test command */
 //#define CERT_CMD		/* Certificate management commands */
 //#define IMAGE_MEM_CMD		/* Read memory command */
 #define IMAGE_ARCHIVE_CMD	/* Archive image management commands */
@@ -193,6 +208,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 				 * "make bin/rtl8139.dsk bs" */
 #undef	BUILD_ID		/* Include a custom build ID string,
 				 * e.g "test-foo" */
+//#define TIMELINE		/* Boot timeline event tracer */
 #undef	NULL_TRAP		/* Attempt to catch NULL function calls */
 #undef	GDBSERIAL		/* Remote GDB debugging over serial */
 #undef	GDBUDP			/* Remote GDB debugging over UDP
@@ -35,6 +35,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/image.h>
 #include <ipxe/xferbuf.h>
 #include <ipxe/downloader.h>
+#include <ipxe/timeline.h>
 
 /** @file
  *
@@ -56,6 +57,8 @@ struct downloader {
 	struct image *image;
 	/** Data transfer buffer */
 	struct xfer_buffer buffer;
+	/** Data has been received */
+	int received;
 };
 
 /**
@@ -79,6 +82,9 @@ static void downloader_free ( struct refcnt *refcnt ) {
  */
 static void downloader_finished ( struct downloader *downloader, int rc ) {
 
+	/* Record completion in boot timeline */
+	timeline ( "image-done", "%s rc %d", downloader->image->name, rc );
+
 	/* Log download status */
 	if ( rc == 0 ) {
 		syslog ( LOG_NOTICE, "Downloaded \"%s\"\n",
@@ -148,6 +154,12 @@ static int downloader_deliver ( struct downloader *downloader,
 				struct xfer_metadata *meta ) {
 	int rc;
 
+	/* Record first data in boot timeline */
+	if ( iob_len ( iobuf ) && ( ! downloader->received ) ) {
+		timeline ( "image-first-byte", "%s", downloader->image->name );
+		downloader->received = 1;
+	}
+
 	/* Add data to buffer */
 	if ( ( rc = xferbuf_deliver ( &downloader->buffer, iob_disown ( iobuf ),
 				      meta ) ) != 0 )
@@ -270,6 +282,7 @@ int create_downloader ( struct interface *job, struct image *image ) {
 		    &downloader->refcnt );
 	downloader->image = image_get ( image );
 	xferbuf_umalloc_init ( &downloader->buffer, &image->data );
+	timeline ( "image-start", "%s", image->name );
 
 	/* Instantiate child objects and attach to our interfaces */
 	if ( ( rc = xfer_open_uri ( &downloader->xfer, image->uri ) ) != 0 )
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/erasure.h>
+
+/** @file
+ *
+ * Reed-Solomon erasure coding
+ *
+ * A group of @c count equal-sized source blocks is extended with up
+ * to ( @c ERASURE_MAX_BLOCKS - @c count ) repair blocks.  The code is
+ * systematic: the source blocks are transmitted unmodified, and
+ * repair block @c j is a linear combination of the source blocks
+ * over GF(2^8) with coefficients taken from row @c j of a Cauchy
+ * matrix
+ *
+ *    C[j][i] = 1 / ( ( count + j ) + i )
+ *
+ * (where addition is exclusive-or).  Every square submatrix of a
+ * Cauchy matrix is nonsingular, and so any @c count distinct blocks
+ * from the group suffice to reconstruct all of the source blocks.
+ *
+ */
+
+/** GF(2^8) reducing polynomial (x^8 + x^4 + x^3 + x^2 + 1) */
+#define ERASURE_POLY 0x11d
+
+/** GF(2^8) exponent table (doubled to avoid a modular reduction) */
+static uint8_t erasure_exp[ 2 * 255 ];
+
+/** GF(2^8) logarithm table */
+static uint8_t erasure_log[256];
+
+/**
+ * Construct GF(2^8) exponent and logarithm tables
+ *
+ */
+static void erasure_init ( void ) {
+	unsigned int value;
+	unsigned int i;
+
+	/* Do nothing if tables have already been constructed */
+	if ( erasure_exp[0] )
+		return;
+
+	/* Construct tables using generator x (i.e. 0x02) */
+	value = 1;
+	for ( i = 0 ; i < 255 ; i++ ) {
+		erasure_exp[i] = value;
+		erasure_exp[ i + 255 ] = value;
+		erasure_log[value] = i;
+		value <<= 1;
+		if ( value & 0x100 )
+			value ^= ERASURE_POLY;
+	}
+}
+
+/**
+ * Multiply in GF(2^8)
+ *
+ * @v a			Multiplicand
+ * @v b			Multiplier
+ * @ret product		Product
+ */
+static uint8_t erasure_mul ( uint8_t a, uint8_t b ) {
+
+	if ( ! ( a && b ) )
+		return 0;
+	return erasure_exp[ erasure_log[a] + erasure_log[b] ];
+}
+
+/**
+ * Invert in GF(2^8)
+ *
+ * @v a			Value (must be non-zero)
+ * @ret inverse		Multiplicative inverse
+ */
+static uint8_t erasure_inv ( uint8_t a ) {
+
+	assert ( a != 0 );
+	return erasure_exp[ 255 - erasure_log[a] ];
+}
+
+/**
+ * Swap matrix rows
+ *
+ * @v a			First row
+ * @v b			Second row
+ * @v len		Length of each row
+ */
+static void erasure_swap ( uint8_t *a, uint8_t *b, size_t len ) {
+	uint8_t tmp;
+
+	while ( len-- ) {
+		tmp = *a;
+		*(a++) = *b;
+		*(b++) = tmp;
+	}
+}
+
+/**
+ * Calculate generator matrix coefficient
+ *
+ * @v count		Number of source blocks
+ * @v index		Block index within group
+ * @v source		Source block index
+ * @ret coeff		Coefficient of source block within block
+ */
+static uint8_t erasure_coeff ( unsigned int count, unsigned int index,
+			       unsigned int source ) {
+
+	/* Source blocks form an identity matrix */
+	if ( index < count )
+		return ( ( index == source ) ? 1 : 0 );
+
+	/* Repair blocks form a Cauchy matrix */
+	return erasure_inv ( index ^ source );
+}
+
+/**
+ * Multiply block by constant and accumulate
+ *
+ * @v out		Output block
+ * @v in		Input block
+ * @v coeff		Coefficient
+ * @v len		Length of blocks
+ */
+static void erasure_mul_add ( uint8_t *out, const uint8_t *in, uint8_t coeff,
+			      size_t len ) {
+	unsigned int log;
+	uint8_t byte;
+
+	/* Do nothing for a zero coefficient */
+	if ( ! coeff )
+		return;
+
+	/* Accumulate product */
+	log = erasure_log[coeff];
+	while ( len-- ) {
+		byte = *(in++);
+		if ( byte )
+			*out ^= erasure_exp[ log + erasure_log[byte] ];
+		out++;
+	}
+}
+
+/**
+ * Construct repair block
+ *
+ * @v count		Number of source blocks
+ * @v repair		Repair block number
+ * @v blocks		Source blocks
+ * @v out		Repair block to fill in
+ * @v len		Length of each block
+ */
+void erasure_encode ( unsigned int count, unsigned int repair,
+		      const void **blocks, void *out, size_t len ) {
+	unsigned int index = erasure_repair_index ( count, repair );
+	unsigned int i;
+
+	/* Sanity check */
+	assert ( index < ERASURE_MAX_BLOCKS );
+
+	/* Construct repair block */
+	erasure_init();
+	memset ( out, 0, len );
+	for ( i = 0 ; i < count ; i++ ) {
+		erasure_mul_add ( out, blocks[i],
+				  erasure_coeff ( count, index, i ), len );
+	}
+}
+
+/**
+ * Reconstruct source blocks
+ *
+ * @v count		Number of source blocks
+ * @v index		Block indices (source blocks followed by repair blocks)
+ * @v blocks		Received blocks
+ * @v len		Length of each block
+ * @ret rc		Return status code
+ *
+ * On entry, @c blocks[n] must hold the received block with group
+ * index @c index[n], for each of @c count distinct received blocks.
+ * On successful return, @c blocks[n] will hold source block @c n and
+ * @c index[n] will be equal to @c n.  Reconstructed source blocks
+ * are written into the buffers previously occupied by repair blocks.
+ */
+int erasure_decode ( unsigned int count, unsigned int *index,
+		     void **blocks, size_t len ) {
+	uint8_t *matrix;
+	uint8_t *inverse;
+	uint8_t *scratch;
+	uint8_t *present;
+	void **sorted;
+	uint8_t *pivot_row;
+	uint8_t *row;
+	uint8_t *tmp;
+	uint8_t scale;
+	uint8_t factor;
+	unsigned int missing;
+	unsigned int col;
+	unsigned int pivot;
+	unsigned int i;
+	unsigned int j;
+	unsigned int n;
+	int rc;
+
+	/* Sanity check */
+	if ( count > ERASURE_MAX_BLOCKS ) {
+		rc = -EINVAL;
+		goto err_count;
+	}
+
+	/* Allocate working storage */
+	missing = 0;
+	for ( n = 0 ; n < count ; n++ ) {
+		if ( index[n] >= ERASURE_MAX_BLOCKS ) {
+			rc = -EINVAL;
+			goto err_count;
+		}
+		if ( index[n] >= count )
+			missing++;
+	}
+	sorted = malloc ( ( count * sizeof ( sorted[0] ) ) +
+			  ( 2 * count * count ) + count + ( missing * len ) );
+	if ( ! sorted ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	matrix = ( ( void * ) ( sorted + count ) );
+	inverse = ( matrix + ( count * count ) );
+	present = ( inverse + ( count * count ) );
+	scratch = ( present + count );
+
+	/* Identify received source blocks */
+	memset ( present, 0, count );
+	for ( n = 0 ; n < count ; n++ ) {
+		if ( index[n] >= count )
+			continue;
+		if ( present[ index[n] ] ) {
+			/* Duplicate block index */
+			rc = -EINVAL;
+			goto err_duplicate;
+		}
+		present[ index[n] ] = 1;
+	}
+
+	/* Nothing to do unless some source blocks are missing */
+	if ( ! missing )
+		goto sort;
+
+	/* Construct generator submatrix for received blocks, and
+	 * identity matrix.
+	 */
+	erasure_init();
+	for ( n = 0 ; n < count ; n++ ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			matrix[ n * count + i ] =
+				erasure_coeff ( count, index[n], i );
+			inverse[ n * count + i ] = ( ( n == i ) ? 1 : 0 );
+		}
+	}
+
+	/* Invert generator submatrix using Gauss-Jordan elimination */
+	for ( col = 0 ; col < count ; col++ ) {
+
+		/* Find pivot row */
+		for ( pivot = col ; pivot < count ; pivot++ ) {
+			if ( matrix[ pivot * count + col ] )
+				break;
+		}
+		if ( pivot == count ) {
+			/* Singular matrix: duplicate block indices */
+			rc = -EINVAL;
+			goto err_duplicate;
+		}
+
+		/* Swap pivot row into place */
+		if ( pivot != col ) {
+			erasure_swap ( &matrix[ pivot * count ],
+				       &matrix[ col * count ], count );
+			erasure_swap ( &inverse[ pivot * count ],
+				       &inverse[ col * count ], count );
+		}
+
+		/* Normalise pivot row */
+		scale = erasure_inv ( matrix[ col * count + col ] );
+		pivot_row = &matrix[ col * count ];
+		row = &inverse[ col * count ];
+		for ( i = 0 ; i < count ; i++ ) {
+			pivot_row[i] = erasure_mul ( pivot_row[i], scale );
+			row[i] = erasure_mul ( row[i], scale );
+		}
+
+		/* Eliminate column from all other rows */
+		for ( n = 0 ; n < count ; n++ ) {
+			factor = matrix[ n * count + col ];
+			if ( ( n == col ) || ( ! factor ) )
+				continue;
+			for ( i = 0 ; i < count ; i++ ) {
+				matrix[ n * count + i ] ^=
+					erasure_mul ( factor,
+						      matrix[ col * count + i ] );
+				inverse[ n * count + i ] ^=
+					erasure_mul ( factor,
+						      inverse[ col * count + i ]);
+			}
+		}
+	}
+
+	/* Reconstruct missing source blocks into scratch space */
+	memset ( scratch, 0, ( missing * len ) );
+	tmp = scratch;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( present[i] )
+			continue;
+		for ( n = 0 ; n < count ; n++ ) {
+			erasure_mul_add ( tmp, blocks[n],
+					  inverse[ i * count + n ], len );
+		}
+		tmp += len;
+	}
+
+	/* Copy reconstructed blocks into repair block buffers */
+	tmp = scratch;
+	j = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( present[i] )
+			continue;
+		while ( index[j] < count )
+			j++;
+		memcpy ( blocks[j], tmp, len );
+		index[j++] = i;
+		tmp += len;
+	}
+
+ sort:
+	/* Sort blocks into source block order */
+	for ( n = 0 ; n < count ; n++ )
+		sorted[ index[n] ] = blocks[n];
+	for ( n = 0 ; n < count ; n++ ) {
+		blocks[n] = sorted[n];
+		index[n] = n;
+	}
+
+	rc = 0;
+ err_duplicate:
+	free ( sorted );
+ err_alloc:
+ err_count:
+	return rc;
+}
@@ -29,6 +29,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
@@ -147,19 +148,17 @@ static void fbcon_store ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 }
 
 /**
- * Draw character at specified position
+ * Render character
  *
  * @v fbcon		Frame buffer console
  * @v cell		Text cell
- * @v xpos		X position
- * @v ypos		Y position
+ * @v offset		Offset of character within frame buffer
+ * @v pixels		Rendered pixel rows to fill in
  */
-static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
-			 unsigned int xpos, unsigned int ypos ) {
+static void fbcon_render ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
+			   size_t offset, uint8_t *pixels ) {
 	uint8_t glyph[fbcon->font->height];
-	size_t offset;
 	size_t pixel_len;
-	size_t skip_len;
 	unsigned int row;
 	unsigned int column;
 	uint8_t bitmask;
@@ -168,35 +167,28 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 
 	/* Get font character */
 	fbcon->font->glyph ( cell->character, glyph );
-
-	/* Calculate pixel geometry */
-	offset = ( fbcon->indent +
-		   ( ypos * fbcon->character.stride ) +
-		   ( xpos * fbcon->character.len ) );
 	pixel_len = fbcon->pixel->len;
-	skip_len = ( fbcon->pixel->stride - fbcon->character.len );
 
 	/* Check for transparent background colour */
 	transparent = ( cell->background == FBCON_TRANSPARENT );
 
-	/* Draw character rows */
+	/* Render character rows */
 	for ( row = 0 ; row < fbcon->font->height ; row++ ) {
 
-		/* Draw background picture, if applicable */
+		/* Render background picture, if applicable */
 		if ( transparent ) {
 			if ( fbcon->picture.start ) {
-				memcpy_user ( fbcon->start, offset,
-					      fbcon->picture.start, offset,
-					      fbcon->character.len );
+				copy_from_user ( pixels, fbcon->picture.start,
+						 offset,
+						 fbcon->character.len );
 			} else {
-				memset_user ( fbcon->start, offset, 0,
-					      fbcon->character.len );
+				memset ( pixels, 0, fbcon->character.len );
 			}
 		}
 
-		/* Draw character row */
+		/* Render character row */
 		for ( column = FBCON_CHAR_WIDTH, bitmask = glyph[row] ;
-		      column ; column--, bitmask <<= 1, offset += pixel_len ) {
+		      column ; column--, bitmask <<= 1, pixels += pixel_len ) {
 			if ( bitmask & 0x80 ) {
 				src = &cell->foreground;
 			} else if ( ! transparent ) {
@@ -204,11 +196,87 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 			} else {
 				continue;
 			}
-			copy_to_user ( fbcon->start, offset, src, pixel_len );
+			memcpy ( pixels, src, pixel_len );
 		}
 
 		/* Move to next row */
-		offset += skip_len;
+		offset += fbcon->pixel->stride;
+	}
+}
+
+/**
+ * Find pre-rendered character in glyph cache
+ *
+ * @v fbcon		Frame buffer console
+ * @v cell		Text cell
+ * @v offset		Offset of character within frame buffer
+ * @ret glyph		Pre-rendered glyph, or NULL
+ *
+ * Characters with a transparent background are never cached, since
+ * their rendering depends upon their position over the background
+ * picture.
+ */
+static struct fbcon_glyph * fbcon_glyph ( struct fbcon *fbcon,
+					  struct fbcon_text_cell *cell,
+					  size_t offset ) {
+	struct fbcon_glyph_cache *glyphs = &fbcon->glyphs;
+	struct fbcon_glyph *glyph;
+	unsigned int index;
+
+	/* Do nothing unless cache is present and applicable */
+	if ( ( ! glyphs->entries ) || ( cell->background == FBCON_TRANSPARENT ))
+		return NULL;
+
+	/* Find cache entry */
+	index = ( ( cell->character ^ cell->foreground ^
+		    ( cell->background << 1 ) ) & ( FBCON_GLYPHS - 1 ) );
+	glyph = ( glyphs->entries + ( index * glyphs->len ) );
+
+	/* Render character into cache entry, if not already present */
+	if ( memcmp ( &glyph->cell, cell, sizeof ( glyph->cell ) ) != 0 ) {
+		fbcon_render ( fbcon, cell, offset, glyph->pixels );
+		memcpy ( &glyph->cell, cell, sizeof ( glyph->cell ) );
+	}
+
+	return glyph;
+}
+
+/**
+ * Draw character at specified position
+ *
+ * @v fbcon		Frame buffer console
+ * @v cell		Text cell
+ * @v xpos		X position
+ * @v ypos		Y position
+ */
+static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
+			 unsigned int xpos, unsigned int ypos ) {
+	uint8_t buffer[ fbcon->font->height * fbcon->character.len ];
+	struct fbcon_glyph *glyph;
+	uint8_t *pixels;
+	size_t offset;
+	unsigned int row;
+
+	/* Calculate pixel geometry */
+	offset = ( fbcon->indent +
+		   ( ypos * fbcon->character.stride ) +
+		   ( xpos * fbcon->character.len ) );
+
+	/* Use pre-rendered glyph, if available */
+	glyph = fbcon_glyph ( fbcon, cell, offset );
+	if ( glyph ) {
+		pixels = glyph->pixels;
+	} else {
+		fbcon_render ( fbcon, cell, offset, buffer );
+		pixels = buffer;
+	}
+
+	/* Draw character rows */
+	for ( row = 0 ; row < fbcon->font->height ; row++ ) {
+		copy_to_user ( fbcon->start, offset, pixels,
+			       fbcon->character.len );
+		pixels += fbcon->character.len;
+		offset += fbcon->pixel->stride;
 	}
 }
 
@@ -238,24 +306,54 @@ static void fbcon_redraw ( struct fbcon *fbcon ) {
  * Scroll screen
  *
  * @v fbcon		Frame buffer console
+ *
+ * Only characters that differ from the character currently displayed
+ * at the same position are redrawn.  The frame buffer contents are
+ * not moved, since reading from a (typically write-combining) frame
+ * buffer is extremely slow.
  */
 static void fbcon_scroll ( struct fbcon *fbcon ) {
+	struct fbcon_text_cell blank = {
+		.foreground = fbcon->foreground,
+		.background = fbcon->background,
+		.character = ' ',
+	};
+	struct fbcon_text_cell old;
+	struct fbcon_text_cell new;
 	size_t row_len;
+	size_t offset = 0;
+	unsigned int xpos;
+	unsigned int ypos;
 
 	/* Sanity check */
 	assert ( fbcon->ypos == fbcon->character.height );
 
-	/* Scroll up character array */
+	/* Redraw characters that will change */
 	row_len = ( fbcon->character.width * sizeof ( struct fbcon_text_cell ));
+	for ( ypos = 0 ; ypos < fbcon->character.height ; ypos++ ) {
+		for ( xpos = 0 ; xpos < fbcon->character.width ; xpos++ ) {
+			copy_from_user ( &old, fbcon->text.start, offset,
+					 sizeof ( old ) );
+			if ( ( ypos + 1 ) < fbcon->character.height ) {
+				copy_from_user ( &new, fbcon->text.start,
+						 ( offset + row_len ),
+						 sizeof ( new ) );
+			} else {
+				memcpy ( &new, &blank, sizeof ( new ) );
+			}
+			if ( memcmp ( &old, &new, sizeof ( old ) ) != 0 )
+				fbcon_draw ( fbcon, &new, xpos, ypos );
+			offset += sizeof ( old );
+		}
+	}
+
+	/* Scroll up character array */
 	memmove_user ( fbcon->text.start, 0, fbcon->text.start, row_len,
 		       ( row_len * ( fbcon->character.height - 1 ) ) );
 	fbcon_clear ( fbcon, ( fbcon->character.height - 1 ) );
 
 	/* Update cursor position */
 	fbcon->ypos--;
-
-	/* Redraw all characters */
-	fbcon_redraw ( fbcon );
 }
 
 /**
@@ -513,6 +611,7 @@ static int fbcon_picture_init ( struct fbcon *fbcon,
 	size_t pixbuf_indent;
 	size_t offset;
 	size_t pixbuf_offset;
+	uint32_t *row;
 	uint32_t rgb;
 	uint32_t raw;
 	unsigned int x;
@@ -551,29 +650,70 @@ static int fbcon_picture_init ( struct fbcon *fbcon,
 	       fbcon, width, height, xgap, ( xgap + pixbuf->width ), ygap,
 	       ( ygap + pixbuf->height ) );
 
-	/* Convert to frame buffer raw format */
+	/* Allocate row buffer */
+	row = malloc ( width * sizeof ( rgb ) );
+	if ( ! row ) {
+		rc = -ENOMEM;
+		goto err_row;
+	}
+
+	/* Convert to frame buffer raw format a row at a time.  Each
+	 * raw pixel is no wider than the corresponding RGB pixel, so
+	 * the conversion may be performed in place.
+	 */
 	memset_user ( picture->start, 0, 0, len );
 	for ( y = 0 ; y < height ; y++ ) {
 		offset = ( indent + ( y * pixel->stride ) );
 		pixbuf_offset = ( pixbuf_indent + ( y * pixbuf_stride ) );
+		copy_from_user ( row, pixbuf->data, pixbuf_offset,
+				 ( width * sizeof ( rgb ) ) );
 		for ( x = 0 ; x < width ; x++ ) {
-			copy_from_user ( &rgb, pixbuf->data, pixbuf_offset,
-					 sizeof ( rgb ) );
-			raw = fbcon_colour ( fbcon, rgb );
-			copy_to_user ( picture->start, offset, &raw,
-				       pixel->len );
-			offset += pixel->len;
-			pixbuf_offset += sizeof ( rgb );
+			raw = fbcon_colour ( fbcon, row[x] );
+			memcpy ( ( ( ( void * ) row ) + ( x * pixel->len ) ),
+				 &raw, pixel->len );
 		}
+		copy_to_user ( picture->start, offset, row,
+			       ( width * pixel->len ) );
 	}
 
+	free ( row );
 	return 0;
 
+ err_row:
 	ufree ( picture->start );
  err_umalloc:
 	return rc;
 }
 
+/**
+ * Initialise glyph cache
+ *
+ * @v fbcon		Frame buffer console
+ */
+static void fbcon_glyph_init ( struct fbcon *fbcon ) {
+	struct fbcon_glyph_cache *glyphs = &fbcon->glyphs;
+	struct fbcon_glyph *glyph;
+	unsigned int i;
+
+	/* Allocate cache entries, keeping each entry aligned */
+	glyphs->len = ( sizeof ( *glyph ) +
+			( fbcon->font->height * fbcon->character.len ) );
+	glyphs->len = ( ( glyphs->len + sizeof ( uint32_t ) - 1 ) &
+			~( sizeof ( uint32_t ) - 1 ) );
+	glyphs->entries = malloc ( FBCON_GLYPHS * glyphs->len );
+	if ( ! glyphs->entries ) {
+		DBGC ( fbcon, "FBCON %p could not allocate glyph cache\n",
+		       fbcon );
+		return;
+	}
+
+	/* Mark all entries as unused */
+	for ( i = 0 ; i < FBCON_GLYPHS ; i++ ) {
+		glyph = ( glyphs->entries + ( i * glyphs->len ) );
+		glyph->cell.background = FBCON_TRANSPARENT;
+	}
+}
+
 /**
  * Initialise frame buffer console
  *
@@ -697,6 +837,9 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
 			      fbcon->len );
 	}
 
+	/* Allocate glyph cache (failure is not fatal) */
+	fbcon_glyph_init ( fbcon );
+
 	/* Update console width and height */
 	console_set_size ( fbcon->character.width, fbcon->character.height );
 
@@ -717,6 +860,7 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
  */
 void fbcon_fini ( struct fbcon *fbcon ) {
 
+	free ( fbcon->glyphs.entries );
 	ufree ( fbcon->text.start );
 	ufree ( fbcon->picture.start );
 }
@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/job.h>
 #include <ipxe/monojob.h>
 #include <ipxe/timer.h>
+#include <ipxe/nap.h>
 
 /** @file
  *
@@ -100,8 +101,14 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 	last_check = last_progress = last_display = currticks();
 	while ( monojob_rc == -EINPROGRESS ) {
 
-		/* Allow job to progress */
-		step();
+		/* Allow job to progress, or wait for the next
+		 * interrupt if there is nothing to do.
+		 */
+		if ( process_runnable() ) {
+			step();
+		} else {
+			cpu_nap();
+		}
 		now = currticks();
 
 		/* Continue until a timer tick occurs (to minimise
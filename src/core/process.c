@@ -89,6 +89,20 @@ void process_del ( struct process *process ) {
 	}
 }
 
+/**
+ * Check if any process is runnable
+ *
+ * @ret runnable	Any process is runnable
+ *
+ * Processes that are waiting for an event (such as a timer being
+ * started or a network device being opened) remove themselves from
+ * the run queue.  If no process is runnable, then the caller may
+ * safely wait for the next interrupt before calling step() again.
+ */
+int process_runnable ( void ) {
+	return ( ! list_empty ( &run_queue ) );
+}
+
 /**
  * Single-step a single process
  *
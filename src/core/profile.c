@@ -25,6 +25,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <strings.h>
 #include <limits.h>
 #include <assert.h>
@@ -43,6 +44,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  * The algorithm for updating the mean and variance estimators is from
  * The Art of Computer Programming (via Wikipedia), with adjustments
  * to avoid the use of floating-point instructions.
+ *
+ * Since the mean and variance say little about tail latency, the
+ * profiler also records each sample in a log-linear histogram, from
+ * which approximate percentiles may be extracted.
  */
 
 /** Accumulated time excluded from profiling */
@@ -101,6 +106,51 @@ static inline unsigned int profile_accvar_shift ( struct profiler *profiler ) {
 		 - profiler->accvar_msb );
 }
 
+/**
+ * Calculate histogram bucket for a sample value
+ *
+ * @v sample		Sample value
+ * @ret bucket		Histogram bucket
+ */
+static unsigned int profile_bucket ( unsigned long sample ) {
+	unsigned int sub_buckets = ( 1 << PROFILE_HISTOGRAM_SUB_BITS );
+	unsigned int msb;
+
+	/* Record small values exactly */
+	if ( sample < sub_buckets )
+		return sample;
+
+	/* Record larger values by MSB and following bits */
+	msb = ( flsl ( sample ) - 1 );
+	if ( msb >= PROFILE_HISTOGRAM_BITS )
+		return ( PROFILE_HISTOGRAM_BUCKETS - 1 );
+	return ( ( ( msb - PROFILE_HISTOGRAM_SUB_BITS + 1 )
+		   << PROFILE_HISTOGRAM_SUB_BITS ) |
+		 ( ( sample >> ( msb - PROFILE_HISTOGRAM_SUB_BITS ) ) &
+		   ( sub_buckets - 1 ) ) );
+}
+
+/**
+ * Calculate largest sample value within a histogram bucket
+ *
+ * @v bucket		Histogram bucket
+ * @ret limit		Largest sample value within bucket
+ */
+static unsigned long profile_bucket_limit ( unsigned int bucket ) {
+	unsigned int sub_buckets = ( 1 << PROFILE_HISTOGRAM_SUB_BITS );
+	unsigned int shift;
+	unsigned long base;
+
+	/* Small values are recorded exactly */
+	if ( bucket < sub_buckets )
+		return bucket;
+
+	/* Calculate upper bound of larger values */
+	shift = ( ( bucket >> PROFILE_HISTOGRAM_SUB_BITS ) - 1 );
+	base = ( ( sub_buckets | ( bucket & ( sub_buckets - 1 ) ) ) << shift );
+	return ( base + ( 1UL << shift ) - 1 );
+}
+
 /**
  * Update profiler with a new sample
  *
@@ -123,6 +173,15 @@ void profile_update ( struct profiler *profiler, unsigned long sample ) {
 	 */
 	assert ( ( ( signed ) sample ) >= 0 );
 
+	/* Do nothing if profiler is disabled */
+	if ( profiler->disabled )
+		return;
+
+	/* Update histogram and maximum */
+	profiler->histogram[ profile_bucket ( sample ) ]++;
+	if ( sample > profiler->max )
+		profiler->max = sample;
+
 	/* Update sample count, limiting to avoid signed overflow */
 	if ( profiler->count < INT_MAX )
 		profiler->count++;
@@ -276,3 +335,78 @@ unsigned long profile_stddev ( struct profiler *profiler ) {
 
 	return isqrt ( profile_variance ( profiler ) );
 }
+
+/**
+ * Get approximate sample percentile
+ *
+ * @v profiler		Profiler
+ * @v percent		Percentile (0-100)
+ * @ret value		Approximate sample value at this percentile
+ *
+ * The returned value is the upper bound of the histogram bucket
+ * containing the sample at the requested rank, and so may overstate
+ * the true percentile by up to the width of one bucket.
+ */
+unsigned long profile_percentile ( struct profiler *profiler,
+				   unsigned int percent ) {
+	unsigned long long total = 0;
+	unsigned long long rank;
+	unsigned long long seen = 0;
+	unsigned long limit;
+	unsigned int i;
+
+	/* Count total number of samples */
+	for ( i = 0 ; i < PROFILE_HISTOGRAM_BUCKETS ; i++ )
+		total += profiler->histogram[i];
+	if ( ! total )
+		return 0;
+
+	/* Calculate rank of requested sample (rounding up) */
+	rank = ( ( ( total * percent ) + 99 ) / 100 );
+	if ( ! rank )
+		rank = 1;
+
+	/* Find bucket containing requested sample */
+	for ( i = 0 ; i < PROFILE_HISTOGRAM_BUCKETS ; i++ ) {
+		seen += profiler->histogram[i];
+		if ( seen >= rank )
+			break;
+	}
+	assert ( i < PROFILE_HISTOGRAM_BUCKETS );
+
+	/* Report bucket limit, capped at the maximum observed value */
+	limit = profile_bucket_limit ( i );
+	return ( ( limit < profiler->max ) ? limit : profiler->max );
+}
+
+/**
+ * Reset profiler
+ *
+ * @v profiler		Profiler
+ */
+void profile_reset ( struct profiler *profiler ) {
+
+	profiler->count = 0;
+	profiler->mean = 0;
+	profiler->mean_msb = 0;
+	profiler->accvar = 0;
+	profiler->accvar_msb = 0;
+	profiler->max = 0;
+	memset ( profiler->histogram, 0, sizeof ( profiler->histogram ) );
+}
+
+/**
+ * Find profiler by name
+ *
+ * @v name		Profiler name
+ * @ret profiler	Profiler, or NULL if not found
+ */
+struct profiler * find_profiler ( const char *name ) {
+	struct profiler *profiler;
+
+	for_each_table_entry ( profiler, PROFILERS ) {
+		if ( strcmp ( profiler->name, name ) == 0 )
+			return profiler;
+	}
+	return NULL;
+}
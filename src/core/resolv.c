@@ -31,6 +31,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/process.h>
 #include <ipxe/socket.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/tcpip.h>
 #include <ipxe/resolv.h>
 
 /** @file
@@ -298,6 +301,18 @@ int resolv ( struct interface *resolv, const char *name,
  ***************************************************************************
  */
 
+/** Delay for which to wait for a preferred address family to resolve
+ *
+ * This is the "Resolution Delay" from RFC 8305.
+ */
+#define NAMED_RESOLUTION_DELAY ( TICKS_PER_SEC / 20 )
+
+/** Delay between successive connection attempts
+ *
+ * This is the "Connection Attempt Delay" from RFC 8305.
+ */
+#define NAMED_CONNECTION_DELAY ( TICKS_PER_SEC / 4 )
+
 /** A named socket */
 struct named_socket {
 	/** Reference counter */
@@ -312,6 +327,51 @@ struct named_socket {
 	struct sockaddr local;
 	/** Stored local socket address exists */
 	int have_local;
+
+	/** Connection attempts, in order of preference */
+	struct list_head attempts;
+	/** Connection attempt timer */
+	struct retry_timer timer;
+	/** Time at which first address was resolved */
+	unsigned long resolved;
+	/** An address has been resolved */
+	int have_resolved;
+	/** Most recent connection attempt failure */
+	int rc;
+};
+
+/** Named socket connection attempt state */
+enum named_attempt_state {
+	/** Name resolution is in progress */
+	NAMED_RESOLVING = 0,
+	/** Address has been resolved */
+	NAMED_RESOLVED,
+	/** Connection is in progress */
+	NAMED_CONNECTING,
+	/** Attempt has failed */
+	NAMED_FAILED,
+};
+
+/** A named socket connection attempt */
+struct named_attempt {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Named socket */
+	struct named_socket *named;
+	/** List of connection attempts */
+	struct list_head list;
+	/** Name resolution interface */
+	struct interface resolv;
+	/** Connection interface */
+	struct interface socket;
+	/** Address family */
+	sa_family_t family;
+	/** Resolved peer socket address */
+	struct sockaddr peer;
+	/** Attempt state */
+	enum named_attempt_state state;
+	/** Time at which connection attempt started */
+	unsigned long started;
 };
 
 /**
@@ -321,6 +381,20 @@ struct named_socket {
  * @v rc		Reason for termination
  */
 static void named_close ( struct named_socket *named, int rc ) {
+	struct named_attempt *attempt;
+	struct named_attempt *tmp;
+
+	/* Stop connection attempt timer */
+	stop_timer ( &named->timer );
+
+	/* Abandon any outstanding connection attempts */
+	list_for_each_entry_safe ( attempt, tmp, &named->attempts, list ) {
+		intfs_shutdown ( ( rc ? rc : -ECANCELED ), &attempt->socket,
+				 &attempt->resolv, NULL );
+		list_del ( &attempt->list );
+		ref_put ( &attempt->refcnt );
+	}
+
 	/* Shut down interfaces */
 	intf_shutdown ( &named->resolv, rc );
 	intf_shutdown ( &named->xfer, rc );
@@ -390,6 +464,354 @@ static struct interface_descriptor named_resolv_desc =
 	INTF_DESC_PASSTHRU ( struct named_socket, resolv, named_resolv_op,
 			     xfer );
 
+/**
+ * Start or continue connection attempts
+ *
+ * @v named		Named socket
+ *
+ * Connection attempts are started in order of preference.  A less
+ * preferred attempt is started only once each more preferred attempt
+ * has either failed, been given @c NAMED_CONNECTION_DELAY to
+ * connect, or failed to resolve within @c NAMED_RESOLUTION_DELAY of
+ * the first address being resolved.
+ */
+static void named_race ( struct named_socket *named ) {
+	struct named_attempt *attempt;
+	unsigned long now = currticks();
+	unsigned long elapsed;
+	int pending = 0;
+	int rc;
+
+	/* Stop connection attempt timer */
+	stop_timer ( &named->timer );
+
+	/* Find next connection attempt to start, if any */
+	list_for_each_entry ( attempt, &named->attempts, list ) {
+		switch ( attempt->state ) {
+
+		case NAMED_RESOLVING:
+			/* Wait for preferred address family to resolve */
+			pending = 1;
+			if ( ! named->have_resolved )
+				return;
+			elapsed = ( now - named->resolved );
+			if ( elapsed < NAMED_RESOLUTION_DELAY ) {
+				start_timer_fixed ( &named->timer,
+						    ( NAMED_RESOLUTION_DELAY -
+						      elapsed ) );
+				return;
+			}
+			break;
+
+		case NAMED_RESOLVED:
+			/* Start connection attempt */
+			DBGC ( named, "NAMED %p attempting %s\n",
+			       named, sock_ntoa ( &attempt->peer ) );
+			if ( ( rc = xfer_open_socket ( &attempt->socket,
+						       named->semantics,
+						       &attempt->peer,
+						       ( named->have_local ?
+							 &named->local :
+							 NULL ) ) ) != 0 ) {
+				DBGC ( named, "NAMED %p could not attempt %s: "
+				       "%s\n", named,
+				       sock_ntoa ( &attempt->peer ),
+				       strerror ( rc ) );
+				attempt->state = NAMED_FAILED;
+				named->rc = rc;
+				break;
+			}
+			attempt->state = NAMED_CONNECTING;
+			attempt->started = now;
+			start_timer_fixed ( &named->timer,
+					    NAMED_CONNECTION_DELAY );
+			return;
+
+		case NAMED_CONNECTING:
+			/* Allow time for connection attempt to complete */
+			pending = 1;
+			elapsed = ( now - attempt->started );
+			if ( elapsed < NAMED_CONNECTION_DELAY ) {
+				start_timer_fixed ( &named->timer,
+						    ( NAMED_CONNECTION_DELAY -
+						      elapsed ) );
+				return;
+			}
+			break;
+
+		case NAMED_FAILED:
+			break;
+		}
+	}
+
+	/* Fail if no connection attempts remain */
+	if ( ! pending ) {
+		DBGC ( named, "NAMED %p failed: %s\n",
+		       named, strerror ( named->rc ) );
+		named_close ( named, named->rc );
+	}
+}
+
+/**
+ * Handle connection attempt timer expiry
+ *
+ * @v timer		Connection attempt timer
+ * @v fail		Failure indicator
+ */
+static void named_expired ( struct retry_timer *timer, int fail __unused ) {
+	struct named_socket *named =
+		container_of ( timer, struct named_socket, timer );
+
+	named_race ( named );
+}
+
+/**
+ * Mark connection attempt as failed
+ *
+ * @v attempt		Connection attempt
+ * @v rc		Reason for failure
+ */
+static void named_attempt_failed ( struct named_attempt *attempt, int rc ) {
+	struct named_socket *named = attempt->named;
+
+	/* Record failure */
+	attempt->state = NAMED_FAILED;
+	named->rc = rc;
+
+	/* Continue with any remaining connection attempts */
+	named_race ( named );
+}
+
+/**
+ * Handle connection attempt name resolution
+ *
+ * @v attempt		Connection attempt
+ * @v sa		Completed socket address
+ */
+static void named_attempt_resolv_done ( struct named_attempt *attempt,
+					struct sockaddr *sa ) {
+	struct named_socket *named = attempt->named;
+
+	/* Ignore addresses of the wrong family (e.g. from the numeric
+	 * resolver), since these will also be resolved by the
+	 * connection attempt for the correct family.
+	 */
+	if ( sa->sa_family != attempt->family )
+		return;
+
+	/* Record resolved address */
+	DBGC ( named, "NAMED %p resolved %s\n", named, sock_ntoa ( sa ) );
+	memcpy ( &attempt->peer, sa, sizeof ( attempt->peer ) );
+	attempt->state = NAMED_RESOLVED;
+	if ( ! named->have_resolved ) {
+		named->resolved = currticks();
+		named->have_resolved = 1;
+	}
+
+	/* Start connection attempt, if applicable */
+	named_race ( named );
+}
+
+/**
+ * Handle connection attempt name resolution completion
+ *
+ * @v attempt		Connection attempt
+ * @v rc		Reason for close
+ */
+static void named_attempt_resolv_close ( struct named_attempt *attempt,
+					 int rc ) {
+
+	/* Shut down interface */
+	intf_shutdown ( &attempt->resolv, rc );
+
+	/* Fail attempt if no address was resolved */
+	if ( attempt->state == NAMED_RESOLVING )
+		named_attempt_failed ( attempt, ( rc ? rc : -EAFNOSUPPORT ) );
+}
+
+/**
+ * Handle connection attempt window change
+ *
+ * @v attempt		Connection attempt
+ */
+static void named_attempt_window_changed ( struct named_attempt *attempt ) {
+	struct named_socket *named = attempt->named;
+	struct interface *xfer;
+	struct interface *socket;
+
+	/* Wait until connection is ready for data */
+	if ( ! xfer_window ( &attempt->socket ) )
+		return;
+	DBGC ( named, "NAMED %p connected to %s\n",
+	       named, sock_ntoa ( &attempt->peer ) );
+
+	/* Hand over connection to parent interface */
+	xfer = intf_get ( named->xfer.dest );
+	socket = intf_get ( attempt->socket.dest );
+	intf_unplug ( &named->xfer );
+	intf_unplug ( &attempt->socket );
+	intf_plug_plug ( xfer, socket );
+	xfer_window_changed ( socket );
+	intf_put ( socket );
+	intf_put ( xfer );
+
+	/* Terminate named socket opener */
+	named_close ( named, 0 );
+}
+
+/**
+ * Handle connection attempt failure
+ *
+ * @v attempt		Connection attempt
+ * @v rc		Reason for close
+ */
+static void named_attempt_socket_close ( struct named_attempt *attempt,
+					 int rc ) {
+
+	/* Shut down interface */
+	intf_shutdown ( &attempt->socket, rc );
+
+	/* Fail attempt */
+	if ( attempt->state == NAMED_CONNECTING ) {
+		DBGC ( attempt->named, "NAMED %p could not connect to %s: "
+		       "%s\n", attempt->named, sock_ntoa ( &attempt->peer ),
+		       strerror ( rc ) );
+		named_attempt_failed ( attempt,
+				       ( rc ? rc : -ECONNABORTED ) );
+	}
+}
+
+/** Connection attempt resolver interface operations */
+static struct interface_operation named_attempt_resolv_op[] = {
+	INTF_OP ( intf_close, struct named_attempt *,
+		  named_attempt_resolv_close ),
+	INTF_OP ( resolv_done, struct named_attempt *,
+		  named_attempt_resolv_done ),
+};
+
+/** Connection attempt resolver interface descriptor */
+static struct interface_descriptor named_attempt_resolv_desc =
+	INTF_DESC ( struct named_attempt, resolv, named_attempt_resolv_op );
+
+/** Connection attempt socket interface operations */
+static struct interface_operation named_attempt_socket_op[] = {
+	INTF_OP ( xfer_window_changed, struct named_attempt *,
+		  named_attempt_window_changed ),
+	INTF_OP ( intf_close, struct named_attempt *,
+		  named_attempt_socket_close ),
+};
+
+/** Connection attempt socket interface descriptor */
+static struct interface_descriptor named_attempt_socket_desc =
+	INTF_DESC ( struct named_attempt, socket, named_attempt_socket_op );
+
+/**
+ * Free connection attempt
+ *
+ * @v refcnt		Reference counter
+ */
+static void named_attempt_free ( struct refcnt *refcnt ) {
+	struct named_attempt *attempt =
+		container_of ( refcnt, struct named_attempt, refcnt );
+
+	ref_put ( &attempt->named->refcnt );
+	free ( attempt );
+}
+
+/**
+ * Start connection attempt
+ *
+ * @v named		Named socket
+ * @v family		Address family
+ * @v peer		Peer socket address to complete
+ * @v name		Name to resolve
+ * @ret rc		Return status code
+ */
+static int named_attempt_start ( struct named_socket *named,
+				 sa_family_t family, struct sockaddr *peer,
+				 const char *name ) {
+	struct named_attempt *attempt;
+	int rc;
+
+	/* Allocate and initialise structure */
+	attempt = zalloc ( sizeof ( *attempt ) );
+	if ( ! attempt )
+		return -ENOMEM;
+	ref_init ( &attempt->refcnt, named_attempt_free );
+	intf_init ( &attempt->resolv, &named_attempt_resolv_desc,
+		    &attempt->refcnt );
+	intf_init ( &attempt->socket, &named_attempt_socket_desc,
+		    &attempt->refcnt );
+	attempt->named = named;
+	ref_get ( &named->refcnt );
+	attempt->family = family;
+	memcpy ( &attempt->peer, peer, sizeof ( attempt->peer ) );
+	attempt->peer.sa_family = family;
+
+	/* Start name resolution */
+	if ( ( rc = resolv ( &attempt->resolv, name, &attempt->peer ) ) != 0 )
+		goto err;
+
+	/* Add to list of connection attempts (transferring ownership) */
+	list_add_tail ( &attempt->list, &named->attempts );
+	return 0;
+
+ err:
+	ref_put ( &attempt->refcnt );
+	return rc;
+}
+
+/**
+ * Start racing connection attempts
+ *
+ * @v named		Named socket
+ * @v peer		Peer socket address to complete
+ * @v name		Name to resolve
+ * @ret rc		Return status code
+ *
+ * Resolve IPv6 and IPv4 addresses concurrently and race connection
+ * attempts to each, preferring IPv6 (as per RFC 8305).
+ */
+static int named_race_start ( struct named_socket *named,
+			      struct sockaddr *peer, const char *name ) {
+	static const sa_family_t families[] = { AF_INET6, AF_INET };
+	unsigned int i;
+	int rc = -EAFNOSUPPORT;
+
+	/* Start a connection attempt for each address family */
+	for ( i = 0 ; i < ( sizeof ( families ) /
+			    sizeof ( families[0] ) ) ; i++ ) {
+		if ( ( rc = named_attempt_start ( named, families[i], peer,
+						  name ) ) != 0 ) {
+			named->rc = rc;
+		}
+	}
+
+	/* Fail if no connection attempts could be started */
+	if ( list_empty ( &named->attempts ) )
+		return named->rc;
+
+	return 0;
+}
+
+/**
+ * Check whether or not to race connection attempts
+ *
+ * @v semantics		Communication semantics (e.g. SOCK_STREAM)
+ * @v peer		Peer socket address to complete
+ * @ret race		Race connection attempts
+ */
+static int named_can_race ( int semantics, struct sockaddr *peer ) {
+
+	/* Race only connection-oriented sockets of unspecified
+	 * address family, when both IPv6 and IPv4 are supported.
+	 */
+	return ( ( semantics == SOCK_STREAM ) &&
+		 ( peer->sa_family == 0 ) &&
+		 tcpip_net_protocol ( AF_INET6 ) &&
+		 tcpip_net_protocol ( AF_INET ) );
+}
+
 /**
  * Open named socket
  *
@@ -412,6 +834,8 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 	ref_init ( &named->refcnt, NULL );
 	intf_init ( &named->xfer, &named_xfer_desc, &named->refcnt );
 	intf_init ( &named->resolv, &named_resolv_desc, &named->refcnt );
+	INIT_LIST_HEAD ( &named->attempts );
+	timer_init ( &named->timer, named_expired, &named->refcnt );
 	named->semantics = semantics;
 	if ( local ) {
 		memcpy ( &named->local, local, sizeof ( named->local ) );
@@ -421,9 +845,16 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 	DBGC ( named, "NAMED %p opening \"%s\"\n",
 	       named, name );
 
-	/* Start name resolution */
-	if ( ( rc = resolv ( &named->resolv, name, peer ) ) != 0 )
-		goto err;
+	/* Start name resolution, racing connection attempts if
+	 * applicable
+	 */
+	if ( named_can_race ( semantics, peer ) ) {
+		if ( ( rc = named_race_start ( named, peer, name ) ) != 0 )
+			goto err;
+	} else {
+		if ( ( rc = resolv ( &named->resolv, name, peer ) ) != 0 )
+			goto err;
+	}
 
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &named->xfer, xfer );
@@ -431,6 +862,7 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 	return 0;
 
  err:
+	named_close ( named, rc );
 	ref_put ( &named->refcnt );
 	return rc;
 }
@@ -118,6 +118,7 @@ static void sandev_free ( struct refcnt *refcnt ) {
 	unsigned int i;
 
 	assert ( ! timer_running ( &sandev->timer ) );
+	assert ( list_empty ( &sandev->commands ) );
 	assert ( ! sandev->active );
 	assert ( list_empty ( &sandev->opened ) );
 	for ( i = 0 ; i < sandev->paths ; i++ ) {
@@ -672,6 +673,330 @@ int sandev_write ( struct san_device *sandev, uint64_t lba,
 	return 0;
 }
 
+/** An asynchronous SAN device read/write command */
+struct san_command {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** SAN device */
+	struct san_device *sandev;
+	/** List of asynchronous commands */
+	struct list_head list;
+	/** Parent interface */
+	struct interface parent;
+	/** Underlying block device command interface */
+	struct interface block;
+	/** Command timeout timer */
+	struct retry_timer timer;
+	/** Read/write parameters for the current fragment */
+	struct san_command_rw_params rw;
+	/** Number of underlying blocks remaining */
+	unsigned int remaining;
+	/** Number of times the current fragment has been retried */
+	unsigned int retries;
+	/** Current fragment is in progress */
+	int busy;
+};
+
+/**
+ * Free asynchronous SAN device command
+ *
+ * @v refcnt		Reference count
+ */
+static void san_command_free ( struct refcnt *refcnt ) {
+	struct san_command *command =
+		container_of ( refcnt, struct san_command, refcnt );
+
+	sandev_put ( command->sandev );
+	free ( command );
+}
+
+/**
+ * Finish asynchronous SAN device command
+ *
+ * @v command		Asynchronous SAN device command
+ * @v rc		Reason for finishing
+ */
+static void san_command_finished ( struct san_command *command, int rc ) {
+	struct san_device *sandev = command->sandev;
+
+	DBGC2 ( sandev, "SAN %#02x async %p finished: %s\n",
+		sandev->drive, command, strerror ( rc ) );
+
+	/* Stop timer */
+	stop_timer ( &command->timer );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &command->block, rc );
+	intf_shutdown ( &command->parent, rc );
+
+	/* Remove from list of commands and drop list's reference */
+	list_del ( &command->list );
+	ref_put ( &command->refcnt );
+}
+
+/**
+ * Handle completion of asynchronous SAN device command fragment
+ *
+ * @v command		Asynchronous SAN device command
+ * @v rc		Reason for close
+ */
+static void san_command_block_close ( struct san_command *command, int rc ) {
+	struct san_device *sandev = command->sandev;
+	size_t frag_len;
+
+	/* Stop timer and restart interface */
+	stop_timer ( &command->timer );
+	intf_restart ( &command->block, rc );
+	command->busy = 0;
+
+	/* Retry fragment on failure, up to the usual retry limit */
+	if ( rc != 0 ) {
+		DBGC ( sandev, "SAN %#02x async %p LBA %#08llx failed: %s\n",
+		       sandev->drive, command, command->rw.lba,
+		       strerror ( rc ) );
+		if ( command->retries++ >= san_retries )
+			san_command_finished ( command, rc );
+		process_add ( &sandev->process );
+		return;
+	}
+
+	/* Move to next fragment */
+	frag_len = ( sandev->capacity.blksize * command->rw.count );
+	command->rw.buffer = userptr_add ( command->rw.buffer, frag_len );
+	command->rw.lba += command->rw.count;
+	command->remaining -= command->rw.count;
+	command->retries = 0;
+
+	/* Finish command if all fragments are complete */
+	if ( ! command->remaining )
+		san_command_finished ( command, 0 );
+
+	/* Dispatch any waiting commands */
+	process_add ( &sandev->process );
+}
+
+/**
+ * Handle asynchronous SAN device command fragment timeout
+ *
+ * @v retry		Retry timer
+ */
+static void san_command_expired ( struct retry_timer *timer,
+				  int over __unused ) {
+	struct san_command *command =
+		container_of ( timer, struct san_command, timer );
+
+	san_command_block_close ( command, -ETIMEDOUT );
+}
+
+/** Asynchronous SAN device command block interface operations */
+static struct interface_operation san_command_block_op[] = {
+	INTF_OP ( intf_close, struct san_command *, san_command_block_close ),
+};
+
+/** Asynchronous SAN device command block interface descriptor */
+static struct interface_descriptor san_command_block_desc =
+	INTF_DESC ( struct san_command, block, san_command_block_op );
+
+/** Asynchronous SAN device command parent interface operations */
+static struct interface_operation san_command_parent_op[] = {
+	INTF_OP ( intf_close, struct san_command *, san_command_finished ),
+};
+
+/** Asynchronous SAN device command parent interface descriptor */
+static struct interface_descriptor san_command_parent_desc =
+	INTF_DESC ( struct san_command, parent, san_command_parent_op );
+
+/**
+ * Dispatch waiting asynchronous SAN device commands
+ *
+ * @v sandev		SAN device
+ *
+ * Fragments are issued to the active path for as long as the
+ * underlying block device is prepared to accept new commands.  Block
+ * devices that cannot handle concurrent commands (such as iSCSI)
+ * will close their window while a command is in progress, and so
+ * will naturally receive one fragment at a time.
+ */
+static void sandev_dispatch ( struct san_device *sandev ) {
+	struct san_path *sanpath = sandev->active;
+	struct san_command *command;
+	struct san_command *tmp;
+	unsigned int waiting = 0;
+	size_t len;
+	int rc;
+
+	/* Keep SAN device in scope while commands complete */
+	sandev_get ( sandev );
+
+	list_for_each_entry_safe ( command, tmp, &sandev->commands, list ) {
+
+		/* Skip commands that are already in progress */
+		if ( command->busy )
+			continue;
+
+		/* Fail command if there is no active path.  We cannot
+		 * block waiting for the device to be reopened.
+		 */
+		if ( ! sanpath ) {
+			san_command_finished ( command, -ENOTCONN );
+			continue;
+		}
+
+		/* Wait until block device can accept a new command */
+		if ( ! xfer_window ( &sanpath->block ) ) {
+			waiting++;
+			continue;
+		}
+
+		/* Mark fragment as in progress before issuing it, since
+		 * the block device may complete (and close the command
+		 * interface) before returning.  Keep the command in
+		 * scope in case this finishes the command.
+		 */
+		command->rw.count = sandev->capacity.max_count;
+		if ( command->rw.count > command->remaining )
+			command->rw.count = command->remaining;
+		len = ( command->rw.count * sandev->capacity.blksize );
+		command->busy = 1;
+		start_timer_fixed ( &command->timer, SAN_COMMAND_TIMEOUT );
+		ref_get ( &command->refcnt );
+
+		/* Issue next fragment */
+		rc = command->rw.block_rw ( &sanpath->block, &command->block,
+					    command->rw.lba, command->rw.count,
+					    command->rw.buffer, len );
+
+		/* Handle failure to issue fragment, unless already
+		 * handled via the command interface being closed
+		 */
+		if ( ( rc != 0 ) && command->busy ) {
+			DBGC ( sandev, "SAN %#02x.%d async %p could not "
+			       "initiate read/write: %s\n", sandev->drive,
+			       sanpath->index, command, strerror ( rc ) );
+			stop_timer ( &command->timer );
+			command->busy = 0;
+			if ( command->retries++ >= san_retries ) {
+				san_command_finished ( command, rc );
+			} else {
+				waiting++;
+			}
+		}
+		ref_put ( &command->refcnt );
+	}
+
+	/* Stop dispatching once there are no waiting commands */
+	if ( ! waiting )
+		process_del ( &sandev->process );
+
+	sandev_put ( sandev );
+}
+
+/** Asynchronous SAN device command dispatch process descriptor */
+static struct process_descriptor sandev_process_desc =
+	PROC_DESC ( struct san_device, process, sandev_dispatch );
+
+/**
+ * Start asynchronous read from or write to SAN device
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v block_rw		Block read/write method
+ * @v parent		Parent interface
+ * @ret rc		Return status code
+ *
+ * The parent interface will be closed when the read or write has
+ * completed.  Any number of asynchronous commands may be started;
+ * they will be issued to the underlying block device as concurrently
+ * as it is able to accept them.
+ */
+static int sandev_rw_async ( struct san_device *sandev, uint64_t lba,
+			     unsigned int count, userptr_t buffer,
+			     int ( * block_rw ) ( struct interface *control,
+						  struct interface *data,
+						  uint64_t lba,
+						  unsigned int count,
+						  userptr_t buffer, size_t len ),
+			     struct interface *parent ) {
+	struct san_command *command;
+
+	/* Asynchronous commands cannot wait for the device to be
+	 * reopened; leave this to the synchronous APIs.
+	 */
+	if ( sandev_needs_reopen ( sandev ) )
+		return -ENOTCONN;
+
+	/* Allocate and initialise structure */
+	command = zalloc ( sizeof ( *command ) );
+	if ( ! command )
+		return -ENOMEM;
+	ref_init ( &command->refcnt, san_command_free );
+	intf_init ( &command->parent, &san_command_parent_desc,
+		    &command->refcnt );
+	intf_init ( &command->block, &san_command_block_desc,
+		    &command->refcnt );
+	timer_init ( &command->timer, san_command_expired, &command->refcnt );
+	command->sandev = sandev_get ( sandev );
+	command->rw.block_rw = block_rw;
+	command->rw.buffer = buffer;
+	command->rw.lba = ( lba << sandev->blksize_shift );
+	command->remaining = ( count << sandev->blksize_shift );
+	DBGC2 ( sandev, "SAN %#02x async %p LBA %#08llx+%#x\n",
+		sandev->drive, command, lba, count );
+
+	/* Add to list of commands (which holds our reference) */
+	list_add_tail ( &command->list, &sandev->commands );
+
+	/* Attach to parent interface */
+	intf_plug_plug ( &command->parent, parent );
+
+	/* Start dispatching, or complete immediately if empty */
+	if ( command->remaining ) {
+		process_add ( &sandev->process );
+	} else {
+		san_command_finished ( command, 0 );
+	}
+
+	return 0;
+}
+
+/**
+ * Start asynchronous read from SAN device
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v parent		Parent interface
+ * @ret rc		Return status code
+ */
+int sandev_read_async ( struct san_device *sandev, uint64_t lba,
+			unsigned int count, userptr_t buffer,
+			struct interface *parent ) {
+
+	return sandev_rw_async ( sandev, lba, count, buffer, block_read,
+				 parent );
+}
+
+/**
+ * Start asynchronous write to SAN device
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v parent		Parent interface
+ * @ret rc		Return status code
+ */
+int sandev_write_async ( struct san_device *sandev, uint64_t lba,
+			 unsigned int count, userptr_t buffer,
+			 struct interface *parent ) {
+
+	return sandev_rw_async ( sandev, lba, count, buffer, block_write,
+				 parent );
+}
+
 /**
  * Describe SAN device
  *
@@ -839,6 +1164,9 @@ struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 	timer_init ( &sandev->timer, sandev_command_expired, &sandev->refcnt );
 	sandev->priv = ( ( ( void * ) sandev ) + size );
 	sandev->paths = count;
+	INIT_LIST_HEAD ( &sandev->commands );
+	process_init_stopped ( &sandev->process, &sandev_process_desc,
+			       &sandev->refcnt );
 	INIT_LIST_HEAD ( &sandev->opened );
 	INIT_LIST_HEAD ( &sandev->closed );
 	for ( i = 0 ; i < count ; i++ ) {
@@ -923,6 +1251,7 @@ int register_sandev ( struct san_device *sandev, unsigned int drive,
  * @v sandev		SAN device
  */
 void unregister_sandev ( struct san_device *sandev ) {
+	struct san_command *command;
 
 	/* Sanity check */
 	assert ( ! timer_running ( &sandev->timer ) );
@@ -930,6 +1259,13 @@ void unregister_sandev ( struct san_device *sandev ) {
 	/* Remove from list of SAN devices */
 	list_del ( &sandev->list );
 
+	/* Abort any asynchronous commands */
+	while ( ( command = list_first_entry ( &sandev->commands,
+					       struct san_command, list ) ) ) {
+		san_command_finished ( command, -ENODEV );
+	}
+	process_del ( &sandev->process );
+
 	/* Shut down interfaces */
 	sandev_restart ( sandev, 0 );
 
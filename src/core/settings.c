@@ -66,6 +66,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 struct generic_setting {
 	/** List of generic settings */
 	struct list_head list;
+	/** Next generic setting in tag hash bucket */
+	struct generic_setting *tag_next;
+	/** Next generic setting in name hash bucket */
+	struct generic_setting *name_next;
 	/** Setting */
 	struct setting setting;
 	/** Size of setting name */
@@ -95,25 +99,141 @@ static inline void * generic_setting_data ( struct generic_setting *generic ) {
 		 generic->name_len );
 }
 
+/**
+ * Calculate setting tag hash bucket
+ *
+ * @v tag		Setting tag
+ * @ret bucket		Hash bucket index
+ */
+static inline unsigned int setting_tag_hash ( uint64_t tag ) {
+
+	/* Predefined tags (e.g. DHCP options) are generally small
+	 * integers, with any encapsulation in the higher-order bytes.
+	 */
+	tag ^= ( tag >> 32 );
+	tag ^= ( tag >> 16 );
+	tag ^= ( tag >> 8 );
+	return ( tag & ( GENERIC_SETTINGS_HASH_SIZE - 1 ) );
+}
+
+/**
+ * Calculate setting name hash
+ *
+ * @v name		Setting name
+ * @ret hash		Hash value
+ */
+static unsigned int setting_name_hash ( const char *name ) {
+	unsigned int hash = 0;
+
+	while ( *name )
+		hash = ( ( hash * 31 ) + *(name++) );
+	return hash;
+}
+
 /**
  * Find generic setting
  *
  * @v generics		Generic settings block
  * @v setting		Setting to find
  * @ret generic		Generic setting, or NULL
+ *
+ * As with setting_cmp(), a generic setting with a matching tag is
+ * preferred over a generic setting with a matching name.
  */
 static struct generic_setting *
 find_generic_setting ( struct generic_settings *generics,
 		       const struct setting *setting ) {
 	struct generic_setting *generic;
+	unsigned int bucket;
+
+	/* Look for a generic setting with a matching tag */
+	if ( setting->tag ) {
+		bucket = setting_tag_hash ( setting->tag );
+		for ( generic = generics->tags[bucket] ; generic ;
+		      generic = generic->tag_next ) {
+			if ( ( generic->setting.tag == setting->tag ) &&
+			     ( generic->setting.scope == setting->scope ) )
+				return generic;
+		}
+	}
 
-	list_for_each_entry ( generic, &generics->list, list ) {
-		if ( setting_cmp ( &generic->setting, setting ) == 0 )
-			return generic;
+	/* Look for a generic setting with a matching name */
+	if ( setting->name ) {
+		bucket = ( setting_name_hash ( setting->name ) &
+			   ( GENERIC_SETTINGS_HASH_SIZE - 1 ) );
+		for ( generic = generics->names[bucket] ; generic ;
+		      generic = generic->name_next ) {
+			if ( strcmp ( generic->setting.name,
+				      setting->name ) == 0 )
+				return generic;
+		}
 	}
+
 	return NULL;
 }
 
+/**
+ * Add generic setting to settings block
+ *
+ * @v generics		Generic settings block
+ * @v generic		Generic setting
+ */
+static void add_generic_setting ( struct generic_settings *generics,
+				  struct generic_setting *generic ) {
+	const struct setting *setting = &generic->setting;
+	struct generic_setting **head;
+
+	/* Add to list */
+	list_add ( &generic->list, &generics->list );
+
+	/* Add to tag hash bucket, if applicable */
+	if ( setting->tag ) {
+		head = &generics->tags[ setting_tag_hash ( setting->tag ) ];
+		generic->tag_next = *head;
+		*head = generic;
+	}
+
+	/* Add to name hash bucket, if applicable */
+	if ( setting->name[0] ) {
+		head = &generics->names[ setting_name_hash ( setting->name ) &
+					 ( GENERIC_SETTINGS_HASH_SIZE - 1 ) ];
+		generic->name_next = *head;
+		*head = generic;
+	}
+}
+
+/**
+ * Remove generic setting from settings block
+ *
+ * @v generics		Generic settings block
+ * @v generic		Generic setting
+ */
+static void del_generic_setting ( struct generic_settings *generics,
+				  struct generic_setting *generic ) {
+	const struct setting *setting = &generic->setting;
+	struct generic_setting **prev;
+
+	/* Remove from list */
+	list_del ( &generic->list );
+
+	/* Remove from tag hash bucket, if applicable */
+	if ( setting->tag ) {
+		prev = &generics->tags[ setting_tag_hash ( setting->tag ) ];
+		while ( *prev != generic )
+			prev = &(*prev)->tag_next;
+		*prev = generic->tag_next;
+	}
+
+	/* Remove from name hash bucket, if applicable */
+	if ( setting->name[0] ) {
+		prev = &generics->names[ setting_name_hash ( setting->name ) &
+					 ( GENERIC_SETTINGS_HASH_SIZE - 1 ) ];
+		while ( *prev != generic )
+			prev = &(*prev)->name_next;
+		*prev = generic->name_next;
+	}
+}
+
 /**
  * Store value of generic setting
  *
@@ -155,13 +275,13 @@ int generic_settings_store ( struct settings *settings,
 
 	/* Delete existing generic setting, if any */
 	if ( old ) {
-		list_del ( &old->list );
+		del_generic_setting ( generics, old );
 		free ( old );
 	}
 
-	/* Add new setting to list, if any */
+	/* Add new setting, if any */
 	if ( new )
-		list_add ( &new->list, &generics->list );
+		add_generic_setting ( generics, new );
 
 	return 0;
 }
@@ -211,7 +331,7 @@ void generic_settings_clear ( struct settings *settings ) {
 	struct generic_setting *tmp;
 
 	list_for_each_entry_safe ( generic, tmp, &generics->list, list ) {
-		list_del ( &generic->list );
+		del_generic_setting ( generics, generic );
 		free ( generic );
 	}
 	assert ( list_empty ( &generics->list ) );
@@ -224,6 +344,166 @@ struct settings_operations generic_settings_operations = {
 	.clear = generic_settings_clear,
 };
 
+/******************************************************************************
+ *
+ * Fetched setting cache
+ *
+ ******************************************************************************
+ */
+
+/** Number of entries in fetched setting cache
+ *
+ * Must be a power of two.
+ */
+#define SETTING_CACHE_SIZE 32
+
+/** Maximum length of setting name within fetched setting cache */
+#define SETTING_CACHE_NAME_LEN 32
+
+/**
+ * A fetched setting cache entry
+ *
+ * A fetched setting may be cached only if every settings block
+ * consulted while searching for it was a registered generic settings
+ * block.  The contents of such blocks change only via
+ * store_setting() or clear_settings(), and the shape of the settings
+ * hierarchy changes only via register_settings() or
+ * unregister_settings().  The cache is invalidated by each of these
+ * functions.
+ */
+struct setting_cache_entry {
+	/** Settings block in which search started, or NULL if unused */
+	struct settings *settings;
+	/** Setting tag */
+	uint64_t tag;
+	/** Setting scope */
+	const struct settings_scope *scope;
+	/** Setting name */
+	char name[SETTING_CACHE_NAME_LEN];
+	/** Settings block in which setting was found */
+	struct settings *origin;
+	/** Generic setting */
+	struct generic_setting *generic;
+};
+
+/** Fetched setting cache */
+static struct setting_cache_entry setting_cache[SETTING_CACHE_SIZE];
+
+/**
+ * Invalidate fetched setting cache
+ *
+ */
+static void setting_cache_invalidate ( void ) {
+
+	memset ( setting_cache, 0, sizeof ( setting_cache ) );
+}
+
+/**
+ * Find fetched setting cache entry
+ *
+ * @v settings		Settings block in which search starts
+ * @v setting		Setting to fetch
+ * @ret entry		Cache entry, or NULL if setting cannot be cached
+ */
+static struct setting_cache_entry *
+setting_cache_entry ( struct settings *settings,
+		      const struct setting *setting ) {
+	unsigned int hash;
+
+	/* Only settings with (reasonably short) names can be cached */
+	if ( ! setting->name )
+		return NULL;
+	if ( strlen ( setting->name ) >= SETTING_CACHE_NAME_LEN )
+		return NULL;
+
+	/* Identify cache entry */
+	hash = ( setting_name_hash ( setting->name ) + setting->tag +
+		 ( ( ( intptr_t ) settings ) >> 4 ) );
+	return &setting_cache[ hash & ( SETTING_CACHE_SIZE - 1 ) ];
+}
+
+/**
+ * Check if fetched setting cache entry matches setting
+ *
+ * @v entry		Cache entry
+ * @v settings		Settings block in which search starts
+ * @v setting		Setting to fetch
+ * @ret matches		Cache entry matches setting
+ */
+static int setting_cache_matches ( struct setting_cache_entry *entry,
+				   struct settings *settings,
+				   const struct setting *setting ) {
+
+	return ( ( entry->settings == settings ) &&
+		 ( entry->tag == setting->tag ) &&
+		 ( entry->scope == setting->scope ) &&
+		 ( strcmp ( entry->name, setting->name ) == 0 ) );
+}
+
+/**
+ * Record fetched setting in cache
+ *
+ * @v entry		Cache entry
+ * @v settings		Settings block in which search started
+ * @v setting		Setting fetched
+ * @v origin		Generic settings block in which setting was found
+ */
+static void setting_cache_store ( struct setting_cache_entry *entry,
+				  struct settings *settings,
+				  const struct setting *setting,
+				  struct settings *origin ) {
+	struct generic_settings *generics =
+		container_of ( origin, struct generic_settings, settings );
+
+	entry->settings = settings;
+	entry->tag = setting->tag;
+	entry->scope = setting->scope;
+	strcpy ( entry->name, setting->name );
+	entry->origin = origin;
+	entry->generic = find_generic_setting ( generics, setting );
+	assert ( entry->generic != NULL );
+}
+
+/**
+ * Fetch setting from cache
+ *
+ * @v entry		Cache entry
+ * @v setting		Setting to fetch
+ * @v origin		Origin of setting to fill in, or NULL
+ * @v fetched		Fetched setting to fill in, or NULL
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data
+ */
+static int setting_cache_fetch ( struct setting_cache_entry *entry,
+				 const struct setting *setting,
+				 struct settings **origin,
+				 struct setting *fetched,
+				 void *data, size_t len ) {
+	struct generic_setting *generic = entry->generic;
+
+	/* Copy out generic setting data */
+	memset ( data, 0, len );
+	if ( len > generic->data_len )
+		len = generic->data_len;
+	memcpy ( data, generic_setting_data ( generic ), len );
+
+	/* Record origin, if applicable */
+	if ( origin )
+		*origin = entry->origin;
+
+	/* Record fetched setting, if applicable */
+	if ( fetched ) {
+		memcpy ( fetched, setting, sizeof ( *fetched ) );
+		if ( ! fetched->type )
+			fetched->type = generic->setting.type;
+		if ( ! fetched->type )
+			fetched->type = &setting_type_string;
+	}
+
+	return generic->data_len;
+}
+
 /******************************************************************************
  *
  * Registered settings blocks
@@ -497,6 +777,9 @@ int register_settings ( struct settings *settings, struct settings *parent,
 	DBGC ( settings, "Settings %p (\"%s\") registered\n",
 	       settings, settings_name ( settings ) );
 
+	/* Invalidate fetched setting cache */
+	setting_cache_invalidate();
+
 	/* Fix up settings priority */
 	reprioritise_settings ( settings );
 
@@ -529,6 +812,9 @@ void unregister_settings ( struct settings *settings ) {
 	list_del ( &settings->siblings );
 	ref_put ( settings->refcnt );
 
+	/* Invalidate fetched setting cache */
+	setting_cache_invalidate();
+
 	/* Apply potentially-updated settings */
 	apply_settings();
 }
@@ -603,6 +889,21 @@ applicable_setting ( struct settings *settings, const struct setting *setting ){
 	return NULL;
 }
 
+/**
+ * Check if settings block is registered
+ *
+ * @v settings		Settings block
+ * @ret registered	Settings block is registered
+ */
+static int settings_registered ( struct settings *settings ) {
+
+	for ( ; settings ; settings = settings->parent ) {
+		if ( settings == &settings_root )
+			return 1;
+	}
+	return 0;
+}
+
 /**
  * Store value of setting
  *
@@ -627,6 +928,9 @@ int store_setting ( struct settings *settings, const struct setting *setting,
 	if ( ! settings->op->store )
 		return -ENOTSUP;
 
+	/* Invalidate fetched setting cache */
+	setting_cache_invalidate();
+
 	/* Store setting */
 	if ( ( rc = settings->op->store ( settings, setting,
 					  data, len ) ) != 0 )
@@ -639,33 +943,29 @@ int store_setting ( struct settings *settings, const struct setting *setting,
 	/* If these settings are registered, apply potentially-updated
 	 * settings
 	 */
-	for ( ; settings ; settings = settings->parent ) {
-		if ( settings == &settings_root ) {
-			apply_settings();
-			break;
-		}
-	}
+	if ( settings_registered ( settings ) )
+		apply_settings();
 
 	return 0;
 }
 
 /**
- * Fetch setting
+ * Fetch setting from settings block and its descendants
  *
  * @v settings		Settings block, or NULL to search all blocks
  * @v setting		Setting to fetch
- * @v origin		Origin of setting to fill in, or NULL
+ * @v origin		Origin of setting to fill in
  * @v fetched		Fetched setting to fill in, or NULL
  * @v data		Buffer to fill with setting data
  * @v len		Length of buffer
+ * @v cacheable		Result may be cached (cleared if not)
  * @ret len		Length of setting data, or negative error
- *
- * The actual length of the setting will be returned even if
- * the buffer was too small.
  */
-int fetch_setting ( struct settings *settings, const struct setting *setting,
-		    struct settings **origin, struct setting *fetched,
-		    void *data, size_t len ) {
+static int fetch_setting_tree ( struct settings *settings,
+				const struct setting *setting,
+				struct settings **origin,
+				struct setting *fetched,
+				void *data, size_t len, int *cacheable ) {
 	const struct setting *applicable;
 	struct settings *child;
 	struct setting tmp;
@@ -673,14 +973,17 @@ int fetch_setting ( struct settings *settings, const struct setting *setting,
 
 	/* Avoid returning uninitialised data on error */
 	memset ( data, 0, len );
-	if ( origin )
-		*origin = NULL;
+	*origin = NULL;
 	if ( fetched )
 		memcpy ( fetched, setting, sizeof ( *fetched ) );
 
 	/* Find target settings block */
 	settings = settings_target ( settings );
 
+	/* Only generic settings blocks may be cached */
+	if ( settings->op != &generic_settings_operations )
+		*cacheable = 0;
+
 	/* Sanity check */
 	if ( ! settings->op->fetch )
 		return -ENOTSUP;
@@ -697,9 +1000,8 @@ int fetch_setting ( struct settings *settings, const struct setting *setting,
 			if ( ! tmp.type )
 				tmp.type = &setting_type_string;
 
-			/* Record origin, if applicable */
-			if ( origin )
-				*origin = settings;
+			/* Record origin */
+			*origin = settings;
 
 			/* Record fetched setting, if applicable */
 			if ( fetched )
@@ -711,14 +1013,63 @@ int fetch_setting ( struct settings *settings, const struct setting *setting,
 
 	/* Recurse into each child block in turn */
 	list_for_each_entry ( child, &settings->children, siblings ) {
-		if ( ( ret = fetch_setting ( child, setting, origin, fetched,
-					     data, len ) ) >= 0 )
+		if ( ( ret = fetch_setting_tree ( child, setting, origin,
+						  fetched, data, len,
+						  cacheable ) ) >= 0 )
 			return ret;
 	}
 
 	return -ENOENT;
 }
 
+/**
+ * Fetch setting
+ *
+ * @v settings		Settings block, or NULL to search all blocks
+ * @v setting		Setting to fetch
+ * @v origin		Origin of setting to fill in, or NULL
+ * @v fetched		Fetched setting to fill in, or NULL
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ *
+ * The actual length of the setting will be returned even if
+ * the buffer was too small.
+ */
+int fetch_setting ( struct settings *settings, const struct setting *setting,
+		    struct settings **origin, struct setting *fetched,
+		    void *data, size_t len ) {
+	struct setting_cache_entry *entry;
+	struct settings *target;
+	struct settings *tmp_origin;
+	int cacheable = 1;
+	int ret;
+
+	/* Use local buffer if necessary */
+	if ( ! origin )
+		origin = &tmp_origin;
+
+	/* Use cached result, if available */
+	target = settings_target ( settings );
+	entry = setting_cache_entry ( target, setting );
+	if ( entry && setting_cache_matches ( entry, target, setting ) ) {
+		return setting_cache_fetch ( entry, setting, origin, fetched,
+					     data, len );
+	}
+
+	/* Search settings blocks */
+	ret = fetch_setting_tree ( settings, setting, origin, fetched,
+				   data, len, &cacheable );
+
+	/* Cache result, if applicable */
+	if ( ( ret >= 0 ) && entry && cacheable &&
+	     settings_registered ( target ) ) {
+		setting_cache_store ( entry, target, setting, *origin );
+	}
+
+	return ret;
+}
+
 /**
  * Fetch allocated copy of setting
  *
@@ -1104,6 +1455,9 @@ void clear_settings ( struct settings *settings ) {
 	/* Find target settings block */
 	settings = settings_target ( settings );
 
+	/* Invalidate fetched setting cache */
+	setting_cache_invalidate();
+
 	/* Clear settings, if applicable */
 	if ( settings->op->clear )
 		settings->op->clear ( settings );
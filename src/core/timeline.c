@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/* Always provide the real tracer, irrespective of configuration */
+#define TIMELINE
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/timeline.h>
+
+/** @file
+ *
+ * Boot timeline
+ *
+ * Significant events during the boot process (link-up, DHCP state
+ * changes, name resolution, connection establishment, TLS handshake
+ * progress, image download and image execution) are recorded into a
+ * fixed-size ring, along with a high-resolution timestamp.  Recording
+ * an event never allocates memory; once the ring is full, the oldest
+ * events are overwritten.
+ *
+ */
+
+/** Timeline event ring */
+static struct timeline_event timeline_ring[TIMELINE_MAX_EVENTS];
+
+/** Number of events ever recorded */
+static unsigned long timeline_count;
+
+/** Number of events discarded by timeline_clear() */
+static unsigned long timeline_cleared;
+
+/**
+ * Record timeline event
+ *
+ * @v name		Event name (must be a static string)
+ * @v fmt		Format string for event detail
+ * @v ...		Arguments
+ */
+void timeline ( const char *name, const char *fmt, ... ) {
+	struct timeline_event *event;
+	va_list args;
+
+	/* Populate next ring entry */
+	event = &timeline_ring[ timeline_count % TIMELINE_MAX_EVENTS ];
+	event->seq = timeline_count++;
+	event->timestamp = profile_timestamp();
+	event->ticks = currticks();
+	event->name = name;
+	va_start ( args, fmt );
+	vsnprintf ( event->detail, sizeof ( event->detail ), fmt, args );
+	va_end ( args );
+}
+
+/**
+ * Get oldest retained timeline event
+ *
+ * @ret event		Timeline event, or NULL if none
+ */
+struct timeline_event * timeline_first ( void ) {
+	unsigned long first = timeline_cleared;
+
+	/* Skip any events that have been overwritten */
+	if ( ( timeline_count - first ) > TIMELINE_MAX_EVENTS )
+		first = ( timeline_count - TIMELINE_MAX_EVENTS );
+
+	/* Return oldest event, if any */
+	if ( first == timeline_count )
+		return NULL;
+	return &timeline_ring[ first % TIMELINE_MAX_EVENTS ];
+}
+
+/**
+ * Get next retained timeline event
+ *
+ * @v event		Timeline event
+ * @ret next		Next timeline event, or NULL if none
+ */
+struct timeline_event * timeline_next ( struct timeline_event *event ) {
+	unsigned long seq = ( event->seq + 1 );
+
+	if ( seq == timeline_count )
+		return NULL;
+	return &timeline_ring[ seq % TIMELINE_MAX_EVENTS ];
+}
+
+/**
+ * Discard all recorded timeline events
+ *
+ */
+void timeline_clear ( void ) {
+
+	timeline_cleared = timeline_count;
+}
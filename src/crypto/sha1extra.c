@@ -92,39 +92,80 @@ void prf_sha1 ( const void *key, size_t key_len, const char *label,
  * @ret block		SHA1_SIZE bytes of PBKDF2 data
  *
  * The operation of this function is described in RFC 2898.
+ *
+ * Every iteration uses the same HMAC key, so the SHA1 states after
+ * absorbing the inner and outer pads are calculated only once.  Each
+ * iteration then requires only two SHA1 compressions rather than
+ * four.
  */
 static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
 			    const void *salt, size_t salt_len,
 			    int iterations, u32 blocknr, u8 *block )
 {
-	u8 pass[pass_len];	/* modifiable passphrase */
-	u8 in[salt_len + 4];	/* input buffer to first round */
+	u8 pad[SHA1_BLOCK_SIZE]; /* HMAC input/output pad */
+	u8 inner[SHA1_CTX_SIZE]; /* SHA1 state after inner pad */
+	u8 outer[SHA1_CTX_SIZE]; /* SHA1 state after outer pad */
+	u8 ctx[SHA1_CTX_SIZE];
 	u8 last[SHA1_DIGEST_SIZE]; /* output of round N, input of N+1 */
-	u8 ctx[SHA1_CTX_SIZE + SHA1_BLOCK_SIZE];
-	u8 *next_in = in;	/* changed to `last' after first round */
-	int next_size = sizeof ( in );
 	int i;
 	unsigned int j;
 
 	blocknr = htonl ( blocknr );
 
-	memcpy ( pass, passphrase, pass_len );
-	memcpy ( in, salt, salt_len );
-	memcpy ( in + salt_len, &blocknr, 4 );
+	/* Construct input pad, as per hmac_init() */
+	memset ( pad, 0, sizeof ( pad ) );
+	if ( pass_len <= sizeof ( pad ) ) {
+		memcpy ( pad, passphrase, pass_len );
+	} else {
+		digest_init ( &sha1_algorithm, ctx );
+		digest_update ( &sha1_algorithm, ctx, passphrase, pass_len );
+		digest_final ( &sha1_algorithm, ctx, pad );
+	}
+	for ( j = 0; j < sizeof ( pad ); j++ ) {
+		pad[j] ^= 0x36;
+	}
+
+	/* Calculate SHA1 state after inner pad */
+	digest_init ( &sha1_algorithm, inner );
+	digest_update ( &sha1_algorithm, inner, pad, sizeof ( pad ) );
+
+	/* Calculate SHA1 state after outer pad */
+	for ( j = 0; j < sizeof ( pad ); j++ ) {
+		pad[j] ^= ( 0x36 ^ 0x5c );
+	}
+	digest_init ( &sha1_algorithm, outer );
+	digest_update ( &sha1_algorithm, outer, pad, sizeof ( pad ) );
+	memset ( pad, 0, sizeof ( pad ) );
+
+	/* First round operates on salt and block number */
+	memcpy ( ctx, inner, sizeof ( ctx ) );
+	digest_update ( &sha1_algorithm, ctx, salt, salt_len );
+	digest_update ( &sha1_algorithm, ctx, &blocknr, sizeof ( blocknr ) );
 	memset ( block, 0, sizeof ( last ) );
 
 	for ( i = 0; i < iterations; i++ ) {
-		hmac_init ( &sha1_algorithm, ctx, pass, pass_len );
-		hmac_update ( &sha1_algorithm, ctx, next_in, next_size );
-		hmac_final ( &sha1_algorithm, ctx, last );
+
+		/* Finish inner hash (of salt or of previous round) */
+		digest_final ( &sha1_algorithm, ctx, last );
+
+		/* Perform outer hash */
+		memcpy ( ctx, outer, sizeof ( ctx ) );
+		digest_update ( &sha1_algorithm, ctx, last, sizeof ( last ) );
+		digest_final ( &sha1_algorithm, ctx, last );
 
 		for ( j = 0; j < sizeof ( last ); j++ ) {
 			block[j] ^= last[j];
 		}
 
-		next_in = last;
-		next_size = sizeof ( last );
+		/* Start inner hash of this round's output */
+		memcpy ( ctx, inner, sizeof ( ctx ) );
+		digest_update ( &sha1_algorithm, ctx, last, sizeof ( last ) );
 	}
+
+	/* Erase pad states (from which the key may be derivable) */
+	memset ( inner, 0, sizeof ( inner ) );
+	memset ( outer, 0, sizeof ( outer ) );
+	memset ( ctx, 0, sizeof ( ctx ) );
 }
 
 /**
@@ -4,6 +4,7 @@ FILE_LICENCE ( GPL2_ONLY );
 #include <mii.h>
 #include <stdio.h>
 #include <errno.h>
+#include <strings.h>
 #include <unistd.h>
 #include <byteswap.h>
 #include <ipxe/pci.h>
@@ -476,6 +477,8 @@ void bnxt_rx_process ( struct net_device *dev, struct bnxt *bp,
 	bp->rx.cnt++;
 	bp->rx.iob[desc_idx] = NULL;
 	bp->rx.iob_cnt--;
+	if ( !bp->rx.iob_cnt )
+		netdev_rx_overflow ( dev );
 	bnxt_post_rx_buffers ( bp );
 	bnxt_adv_cq_index ( bp, 2 ); /* Rx completion is 2 entries. */
 	dbg_rx_stat ( bp );
@@ -546,7 +549,8 @@ void bnxt_mm_nic ( struct bnxt *bp )
 	bp->cq.ring_cnt		= MAX_CQ_DESC_CNT;
 	bp->tx.ring_cnt		= MAX_TX_DESC_CNT;
 	bp->rx.ring_cnt		= MAX_RX_DESC_CNT;
-	bp->rx.buf_cnt		= NUM_RX_BUFFERS;
+	/* Rx buffer count must divide the ring size */
+	bp->rx.buf_cnt		= ( 1 << ( fls ( bp->dev->rx_fill ) - 1 ) );
 }
 
 void bnxt_free_mem ( struct bnxt *bp )
@@ -2153,6 +2157,8 @@ static int bnxt_init_one ( struct pci_device *pci )
 	bp->pdev = pci;
 	bp->dev  = netdev;
 	netdev->dev = &pci->dev;
+	netdev->rx_fill = NUM_RX_BUFFERS;
+	netdev->max_rx_fill = MAX_RX_BUFFERS;
 
 	/* Enable PCI device */
 	adjust_pci_device ( pci );
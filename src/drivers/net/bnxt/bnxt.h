@@ -141,9 +141,10 @@ union dma_addr64_t {
 #define DEFAULT_NUMBER_OF_RING_GRPS             0x01
 #define DEFAULT_NUMBER_OF_STAT_CTXS             0x01
 #define NUM_RX_BUFFERS                          8
-#define MAX_RX_DESC_CNT                         16
+#define MAX_RX_DESC_CNT                         64
+#define MAX_RX_BUFFERS                          (MAX_RX_DESC_CNT / 2)
 #define MAX_TX_DESC_CNT                         16
-#define MAX_CQ_DESC_CNT                         64
+#define MAX_CQ_DESC_CNT                         128
 #define TX_RING_BUFFER_SIZE (MAX_TX_DESC_CNT * sizeof(struct tx_bd_short))
 #define RX_RING_BUFFER_SIZE \
 	(MAX_RX_DESC_CNT * sizeof(struct rx_prod_pkt_bd))
@@ -694,7 +695,7 @@ struct rx_prod_pkt_bd {
 
 struct rx_info {
 	void              *bd_virt;
-	struct io_buffer  *iob[NUM_RX_BUFFERS];
+	struct io_buffer  *iob[MAX_RX_BUFFERS];
 	u16               iob_cnt;
 	u16               buf_cnt;  /* Total Rx buffer descriptors. */
 	u16               ring_cnt;
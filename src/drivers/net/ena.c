@@ -696,10 +696,16 @@ static void ena_refill_rx ( struct net_device *netdev ) {
 	size_t len = netdev->max_pkt_len;
 	unsigned int refilled = 0;
 	unsigned int index;
+	unsigned int fill;
 	unsigned int id;
 
+	/* Calculate fill level (limited to completion queue size) */
+	fill = netdev->rx_fill;
+	if ( fill > ena->rx.sq.fill )
+		fill = ena->rx.sq.fill;
+
 	/* Refill queue */
-	while ( ( ena->rx.sq.prod - ena->rx.cq.cons ) < ena->rx.sq.fill ) {
+	while ( ( ena->rx.sq.prod - ena->rx.cq.cons ) < fill ) {
 
 		/* Allocate I/O buffer */
 		iobuf = alloc_iob ( len );
@@ -915,6 +921,7 @@ static void ena_poll_rx ( struct net_device *netdev ) {
 	struct ena_nic *ena = netdev->priv;
 	struct ena_rx_cqe *cqe;
 	struct io_buffer *iobuf;
+	unsigned int received = 0;
 	unsigned int index;
 	unsigned int id;
 	size_t len;
@@ -929,6 +936,7 @@ static void ena_poll_rx ( struct net_device *netdev ) {
 		/* Stop if completion queue entry is empty */
 		if ( ( cqe->flags ^ ena->rx.cq.phase ) & ENA_CQE_PHASE )
 			return;
+		received++;
 
 		/* Increment consumer counter */
 		ena->rx.cq.cons++;
@@ -951,6 +959,10 @@ static void ena_poll_rx ( struct net_device *netdev ) {
 			ena, id, len );
 		netdev_rx ( netdev, iobuf );
 	}
+
+	/* Record overflow if all receive buffers were consumed */
+	if ( received )
+		netdev_rx_overflow ( netdev );
 }
 
 /**
@@ -1046,6 +1058,7 @@ static int ena_probe ( struct pci_device *pci ) {
 	ena = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
+	netdev->state |= NETDEV_TX_ZERO_COPY;
 	memset ( ena, 0, sizeof ( *ena ) );
 	ena->acq.phase = ENA_ACQ_PHASE;
 	ena_cq_init ( &ena->tx.cq, ENA_TX_COUNT,
@@ -1054,8 +1067,10 @@ static int ena_probe ( struct pci_device *pci ) {
 		      sizeof ( ena->tx.sq.sqe.tx[0] ), ena->tx_ids );
 	ena_cq_init ( &ena->rx.cq, ENA_RX_COUNT,
 		      sizeof ( ena->rx.cq.cqe.rx[0] ) );
-	ena_sq_init ( &ena->rx.sq, ENA_SQ_RX, ENA_RX_COUNT, ENA_RX_FILL,
+	ena_sq_init ( &ena->rx.sq, ENA_SQ_RX, ENA_RX_COUNT, ENA_RX_COUNT,
 		      sizeof ( ena->rx.sq.sqe.rx[0] ), ena->rx_ids );
+	netdev->rx_fill = ENA_RX_FILL;
+	netdev->max_rx_fill = ENA_RX_COUNT;
 
 	/* Fix up PCI device */
 	adjust_pci_device ( pci );
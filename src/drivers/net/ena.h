@@ -30,7 +30,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Number of receive queue entries */
 #define ENA_RX_COUNT 128
 
-/** Receive queue maximum fill level */
+/** Default receive queue fill level */
 #define ENA_RX_FILL 16
 
 /** Base address low register offset */
@@ -782,9 +782,12 @@ static int ice_probe ( struct pci_device *pci ) {
 	}
 	netdev_init ( netdev, &ice_operations );
 	netdev->max_pkt_len = INTELXL_MAX_PKT_LEN;
+	netdev->rx_fill = INTELXL_RX_FILL;
+	netdev->max_rx_fill = INTELXL_RX_MAX_FILL;
 	intelxl = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
+	netdev->state |= NETDEV_TX_ZERO_COPY;
 	memset ( intelxl, 0, sizeof ( *intelxl ) );
 	intelxl->intr = ICE_GLINT_DYN_CTL;
 	intelxl->handle = ice_admin_event;
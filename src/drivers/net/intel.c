@@ -945,6 +945,7 @@ static int intel_probe ( struct pci_device *pci ) {
 	intel = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
+	netdev->state |= NETDEV_TX_ZERO_COPY;
 	memset ( intel, 0, sizeof ( *intel ) );
 	intel->port = PCI_FUNC ( pci->busdevfn );
 	intel->flags = pci->id->driver_data;
@@ -1331,17 +1331,25 @@ void intelxl_destroy_ring ( struct intelxl_nic *intelxl,
 /**
  * Refill receive descriptor ring
  *
- * @v intelxl		Intel device
+ * @v netdev		Network device
  */
-static void intelxl_refill_rx ( struct intelxl_nic *intelxl ) {
+static void intelxl_refill_rx ( struct net_device *netdev ) {
+	struct intelxl_nic *intelxl = netdev->priv;
 	struct intelxl_rx_data_descriptor *rx;
 	struct io_buffer *iobuf;
 	unsigned int rx_idx;
 	unsigned int rx_tail;
 	unsigned int refilled = 0;
+	unsigned int fill;
+
+	/* Calculate fill level (which must be a multiple of 8) */
+	fill = ( netdev->rx_fill & ~7U );
+	if ( fill < INTELXL_RX_FILL )
+		fill = INTELXL_RX_FILL;
+	assert ( fill <= INTELXL_RX_MAX_FILL );
 
 	/* Refill ring */
-	while ( ( intelxl->rx.prod - intelxl->rx.cons ) < INTELXL_RX_FILL ) {
+	while ( ( intelxl->rx.prod - intelxl->rx.cons ) < fill ) {
 
 		/* Allocate I/O buffer */
 		iobuf = alloc_rx_iob ( intelxl->mfs, intelxl->dma );
@@ -1445,7 +1453,7 @@ static int intelxl_open ( struct net_device *netdev ) {
 		goto err_create_tx;
 
 	/* Fill receive ring */
-	intelxl_refill_rx ( intelxl );
+	intelxl_refill_rx ( netdev );
 
 	/* Restart autonegotiation */
 	intelxl_admin_autoneg ( intelxl );
@@ -1581,6 +1589,7 @@ static void intelxl_poll_rx ( struct net_device *netdev ) {
 	struct io_buffer *iobuf;
 	unsigned int rx_idx;
 	unsigned int tag;
+	unsigned int received = 0;
 	size_t len;
 
 	/* Check for received packets */
@@ -1593,6 +1602,7 @@ static void intelxl_poll_rx ( struct net_device *netdev ) {
 		/* Stop if descriptor is still in use */
 		if ( ! ( rx_wb->flags & cpu_to_le32 ( INTELXL_RX_WB_FL_DD ) ) )
 			return;
+		received++;
 
 		/* Populate I/O buffer */
 		iobuf = intelxl->rx_iobuf[rx_idx];
@@ -1620,6 +1630,10 @@ static void intelxl_poll_rx ( struct net_device *netdev ) {
 		}
 		intelxl->rx.cons++;
 	}
+
+	/* Record overflow if all receive buffers were consumed */
+	if ( received )
+		netdev_rx_overflow ( netdev );
 }
 
 /**
@@ -1640,7 +1654,7 @@ void intelxl_poll ( struct net_device *netdev ) {
 	intelxl_poll_admin ( netdev );
 
 	/* Refill RX ring */
-	intelxl_refill_rx ( intelxl );
+	intelxl_refill_rx ( netdev );
 
 	/* Rearm interrupt, since otherwise receive descriptors will
 	 * be written back only after a complete cacheline (four
@@ -1697,9 +1711,12 @@ static int intelxl_probe ( struct pci_device *pci ) {
 	}
 	netdev_init ( netdev, &intelxl_operations );
 	netdev->max_pkt_len = INTELXL_MAX_PKT_LEN;
+	netdev->rx_fill = INTELXL_RX_FILL;
+	netdev->max_rx_fill = INTELXL_RX_MAX_FILL;
 	intelxl = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
+	netdev->state |= NETDEV_TX_ZERO_COPY;
 	memset ( intelxl, 0, sizeof ( *intelxl ) );
 	intelxl->intr = INTELXL_PFINT_DYN_CTL0;
 	intelxl->handle = intelxl_admin_event;
@@ -809,14 +809,21 @@ intelxl_init_ring ( struct intelxl_ring *ring, unsigned int count, size_t len,
  *
  * Must be a multiple of 32 and greater than or equal to 64.
  */
-#define INTELXL_RX_NUM_DESC 64
+#define INTELXL_RX_NUM_DESC 256
 
-/** Receive descriptor ring fill level
+/** Default receive descriptor ring fill level
  *
  * Must be a multiple of 8 and greater than 8.
  */
 #define INTELXL_RX_FILL 16
 
+/** Maximum receive descriptor ring fill level
+ *
+ * Must be a multiple of 8 and less than the number of receive
+ * descriptors.
+ */
+#define INTELXL_RX_MAX_FILL ( INTELXL_RX_NUM_DESC - 8 )
+
 /** Maximum packet length (excluding CRC) */
 #define INTELXL_MAX_PKT_LEN ( 9728 - 4 /* CRC */ )
 
@@ -756,6 +756,9 @@ static int intelxlvf_probe ( struct pci_device *pci ) {
 	intelxl = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
+	netdev->state |= NETDEV_TX_ZERO_COPY;
+	netdev->rx_fill = INTELXL_RX_FILL;
+	netdev->max_rx_fill = INTELXL_RX_MAX_FILL;
 	memset ( intelxl, 0, sizeof ( *intelxl ) );
 	intelxl->intr = INTELXLVF_VFINT_DYN_CTLN ( INTELXLVF_MSIX_VECTOR );
 	intelxl->handle = intelxlvf_admin_event;
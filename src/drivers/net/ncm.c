@@ -394,6 +394,133 @@ static int ncm_out_transmit ( struct ncm_device *ncm,
 	return 0;
 }
 
+/**
+ * Calculate aggregated NTB length
+ *
+ * @v ncm		CDC-NCM device
+ * @v count		Number of datagrams
+ * @v len		Total length of datagrams
+ * @ret ntb_len		Maximum length of aggregated NTB
+ */
+static size_t ncm_out_len ( struct ncm_device *ncm, unsigned int count,
+			    size_t len ) {
+
+	return ( sizeof ( struct ncm_transfer_header ) +
+		 sizeof ( struct ncm_datagram_pointer ) +
+		 ( ( count + 1 ) * sizeof ( struct ncm_datagram_descriptor ) ) +
+		 ( count * ( ncm->out_divisor - 1 ) ) + len );
+}
+
+/**
+ * Transmit aggregated NTB
+ *
+ * @v ncm		CDC-NCM device
+ * @ret rc		Return status code
+ *
+ * The pending datagrams are copied into a single NTB, and are
+ * considered to have been transmitted once the NTB has been
+ * enqueued.
+ */
+static int ncm_out_aggregate ( struct ncm_device *ncm ) {
+	struct ncm_transfer_header *nth;
+	struct ncm_datagram_pointer *ndp;
+	struct ncm_datagram_descriptor *desc;
+	struct io_buffer *ntb;
+	struct io_buffer *iobuf;
+	unsigned int count = ncm->pending_count;
+	unsigned int i;
+	size_t offset;
+	size_t len;
+	size_t pad;
+	int rc;
+
+	/* Profile transmissions */
+	profile_start ( &ncm_out_profiler );
+
+	/* Allocate NTB */
+	ntb = alloc_iob ( ncm_out_len ( ncm, count, ncm->pending_len ) );
+	if ( ! ntb )
+		return -ENOMEM;
+
+	/* Construct headers */
+	nth = iob_put ( ntb, sizeof ( *nth ) );
+	ndp = iob_put ( ntb, sizeof ( *ndp ) );
+	desc = iob_put ( ntb, ( ( count + 1 ) * sizeof ( *desc ) ) );
+	nth->magic = cpu_to_le32 ( NCM_TRANSFER_HEADER_MAGIC );
+	nth->header_len = cpu_to_le16 ( sizeof ( *nth ) );
+	nth->sequence = cpu_to_le16 ( ncm->sequence );
+	nth->offset = cpu_to_le16 ( sizeof ( *nth ) );
+	ndp->magic = cpu_to_le32 ( NCM_DATAGRAM_POINTER_MAGIC );
+	ndp->header_len = cpu_to_le16 ( sizeof ( *ndp ) +
+					( ( count + 1 ) * sizeof ( *desc ) ) );
+	ndp->offset = cpu_to_le16 ( 0 );
+
+	/* Append datagrams, aligning each in the same way as for a
+	 * single transmitted datagram.
+	 */
+	for ( i = 0 ; i < count ; i++ ) {
+		iobuf = ncm->pending[i];
+		offset = iob_len ( ntb );
+		pad = ( ( ncm->out_remainder - offset - ETH_HLEN ) &
+			( ncm->out_divisor - 1 ) );
+		memset ( iob_put ( ntb, pad ), 0, pad );
+		len = iob_len ( iobuf );
+		desc[i].offset = cpu_to_le16 ( offset + pad );
+		desc[i].len = cpu_to_le16 ( len );
+		memcpy ( iob_put ( ntb, len ), iobuf->data, len );
+	}
+	memset ( &desc[count], 0, sizeof ( desc[count] ) );
+	nth->len = cpu_to_le16 ( iob_len ( ntb ) );
+
+	/* Enqueue NTB */
+	if ( ( rc = usb_stream ( &ncm->usbnet.out, ntb, 0 ) ) != 0 ) {
+		free_iob ( ntb );
+		return rc;
+	}
+	list_add_tail ( &ntb->list, &ncm->ntbs );
+
+	/* Increment sequence number */
+	ncm->sequence++;
+
+	profile_stop ( &ncm_out_profiler );
+	return 0;
+}
+
+/**
+ * Transmit all datagrams awaiting aggregation
+ *
+ * @v ncm		CDC-NCM device
+ */
+static void ncm_out_flush ( struct ncm_device *ncm ) {
+	struct net_device *netdev = ncm->netdev;
+	struct io_buffer *iobuf;
+	unsigned int i;
+	int rc;
+
+	/* Do nothing unless there are pending datagrams */
+	if ( ! ncm->pending_count )
+		return;
+
+	/* Transmit a lone datagram without copying, otherwise
+	 * aggregate all pending datagrams into a single NTB.
+	 */
+	if ( ncm->pending_count == 1 ) {
+		iobuf = ncm->pending[0];
+		if ( ( rc = ncm_out_transmit ( ncm, iobuf ) ) != 0 )
+			netdev_tx_complete_err ( netdev, iobuf, rc );
+	} else {
+		DBGC2 ( ncm, "NCM %p aggregating %d datagrams\n",
+			ncm, ncm->pending_count );
+		rc = ncm_out_aggregate ( ncm );
+		for ( i = 0 ; i < ncm->pending_count ; i++ )
+			netdev_tx_complete_err ( netdev, ncm->pending[i], rc );
+	}
+
+	/* Clear pending datagrams */
+	ncm->pending_count = 0;
+	ncm->pending_len = 0;
+}
+
 /**
  * Complete bulk OUT transfer
  *
@@ -407,6 +534,17 @@ static void ncm_out_complete ( struct usb_endpoint *ep, struct io_buffer *iobuf,
 						usbnet.out );
 	struct net_device *netdev = ncm->netdev;
 
+	/* Free aggregated NTBs (whose datagrams have already been
+	 * reported as complete), recording any errors.
+	 */
+	if ( list_contains_entry ( iobuf, &ncm->ntbs, list ) ) {
+		list_del ( &iobuf->list );
+		if ( rc != 0 )
+			netdev_tx_err ( netdev, NULL, rc );
+		free_iob ( iobuf );
+		return;
+	}
+
 	/* Report TX completion */
 	netdev_tx_complete_err ( netdev, iobuf, rc );
 }
@@ -487,8 +625,17 @@ static int ncm_open ( struct net_device *netdev ) {
 static void ncm_close ( struct net_device *netdev ) {
 	struct ncm_device *ncm = netdev->priv;
 
+	/* Discard any datagrams awaiting aggregation (which will be
+	 * cancelled when the transmit queue is flushed).
+	 */
+	ncm->pending_count = 0;
+	ncm->pending_len = 0;
+
 	/* Close USB network device */
 	usbnet_close ( &ncm->usbnet );
+
+	/* Sanity check */
+	assert ( list_empty ( &ncm->ntbs ) );
 }
 
 /**
@@ -501,11 +648,28 @@ static void ncm_close ( struct net_device *netdev ) {
 static int ncm_transmit ( struct net_device *netdev,
 			  struct io_buffer *iobuf ) {
 	struct ncm_device *ncm = netdev->priv;
-	int rc;
+	size_t len = iob_len ( iobuf );
 
-	/* Transmit packet */
-	if ( ( rc = ncm_out_transmit ( ncm, iobuf ) ) != 0 )
-		return rc;
+	/* Transmit pending datagrams first if this datagram would
+	 * not fit within the same NTB.
+	 */
+	if ( ncm_out_len ( ncm, ( ncm->pending_count + 1 ),
+			   ( ncm->pending_len + len ) ) > ncm->out_mtu ) {
+		ncm_out_flush ( ncm );
+	}
+
+	/* Add to pending datagrams */
+	ncm->pending[ncm->pending_count++] = iobuf;
+	ncm->pending_len += len;
+
+	/* Transmit immediately if the endpoint is idle or the NTB is
+	 * full.  Otherwise, allow further datagrams to accumulate
+	 * until the next poll.
+	 */
+	if ( ( ncm->usbnet.out.fill == 0 ) ||
+	     ( ncm->pending_count >= ncm->out_max ) ) {
+		ncm_out_flush ( ncm );
+	}
 
 	return 0;
 }
@@ -519,6 +683,9 @@ static void ncm_poll ( struct net_device *netdev ) {
 	struct ncm_device *ncm = netdev->priv;
 	int rc;
 
+	/* Transmit any datagrams awaiting aggregation */
+	ncm_out_flush ( ncm );
+
 	/* Poll USB bus */
 	usb_poll ( ncm->bus );
 
@@ -575,6 +742,7 @@ static int ncm_probe ( struct usb_function *func,
 	ncm->usb = usb;
 	ncm->bus = usb->port->hub->bus;
 	ncm->netdev = netdev;
+	INIT_LIST_HEAD ( &ncm->ntbs );
 	usbnet_init ( &ncm->usbnet, func, &ncm_intr_operations,
 		      &ncm_in_operations, &ncm_out_operations );
 	usb_refill_init ( &ncm->usbnet.intr, 0, 0, NCM_INTR_COUNT );
@@ -628,6 +796,18 @@ static int ncm_probe ( struct usb_function *func,
 	assert ( ( ( sizeof ( struct ncm_ntb_header ) + ncm->padding +
 		     ETH_HLEN ) % divisor ) == remainder );
 
+	/* Get transmit aggregation limits */
+	ncm->out_mtu = le32_to_cpu ( params.out.mtu );
+	if ( ncm->out_mtu > NCM_MAX_NTB_INPUT_SIZE - 1 )
+		ncm->out_mtu = ( NCM_MAX_NTB_INPUT_SIZE - 1 );
+	ncm->out_max = le16_to_cpu ( params.max );
+	if ( ( ncm->out_max == 0 ) || ( ncm->out_max > NCM_OUT_MAX_DATAGRAMS ) )
+		ncm->out_max = NCM_OUT_MAX_DATAGRAMS;
+	ncm->out_divisor = divisor;
+	ncm->out_remainder = remainder;
+	DBGC2 ( ncm, "NCM %p aggregating up to %d datagrams in %zd bytes\n",
+		ncm, ncm->out_max, ncm->out_mtu );
+
 	/* Register network device */
 	if ( ( rc = register_netdev ( netdev ) ) != 0 )
 		goto err_register;
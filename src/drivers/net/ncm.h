@@ -132,6 +132,12 @@ struct ncm_ntb_header {
 	struct ncm_datagram_descriptor desc[2];
 } __attribute__ (( packed ));
 
+/** Maximum number of datagrams aggregated into a transmitted NTB
+ *
+ * This is a policy decision.
+ */
+#define NCM_OUT_MAX_DATAGRAMS 16
+
 /** A CDC-NCM network device */
 struct ncm_device {
 	/** USB device */
@@ -149,6 +155,23 @@ struct ncm_device {
 	uint16_t sequence;
 	/** Alignment padding required on transmitted packets */
 	size_t padding;
+
+	/** Maximum supported NTB output size */
+	size_t out_mtu;
+	/** Maximum number of datagrams per output NTB */
+	unsigned int out_max;
+	/** Output datagram alignment divisor */
+	unsigned int out_divisor;
+	/** Output datagram alignment remainder */
+	unsigned int out_remainder;
+	/** Datagrams awaiting aggregation */
+	struct io_buffer *pending[NCM_OUT_MAX_DATAGRAMS];
+	/** Number of datagrams awaiting aggregation */
+	unsigned int pending_count;
+	/** Total length of datagrams awaiting aggregation */
+	size_t pending_len;
+	/** Aggregated NTBs in progress */
+	struct list_head ntbs;
 };
 
 /** Bulk IN ring minimum buffer count
@@ -529,7 +529,7 @@ static void netfront_refill_rx ( struct net_device *netdev ) {
 	int rc;
 
 	/* Refill ring */
-	while ( netfront_ring_fill ( &netfront->rx ) < NETFRONT_RX_FILL ) {
+	while ( netfront_ring_fill ( &netfront->rx ) < netdev->rx_fill ) {
 
 		/* Allocate I/O buffer */
 		iobuf = alloc_iob ( PAGE_SIZE );
@@ -841,6 +841,7 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 	struct xen_device *xendev = netfront->xendev;
 	struct netif_rx_response *response;
 	struct io_buffer *iobuf;
+	unsigned int received = 0;
 	int status;
 	int more;
 	size_t len;
@@ -855,6 +856,7 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 
 		/* Retrieve from descriptor ring */
 		iobuf = netfront_pull ( netfront, &netfront->rx, response->id );
+		received++;
 		status = response->status;
 		more = ( response->flags & NETRXF_more_data );
 
@@ -896,6 +898,10 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 		/* Hand off to network stack */
 		netdev_rx ( netdev, iobuf );
 	}
+
+	/* Record overflow if the backend consumed every posted buffer */
+	if ( received && netfront_ring_is_empty ( &netfront->rx ) )
+		netdev_rx_overflow ( netdev );
 }
 
 /**
@@ -950,6 +956,8 @@ static int netfront_probe ( struct xen_device *xendev ) {
 	}
 	netdev_init ( netdev, &netfront_operations );
 	netdev->dev = &xendev->dev;
+	netdev->rx_fill = NETFRONT_RX_FILL;
+	netdev->max_rx_fill = NETFRONT_NUM_RX_DESC;
 	netfront = netdev->priv;
 	netfront->xendev = xendev;
 	INIT_LIST_HEAD ( &netfront->rx_partial );
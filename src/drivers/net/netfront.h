@@ -16,9 +16,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define NETFRONT_NUM_TX_DESC 16
 
 /** Number of receive ring entries */
-#define NETFRONT_NUM_RX_DESC 32
+#define NETFRONT_NUM_RX_DESC 64
 
-/** Receive ring fill level
+/** Default receive ring fill level
  *
  * The xen-netback driver from kernels 3.18 to 4.2 inclusive have a
  * bug (CA-163395) which prevents packet reception if fewer than 18
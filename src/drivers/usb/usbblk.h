@@ -108,9 +108,17 @@ struct usbblk_device {
 
 /** Maximum length of USB data block
  *
- * This is a policy decision.
+ * This is a policy decision.  Larger blocks allow a single transfer
+ * descriptor to cover many packets (a single TRB for xHCI, or a small
+ * number of qTDs for EHCI), which substantially reduces the per-block
+ * overhead on high-speed and SuperSpeed devices.  Since I/O buffers
+ * are aligned to their own size, a block never crosses a 64kB
+ * boundary and so never needs to be split by the host controller.
+ *
+ * The total amount of memory used is bounded by the maximum
+ * endpoint fill level.
  */
-#define USBBLK_MAX_LEN 2048
+#define USBBLK_MAX_LEN 32768
 
 /** Maximum endpoint fill level
  *
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/iperf.h>
+#include <usr/iperfmgmt.h>
+
+/** @file
+ *
+ * iperf3 network throughput test command
+ *
+ */
+
+/** "iperf" options */
+struct iperf_options {
+	/** Server port */
+	unsigned int port;
+	/** Use UDP */
+	int udp;
+	/** Reverse direction */
+	int reverse;
+	/** Test duration (in seconds) */
+	unsigned int time;
+	/** UDP bandwidth (in bits per second) */
+	unsigned int bandwidth;
+	/** Block length */
+	unsigned int length;
+};
+
+/** "iperf" option list */
+static struct option_descriptor iperf_opts[] = {
+	OPTION_DESC ( "port", 'p', required_argument,
+		      struct iperf_options, port, parse_integer ),
+	OPTION_DESC ( "udp", 'u', no_argument,
+		      struct iperf_options, udp, parse_flag ),
+	OPTION_DESC ( "reverse", 'R', no_argument,
+		      struct iperf_options, reverse, parse_flag ),
+	OPTION_DESC ( "time", 't', required_argument,
+		      struct iperf_options, time, parse_integer ),
+	OPTION_DESC ( "bandwidth", 'b', required_argument,
+		      struct iperf_options, bandwidth, parse_integer ),
+	OPTION_DESC ( "length", 'l', required_argument,
+		      struct iperf_options, length, parse_integer ),
+};
+
+/** "iperf" command descriptor */
+static struct command_descriptor iperf_cmd =
+	COMMAND_DESC ( struct iperf_options, iperf_opts, 1, 1, "<server>" );
+
+/**
+ * The "iperf" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int iperf_exec ( int argc, char **argv ) {
+	struct iperf_options opts;
+	struct iperf_parameters params;
+	const char *hostname;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &iperf_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse hostname */
+	hostname = argv[optind];
+
+	/* Construct test parameters */
+	memset ( &params, 0, sizeof ( params ) );
+	params.port = opts.port;
+	if ( opts.udp )
+		params.flags |= IPERF_FL_UDP;
+	if ( opts.reverse )
+		params.flags |= IPERF_FL_REVERSE;
+	params.duration = opts.time;
+	params.bandwidth = opts.bandwidth;
+	params.len = opts.length;
+
+	/* Run test */
+	if ( ( rc = iperf ( hostname, &params ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/** iperf command */
+struct command iperf_command __command = {
+	.name = "iperf",
+	.exec = iperf_exec,
+};
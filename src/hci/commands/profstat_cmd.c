@@ -24,9 +24,11 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdio.h>
+#include <errno.h>
 #include <getopt.h>
 #include <ipxe/command.h>
 #include <ipxe/parseopt.h>
+#include <ipxe/profile.h>
 #include <usr/profstat.h>
 
 /** @file
@@ -36,14 +38,51 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 /** "profstat" options */
-struct profstat_options {};
+struct profstat_options {
+	/** Reset statistics */
+	int reset;
+	/** Enable profiler */
+	int enable;
+	/** Disable profiler */
+	int disable;
+};
 
 /** "profstat" option list */
-static struct option_descriptor profstat_opts[] = {};
+static struct option_descriptor profstat_opts[] = {
+	OPTION_DESC ( "reset", 'r', no_argument,
+		      struct profstat_options, reset, parse_flag ),
+	OPTION_DESC ( "enable", 'e', no_argument,
+		      struct profstat_options, enable, parse_flag ),
+	OPTION_DESC ( "disable", 'd', no_argument,
+		      struct profstat_options, disable, parse_flag ),
+};
 
 /** "profstat" command descriptor */
 static struct command_descriptor profstat_cmd =
-	COMMAND_DESC ( struct profstat_options, profstat_opts, 0, 0, NULL );
+	COMMAND_DESC ( struct profstat_options, profstat_opts, 0, MAX_ARGUMENTS,
+		       "[<profiler>...]" );
+
+/**
+ * Apply "profstat" command to a profiler
+ *
+ * @v profiler		Profiler
+ * @v opts		Command options
+ */
+static void profstat_apply ( struct profiler *profiler,
+			     struct profstat_options *opts ) {
+
+	/* Display statistics unless another action was requested */
+	if ( ! ( opts->reset || opts->enable || opts->disable ) )
+		profstat_profiler ( profiler );
+
+	/* Enable, disable and reset as applicable */
+	if ( opts->enable )
+		profiler->disabled = 0;
+	if ( opts->disable )
+		profiler->disabled = 1;
+	if ( opts->reset )
+		profile_reset ( profiler );
+}
 
 /**
  * The "profstat" command
@@ -54,13 +93,30 @@ static struct command_descriptor profstat_cmd =
  */
 static int profstat_exec ( int argc, char **argv ) {
 	struct profstat_options opts;
+	struct profiler *profiler;
+	int i;
 	int rc;
 
 	/* Parse options */
 	if ( ( rc = parse_options ( argc, argv, &profstat_cmd, &opts ) ) != 0 )
 		return rc;
 
-	profstat();
+	/* Apply to all profilers, if none are specified */
+	if ( optind == argc ) {
+		for_each_table_entry ( profiler, PROFILERS )
+			profstat_apply ( profiler, &opts );
+		return 0;
+	}
+
+	/* Apply to each specified profiler */
+	for ( i = optind ; i < argc ; i++ ) {
+		profiler = find_profiler ( argv[i] );
+		if ( ! profiler ) {
+			printf ( "No such profiler: %s\n", argv[i] );
+			return -ENOENT;
+		}
+		profstat_apply ( profiler, &opts );
+	}
 
 	return 0;
 }
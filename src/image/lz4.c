@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/rotate.h>
+#include <ipxe/image.h>
+#include <ipxe/lz4.h>
+
+/** @file
+ *
+ * LZ4 compressed images
+ *
+ * This is a decoder for the LZ4 frame format, and for the legacy
+ * frame format as used by the Linux kernel's LZ4 compressed images
+ * and initramfs files.  Dictionaries are not supported.
+ */
+
+/** XXH32 primes */
+#define XXH32_P1 0x9e3779b1U
+#define XXH32_P2 0x85ebca77U
+#define XXH32_P3 0xc2b2ae3dU
+#define XXH32_P4 0x27d4eb2fU
+#define XXH32_P5 0x165667b1U
+
+/**
+ * Read little-endian 32-bit value
+ *
+ * @v data		Data
+ * @ret value		Value
+ */
+static inline uint32_t lz4_le32 ( const uint8_t *data ) {
+
+	return ( ( data[0] << 0 ) | ( data[1] << 8 ) |
+		 ( data[2] << 16 ) | ( ( ( uint32_t ) data[3] ) << 24 ) );
+}
+
+/**
+ * Perform XXH32 accumulator round
+ *
+ * @v acc		Accumulator
+ * @v input		Input lane
+ * @ret acc		Updated accumulator
+ */
+static inline uint32_t xxh32_round ( uint32_t acc, uint32_t input ) {
+
+	acc += ( input * XXH32_P2 );
+	acc = rol32 ( acc, 13 );
+	acc *= XXH32_P1;
+	return acc;
+}
+
+/**
+ * Calculate XXH32 hash (with zero seed)
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret hash		Hash
+ */
+static uint32_t xxh32 ( const uint8_t *data, size_t len ) {
+	uint32_t acc[4];
+	uint32_t hash;
+	size_t remaining = len;
+	unsigned int i;
+
+	/* Process stripes */
+	if ( remaining >= 16 ) {
+		acc[0] = ( XXH32_P1 + XXH32_P2 );
+		acc[1] = XXH32_P2;
+		acc[2] = 0;
+		acc[3] = -XXH32_P1;
+		do {
+			for ( i = 0 ; i < 4 ; i++, data += 4 ) {
+				acc[i] = xxh32_round ( acc[i],
+						       lz4_le32 ( data ) );
+			}
+			remaining -= 16;
+		} while ( remaining >= 16 );
+		hash = ( rol32 ( acc[0], 1 ) + rol32 ( acc[1], 7 ) +
+			 rol32 ( acc[2], 12 ) + rol32 ( acc[3], 18 ) );
+	} else {
+		hash = XXH32_P5;
+	}
+	hash += len;
+
+	/* Process remaining data */
+	for ( ; remaining >= 4 ; data += 4, remaining -= 4 ) {
+		hash += ( lz4_le32 ( data ) * XXH32_P3 );
+		hash = ( rol32 ( hash, 17 ) * XXH32_P4 );
+	}
+	for ( ; remaining ; data++, remaining-- ) {
+		hash += ( *data * XXH32_P5 );
+		hash = ( rol32 ( hash, 11 ) * XXH32_P1 );
+	}
+
+	/* Avalanche */
+	hash ^= ( hash >> 15 );
+	hash *= XXH32_P2;
+	hash ^= ( hash >> 13 );
+	hash *= XXH32_P3;
+	hash ^= ( hash >> 16 );
+
+	return hash;
+}
+
+/**
+ * Write literals to output buffer (if available)
+ *
+ * @v out		Output data buffer
+ * @v data		Literals
+ * @v len		Length of literals
+ */
+static void lz4_copy ( struct deflate_chunk *out, const void *data,
+		       size_t len ) {
+	size_t copy_len;
+
+	if ( out->offset < out->len ) {
+		copy_len = ( out->len - out->offset );
+		if ( copy_len > len )
+			copy_len = len;
+		copy_to_user ( out->data, out->offset, data, copy_len );
+	}
+	out->offset += len;
+}
+
+/**
+ * Copy match to output buffer (if available)
+ *
+ * @v out		Output data buffer
+ * @v offset		Match offset
+ * @v len		Match length
+ */
+static void lz4_match ( struct deflate_chunk *out, size_t offset,
+			size_t len ) {
+	uint8_t *dst;
+	uint8_t *src;
+	size_t copy_len;
+	size_t frag_len;
+
+	if ( out->offset < out->len ) {
+		copy_len = ( out->len - out->offset );
+		if ( copy_len > len )
+			copy_len = len;
+		dst = user_to_virt ( out->data, out->offset );
+		src = ( dst - offset );
+		while ( copy_len ) {
+			frag_len = ( dst - src );
+			if ( frag_len > copy_len )
+				frag_len = copy_len;
+			memcpy ( dst, src, frag_len );
+			dst += frag_len;
+			copy_len -= frag_len;
+		}
+	}
+	out->offset += len;
+}
+
+/**
+ * Parse variable-length extension
+ *
+ * @v data		Data pointer
+ * @v end		End of data
+ * @v len		Length to extend
+ * @ret rc		Return status code
+ */
+static int lz4_extend ( const uint8_t **data, const uint8_t *end,
+			size_t *len ) {
+	uint8_t byte;
+
+	do {
+		if ( *data >= end )
+			return -EINVAL;
+		byte = *((*data)++);
+		*len += byte;
+	} while ( byte == 0xff );
+
+	return 0;
+}
+
+/**
+ * Decompress block
+ *
+ * @v data		Compressed data
+ * @v len		Length of compressed data
+ * @v out		Output data buffer
+ * @v history		Output offset of start of available history
+ * @ret rc		Return status code
+ */
+static int lz4_block ( const uint8_t *data, size_t len,
+		       struct deflate_chunk *out, size_t history ) {
+	const uint8_t *end = ( data + len );
+	unsigned int token;
+	size_t literals;
+	size_t match;
+	size_t offset;
+	int rc;
+
+	while ( data < end ) {
+
+		/* Parse token */
+		token = *(data++);
+
+		/* Copy literals */
+		literals = ( token >> 4 );
+		if ( ( literals == 0x0f ) &&
+		     ( ( rc = lz4_extend ( &data, end, &literals ) ) != 0 ) )
+			return rc;
+		if ( literals > ( ( size_t ) ( end - data ) ) )
+			return -EINVAL;
+		lz4_copy ( out, data, literals );
+		data += literals;
+
+		/* Final sequence has no match */
+		if ( data == end )
+			break;
+
+		/* Parse match */
+		if ( ( end - data ) < 2 )
+			return -EINVAL;
+		offset = ( data[0] | ( data[1] << 8 ) );
+		data += 2;
+		match = ( token & 0x0f );
+		if ( ( match == 0x0f ) &&
+		     ( ( rc = lz4_extend ( &data, end, &match ) ) != 0 ) )
+			return rc;
+		match += LZ4_MIN_MATCH;
+
+		/* Copy match */
+		if ( ( ! offset ) || ( offset > ( out->offset - history ) ) )
+			return -EINVAL;
+		lz4_match ( out, offset, match );
+	}
+
+	return 0;
+}
+
+/**
+ * Decompress frame
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output data buffer
+ * @ret used		Length of frame, or negative error
+ */
+static ssize_t lz4_frame ( const uint8_t *data, size_t len,
+			   struct deflate_chunk *out ) {
+	const uint8_t *start = data;
+	const struct lz4_frame_header *header = ( ( const void * ) data );
+	size_t frame = out->offset;
+	size_t history = frame;
+	size_t header_len;
+	size_t block_len;
+	uint32_t block;
+	uint32_t checksum;
+	int rc;
+
+	/* Parse frame header */
+	if ( len < sizeof ( *header ) )
+		return -EINVAL;
+	if ( ( header->flags & LZ4_FL_VERSION_MASK ) != LZ4_FL_VERSION ) {
+		DBGC ( out, "LZ4 %p unsupported version %#02x\n",
+		       out, header->flags );
+		return -ENOTSUP;
+	}
+	if ( header->flags & LZ4_FL_DICT ) {
+		DBGC ( out, "LZ4 %p dictionaries not supported\n", out );
+		return -ENOTSUP;
+	}
+	header_len = ( sizeof ( *header ) +
+		       ( ( header->flags & LZ4_FL_CONTENT_SIZE ) ? 8 : 0 ) );
+	if ( len < ( header_len + 1 /* header checksum */ ) )
+		return -EINVAL;
+	if ( data[header_len] !=
+	     ( ( xxh32 ( ( data + 4 ), ( header_len - 4 ) ) >> 8 ) & 0xff ) ) {
+		DBGC ( out, "LZ4 %p header checksum mismatch\n", out );
+		return -EINVAL;
+	}
+	data += ( header_len + 1 );
+	len -= ( header_len + 1 );
+
+	/* Decompress blocks */
+	while ( 1 ) {
+
+		/* Parse block header */
+		if ( len < sizeof ( block ) )
+			return -EINVAL;
+		block = lz4_le32 ( data );
+		data += sizeof ( block );
+		len -= sizeof ( block );
+		if ( ! block )
+			break;
+		block_len = ( block & ~LZ4_BLOCK_UNCOMPRESSED );
+		if ( block_len > len )
+			return -EINVAL;
+
+		/* Decompress block */
+		if ( header->flags & LZ4_FL_INDEPENDENT )
+			history = out->offset;
+		if ( block & LZ4_BLOCK_UNCOMPRESSED ) {
+			lz4_copy ( out, data, block_len );
+		} else {
+			if ( ( rc = lz4_block ( data, block_len, out,
+						history ) ) != 0 ) {
+				DBGC ( out, "LZ4 %p invalid block: %s\n",
+				       out, strerror ( rc ) );
+				return rc;
+			}
+		}
+
+		/* Verify block checksum, if present */
+		if ( header->flags & LZ4_FL_BLOCK_CHECKSUM ) {
+			if ( ( len - block_len ) < sizeof ( checksum ) )
+				return -EINVAL;
+			checksum = lz4_le32 ( data + block_len );
+			if ( checksum != xxh32 ( data, block_len ) ) {
+				DBGC ( out, "LZ4 %p block checksum mismatch\n",
+				       out );
+				return -EINVAL;
+			}
+			block_len += sizeof ( checksum );
+		}
+		data += block_len;
+		len -= block_len;
+	}
+
+	/* Verify content checksum, if present and if data is available */
+	if ( header->flags & LZ4_FL_CONTENT_CHECKSUM ) {
+		if ( len < sizeof ( checksum ) )
+			return -EINVAL;
+		checksum = lz4_le32 ( data );
+		data += sizeof ( checksum );
+		len -= sizeof ( checksum );
+		if ( ( out->offset <= out->len ) &&
+		     ( checksum != xxh32 ( user_to_virt ( out->data, frame ),
+					   ( out->offset - frame ) ) ) ) {
+			DBGC ( out, "LZ4 %p content checksum mismatch\n", out );
+			return -EINVAL;
+		}
+	}
+
+	return ( data - start );
+}
+
+/**
+ * Decompress legacy frame
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output data buffer
+ * @ret used		Length of frame, or negative error
+ *
+ * A legacy frame has no end marker, and continues until the end of
+ * the input data or the start of another frame.
+ */
+static ssize_t lz4_legacy ( const uint8_t *data, size_t len,
+			    struct deflate_chunk *out ) {
+	const uint8_t *start = data;
+	size_t block_len;
+	size_t history;
+	uint32_t block;
+	int rc;
+
+	/* Skip magic number */
+	data += sizeof ( block );
+	len -= sizeof ( block );
+
+	/* Decompress blocks */
+	while ( len >= sizeof ( block ) ) {
+
+		/* Parse block header, stopping at start of any new frame */
+		block = lz4_le32 ( data );
+		if ( ( block == LZ4_MAGIC ) || ( block == LZ4_LEGACY_MAGIC ) ||
+		     ( ( block & LZ4_SKIP_MASK ) == LZ4_SKIP_MAGIC ) )
+			break;
+		data += sizeof ( block );
+		len -= sizeof ( block );
+
+		/* Ignore any trailing uncompressed length (as appended
+		 * by the Linux kernel build process).
+		 */
+		if ( ! len )
+			break;
+		block_len = block;
+		if ( block_len > len )
+			return -EINVAL;
+
+		/* Decompress block */
+		history = out->offset;
+		if ( ( rc = lz4_block ( data, block_len, out,
+					history ) ) != 0 ) {
+			DBGC ( out, "LZ4 %p invalid legacy block: %s\n",
+			       out, strerror ( rc ) );
+			return rc;
+		}
+		if ( ( out->offset - history ) > LZ4_LEGACY_BLOCK_MAX ) {
+			DBGC ( out, "LZ4 %p overlength legacy block\n", out );
+			return -EINVAL;
+		}
+		data += block_len;
+		len -= block_len;
+	}
+
+	return ( data - start );
+}
+
+/**
+ * Decompress LZ4 data
+ *
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * The input data may consist of any number of concatenated LZ4,
+ * legacy LZ4, and skippable frames.
+ *
+ * Data will not be written beyond the specified end of the output
+ * data buffer, but the offset within the output data buffer will be
+ * updated to reflect the amount that should have been written.  The
+ * caller can use this to find the length of the decompressed data
+ * before allocating the output data buffer.
+ */
+int lz4_decompress ( struct deflate_chunk *in, struct deflate_chunk *out ) {
+	const uint8_t *data;
+	uint32_t magic;
+	size_t skip;
+	size_t len;
+	ssize_t used;
+
+	/* Decompress frames */
+	while ( in->offset < in->len ) {
+
+		/* Identify frame type */
+		data = user_to_virt ( in->data, in->offset );
+		len = ( in->len - in->offset );
+		if ( len < sizeof ( magic ) )
+			return -EINVAL;
+		magic = lz4_le32 ( data );
+
+		if ( magic == LZ4_MAGIC ) {
+
+			/* Decompress frame */
+			used = lz4_frame ( data, len, out );
+
+		} else if ( magic == LZ4_LEGACY_MAGIC ) {
+
+			/* Decompress legacy frame */
+			used = lz4_legacy ( data, len, out );
+
+		} else if ( ( magic & LZ4_SKIP_MASK ) == LZ4_SKIP_MAGIC ) {
+
+			/* Skip frame */
+			if ( len < 8 )
+				return -EINVAL;
+			skip = lz4_le32 ( data + 4 );
+			if ( skip > ( len - 8 ) )
+				return -EINVAL;
+			used = ( 8 + skip );
+
+		} else {
+
+			DBGC ( out, "LZ4 %p invalid magic %#08x at %#zx\n",
+			       out, magic, in->offset );
+			return -EINVAL;
+		}
+		if ( used < 0 ) {
+			DBGC ( out, "LZ4 %p could not decompress frame at "
+			       "%#zx: %s\n", out, in->offset,
+			       strerror ( used ) );
+			return used;
+		}
+		in->offset += used;
+	}
+
+	return 0;
+}
+
+/**
+ * Extract LZ4 image
+ *
+ * @v image		Image
+ * @v extracted		Extracted image
+ * @ret rc		Return status code
+ */
+static int lz4_extract ( struct image *image, struct image *extracted ) {
+	struct lz4_frame_header header;
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	uint64_t len;
+	int rc;
+
+	/* Presize extracted image using content size of first frame,
+	 * if known.
+	 */
+	copy_from_user ( &header, image->data, 0, sizeof ( header ) );
+	if ( ( header.magic == cpu_to_le32 ( LZ4_MAGIC ) ) &&
+	     ( header.flags & LZ4_FL_CONTENT_SIZE ) &&
+	     ( image->len >= ( sizeof ( header ) + sizeof ( len ) ) ) ) {
+		copy_from_user ( &len, image->data, sizeof ( header ),
+				 sizeof ( len ) );
+		len = le64_to_cpu ( len );
+		if ( ( len == ( ( size_t ) len ) ) &&
+		     ( ( rc = image_set_len ( extracted, len ) ) != 0 ) ) {
+			DBGC ( image, "LZ4 %p could not presize: %s\n",
+			       image, strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	/* Decompress image, (re)allocating if necessary */
+	while ( 1 ) {
+
+		/* Initialise input and output chunks */
+		deflate_chunk_init ( &in, image->data, 0, image->len );
+		deflate_chunk_init ( &out, extracted->data, 0, extracted->len );
+
+		/* Decompress data */
+		if ( ( rc = lz4_decompress ( &in, &out ) ) != 0 ) {
+			DBGC ( image, "LZ4 %p could not decompress: %s\n",
+			       image, strerror ( rc ) );
+			return rc;
+		}
+
+		/* Finish if output image size was correct */
+		if ( out.offset == extracted->len )
+			break;
+
+		/* Otherwise, resize output image and retry */
+		if ( ( rc = image_set_len ( extracted, out.offset ) ) != 0 ) {
+			DBGC ( image, "LZ4 %p could not resize: %s\n",
+			       image, strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Probe LZ4 image
+ *
+ * @v image		LZ4 image
+ * @ret rc		Return status code
+ */
+static int lz4_probe ( struct image *image ) {
+	uint32_t magic;
+
+	/* Sanity check */
+	if ( image->len < sizeof ( magic ) ) {
+		DBGC ( image, "LZ4 %p image too short\n", image );
+		return -ENOEXEC;
+	}
+
+	/* Check magic header */
+	copy_from_user ( &magic, image->data, 0, sizeof ( magic ) );
+	if ( ( magic != cpu_to_le32 ( LZ4_MAGIC ) ) &&
+	     ( magic != cpu_to_le32 ( LZ4_LEGACY_MAGIC ) ) ) {
+		DBGC ( image, "LZ4 %p invalid magic\n", image );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** LZ4 image type */
+struct image_type lz4_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "lz4",
+	.probe = lz4_probe,
+	.extract = lz4_extract,
+	.exec = image_extract_exec,
+};
@@ -352,71 +352,90 @@ static int png_image_data ( struct image *image, struct png_context *png,
 }
 
 /**
- * Unfilter byte using the "None" filter
+ * Unfilter scanline using the "None" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Filtered current scanline (unfiltered in place)
+ * @v above		Unfiltered above scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_none ( unsigned int current,
-					unsigned int left __unused,
-					unsigned int above __unused,
-					unsigned int above_left __unused ) {
+static void png_unfilter_none ( uint8_t *current __unused,
+				const uint8_t *above __unused,
+				size_t len __unused,
+				size_t pixel_len __unused ) {
 
-	return current;
+	/* Nothing to do */
 }
 
 /**
- * Unfilter byte using the "Sub" filter
+ * Unfilter scanline using the "Sub" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Filtered current scanline (unfiltered in place)
+ * @v above		Unfiltered above scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_sub ( unsigned int current,
-				       unsigned int left,
-				       unsigned int above __unused,
-				       unsigned int above_left __unused ) {
+static void png_unfilter_sub ( uint8_t *current,
+			       const uint8_t *above __unused,
+			       size_t len, size_t pixel_len ) {
+	size_t i;
 
-	return ( current + left );
+	for ( i = pixel_len ; i < len ; i++ )
+		current[i] += current[ i - pixel_len ];
 }
 
 /**
- * Unfilter byte using the "Up" filter
+ * Unfilter scanline using the "Up" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Filtered current scanline (unfiltered in place)
+ * @v above		Unfiltered above scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
+ *
+ * The "Up" filter has no dependencies between bytes within a
+ * scanline, so we process a whole word at a time.  The high bit of
+ * each byte is excluded from the addition (to prevent carries from
+ * propagating into the next byte) and then restored via XOR.
  */
-static unsigned int png_unfilter_up ( unsigned int current,
-				      unsigned int left __unused,
-				      unsigned int above,
-				      unsigned int above_left __unused ) {
+static void png_unfilter_up ( uint8_t *current, const uint8_t *above,
+			      size_t len, size_t pixel_len __unused ) {
+	const unsigned long high = ( ( ~0UL / 0xff ) * 0x80 );
+	unsigned long sum;
+	unsigned long add;
+
+	/* Process whole words */
+	for ( ; len >= sizeof ( sum ) ; len -= sizeof ( sum ) ) {
+		memcpy ( &sum, current, sizeof ( sum ) );
+		memcpy ( &add, above, sizeof ( add ) );
+		sum = ( ( ( sum & ~high ) + ( add & ~high ) ) ^
+			( ( sum ^ add ) & high ) );
+		memcpy ( current, &sum, sizeof ( sum ) );
+		current += sizeof ( sum );
+		above += sizeof ( add );
+	}
 
-	return ( current + above );
+	/* Process any trailing bytes */
+	while ( len-- )
+		*(current++) += *(above++);
 }
 
 /**
- * Unfilter byte using the "Average" filter
+ * Unfilter scanline using the "Average" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Filtered current scanline (unfiltered in place)
+ * @v above		Unfiltered above scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_average ( unsigned int current,
-					   unsigned int left,
-					   unsigned int above,
-					   unsigned int above_left __unused ) {
-
-	return ( current + ( ( above + left ) >> 1 ) );
+static void png_unfilter_average ( uint8_t *current, const uint8_t *above,
+				   size_t len, size_t pixel_len ) {
+	size_t i;
+
+	/* Left bytes are taken to be zero for the first pixel */
+	for ( i = 0 ; i < pixel_len ; i++ )
+		current[i] += ( above[i] >> 1 );
+	for ( ; i < len ; i++ )
+		current[i] += ( ( above[i] + current[ i - pixel_len ] ) >> 1 );
 }
 
 /**
@@ -427,8 +446,9 @@ static unsigned int png_unfilter_average ( unsigned int current,
  * @v c			Pixel C
  * @ret predictor	Predictor pixel
  */
-static unsigned int png_paeth_predictor ( unsigned int a, unsigned int b,
-					  unsigned int c ) {
+static inline unsigned int png_paeth_predictor ( unsigned int a,
+						 unsigned int b,
+						 unsigned int c ) {
 	unsigned int p;
 	unsigned int pa;
 	unsigned int pb;
@@ -449,37 +469,41 @@ static unsigned int png_paeth_predictor ( unsigned int a, unsigned int b,
 }
 
 /**
- * Unfilter byte using the "Paeth" filter
+ * Unfilter scanline using the "Paeth" filter
  *
- * @v current		Filtered current byte
- * @v above_left	Unfiltered above-left byte
- * @v above		Unfiltered above byte
- * @v left		Unfiltered left byte
- * @ret current		Unfiltered current byte
+ * @v current		Filtered current scanline (unfiltered in place)
+ * @v above		Unfiltered above scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_paeth ( unsigned int current,
-					 unsigned int left,
-					 unsigned int above,
-					 unsigned int above_left ) {
+static void png_unfilter_paeth ( uint8_t *current, const uint8_t *above,
+				 size_t len, size_t pixel_len ) {
+	size_t i;
 
-	return ( current + png_paeth_predictor ( left, above, above_left ) );
+	/* Left and above-left bytes are taken to be zero for the
+	 * first pixel, in which case the predictor is the above byte.
+	 */
+	for ( i = 0 ; i < pixel_len ; i++ )
+		current[i] += above[i];
+	for ( ; i < len ; i++ ) {
+		current[i] += png_paeth_predictor ( current[ i - pixel_len ],
+						    above[i],
+						    above[ i - pixel_len ] );
+	}
 }
 
 /** A PNG filter */
 struct png_filter {
 	/**
-	 * Unfilter byte
+	 * Unfilter scanline
 	 *
-	 * @v current		Filtered current byte
-	 * @v left		Unfiltered left byte
-	 * @v above		Unfiltered above byte
-	 * @v above_left	Unfiltered above-left byte
-	 * @ret current		Unfiltered current byte
+	 * @v current		Filtered current scanline (unfiltered in place)
+	 * @v above		Unfiltered above scanline
+	 * @v len		Scanline length (excluding filter byte)
+	 * @v pixel_len		Pixel length
 	 */
-	unsigned int ( * unfilter ) ( unsigned int current,
-				      unsigned int left,
-				      unsigned int above,
-				      unsigned int above_left );
+	void ( * unfilter ) ( uint8_t *current, const uint8_t *above,
+			      size_t len, size_t pixel_len );
 };
 
 /** PNG filter types */
@@ -506,20 +530,26 @@ static int png_unfilter_pass ( struct image *image, struct png_context *png,
 			       struct png_interlace *interlace ) {
 	size_t offset = png->raw.offset;
 	size_t pixel_len = png_pixel_len ( png );
-	size_t scanline_len = png_scanline_len ( png, interlace );
+	size_t len = ( png_scanline_len ( png, interlace ) - 1 );
 	struct png_filter *filter;
 	unsigned int scanline;
-	unsigned int byte;
 	uint8_t filter_type;
-	uint8_t left;
-	uint8_t above;
-	uint8_t above_left;
-	uint8_t current;
+	uint8_t *buffer;
+	uint8_t *current;
+	uint8_t *above;
+	uint8_t *tmp;
+
+	/* Allocate buffers for the current and above scanlines */
+	buffer = malloc ( 2 * len );
+	if ( ! buffer )
+		return -ENOMEM;
+	current = buffer;
+	above = ( buffer + len );
 
 	/* On the first scanline of a pass, above bytes are assumed to
 	 * be zero.
 	 */
-	above = 0;
+	memset ( above, 0, len );
 
 	/* Iterate over each scanline in turn */
 	for ( scanline = 0 ; scanline < interlace->height ; scanline++ ) {
@@ -531,6 +561,7 @@ static int png_unfilter_pass ( struct image *image, struct png_context *png,
 				      sizeof ( png_filters[0] ) ) ) {
 			DBGC ( image, "PNG %s unknown filter type %d\n",
 			       image->name, filter_type );
+			free ( buffer );
 			return -ENOTSUP;
 		}
 		filter = &png_filters[filter_type];
@@ -538,46 +569,22 @@ static int png_unfilter_pass ( struct image *image, struct png_context *png,
 		DBGC2 ( image, "PNG %s pass %d scanline %d filter type %d\n",
 			image->name, interlace->pass, scanline, filter_type );
 
-		/* At the start of a line, both above-left and left
-		 * bytes are taken to be zero.
-		 */
-		left = 0;
-		above_left = 0;
+		/* Unfilter scanline */
+		copy_from_user ( current, png->raw.data, offset, len );
+		filter->unfilter ( current, above, len, pixel_len );
+		copy_to_user ( png->raw.data, offset, current, len );
+		offset += len;
 
-		/* Iterate over each byte (not pixel) in turn */
-		for ( byte = 0 ; byte < ( scanline_len - 1 ) ; byte++ ) {
-
-			/* Extract predictor bytes, if applicable */
-			if ( byte >= pixel_len ) {
-				copy_from_user ( &left, png->raw.data,
-						 ( offset - pixel_len ),
-						 sizeof ( left ) );
-			}
-			if ( scanline > 0 ) {
-				copy_from_user ( &above, png->raw.data,
-						 ( offset - scanline_len ),
-						 sizeof ( above ) );
-			}
-			if ( ( scanline > 0 ) && ( byte >= pixel_len ) ) {
-				copy_from_user ( &above_left, png->raw.data,
-						 ( offset - scanline_len -
-						   pixel_len ),
-						 sizeof ( above_left ) );
-			}
-
-			/* Unfilter current byte */
-			copy_from_user ( &current, png->raw.data,
-					 offset, sizeof ( current ) );
-			current = filter->unfilter ( current, left, above,
-						     above_left );
-			copy_to_user ( png->raw.data, offset++,
-				       &current, sizeof ( current ) );
-		}
+		/* Current scanline becomes the above scanline */
+		tmp = above;
+		above = current;
+		current = tmp;
 	}
 
 	/* Update offset */
 	png->raw.offset = offset;
 
+	free ( buffer );
 	return 0;
 }
 
@@ -643,16 +650,19 @@ static inline unsigned int png_pixel ( unsigned int raw, unsigned int alpha,
  * @v image		PNG image
  * @v png		PNG context
  * @v interlace		Interlace pass
+ * @ret rc		Return status code
  *
  * This routine may assume that it is impossible to overrun either the
  * raw data buffer or the pixel buffer, since the sizes of both are
  * determined by the image dimensions.
  */
-static void png_pixels_pass ( struct image *image,
-			      struct png_context *png,
-			      struct png_interlace *interlace ) {
+static int png_pixels_pass ( struct image *image,
+			     struct png_context *png,
+			     struct png_interlace *interlace ) {
 	size_t raw_offset = png->raw.offset;
+	size_t raw_len = ( png_scanline_len ( png, interlace ) - 1 );
 	uint8_t channel[png->channels];
+	uint8_t opaque[256];
 	int is_indexed = ( png->colour_type & PNG_COLOUR_TYPE_PALETTE );
 	int is_rgb = ( png->colour_type & PNG_COLOUR_TYPE_RGB );
 	int has_alpha = ( png->colour_type & PNG_COLOUR_TYPE_ALPHA );
@@ -661,6 +671,10 @@ static void png_pixels_pass ( struct image *image,
 	size_t pixbuf_x_stride;
 	size_t pixbuf_y_stride;
 	size_t raw_stride;
+	size_t i;
+	uint8_t *scanline;
+	uint32_t *pixels;
+	void *buffer;
 	unsigned int y;
 	unsigned int x;
 	unsigned int c;
@@ -673,6 +687,14 @@ static void png_pixels_pass ( struct image *image,
 	uint8_t current = 0;
 	uint32_t pixel;
 
+	/* Allocate buffers for a raw scanline and a row of pixels */
+	buffer = malloc ( ( interlace->width * sizeof ( pixels[0] ) ) +
+			  raw_len );
+	if ( ! buffer )
+		return -ENOMEM;
+	pixels = buffer;
+	scanline = ( buffer + ( interlace->width * sizeof ( pixels[0] ) ) );
+
 	/* We only ever use the top byte of 16-bit pixels.  Model this
 	 * as a bit depth of 8 with a stride of more than one.
 	 */
@@ -682,6 +704,10 @@ static void png_pixels_pass ( struct image *image,
 		depth = 8;
 	max = ( ( 1 << depth ) - 1 );
 
+	/* Precalculate component values for opaque pixels */
+	for ( raw = 0 ; raw <= max ; raw++ )
+		opaque[raw] = png_pixel ( raw, max, max );
+
 	/* Calculate pixel buffer offset and strides */
 	pixbuf_y_offset = ( ( ( interlace->y_indent * png->pixbuf->width ) +
 			      interlace->x_indent ) * sizeof ( pixel ) );
@@ -696,12 +722,14 @@ static void png_pixels_pass ( struct image *image,
 	/* Iterate over each scanline in turn */
 	for ( y = 0 ; y < interlace->height ; y++ ) {
 
-		/* Skip filter byte */
+		/* Skip filter byte and copy raw scanline */
 		raw_offset++;
+		copy_from_user ( scanline, png->raw.data, raw_offset, raw_len );
+		raw_offset += raw_len;
 
 		/* Iterate over each pixel in turn */
 		bits = depth;
-		pixbuf_offset = pixbuf_y_offset;
+		i = 0;
 		for ( x = 0 ; x < interlace->width ; x++ ) {
 
 			/* Extract sample value */
@@ -711,11 +739,8 @@ static void png_pixels_pass ( struct image *image,
 				current <<= depth;
 				bits -= depth;
 				if ( ! bits ) {
-					copy_from_user ( &current,
-							 png->raw.data,
-							 raw_offset,
-							 sizeof ( current ) );
-					raw_offset += raw_stride;
+					current = scanline[i];
+					i += raw_stride;
 					bits = 8;
 				}
 
@@ -729,26 +754,46 @@ static void png_pixels_pass ( struct image *image,
 				/* Indexed */
 				pixel = png->palette[channel[0]];
 
+			} else if ( ! has_alpha ) {
+
+				/* Opaque */
+				pixel = ( ( opaque[ channel[0] ] << 16 ) |
+					  ( opaque[ channel[ is_rgb ? 1 : 0 ] ]
+					    << 8 ) |
+					  ( opaque[ channel[ is_rgb ? 2 : 0 ] ]
+					    << 0 ) );
+
 			} else {
 
 				/* Determine alpha value */
-				alpha = ( has_alpha ?
-					  channel[ png->channels - 1 ] : max );
+				alpha = channel[ png->channels - 1 ];
 
 				/* Convert to RGB value */
 				pixel = 0;
 				for ( c = 0 ; c < 3 ; c++ ) {
-					raw = channel[ is_rgb ? c : 0 ];
-					value = png_pixel ( raw, alpha, max );
+					value = png_pixel ( channel[ is_rgb ?
+								     c : 0 ],
+							    alpha, max );
 					assert ( value <= 255 );
 					pixel = ( ( pixel << 8 ) | value );
 				}
 			}
+			pixels[x] = pixel;
+		}
 
-			/* Store pixel */
-			copy_to_user ( png->pixbuf->data, pixbuf_offset,
-				       &pixel, sizeof ( pixel ) );
-			pixbuf_offset += pixbuf_x_stride;
+		/* Store pixels */
+		if ( interlace->x_stride == 1 ) {
+			copy_to_user ( png->pixbuf->data, pixbuf_y_offset,
+				       pixels, ( interlace->width *
+						 sizeof ( pixels[0] ) ) );
+		} else {
+			pixbuf_offset = pixbuf_y_offset;
+			for ( x = 0 ; x < interlace->width ; x++ ) {
+				copy_to_user ( png->pixbuf->data,
+					       pixbuf_offset, &pixels[x],
+					       sizeof ( pixels[0] ) );
+				pixbuf_offset += pixbuf_x_stride;
+			}
 		}
 
 		/* Move to next output row */
@@ -757,6 +802,9 @@ static void png_pixels_pass ( struct image *image,
 
 	/* Update offset */
 	png->raw.offset = raw_offset;
+
+	free ( buffer );
+	return 0;
 }
 
 /**
@@ -764,14 +812,16 @@ static void png_pixels_pass ( struct image *image,
  *
  * @v image		PNG image
  * @v png		PNG context
+ * @ret rc		Return status code
  *
  * This routine may assume that it is impossible to overrun either the
  * raw data buffer or the pixel buffer, since the sizes of both are
  * determined by the image dimensions.
  */
-static void png_pixels ( struct image *image, struct png_context *png ) {
+static int png_pixels ( struct image *image, struct png_context *png ) {
 	struct png_interlace interlace;
 	unsigned int pass;
+	int rc;
 
 	/* Process each interlace pass */
 	png->raw.offset = 0;
@@ -784,10 +834,14 @@ static void png_pixels ( struct image *image, struct png_context *png ) {
 		if ( interlace.width == 0 )
 			continue;
 
-		/* Unfilter this pass */
-		png_pixels_pass ( image, png, &interlace );
+		/* Fill pixels for this pass */
+		if ( ( rc = png_pixels_pass ( image, png,
+					      &interlace ) ) != 0 )
+			return rc;
 	}
 	assert ( png->raw.offset == png->raw.len );
+
+	return 0;
 }
 
 /**
@@ -830,7 +884,8 @@ static int png_image_end ( struct image *image, struct png_context *png,
 		return rc;
 
 	/* Fill pixel buffer */
-	png_pixels ( image, png );
+	if ( ( rc = png_pixels ( image, png ) ) != 0 )
+		return rc;
 
 	return 0;
 }
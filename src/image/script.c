@@ -31,10 +31,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
+#include <assert.h>
 #include <getopt.h>
 #include <ipxe/command.h>
 #include <ipxe/parseopt.h>
@@ -43,82 +45,175 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <usr/prompt.h>
 #include <ipxe/script.h>
 
-/** Offset within current script
+/** Average number of lines per label hash bucket */
+#define SCRIPT_LINES_PER_BUCKET 4
+
+/** A script line */
+struct script_line {
+	/** Offset within script */
+	size_t offset;
+	/** Label, or NULL */
+	const char *label;
+	/** Command, or NULL if line is incomplete */
+	const char *command;
+	/** Next line in label hash bucket */
+	struct script_line *next;
+};
+
+/** A parsed script */
+struct script {
+	/** Script image */
+	struct image *image;
+	/** Lines */
+	struct script_line *lines;
+	/** Number of lines */
+	unsigned int count;
+	/** Label hash buckets */
+	struct script_line **labels;
+	/** Number of label hash buckets (a power of two) */
+	unsigned int buckets;
+};
+
+/** Currently executing script */
+static struct script *current_script;
+
+/** Index of next line within current script
  *
  * This is a global in order to allow goto_exec() to update the
- * offset.
+ * line.
+ */
+static unsigned int script_line;
+
+/**
+ * Calculate label hash bucket
+ *
+ * @v script		Parsed script
+ * @v label		Label
+ * @ret bucket		Label hash bucket
  */
-static size_t script_offset;
+static struct script_line ** script_label_bucket ( struct script *script,
+						   const char *label ) {
+	unsigned int hash = 0;
+
+	while ( *label )
+		hash = ( ( hash * 31 ) + *(label++) );
+	return &script->labels[ hash & ( script->buckets - 1 ) ];
+}
+
+/**
+ * Find label within script
+ *
+ * @v script		Parsed script
+ * @v label		Label
+ * @ret line		Script line, or NULL if not found
+ */
+static struct script_line * script_find_label ( struct script *script,
+						const char *label ) {
+	struct script_line *line;
+
+	for ( line = *script_label_bucket ( script, label ) ; line ;
+	      line = line->next ) {
+		if ( strcmp ( line->label, label ) == 0 )
+			return line;
+	}
+	return NULL;
+}
 
 /**
- * Process script lines
+ * Parse script
  *
  * @v image		Script
- * @v process_line	Line processor
- * @v terminate		Termination check
+ * @v parsed		Parsed script to fill in
  * @ret rc		Return status code
+ *
+ * The script is split into lines (joining any backslash
+ * continuations), and each line is split into an optional label and
+ * a command.  The caller is responsible for eventually freeing the
+ * parsed script.
  */
-static int process_script ( struct image *image,
-			    int ( * process_line ) ( struct image *image,
-						     size_t offset,
-						     const char *label,
-						     const char *command ),
-			    int ( * terminate ) ( int rc ) ) {
-	size_t len = 0;
-	char *line = NULL;
+static int script_parse ( struct image *image, struct script **parsed ) {
+	struct script *script;
+	struct script_line *line;
+	struct script_line **bucket;
+	unsigned int max_lines;
+	unsigned int buckets;
+	unsigned int i;
 	size_t line_offset;
+	size_t offset;
+	size_t frag_len;
+	size_t len;
+	int incomplete;
+	char *text;
+	char *eol;
+	char *line_text;
 	char *label;
 	char *command;
-	off_t eol;
-	size_t frag_len;
-	char *tmp;
-	int rc;
-
-	/* Initialise script and line offsets */
-	script_offset = 0;
+	off_t nl;
+
+	/* Count maximum number of lines */
+	max_lines = 1;
+	for ( offset = 0 ; ( nl = memchr_user ( image->data, offset, '\n',
+						( image->len - offset ) ) ) >= 0 ;
+	      offset = ( nl + 1 ) ) {
+		max_lines++;
+	}
+	buckets = ( 1 << fls ( max_lines / SCRIPT_LINES_PER_BUCKET ) );
+
+	/* Allocate and initialise structure */
+	script = zalloc ( sizeof ( *script ) +
+			  ( max_lines * sizeof ( script->lines[0] ) ) +
+			  ( buckets * sizeof ( script->labels[0] ) ) +
+			  image->len + 1 /* NUL */ );
+	if ( ! script )
+		return -ENOMEM;
+	script->image = image;
+	script->lines = ( ( void * ) ( script + 1 ) );
+	script->labels = ( ( void * ) ( script->lines + max_lines ) );
+	script->buckets = buckets;
+	text = ( ( void * ) ( script->labels + buckets ) );
+	copy_from_user ( text, image->data, 0, image->len );
+
+	/* Split script into lines.  Lines are reassembled in place:
+	 * each line is never longer than the portion of the script
+	 * from which it was constructed.
+	 */
+	line_text = text;
 	line_offset = 0;
-
+	offset = 0;
+	len = 0;
+	incomplete = 0;
 	do {
 
 		/* Find length of next line, excluding any terminating '\n' */
-		eol = memchr_user ( image->data, script_offset, '\n',
-				    ( image->len - script_offset ) );
-		if ( eol < 0 )
-			eol = image->len;
-		frag_len = ( eol - script_offset );
-
-		/* Allocate buffer for line */
-		tmp = realloc ( line, ( len + frag_len + 1 /* NUL */ ) );
-		if ( ! tmp ) {
-			rc = -ENOMEM;
-			goto err_alloc;
-		}
-		line = tmp;
+		eol = memchr ( ( text + offset ), '\n',
+			       ( image->len - offset ) );
+		frag_len = ( eol ? ( ( size_t ) ( eol - ( text + offset ) ) ) :
+			     ( image->len - offset ) );
 
-		/* Copy line */
-		copy_from_user ( ( line + len ), image->data, script_offset,
-				 frag_len );
+		/* Append line fragment */
+		memmove ( ( line_text + len ), ( text + offset ), frag_len );
 		len += frag_len;
 
 		/* Move to next line in script */
-		script_offset += ( frag_len + 1 );
+		offset += ( frag_len + 1 );
 
 		/* Strip trailing CR, if present */
-		if ( len && ( line[ len - 1 ] == '\r' ) )
+		if ( len && ( line_text[ len - 1 ] == '\r' ) )
 			len--;
 
 		/* Handle backslash continuations */
-		if ( len && ( line[ len - 1 ] == '\\' ) ) {
+		if ( len && ( line_text[ len - 1 ] == '\\' ) ) {
 			len--;
-			rc = -EINVAL;
+			incomplete = 1;
 			continue;
 		}
+		incomplete = 0;
 
 		/* Terminate line */
-		line[len] = '\0';
+		line_text[len] = '\0';
 
 		/* Split line into (optional) label and command */
-		command = line;
+		command = line_text;
 		while ( isspace ( *command ) )
 			command++;
 		if ( *command == ':' ) {
@@ -131,25 +226,41 @@ static int process_script ( struct image *image,
 			label = NULL;
 		}
 
-		/* Process line */
-		rc = process_line ( image, line_offset, label, command );
-		if ( terminate ( rc ) )
-			goto err_process;
+		/* Record line */
+		line = &script->lines[ script->count++ ];
+		line->offset = line_offset;
+		line->label = label;
+		line->command = command;
 
-		/* Free line */
-		free ( line );
-		line = NULL;
+		/* Move to next line */
+		line_text += ( len + 1 );
 		len = 0;
+		line_offset = offset;
 
-		/* Update line offset */
-		line_offset = script_offset;
+	} while ( offset < image->len );
 
-	} while ( script_offset < image->len );
+	/* Record incomplete final line, if applicable */
+	if ( incomplete ) {
+		line = &script->lines[ script->count++ ];
+		line->offset = line_offset;
+	}
+	assert ( script->count <= max_lines );
 
- err_process:
- err_alloc:
-	free ( line );
-	return rc;
+	/* Index labels.  Lines are added in reverse order, so that the
+	 * first occurrence of any duplicated label takes precedence.
+	 */
+	for ( i = script->count ; i-- ; ) {
+		line = &script->lines[i];
+		if ( ! line->label )
+			continue;
+		bucket = script_label_bucket ( script, line->label );
+		line->next = *bucket;
+		*bucket = line;
+	}
+
+	DBGC ( image, "Parsed %d lines\n", script->count );
+	*parsed = script;
+	return 0;
 }
 
 /**
@@ -168,20 +279,23 @@ static int terminate_on_exit_or_failure ( int rc ) {
  * Execute script line
  *
  * @v image		Script
- * @v offset		Offset within script
- * @v label		Label, or NULL
- * @v command		Command
+ * @v line		Script line
  * @ret rc		Return status code
  */
-static int script_exec_line ( struct image *image, size_t offset,
-			      const char *label __unused,
-			      const char *command ) {
+static int script_exec_line ( struct image *image,
+			      struct script_line *line ) {
 	int rc;
 
-	DBGC ( image, "[%04zx] $ %s\n", offset, command );
+	/* Fail if line is incomplete */
+	if ( ! line->command ) {
+		DBGC ( image, "[%04zx] Incomplete line\n", line->offset );
+		return -EINVAL;
+	}
+
+	DBGC ( image, "[%04zx] $ %s\n", line->offset, line->command );
 
 	/* Execute command */
-	if ( ( rc = system ( command ) ) != 0 )
+	if ( ( rc = system ( line->command ) ) != 0 )
 		return rc;
 
 	return 0;
@@ -194,7 +308,10 @@ static int script_exec_line ( struct image *image, size_t offset,
  * @ret rc		Return status code
  */
 static int script_exec ( struct image *image ) {
-	size_t saved_offset;
+	struct script *saved_script;
+	unsigned int saved_line;
+	struct script *script;
+	struct script_line *line;
 	int rc;
 
 	/* Temporarily de-register image, so that a "boot" command
@@ -203,14 +320,29 @@ static int script_exec ( struct image *image ) {
 	unregister_image ( image );
 
 	/* Preserve state of any currently-running script */
-	saved_offset = script_offset;
+	saved_script = current_script;
+	saved_line = script_line;
+
+	/* Parse script */
+	if ( ( rc = script_parse ( image, &script ) ) != 0 )
+		goto err_parse;
+	current_script = script;
+
+	/* Execute script lines */
+	for ( script_line = 0 ; script_line < script->count ; ) {
+		line = &script->lines[ script_line++ ];
+		rc = script_exec_line ( image, line );
+		if ( terminate_on_exit_or_failure ( rc ) )
+			break;
+	}
 
-	/* Process script */
-	rc = process_script ( image, script_exec_line,
-			      terminate_on_exit_or_failure );
+	/* Free parsed script */
+	free ( script );
 
+ err_parse:
 	/* Restore saved state */
-	script_offset = saved_offset;
+	current_script = saved_script;
+	script_line = saved_line;
 
 	/* Re-register image (unless we have been replaced) */
 	if ( ! image->replacement )
@@ -268,50 +400,6 @@ static struct option_descriptor goto_opts[] = {};
 static struct command_descriptor goto_cmd =
 	COMMAND_DESC ( struct goto_options, goto_opts, 1, 1, "<label>" );
 
-/**
- * Current "goto" label
- *
- * Valid only during goto_exec().  Consider this part of a closure.
- */
-static const char *goto_label;
-
-/**
- * Check for presence of label
- *
- * @v image		Script
- * @v offset		Offset within script
- * @v label		Label
- * @v command		Command
- * @ret rc		Return status code
- */
-static int goto_find_label ( struct image *image, size_t offset,
-			     const char *label, const char *command __unused ) {
-
-	/* Check label exists */
-	if ( ! label )
-		return -ENOENT;
-
-	/* Check label matches */
-	if ( strcmp ( goto_label, label ) != 0 )
-		return -ENOENT;
-
-	/* Update script offset */
-	script_offset = offset;
-	DBGC ( image, "[%04zx] Gone to :%s\n", offset, label );
-
-	return 0;
-}
-
-/**
- * Terminate script processing when label is found
- *
- * @v rc		Line processing status
- * @ret terminate	Terminate script processing
- */
-static int terminate_on_label_found ( int rc ) {
-	return ( rc == 0 );
-}
-
 /**
  * "goto" command
  *
@@ -321,7 +409,8 @@ static int terminate_on_label_found ( int rc ) {
  */
 static int goto_exec ( int argc, char **argv ) {
 	struct goto_options opts;
-	size_t saved_offset;
+	struct script_line *line;
+	const char *label;
 	int rc;
 
 	/* Parse options */
@@ -329,25 +418,27 @@ static int goto_exec ( int argc, char **argv ) {
 		return rc;
 
 	/* Sanity check */
-	if ( ! current_image ) {
+	if ( ! ( current_image && current_script ) ) {
 		rc = -ENOTTY;
 		printf ( "Not in a script: %s\n", strerror ( rc ) );
 		return rc;
 	}
 
 	/* Parse label */
-	goto_label = argv[optind];
+	label = argv[optind];
 
 	/* Find label */
-	saved_offset = script_offset;
-	if ( ( rc = process_script ( current_image, goto_find_label,
-				     terminate_on_label_found ) ) != 0 ) {
-		script_offset = saved_offset;
+	line = script_find_label ( current_script, label );
+	if ( ! line ) {
 		DBGC ( current_image, "[%04zx] No such label :%s\n",
-		       script_offset, goto_label );
-		return rc;
+		       current_script->lines[ script_line - 1 ].offset, label );
+		return -ENOENT;
 	}
 
+	/* Continue execution from label */
+	script_line = ( line - current_script->lines );
+	DBGC ( current_image, "[%04zx] Gone to :%s\n", line->offset, label );
+
 	/* Terminate processing of current command */
 	shell_stop ( SHELL_STOP_COMMAND );
 
@@ -0,0 +1,1485 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/rotate.h>
+#include <ipxe/image.h>
+#include <ipxe/zstd.h>
+
+/** @file
+ *
+ * Zstandard compressed images
+ *
+ * This is a decoder for the Zstandard compression format as
+ * documented in RFC 8878.  Dictionaries are not supported.
+ *
+ * Since the decompressed data is always written to a single
+ * contiguous output buffer, the whole of the decompressed frame is
+ * available as history and there is no need to maintain a separate
+ * window buffer.
+ */
+
+/** A backward bitstream */
+struct zstd_bits {
+	/** Data */
+	const uint8_t *data;
+	/** Current bit offset (may become negative at end of stream) */
+	int offset;
+};
+
+/** Literal length code baselines */
+static const uint32_t zstd_ll_base[ZSTD_LL_CODES] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512,
+	1024, 2048, 4096, 8192, 16384, 32768, 65536,
+};
+
+/** Literal length code extra bits */
+static const uint8_t zstd_ll_bits[ZSTD_LL_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16,
+};
+
+/** Match length code baselines */
+static const uint32_t zstd_ml_base[ZSTD_ML_CODES] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515,
+	1027, 2051, 4099, 8195, 16387, 32771, 65539,
+};
+
+/** Match length code extra bits */
+static const uint8_t zstd_ml_bits[ZSTD_ML_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16,
+};
+
+/** Predefined literal length distribution */
+static const int16_t zstd_ll_default[ZSTD_LL_CODES] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1,
+};
+
+/** Predefined literal length distribution accuracy log */
+#define ZSTD_LL_DEFAULT_LOG 6
+
+/** Predefined match length distribution */
+static const int16_t zstd_ml_default[ZSTD_ML_CODES] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1,
+};
+
+/** Predefined match length distribution accuracy log */
+#define ZSTD_ML_DEFAULT_LOG 6
+
+/** Predefined offset distribution */
+static const int16_t zstd_of_default[] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+/** Predefined offset distribution accuracy log */
+#define ZSTD_OF_DEFAULT_LOG 5
+
+/** Frame content size field lengths */
+static const uint8_t zstd_fcs_len[4] = { 0, 2, 4, 8 };
+
+/** Dictionary ID field lengths */
+static const uint8_t zstd_dict_len[4] = { 0, 1, 2, 4 };
+
+/** XXH64 primes */
+#define XXH64_P1 0x9e3779b185ebca87ULL
+#define XXH64_P2 0xc2b2ae3d27d4eb4fULL
+#define XXH64_P3 0x165667b19e3779f9ULL
+#define XXH64_P4 0x85ebca77c2b2ae63ULL
+#define XXH64_P5 0x27d4eb2f165667c5ULL
+
+/**
+ * Read little-endian value
+ *
+ * @v data		Data
+ * @v len		Length of value
+ * @ret value		Value
+ */
+static inline uint64_t zstd_le ( const uint8_t *data, unsigned int len ) {
+	uint64_t value = 0;
+
+	while ( len-- )
+		value = ( ( value << 8 ) | data[len] );
+	return value;
+}
+
+/**
+ * Perform XXH64 accumulator round
+ *
+ * @v acc		Accumulator
+ * @v input		Input lane
+ * @ret acc		Updated accumulator
+ */
+static inline uint64_t xxh64_round ( uint64_t acc, uint64_t input ) {
+
+	acc += ( input * XXH64_P2 );
+	acc = rol64 ( acc, 31 );
+	acc *= XXH64_P1;
+	return acc;
+}
+
+/**
+ * Merge XXH64 accumulator
+ *
+ * @v hash		Hash
+ * @v acc		Accumulator
+ * @ret hash		Updated hash
+ */
+static inline uint64_t xxh64_merge ( uint64_t hash, uint64_t acc ) {
+
+	hash ^= xxh64_round ( 0, acc );
+	return ( ( hash * XXH64_P1 ) + XXH64_P4 );
+}
+
+/**
+ * Calculate XXH64 hash (with zero seed)
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret hash		Hash
+ */
+static uint64_t xxh64 ( const uint8_t *data, size_t len ) {
+	uint64_t acc[4];
+	uint64_t hash;
+	size_t remaining = len;
+	unsigned int i;
+
+	/* Process stripes */
+	if ( remaining >= 32 ) {
+		acc[0] = ( XXH64_P1 + XXH64_P2 );
+		acc[1] = XXH64_P2;
+		acc[2] = 0;
+		acc[3] = -XXH64_P1;
+		do {
+			for ( i = 0 ; i < 4 ; i++, data += 8 ) {
+				acc[i] = xxh64_round ( acc[i],
+						       zstd_le ( data, 8 ) );
+			}
+			remaining -= 32;
+		} while ( remaining >= 32 );
+		hash = ( rol64 ( acc[0], 1 ) + rol64 ( acc[1], 7 ) +
+			 rol64 ( acc[2], 12 ) + rol64 ( acc[3], 18 ) );
+		hash = xxh64_merge ( hash, acc[0] );
+		hash = xxh64_merge ( hash, acc[1] );
+		hash = xxh64_merge ( hash, acc[2] );
+		hash = xxh64_merge ( hash, acc[3] );
+	} else {
+		hash = XXH64_P5;
+	}
+	hash += len;
+
+	/* Process remaining data */
+	for ( ; remaining >= 8 ; data += 8, remaining -= 8 ) {
+		hash ^= xxh64_round ( 0, zstd_le ( data, 8 ) );
+		hash = ( ( rol64 ( hash, 27 ) * XXH64_P1 ) + XXH64_P4 );
+	}
+	if ( remaining >= 4 ) {
+		hash ^= ( zstd_le ( data, 4 ) * XXH64_P1 );
+		hash = ( ( rol64 ( hash, 23 ) * XXH64_P2 ) + XXH64_P3 );
+		data += 4;
+		remaining -= 4;
+	}
+	for ( ; remaining ; data++, remaining-- ) {
+		hash ^= ( *data * XXH64_P5 );
+		hash = ( rol64 ( hash, 11 ) * XXH64_P1 );
+	}
+
+	/* Avalanche */
+	hash ^= ( hash >> 33 );
+	hash *= XXH64_P2;
+	hash ^= ( hash >> 29 );
+	hash *= XXH64_P3;
+	hash ^= ( hash >> 32 );
+
+	return hash;
+}
+
+/**
+ * Initialise backward bitstream
+ *
+ * @v bits		Bitstream
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int zstd_bits_init ( struct zstd_bits *bits, const uint8_t *data,
+			    size_t len ) {
+	uint8_t last;
+
+	/* Final byte must contain the end-of-stream marker bit */
+	if ( ! len )
+		return -EINVAL;
+	last = data[ len - 1 ];
+	if ( ! last )
+		return -EINVAL;
+
+	/* Start immediately below the marker bit */
+	bits->data = data;
+	bits->offset = ( ( 8 * len ) - 9 + fls ( last ) );
+	return 0;
+}
+
+/**
+ * Read bits from backward bitstream
+ *
+ * @v bits		Bitstream
+ * @v count		Number of bits to read (at most 31)
+ * @ret value		Value
+ *
+ * Bits read from beyond the start of the stream are zero.
+ */
+static inline uint32_t zstd_bits ( struct zstd_bits *bits,
+				   unsigned int count ) {
+	const uint8_t *data;
+	unsigned int shift = 0;
+	unsigned int skip;
+	uint64_t value;
+	int offset;
+
+	/* Calculate offset */
+	if ( ! count )
+		return 0;
+	bits->offset -= count;
+	offset = bits->offset;
+	if ( offset < 0 ) {
+		if ( ( offset + ( ( int ) count ) ) <= 0 )
+			return 0;
+		shift = -offset;
+		count -= shift;
+		offset = 0;
+	}
+
+	/* Extract bits */
+	data = &bits->data[ offset / 8 ];
+	skip = ( offset % 8 );
+	value = zstd_le ( data, ( ( skip + count + 7 ) / 8 ) );
+	value = ( ( value >> skip ) & ( ( 1UL << count ) - 1 ) );
+	return ( value << shift );
+}
+
+/**
+ * Read bits from forward bitstream
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v offset		Bit offset
+ * @v count		Number of bits to read
+ * @ret value		Value
+ *
+ * Bits beyond the end of the data are zero.
+ */
+static unsigned int zstd_forward_bits ( const uint8_t *data, size_t len,
+					size_t offset, unsigned int count ) {
+	unsigned int value = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < count ; i++, offset++ ) {
+		if ( ( offset / 8 ) >= len )
+			break;
+		if ( data[ offset / 8 ] & ( 1 << ( offset % 8 ) ) )
+			value |= ( 1 << i );
+	}
+	return value;
+}
+
+/**
+ * Construct FSE decoding table
+ *
+ * @v fse		FSE table
+ * @v norm		Normalised probabilities
+ * @v count		Number of symbols
+ * @v log		Accuracy log
+ * @ret rc		Return status code
+ */
+static int zstd_fse_build ( struct zstd_fse *fse, const int16_t *norm,
+			    unsigned int count, unsigned int log ) {
+	uint16_t next[ZSTD_FSE_MAX_SYMBOLS];
+	struct zstd_fse_entry *entry;
+	unsigned int size = ( 1 << log );
+	unsigned int mask = ( size - 1 );
+	unsigned int step = ( ( size >> 1 ) + ( size >> 3 ) + 3 );
+	unsigned int high = size;
+	unsigned int pos = 0;
+	unsigned int symbol;
+	unsigned int state;
+	unsigned int bits;
+	int i;
+
+	/* Sanity checks */
+	assert ( log <= ZSTD_FSE_MAX_LOG );
+	assert ( count <= ZSTD_FSE_MAX_SYMBOLS );
+	fse->log = log;
+
+	/* Place "less than one" probability symbols at end of table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( norm[symbol] == -1 ) {
+			fse->entry[--high].symbol = symbol;
+			next[symbol] = 1;
+		}
+	}
+
+	/* Spread remaining symbols through table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( norm[symbol] <= 0 )
+			continue;
+		next[symbol] = norm[symbol];
+		for ( i = 0 ; i < norm[symbol] ; i++ ) {
+			fse->entry[pos].symbol = symbol;
+			do {
+				pos = ( ( pos + step ) & mask );
+			} while ( pos >= high );
+		}
+	}
+	if ( pos != 0 )
+		return -EINVAL;
+
+	/* Calculate state transitions */
+	for ( state = 0 ; state < size ; state++ ) {
+		entry = &fse->entry[state];
+		i = next[entry->symbol]++;
+		bits = ( log + 1 - fls ( i ) );
+		entry->bits = bits;
+		entry->base = ( ( i << bits ) - size );
+	}
+
+	return 0;
+}
+
+/**
+ * Construct single-symbol FSE decoding table
+ *
+ * @v fse		FSE table
+ * @v symbol		Symbol
+ */
+static void zstd_fse_rle ( struct zstd_fse *fse, unsigned int symbol ) {
+
+	fse->log = 0;
+	fse->entry[0].symbol = symbol;
+	fse->entry[0].bits = 0;
+	fse->entry[0].base = 0;
+}
+
+/**
+ * Parse FSE table description
+ *
+ * @v fse		FSE table
+ * @v data		Data
+ * @v len		Length of data
+ * @v max_log		Maximum accuracy log
+ * @v max_count		Maximum number of symbols
+ * @ret used		Length of description, or negative error
+ */
+static int zstd_fse_parse ( struct zstd_fse *fse, const uint8_t *data,
+			    size_t len, unsigned int max_log,
+			    unsigned int max_count ) {
+	int16_t norm[ZSTD_FSE_MAX_SYMBOLS];
+	unsigned int threshold;
+	unsigned int lower;
+	unsigned int count = 0;
+	unsigned int repeat;
+	unsigned int value;
+	unsigned int bits;
+	unsigned int log;
+	unsigned int i;
+	size_t offset = 0;
+	int remaining;
+	int prob;
+	int rc;
+
+	/* Parse accuracy log */
+	log = ( zstd_forward_bits ( data, len, offset, 4 ) + 5 );
+	offset += 4;
+	if ( log > max_log )
+		return -EINVAL;
+
+	/* Parse probabilities */
+	remaining = ( 1 << log );
+	while ( remaining > 0 ) {
+
+		/* Check symbol count */
+		if ( count >= max_count )
+			return -EINVAL;
+
+		/* Parse variable-length value */
+		bits = fls ( remaining + 1 );
+		value = zstd_forward_bits ( data, len, offset, bits );
+		lower = ( ( 1 << ( bits - 1 ) ) - 1 );
+		threshold = ( ( 1 << bits ) - 1 - ( remaining + 1 ) );
+		if ( ( value & lower ) < threshold ) {
+			value &= lower;
+			bits--;
+		} else if ( value > lower ) {
+			value -= threshold;
+		}
+		offset += bits;
+
+		/* Record probability */
+		prob = ( value - 1 );
+		remaining -= ( ( prob < 0 ) ? -prob : prob );
+		norm[count++] = prob;
+
+		/* Parse zero repeat flags */
+		if ( prob == 0 ) {
+			do {
+				repeat = zstd_forward_bits ( data, len,
+							     offset, 2 );
+				offset += 2;
+				if ( ( count + repeat ) > max_count )
+					return -EINVAL;
+				for ( i = 0 ; i < repeat ; i++ )
+					norm[count++] = 0;
+			} while ( repeat == 3 );
+		}
+	}
+	if ( remaining != 0 )
+		return -EINVAL;
+
+	/* Check length */
+	offset = ( ( offset + 7 ) / 8 );
+	if ( offset > len )
+		return -EINVAL;
+
+	/* Construct decoding table */
+	if ( ( rc = zstd_fse_build ( fse, norm, count, log ) ) != 0 )
+		return rc;
+
+	return offset;
+}
+
+/**
+ * Initialise FSE state
+ *
+ * @v fse		FSE table
+ * @v bits		Bitstream
+ * @ret state		State
+ */
+static inline unsigned int zstd_fse_init ( struct zstd_fse *fse,
+					   struct zstd_bits *bits ) {
+
+	return zstd_bits ( bits, fse->log );
+}
+
+/**
+ * Update FSE state
+ *
+ * @v fse		FSE table
+ * @v state		State
+ * @v bits		Bitstream
+ * @ret state		New state
+ */
+static inline unsigned int zstd_fse_update ( struct zstd_fse *fse,
+					     unsigned int state,
+					     struct zstd_bits *bits ) {
+	struct zstd_fse_entry *entry = &fse->entry[state];
+
+	return ( entry->base + zstd_bits ( bits, entry->bits ) );
+}
+
+/**
+ * Construct Huffman decoding table
+ *
+ * @v huffman		Huffman table
+ * @v weights		Symbol weights (with space for implied final weight)
+ * @v count		Number of explicit weights
+ * @ret rc		Return status code
+ */
+static int zstd_huffman_build ( struct zstd_huffman *huffman,
+				uint8_t *weights, unsigned int count ) {
+	unsigned int ranks[ ZSTD_HUFFMAN_MAX_BITS + 1 ];
+	unsigned int index[ ZSTD_HUFFMAN_MAX_BITS + 1 ];
+	struct zstd_huffman_entry *entry;
+	unsigned int remaining;
+	unsigned int total = 0;
+	unsigned int symbol;
+	unsigned int weight;
+	unsigned int bits;
+	unsigned int max;
+	unsigned int len;
+
+	/* Calculate total weight */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		weight = weights[symbol];
+		if ( weight > ZSTD_HUFFMAN_MAX_BITS )
+			return -EINVAL;
+		if ( weight )
+			total += ( 1 << ( weight - 1 ) );
+	}
+	if ( ! total )
+		return -EINVAL;
+
+	/* Calculate maximum code length and implied final weight */
+	max = fls ( total );
+	if ( max > ZSTD_HUFFMAN_MAX_BITS )
+		return -EINVAL;
+	remaining = ( ( 1 << max ) - total );
+	if ( remaining & ( remaining - 1 ) )
+		return -EINVAL;
+	weights[count++] = fls ( remaining );
+	huffman->bits = max;
+
+	/* Count symbols of each code length */
+	memset ( ranks, 0, sizeof ( ranks ) );
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( weights[symbol] )
+			ranks[ max + 1 - weights[symbol] ]++;
+	}
+
+	/* Calculate starting index for each code length */
+	index[max] = 0;
+	for ( bits = max ; bits > 0 ; bits-- ) {
+		index[ bits - 1 ] = ( index[bits] +
+				      ( ranks[bits] << ( max - bits ) ) );
+	}
+
+	/* Populate table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( ! weights[symbol] )
+			continue;
+		bits = ( max + 1 - weights[symbol] );
+		len = ( 1 << ( max - bits ) );
+		entry = &huffman->entry[ index[bits] ];
+		index[bits] += len;
+		while ( len-- ) {
+			entry->symbol = symbol;
+			entry->bits = bits;
+			entry++;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Parse Huffman tree description
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @ret used		Length of description, or negative error
+ */
+static int zstd_huffman_parse ( struct zstd *zstd, const uint8_t *data,
+				size_t len ) {
+	uint8_t weights[256];
+	struct zstd_bits bits;
+	unsigned int state[2];
+	unsigned int count;
+	unsigned int which;
+	unsigned int i;
+	size_t used;
+	int fse_len;
+	int rc;
+
+	/* Parse header byte */
+	if ( ! len )
+		return -EINVAL;
+	used = data[0];
+	data++;
+	len--;
+
+	if ( used >= 128 ) {
+
+		/* Weights are stored directly as 4-bit values */
+		count = ( used - 127 );
+		used = ( ( count + 1 ) / 2 );
+		if ( used > len )
+			return -EINVAL;
+		for ( i = 0 ; i < count ; i++ ) {
+			weights[i] = ( ( i & 1 ) ? ( data[ i / 2 ] & 0x0f ) :
+				       ( data[ i / 2 ] >> 4 ) );
+		}
+
+	} else {
+
+		/* Weights are FSE compressed */
+		if ( used > len )
+			return -EINVAL;
+		fse_len = zstd_fse_parse ( &zstd->weights, data, used,
+					   ZSTD_WEIGHTS_MAX_LOG,
+					   ( ZSTD_HUFFMAN_MAX_BITS + 1 ) );
+		if ( fse_len < 0 )
+			return fse_len;
+		if ( ( rc = zstd_bits_init ( &bits, ( data + fse_len ),
+					     ( used - fse_len ) ) ) != 0 )
+			return rc;
+
+		/* Decode using two interleaved states */
+		state[0] = zstd_fse_init ( &zstd->weights, &bits );
+		state[1] = zstd_fse_init ( &zstd->weights, &bits );
+		for ( count = 0, which = 0 ; ; which ^= 1 ) {
+			if ( count >= ( sizeof ( weights ) - 1 ) )
+				return -EINVAL;
+			weights[count++] =
+				zstd->weights.entry[ state[which] ].symbol;
+			state[which] = zstd_fse_update ( &zstd->weights,
+							 state[which], &bits );
+			if ( bits.offset < 0 ) {
+				which ^= 1;
+				weights[count++] = zstd->weights.entry
+					[ state[which] ].symbol;
+				break;
+			}
+		}
+	}
+
+	/* Check that implied final weight will fit */
+	if ( count >= sizeof ( weights ) )
+		return -EINVAL;
+
+	/* Construct decoding table */
+	if ( ( rc = zstd_huffman_build ( &zstd->huffman, weights,
+					 count ) ) != 0 )
+		return rc;
+	zstd->have_huffman = 1;
+
+	return ( 1 /* header byte */ + used );
+}
+
+/**
+ * Decode Huffman stream
+ *
+ * @v huffman		Huffman table
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output buffer
+ * @v count		Number of symbols to decode
+ * @ret rc		Return status code
+ */
+static int zstd_huffman_decode ( struct zstd_huffman *huffman,
+				 const uint8_t *data, size_t len,
+				 uint8_t *out, size_t count ) {
+	struct zstd_huffman_entry *entry;
+	unsigned int mask = ( ( 1 << huffman->bits ) - 1 );
+	struct zstd_bits bits;
+	unsigned int state;
+	int rc;
+
+	/* Initialise bitstream */
+	if ( ( rc = zstd_bits_init ( &bits, data, len ) ) != 0 )
+		return rc;
+	state = zstd_bits ( &bits, huffman->bits );
+
+	/* Decode symbols */
+	while ( count-- ) {
+		entry = &huffman->entry[state];
+		*(out++) = entry->symbol;
+		state = ( ( ( state << entry->bits ) |
+			    zstd_bits ( &bits, entry->bits ) ) & mask );
+	}
+
+	/* Check that stream was consumed exactly */
+	if ( bits.offset != -( ( int ) huffman->bits ) )
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * Parse literals section
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @ret used		Length of literals section, or negative error
+ */
+static int zstd_literals ( struct zstd *zstd, const uint8_t *data,
+			   size_t len ) {
+	unsigned int type;
+	unsigned int format;
+	unsigned int header_len;
+	unsigned int size_bits;
+	unsigned int streams;
+	size_t regen_len;
+	size_t comp_len;
+	size_t stream_len[4];
+	size_t stream_regen;
+	uint64_t header;
+	uint8_t *out;
+	unsigned int i;
+	int tree_len = 0;
+	int used;
+	int rc;
+
+	/* Parse header */
+	if ( ! len )
+		return -EINVAL;
+	type = ( data[0] & 0x03 );
+	format = ( ( data[0] >> 2 ) & 0x03 );
+	switch ( type ) {
+
+	case ZSTD_LITERALS_RAW:
+	case ZSTD_LITERALS_RLE:
+		header_len = ( ( format == 1 ) ? 2 : ( ( format == 3 ) ? 3 : 1 ));
+		if ( header_len > len )
+			return -EINVAL;
+		header = zstd_le ( data, header_len );
+		regen_len = ( header >> ( ( format & 1 ) ? 4 : 3 ) );
+		data += header_len;
+		len -= header_len;
+		zstd->literals_len = regen_len;
+		if ( type == ZSTD_LITERALS_RAW ) {
+			if ( regen_len > len )
+				return -EINVAL;
+			zstd->literals = data;
+			return ( header_len + regen_len );
+		} else {
+			if ( ( ! len ) || ( regen_len > ZSTD_BLOCK_MAX ) )
+				return -EINVAL;
+			memset ( zstd->buffer, data[0], regen_len );
+			zstd->literals = zstd->buffer;
+			return ( header_len + 1 );
+		}
+
+	case ZSTD_LITERALS_COMPRESSED:
+	case ZSTD_LITERALS_TREELESS:
+		header_len = ( ( format < 2 ) ? 3 : ( format + 2 ) );
+		size_bits = ( ( format < 2 ) ? 10 : ( 4 * format + 6 ) );
+		streams = ( format ? 4 : 1 );
+		if ( header_len > len )
+			return -EINVAL;
+		header = zstd_le ( data, header_len );
+		regen_len = ( ( header >> 4 ) & ( ( 1 << size_bits ) - 1 ) );
+		comp_len = ( header >> ( 4 + size_bits ) );
+		data += header_len;
+		len -= header_len;
+		if ( ( comp_len > len ) || ( regen_len > ZSTD_BLOCK_MAX ) )
+			return -EINVAL;
+		used = ( header_len + comp_len );
+		break;
+
+	default:
+		assert ( 0 );
+		return -EINVAL;
+	}
+
+	/* Parse Huffman tree description, if present */
+	if ( type == ZSTD_LITERALS_COMPRESSED ) {
+		tree_len = zstd_huffman_parse ( zstd, data, comp_len );
+		if ( tree_len < 0 )
+			return tree_len;
+	} else if ( ! zstd->have_huffman ) {
+		return -EINVAL;
+	}
+	data += tree_len;
+	comp_len -= tree_len;
+
+	/* Parse jump table, if present */
+	if ( streams > 1 ) {
+		if ( comp_len < 6 )
+			return -EINVAL;
+		stream_len[0] = zstd_le ( data, 2 );
+		stream_len[1] = zstd_le ( data + 2, 2 );
+		stream_len[2] = zstd_le ( data + 4, 2 );
+		data += 6;
+		comp_len -= 6;
+		if ( ( stream_len[0] + stream_len[1] +
+		       stream_len[2] ) > comp_len )
+			return -EINVAL;
+		stream_len[3] = ( comp_len - stream_len[0] - stream_len[1] -
+				  stream_len[2] );
+	} else {
+		stream_len[0] = comp_len;
+	}
+
+	/* Decode streams */
+	stream_regen = ( ( regen_len + streams - 1 ) / streams );
+	if ( ( stream_regen * ( streams - 1 ) ) > regen_len )
+		return -EINVAL;
+	out = zstd->buffer;
+	for ( i = 0 ; i < streams ; i++ ) {
+		if ( i == ( streams - 1 ) )
+			stream_regen = ( regen_len - ( out - zstd->buffer ) );
+		if ( ( rc = zstd_huffman_decode ( &zstd->huffman, data,
+						  stream_len[i], out,
+						  stream_regen ) ) != 0 )
+			return rc;
+		data += stream_len[i];
+		out += stream_regen;
+	}
+	zstd->literals = zstd->buffer;
+	zstd->literals_len = regen_len;
+
+	return used;
+}
+
+/**
+ * Construct sequence symbol decoding table
+ *
+ * @v fse		FSE table
+ * @v mode		Symbol compression mode
+ * @v data		Data
+ * @v len		Length of data
+ * @v norm		Predefined distribution
+ * @v norm_count	Number of symbols in predefined distribution
+ * @v norm_log		Predefined distribution accuracy log
+ * @v max_count		Maximum number of symbols
+ * @v max_log		Maximum accuracy log
+ * @ret used		Length of table description, or negative error
+ */
+static int zstd_table ( struct zstd_fse *fse, unsigned int mode,
+			const uint8_t *data, size_t len, const int16_t *norm,
+			unsigned int norm_count, unsigned int norm_log,
+			unsigned int max_count, unsigned int max_log ) {
+	int rc;
+
+	switch ( mode ) {
+	case ZSTD_MODE_PREDEFINED:
+		if ( ( rc = zstd_fse_build ( fse, norm, norm_count,
+					     norm_log ) ) != 0 )
+			return rc;
+		return 0;
+	case ZSTD_MODE_RLE:
+		if ( ( ! len ) || ( data[0] >= max_count ) )
+			return -EINVAL;
+		zstd_fse_rle ( fse, data[0] );
+		return 1;
+	case ZSTD_MODE_COMPRESSED:
+		return zstd_fse_parse ( fse, data, len, max_log, max_count );
+	case ZSTD_MODE_REPEAT:
+		return 0;
+	default:
+		assert ( 0 );
+		return -EINVAL;
+	}
+}
+
+/**
+ * Write literals to output buffer (if available)
+ *
+ * @v out		Output data buffer
+ * @v data		Literals
+ * @v len		Length of literals
+ */
+static void zstd_copy ( struct deflate_chunk *out, const void *data,
+			size_t len ) {
+	size_t copy_len;
+
+	if ( out->offset < out->len ) {
+		copy_len = ( out->len - out->offset );
+		if ( copy_len > len )
+			copy_len = len;
+		copy_to_user ( out->data, out->offset, data, copy_len );
+	}
+	out->offset += len;
+}
+
+/**
+ * Copy match to output buffer (if available)
+ *
+ * @v out		Output data buffer
+ * @v offset		Match offset
+ * @v len		Match length
+ */
+static void zstd_match ( struct deflate_chunk *out, size_t offset,
+			 size_t len ) {
+	uint8_t *dst;
+	uint8_t *src;
+	size_t copy_len;
+	size_t frag_len;
+
+	if ( out->offset < out->len ) {
+		copy_len = ( out->len - out->offset );
+		if ( copy_len > len )
+			copy_len = len;
+		dst = user_to_virt ( out->data, out->offset );
+		src = ( dst - offset );
+		while ( copy_len ) {
+			frag_len = ( dst - src );
+			if ( frag_len > copy_len )
+				frag_len = copy_len;
+			memcpy ( dst, src, frag_len );
+			dst += frag_len;
+			copy_len -= frag_len;
+		}
+	}
+	out->offset += len;
+}
+
+/**
+ * Decode and execute sequences section
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int zstd_sequences ( struct zstd *zstd, const uint8_t *data,
+			    size_t len, struct deflate_chunk *out ) {
+	struct zstd_bits bits;
+	unsigned int ll_state;
+	unsigned int of_state;
+	unsigned int ml_state;
+	unsigned int ll_code;
+	unsigned int of_code;
+	unsigned int ml_code;
+	unsigned int modes;
+	unsigned int count;
+	uint32_t ll;
+	uint32_t ml;
+	uint32_t offset;
+	unsigned int index;
+	int used;
+	int rc;
+
+	/* Parse number of sequences */
+	if ( ! len )
+		return -EINVAL;
+	count = data[0];
+	if ( count == 0 ) {
+		data++;
+		len--;
+		goto done;
+	} else if ( count < 128 ) {
+		data++;
+		len--;
+	} else if ( count < 255 ) {
+		if ( len < 2 )
+			return -EINVAL;
+		count = ( ( ( count - 128 ) << 8 ) + data[1] );
+		data += 2;
+		len -= 2;
+	} else {
+		if ( len < 3 )
+			return -EINVAL;
+		count = ( zstd_le ( data + 1, 2 ) + 0x7f00 );
+		data += 3;
+		len -= 3;
+	}
+
+	/* Parse symbol compression modes */
+	if ( ! len )
+		return -EINVAL;
+	modes = data[0];
+	data++;
+	len--;
+	if ( modes & 0x03 )
+		return -EINVAL;
+	if ( ( ! zstd->have_fse ) &&
+	     ( ( ( modes >> 6 ) == ZSTD_MODE_REPEAT ) ||
+	       ( ( ( modes >> 4 ) & 0x03 ) == ZSTD_MODE_REPEAT ) ||
+	       ( ( ( modes >> 2 ) & 0x03 ) == ZSTD_MODE_REPEAT ) ) ) {
+		return -EINVAL;
+	}
+
+	/* Construct decoding tables */
+	used = zstd_table ( &zstd->ll, ( modes >> 6 ), data, len,
+			    zstd_ll_default, ZSTD_LL_CODES,
+			    ZSTD_LL_DEFAULT_LOG, ZSTD_LL_CODES,
+			    ZSTD_LL_MAX_LOG );
+	if ( used < 0 )
+		return used;
+	data += used;
+	len -= used;
+	used = zstd_table ( &zstd->of, ( ( modes >> 4 ) & 0x03 ), data, len,
+			    zstd_of_default, ( sizeof ( zstd_of_default ) /
+					       sizeof ( zstd_of_default[0] ) ),
+			    ZSTD_OF_DEFAULT_LOG, ZSTD_OF_CODES,
+			    ZSTD_OF_MAX_LOG );
+	if ( used < 0 )
+		return used;
+	data += used;
+	len -= used;
+	used = zstd_table ( &zstd->ml, ( ( modes >> 2 ) & 0x03 ), data, len,
+			    zstd_ml_default, ZSTD_ML_CODES,
+			    ZSTD_ML_DEFAULT_LOG, ZSTD_ML_CODES,
+			    ZSTD_ML_MAX_LOG );
+	if ( used < 0 )
+		return used;
+	data += used;
+	len -= used;
+	zstd->have_fse = 1;
+
+	/* Initialise states */
+	if ( ( rc = zstd_bits_init ( &bits, data, len ) ) != 0 )
+		return rc;
+	ll_state = zstd_fse_init ( &zstd->ll, &bits );
+	of_state = zstd_fse_init ( &zstd->of, &bits );
+	ml_state = zstd_fse_init ( &zstd->ml, &bits );
+
+	/* Decode and execute sequences */
+	while ( count-- ) {
+
+		/* Decode sequence */
+		ll_code = zstd->ll.entry[ll_state].symbol;
+		of_code = zstd->of.entry[of_state].symbol;
+		ml_code = zstd->ml.entry[ml_state].symbol;
+		offset = ( ( 1UL << of_code ) + zstd_bits ( &bits, of_code ) );
+		ml = ( zstd_ml_base[ml_code] +
+		       zstd_bits ( &bits, zstd_ml_bits[ml_code] ) );
+		ll = ( zstd_ll_base[ll_code] +
+		       zstd_bits ( &bits, zstd_ll_bits[ll_code] ) );
+
+		/* Resolve repeated offsets */
+		if ( offset > ZSTD_REPEATS ) {
+			offset -= ZSTD_REPEATS;
+			zstd->repeat[2] = zstd->repeat[1];
+			zstd->repeat[1] = zstd->repeat[0];
+			zstd->repeat[0] = offset;
+		} else {
+			index = ( offset - 1 + ( ll ? 0 : 1 ) );
+			if ( index == ZSTD_REPEATS ) {
+				offset = ( zstd->repeat[0] - 1 );
+				if ( ! offset )
+					return -EINVAL;
+				zstd->repeat[2] = zstd->repeat[1];
+			} else {
+				offset = zstd->repeat[index];
+				if ( index == 2 )
+					zstd->repeat[2] = zstd->repeat[1];
+			}
+			if ( index ) {
+				zstd->repeat[1] = zstd->repeat[0];
+				zstd->repeat[0] = offset;
+			}
+		}
+
+		/* Update states, unless this is the final sequence */
+		if ( count ) {
+			ll_state = zstd_fse_update ( &zstd->ll, ll_state,
+						     &bits );
+			ml_state = zstd_fse_update ( &zstd->ml, ml_state,
+						     &bits );
+			of_state = zstd_fse_update ( &zstd->of, of_state,
+						     &bits );
+		}
+
+		/* Copy literals */
+		if ( ll > zstd->literals_len )
+			return -EINVAL;
+		zstd_copy ( out, zstd->literals, ll );
+		zstd->literals += ll;
+		zstd->literals_len -= ll;
+
+		/* Copy match */
+		if ( offset > ( out->offset - zstd->frame ) )
+			return -EINVAL;
+		zstd_match ( out, offset, ml );
+	}
+
+	/* Check that stream was consumed exactly */
+	if ( bits.offset != 0 )
+		return -EINVAL;
+
+ done:
+	/* Copy any remaining literals */
+	zstd_copy ( out, zstd->literals, zstd->literals_len );
+	zstd->literals_len = 0;
+
+	return 0;
+}
+
+/**
+ * Decompress block
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int zstd_block ( struct zstd *zstd, const uint8_t *data, size_t len,
+			struct deflate_chunk *out ) {
+	int used;
+	int rc;
+
+	/* Parse literals section */
+	used = zstd_literals ( zstd, data, len );
+	if ( used < 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid literals: %s\n",
+		       zstd, strerror ( used ) );
+		return used;
+	}
+	data += used;
+	len -= used;
+
+	/* Decode and execute sequences */
+	if ( ( rc = zstd_sequences ( zstd, data, len, out ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid sequences: %s\n",
+		       zstd, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Decompress frame
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Output data buffer
+ * @ret used		Length of frame, or negative error
+ */
+static ssize_t zstd_frame ( struct zstd *zstd, const uint8_t *data,
+			    size_t len, struct deflate_chunk *out ) {
+	const uint8_t *start = data;
+	unsigned int descriptor;
+	unsigned int fcs_len;
+	unsigned int dict_len;
+	unsigned int header_len;
+	uint32_t header;
+	uint32_t checksum;
+	uint64_t expected;
+	size_t block_len;
+	size_t frame_len;
+	int rc;
+
+	/* Parse frame header */
+	if ( len < sizeof ( struct zstd_frame_header ) )
+		return -EINVAL;
+	descriptor = data[4];
+	if ( descriptor & ZSTD_RESERVED ) {
+		DBGC ( zstd, "ZSTD %p reserved descriptor bit set\n", zstd );
+		return -ENOTSUP;
+	}
+	fcs_len = zstd_fcs_len[ ZSTD_FCS_FLAG ( descriptor ) ];
+	if ( ( descriptor & ZSTD_SINGLE_SEGMENT ) && ( ! fcs_len ) )
+		fcs_len = 1;
+	dict_len = zstd_dict_len[ ZSTD_DICT_FLAG ( descriptor ) ];
+	header_len = ( sizeof ( struct zstd_frame_header ) +
+		       ( ( descriptor & ZSTD_SINGLE_SEGMENT ) ? 0 : 1 ) +
+		       dict_len + fcs_len );
+	if ( len < header_len )
+		return -EINVAL;
+	if ( dict_len &&
+	     zstd_le ( ( data + header_len - fcs_len - dict_len ),
+		       dict_len ) ) {
+		DBGC ( zstd, "ZSTD %p dictionaries not supported\n", zstd );
+		return -ENOTSUP;
+	}
+	data += header_len;
+	len -= header_len;
+
+	/* Reset frame state */
+	zstd->frame = out->offset;
+	zstd->have_huffman = 0;
+	zstd->have_fse = 0;
+	zstd->repeat[0] = 1;
+	zstd->repeat[1] = 4;
+	zstd->repeat[2] = 8;
+
+	/* Decompress blocks */
+	do {
+		/* Parse block header */
+		if ( len < 3 )
+			return -EINVAL;
+		header = zstd_le ( data, 3 );
+		block_len = ZSTD_BLOCK_SIZE ( header );
+		data += 3;
+		len -= 3;
+		if ( block_len > ZSTD_BLOCK_MAX ) {
+			DBGC ( zstd, "ZSTD %p overlength block\n", zstd );
+			return -EINVAL;
+		}
+
+		/* Decompress block */
+		switch ( ZSTD_BLOCK_TYPE ( header ) ) {
+		case ZSTD_BLOCK_RAW:
+			if ( block_len > len )
+				return -EINVAL;
+			zstd_copy ( out, data, block_len );
+			break;
+		case ZSTD_BLOCK_RLE:
+			if ( ! len )
+				return -EINVAL;
+			memset ( zstd->buffer, data[0], block_len );
+			zstd_copy ( out, zstd->buffer, block_len );
+			block_len = 1;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if ( block_len > len )
+				return -EINVAL;
+			if ( ( rc = zstd_block ( zstd, data, block_len,
+						 out ) ) != 0 )
+				return rc;
+			break;
+		default:
+			DBGC ( zstd, "ZSTD %p reserved block type\n", zstd );
+			return -EINVAL;
+		}
+		data += block_len;
+		len -= block_len;
+
+	} while ( ! ( header & ZSTD_BLOCK_LAST ) );
+
+	/* Verify content checksum, if present and if data is available */
+	if ( descriptor & ZSTD_CHECKSUM ) {
+		if ( len < sizeof ( checksum ) )
+			return -EINVAL;
+		checksum = zstd_le ( data, sizeof ( checksum ) );
+		data += sizeof ( checksum );
+		len -= sizeof ( checksum );
+		frame_len = ( out->offset - zstd->frame );
+		if ( out->offset <= out->len ) {
+			expected = xxh64 ( user_to_virt ( out->data,
+							  zstd->frame ),
+					   frame_len );
+			if ( checksum != ( ( uint32_t ) expected ) ) {
+				DBGC ( zstd, "ZSTD %p checksum mismatch\n",
+				       zstd );
+				return -EINVAL;
+			}
+		}
+	}
+
+	return ( data - start );
+}
+
+/**
+ * Decompress Zstandard data
+ *
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * The input data may consist of any number of concatenated
+ * Zstandard and skippable frames.
+ *
+ * Data will not be written beyond the specified end of the output
+ * data buffer, but the offset within the output data buffer will be
+ * updated to reflect the amount that should have been written.  The
+ * caller can use this to find the length of the decompressed data
+ * before allocating the output data buffer.
+ */
+int zstd_decompress ( struct deflate_chunk *in, struct deflate_chunk *out ) {
+	struct zstd *zstd;
+	const uint8_t *data;
+	uint32_t magic;
+	size_t skip;
+	size_t len;
+	ssize_t used;
+	int rc;
+
+	/* Allocate decompressor */
+	zstd = malloc ( sizeof ( *zstd ) );
+	if ( ! zstd ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Decompress frames */
+	while ( in->offset < in->len ) {
+
+		/* Identify frame type */
+		data = user_to_virt ( in->data, in->offset );
+		len = ( in->len - in->offset );
+		if ( len < sizeof ( magic ) ) {
+			rc = -EINVAL;
+			goto err_magic;
+		}
+		magic = zstd_le ( data, sizeof ( magic ) );
+
+		if ( magic == ZSTD_MAGIC ) {
+
+			/* Decompress frame */
+			used = zstd_frame ( zstd, data, len, out );
+			if ( used < 0 ) {
+				rc = used;
+				DBGC ( zstd, "ZSTD %p could not decompress "
+				       "frame at %#zx: %s\n", zstd,
+				       in->offset, strerror ( rc ) );
+				goto err_frame;
+			}
+
+		} else if ( ( magic & ZSTD_SKIP_MASK ) == ZSTD_SKIP_MAGIC ) {
+
+			/* Skip frame */
+			if ( len < 8 ) {
+				rc = -EINVAL;
+				goto err_skip;
+			}
+			skip = zstd_le ( data + 4, 4 );
+			if ( skip > ( len - 8 ) ) {
+				rc = -EINVAL;
+				goto err_skip;
+			}
+			used = ( 8 + skip );
+
+		} else {
+
+			DBGC ( zstd, "ZSTD %p invalid magic %#08x at %#zx\n",
+			       zstd, magic, in->offset );
+			rc = -EINVAL;
+			goto err_magic;
+		}
+		in->offset += used;
+	}
+
+	/* Success */
+	rc = 0;
+
+ err_skip:
+ err_frame:
+ err_magic:
+	free ( zstd );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Presize extracted Zstandard image
+ *
+ * @v image		Image
+ * @v extracted		Extracted image
+ * @ret rc		Return status code
+ *
+ * The extracted image is presized using the content size of the
+ * first frame, if known.
+ */
+static int zstd_presize ( struct image *image, struct image *extracted ) {
+	struct zstd_frame_header header;
+	uint8_t fcs[8];
+	unsigned int fcs_len;
+	size_t offset;
+	uint64_t len;
+	int rc;
+
+	/* Parse frame header */
+	copy_from_user ( &header, image->data, 0, sizeof ( header ) );
+	if ( header.magic != cpu_to_le32 ( ZSTD_MAGIC ) )
+		return 0;
+	fcs_len = zstd_fcs_len[ ZSTD_FCS_FLAG ( header.descriptor ) ];
+	if ( ( header.descriptor & ZSTD_SINGLE_SEGMENT ) && ( ! fcs_len ) )
+		fcs_len = 1;
+	offset = ( sizeof ( header ) +
+		   ( ( header.descriptor & ZSTD_SINGLE_SEGMENT ) ? 0 : 1 ) +
+		   zstd_dict_len[ ZSTD_DICT_FLAG ( header.descriptor ) ] );
+	if ( ( ! fcs_len ) || ( ( offset + fcs_len ) > image->len ) )
+		return 0;
+
+	/* Extract frame content size */
+	copy_from_user ( fcs, image->data, offset, fcs_len );
+	len = ( zstd_le ( fcs, fcs_len ) + ( ( fcs_len == 2 ) ? 256 : 0 ) );
+	if ( len != ( ( size_t ) len ) )
+		return 0;
+
+	/* Presize extracted image */
+	if ( ( rc = image_set_len ( extracted, len ) ) != 0 ) {
+		DBGC ( image, "ZSTD %p could not presize: %s\n",
+		       image, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Extract Zstandard image
+ *
+ * @v image		Image
+ * @v extracted		Extracted image
+ * @ret rc		Return status code
+ */
+static int zstd_extract ( struct image *image, struct image *extracted ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	int rc;
+
+	/* Presize extracted image */
+	if ( ( rc = zstd_presize ( image, extracted ) ) != 0 )
+		return rc;
+
+	/* Decompress image, (re)allocating if necessary */
+	while ( 1 ) {
+
+		/* Initialise input and output chunks */
+		deflate_chunk_init ( &in, image->data, 0, image->len );
+		deflate_chunk_init ( &out, extracted->data, 0, extracted->len );
+
+		/* Decompress data */
+		if ( ( rc = zstd_decompress ( &in, &out ) ) != 0 ) {
+			DBGC ( image, "ZSTD %p could not decompress: %s\n",
+			       image, strerror ( rc ) );
+			return rc;
+		}
+
+		/* Finish if output image size was correct */
+		if ( out.offset == extracted->len )
+			break;
+
+		/* Otherwise, resize output image and retry */
+		if ( ( rc = image_set_len ( extracted, out.offset ) ) != 0 ) {
+			DBGC ( image, "ZSTD %p could not resize: %s\n",
+			       image, strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Probe Zstandard image
+ *
+ * @v image		Zstandard image
+ * @ret rc		Return status code
+ */
+static int zstd_probe ( struct image *image ) {
+	struct zstd_frame_header header;
+
+	/* Sanity check */
+	if ( image->len < sizeof ( header ) ) {
+		DBGC ( image, "ZSTD %p image too short\n", image );
+		return -ENOEXEC;
+	}
+
+	/* Check magic header */
+	copy_from_user ( &header, image->data, 0, sizeof ( header ) );
+	if ( ( header.magic != cpu_to_le32 ( ZSTD_MAGIC ) ) &&
+	     ( ( le32_to_cpu ( header.magic ) & ZSTD_SKIP_MASK ) !=
+	       ZSTD_SKIP_MAGIC ) ) {
+		DBGC ( image, "ZSTD %p invalid magic\n", image );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** Zstandard image type */
+struct image_type zstd_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "zstd",
+	.probe = zstd_probe,
+	.extract = zstd_extract,
+	.exec = image_extract_exec,
+};
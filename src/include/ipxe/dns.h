@@ -146,6 +146,21 @@ union dns_rr {
 	struct dns_rr_cname cname;
 };
 
+/** Description of a DNS cache entry */
+struct dns_cache_info {
+	/** Name as originally requested */
+	const char *name;
+	/** Resolved address (if resolution succeeded) */
+	struct sockaddr *sa;
+	/** Resolution status code */
+	int rc;
+	/** Remaining lifetime (in ticks) */
+	unsigned long remaining;
+};
+
+extern int dns_cache_describe ( unsigned int index,
+				struct dns_cache_info *info );
+
 extern int dns_encode ( const char *string, struct dns_name *name );
 extern int dns_decode ( struct dns_name *name, char *data, size_t len );
 extern int dns_compare ( struct dns_name *first, struct dns_name *second );
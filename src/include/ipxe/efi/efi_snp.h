@@ -10,6 +10,7 @@
 FILE_LICENCE ( GPL2_OR_LATER );
 
 #include <ipxe/list.h>
+#include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/efi/efi.h>
 #include <ipxe/efi/Protocol/SimpleNetwork.h>
@@ -48,6 +49,14 @@ struct efi_snp_device {
 	unsigned int tx_prod;
 	/** Transmit completion ring consumer counter */
 	unsigned int tx_cons;
+	/** Borrowed transmit I/O buffer descriptors */
+	struct io_buffer tx_iobufs[EFI_SNP_NUM_TX];
+	/** Unused borrowed transmit I/O buffer descriptors */
+	struct list_head tx_spare;
+	/** Number of borrowed transmit I/O buffers in flight */
+	unsigned int tx_borrowed;
+	/** Borrowed transmit I/O buffer currently being submitted */
+	struct io_buffer *tx_submit;
 	/** Receive queue */
 	struct list_head rx;
 	/** The network interface identifier */
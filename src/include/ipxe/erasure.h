@@ -0,0 +1,43 @@
+#ifndef _IPXE_ERASURE_H
+#define _IPXE_ERASURE_H
+
+/** @file
+ *
+ * Reed-Solomon erasure coding
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Maximum total number of source and repair blocks within a group
+ *
+ * This is the number of distinct non-zero elements of GF(2^8) that
+ * are available for constructing the Cauchy generator matrix.
+ */
+#define ERASURE_MAX_BLOCKS 256
+
+/**
+ * Get block index of repair block
+ *
+ * @v count		Number of source blocks within group
+ * @v repair		Repair block number
+ * @ret index		Block index
+ *
+ * Repair block indices follow on from the source block indices of
+ * the group, and so depend upon the actual number of source blocks
+ * within the group.
+ */
+static inline unsigned int erasure_repair_index ( unsigned int count,
+						  unsigned int repair ) {
+	return ( count + repair );
+}
+
+extern void erasure_encode ( unsigned int count, unsigned int repair,
+			     const void **blocks, void *out, size_t len );
+extern int erasure_decode ( unsigned int count, unsigned int *index,
+			    void **blocks, size_t len );
+
+#endif /* _IPXE_ERASURE_H */
@@ -24,6 +24,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Transparent background magic colour (raw colour value) */
 #define FBCON_TRANSPARENT 0xffffffff
 
+/** Number of glyph cache entries (must be a power of two) */
+#define FBCON_GLYPHS 64
+
 /** A font glyph */
 struct fbcon_font_glyph {
 	/** Row bitmask */
@@ -97,6 +100,22 @@ struct fbcon_text_cell {
 	unsigned int character;
 };
 
+/** A pre-rendered character glyph */
+struct fbcon_glyph {
+	/** Text cell (or transparent background if unused) */
+	struct fbcon_text_cell cell;
+	/** Rendered pixel rows */
+	uint8_t pixels[0];
+};
+
+/** A frame buffer glyph cache */
+struct fbcon_glyph_cache {
+	/** Cache entries (or NULL if no cache is present) */
+	void *entries;
+	/** Length of a single cache entry */
+	size_t len;
+};
+
 /** A frame buffer text array */
 struct fbcon_text {
 	/** Stored text cells */
@@ -145,6 +164,8 @@ struct fbcon {
 	struct fbcon_text text;
 	/** Background picture */
 	struct fbcon_picture picture;
+	/** Glyph cache */
+	struct fbcon_glyph_cache glyphs;
 	/** Display cursor */
 	int show_cursor;
 };
@@ -0,0 +1,134 @@
+#ifndef _IPXE_IPERF_H
+#define _IPXE_IPERF_H
+
+/** @file
+ *
+ * iperf3 network throughput test client
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/interface.h>
+
+/** Default iperf3 server port */
+#define IPERF_PORT 5201
+
+/** Length of iperf3 session cookie (including terminating NUL) */
+#define IPERF_COOKIE_LEN 37
+
+/** iperf3 session cookie character set */
+#define IPERF_COOKIE_CHARS "abcdefghijklmnopqrstuvwxyz234567"
+
+/** Test is starting */
+#define IPERF_TEST_START 1
+
+/** Test is running */
+#define IPERF_TEST_RUNNING 2
+
+/** Test has ended */
+#define IPERF_TEST_END 4
+
+/** Parameter exchange is required */
+#define IPERF_PARAM_EXCHANGE 9
+
+/** Data streams must be created */
+#define IPERF_CREATE_STREAMS 10
+
+/** Server has terminated test */
+#define IPERF_SERVER_TERMINATE 11
+
+/** Client has terminated test */
+#define IPERF_CLIENT_TERMINATE 12
+
+/** Results exchange is required */
+#define IPERF_EXCHANGE_RESULTS 13
+
+/** Results should be displayed */
+#define IPERF_DISPLAY_RESULTS 14
+
+/** Test is complete */
+#define IPERF_DONE 16
+
+/** Server refused access (i.e. server is busy) */
+#define IPERF_ACCESS_DENIED 0xff
+
+/** Server encountered an error */
+#define IPERF_SERVER_ERROR 0xfe
+
+/** UDP stream connection message
+ *
+ * This is transmitted by iperf3 as a native-endian integer; all
+ * commonly encountered iperf3 servers are little-endian.
+ */
+#define IPERF_UDP_CONNECT_MSG 0x36373839UL
+
+/** An iperf3 UDP datagram header */
+struct iperf_udp_header {
+	/** Transmit timestamp (seconds) */
+	uint32_t sec;
+	/** Transmit timestamp (microseconds) */
+	uint32_t usec;
+	/** Packet sequence number */
+	uint32_t count;
+} __attribute__ (( packed ));
+
+/** Default TCP block length */
+#define IPERF_TCP_LEN 131072
+
+/** Default UDP block length */
+#define IPERF_UDP_LEN 1460
+
+/** Default UDP bandwidth (in bits per second) */
+#define IPERF_UDP_BANDWIDTH 1048576
+
+/** Default test duration (in seconds) */
+#define IPERF_DURATION 10
+
+/** Maximum length of results received from server */
+#define IPERF_MAX_RESULTS_LEN 16384
+
+/** Use UDP rather than TCP */
+#define IPERF_FL_UDP 0x0001
+
+/** Reverse direction (i.e. server sends and client receives) */
+#define IPERF_FL_REVERSE 0x0002
+
+/** iperf3 test parameters */
+struct iperf_parameters {
+	/** Server port (or zero to use the default port) */
+	unsigned int port;
+	/** Flags */
+	unsigned int flags;
+	/** Test duration in seconds (or zero to use the default) */
+	unsigned int duration;
+	/** Block length (or zero to use the default) */
+	size_t len;
+	/** UDP bandwidth in bits per second (or zero to use the default) */
+	unsigned long bandwidth;
+};
+
+/** An iperf3 throughput report */
+struct iperf_report {
+	/** Summary name, or NULL for an interval report */
+	const char *summary;
+	/** Start time (in ticks since start of test) */
+	unsigned long start;
+	/** End time (in ticks since start of test) */
+	unsigned long end;
+	/** Number of bytes transferred */
+	unsigned long long bytes;
+	/** Number of packets transferred (UDP only) */
+	unsigned long packets;
+	/** Number of packets lost (UDP only) */
+	unsigned long lost;
+	/** Number of retransmitted TCP segments */
+	unsigned long retransmits;
+};
+
+extern int start_iperf ( struct interface *job, const char *hostname,
+			 struct iperf_parameters *params,
+			 void ( * callback ) ( struct iperf_report *report ) );
+
+#endif /* _IPXE_IPERF_H */
@@ -0,0 +1,76 @@
+#ifndef _IPXE_LZ4_H
+#define _IPXE_LZ4_H
+
+/** @file
+ *
+ * LZ4 compressed images
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/image.h>
+#include <ipxe/deflate.h>
+
+/** LZ4 frame magic number */
+#define LZ4_MAGIC 0x184d2204UL
+
+/** LZ4 legacy frame magic number */
+#define LZ4_LEGACY_MAGIC 0x184c2102UL
+
+/** LZ4 skippable frame magic number */
+#define LZ4_SKIP_MAGIC 0x184d2a50UL
+
+/** LZ4 skippable frame magic number mask */
+#define LZ4_SKIP_MASK 0xfffffff0UL
+
+/** LZ4 frame header */
+struct lz4_frame_header {
+	/** Magic number */
+	uint32_t magic;
+	/** Flags */
+	uint8_t flags;
+	/** Block descriptor */
+	uint8_t bd;
+} __attribute__ (( packed ));
+
+/** LZ4 version number mask */
+#define LZ4_FL_VERSION_MASK 0xc0
+
+/** LZ4 version number */
+#define LZ4_FL_VERSION 0x40
+
+/** Blocks are independent */
+#define LZ4_FL_INDEPENDENT 0x20
+
+/** Block checksums are present */
+#define LZ4_FL_BLOCK_CHECKSUM 0x10
+
+/** Content size is present */
+#define LZ4_FL_CONTENT_SIZE 0x08
+
+/** Content checksum is present */
+#define LZ4_FL_CONTENT_CHECKSUM 0x04
+
+/** Reserved flag */
+#define LZ4_FL_RESERVED 0x02
+
+/** Dictionary ID is present */
+#define LZ4_FL_DICT 0x01
+
+/** Block is uncompressed */
+#define LZ4_BLOCK_UNCOMPRESSED 0x80000000UL
+
+/** Maximum legacy block size (uncompressed) */
+#define LZ4_LEGACY_BLOCK_MAX ( 8 * 1024 * 1024 )
+
+/** Minimum match length */
+#define LZ4_MIN_MATCH 4
+
+extern int lz4_decompress ( struct deflate_chunk *in,
+			    struct deflate_chunk *out );
+
+extern struct image_type lz4_image_type __image_type ( PROBE_NORMAL );
+
+#endif /* _IPXE_LZ4_H */
@@ -293,6 +293,8 @@ struct net_device_stats {
 	unsigned int good;
 	/** Count of error completions */
 	unsigned int bad;
+	/** Count of descriptor ring overflows */
+	unsigned int overflow;
 	/** Error breakdowns */
 	struct net_device_error errors[NETDEV_MAX_UNIQUE_ERRORS];
 };
@@ -413,10 +415,41 @@ struct net_device {
 	 * link-layer headers) configured for the link.
 	 */
 	size_t mtu;
+	/** Maximum receive ring fill level
+	 *
+	 * This is the maximum number of receive buffers that the
+	 * driver is able to keep posted to the hardware, or zero if
+	 * the receive ring fill level is not configurable.
+	 */
+	unsigned int max_rx_fill;
+	/** Receive ring fill level
+	 *
+	 * This is the number of receive buffers that the driver
+	 * should attempt to keep posted to the hardware.  It is
+	 * initialised by the driver and may be changed at runtime
+	 * (up to the maximum receive ring fill level).  Drivers may
+	 * choose to apply a change only when the device is next
+	 * opened.
+	 */
+	unsigned int rx_fill;
 	/** TX packet queue */
 	struct list_head tx_queue;
 	/** Deferred TX packet queue */
 	struct list_head tx_deferred;
+	/** Reclaim borrowed transmit I/O buffer (if any)
+	 *
+	 * @v netdev		Network device
+	 * @v iobuf		I/O buffer
+	 * @v rc		Transmission status code
+	 * @ret reclaimed	I/O buffer was borrowed and has been reclaimed
+	 *
+	 * This is called on completion of each transmission, and
+	 * allows a transmitter that has lent an I/O buffer (rather
+	 * than handing over ownership) to recover it instead of
+	 * having it freed.
+	 */
+	int ( * tx_reclaim ) ( struct net_device *netdev,
+			       struct io_buffer *iobuf, int rc );
 	/** RX packet queue */
 	struct list_head rx_queue;
 	/** TX statistics */
@@ -457,6 +490,15 @@ struct net_device {
 /** Network device poll is in progress */
 #define NETDEV_POLL_IN_PROGRESS 0x0020
 
+/** Network device can transmit directly from borrowed buffers
+ *
+ * This flag can be used by a network device to indicate that it
+ * never adds headers or padding to transmitted I/O buffers of at
+ * least @c IOB_ZLEN bytes, and so can safely transmit from I/O
+ * buffers that have neither headroom nor tailroom.
+ */
+#define NETDEV_TX_ZERO_COPY 0x0040
+
 /** Link-layer protocol table */
 #define LL_PROTOCOLS __table ( struct ll_protocol, "ll_protocols" )
 
@@ -579,6 +621,20 @@ netdev_priv ( struct net_device *netdev ) {
         return netdev->priv;
 }
 
+/**
+ * Record receive ring overflow
+ *
+ * @v netdev		Network device
+ *
+ * Drivers should call this when they find that every posted receive
+ * buffer has been consumed, since any further received packets may
+ * then be dropped by the hardware for lack of buffers.
+ */
+static inline __attribute__ (( always_inline )) void
+netdev_rx_overflow ( struct net_device *netdev ) {
+	netdev->rx_stats.overflow++;
+}
+
 /**
  * Get per-netdevice configuration settings block
  *
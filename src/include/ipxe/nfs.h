@@ -85,10 +85,27 @@ struct nfs_lookup_reply {
 	uint32_t             status;
 	/** Entity type */
 	enum nfs_attr_type   ent_type;
+	/** File size (if attributes were returned) */
+	uint64_t             filesize;
+	/** Attributes were returned */
+	int                  attributes;
 	/** File handle */
 	struct nfs_fh        fh;
 };
 
+/**
+ * A NFS FSINFO reply
+ *
+ */
+struct nfs_fsinfo_reply {
+	/** Reply status */
+	uint32_t             status;
+	/** Maximum READ request size */
+	uint32_t             rtmax;
+	/** Preferred READ request size */
+	uint32_t             rtpref;
+};
+
 /**
  * A NFS READLINK reply
  *
@@ -146,6 +163,8 @@ int nfs_readlink ( struct interface *intf, struct oncrpc_session *session,
                    const struct nfs_fh *fh );
 int nfs_read ( struct interface *intf, struct oncrpc_session *session,
                const struct nfs_fh *fh, uint64_t offset, uint32_t count );
+int nfs_fsinfo ( struct interface *intf, struct oncrpc_session *session,
+                 const struct nfs_fh *fh );
 
 int nfs_get_lookup_reply ( struct nfs_lookup_reply *lookup_reply,
                            struct oncrpc_reply *reply );
@@ -153,5 +172,7 @@ int nfs_get_readlink_reply ( struct nfs_readlink_reply *readlink_reply,
                              struct oncrpc_reply *reply );
 int nfs_get_read_reply ( struct nfs_read_reply *read_reply,
                          struct oncrpc_reply *reply );
+int nfs_get_fsinfo_reply ( struct nfs_fsinfo_reply *fsinfo_reply,
+                           struct oncrpc_reply *reply );
 
 #endif /* _IPXE_NFS_H */
@@ -25,6 +25,13 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Size of an ONC RPC header */
 #define ONCRPC_HEADER_SIZE ( 11 * sizeof ( uint32_t ) )
 
+/** Set most significant bit to 1. */
+#define SET_LAST_FRAME( x ) ( (x) | 1 << 31 )
+#define GET_FRAME_SIZE( x ) ( (x) & ~( 1 << 31 ) )
+
+/** Length of record prefix required to identify an ONC RPC record */
+#define ONCRPC_RECORD_ID_LEN ( 2 * sizeof ( uint32_t ) )
+
 #define ONCRPC_FIELD( type, value ) { oncrpc_ ## type, { .type = value } }
 #define ONCRPC_SUBFIELD( type, args... ) \
 	{ oncrpc_ ## type, { .type = { args } } }
@@ -122,6 +129,7 @@ int oncrpc_call ( struct interface *intf, struct oncrpc_session *session,
 
 size_t oncrpc_compute_size ( const struct oncrpc_field fields[] );
 
+int oncrpc_record_id ( const void *data, size_t *len, uint32_t *xid );
 int oncrpc_get_reply ( struct oncrpc_session *session,
                        struct oncrpc_reply *reply, struct io_buffer *io_buf );
 
@@ -111,6 +111,10 @@ struct peerdist_block {
 	struct peerdisc_client discovery;
 	/** Current position in discovered peer list */
 	struct peerdisc_peer *peer;
+	/** First peer attempted in current cycle */
+	struct peerdisc_peer *first;
+	/** Peer serving current retrieval protocol attempt (if any) */
+	struct peerdisc_peer *active;
 	/** Block download queue */
 	struct peerdist_block_queue *queue;
 	/** List of queued block downloads */
@@ -126,6 +130,8 @@ struct peerdist_block {
 	unsigned long started;
 	/** Time at which most recent attempt was started */
 	unsigned long attempted;
+	/** Time by which current attempt must complete (or zero) */
+	unsigned long deadline;
 };
 
 /** PeerDist block download queue */
@@ -71,6 +71,14 @@ struct peerdisc_segment {
 struct peerdisc_peer {
 	/** List of peers */
 	struct list_head list;
+	/** Number of block download attempts in progress */
+	unsigned int busy;
+	/** Number of successful block download attempts */
+	unsigned int samples;
+	/** Smoothed block download latency (in ticks) */
+	unsigned long latency;
+	/** Penalty for recent failed block download attempts */
+	unsigned int strikes;
 	/** Peer location */
 	char location[0];
 };
@@ -115,6 +123,11 @@ extern void peerdisc_stat ( struct interface *intf, struct peerdisc_peer *peer,
 	typeof ( void ( object_type, struct peerdisc_peer *peer,	\
 			struct list_head *peers ) )
 
+extern struct peerdisc_peer *
+peerdisc_select ( struct peerdisc_segment *segment );
+extern void peerdisc_start ( struct peerdisc_peer *peer );
+extern void peerdisc_finish ( struct peerdisc_peer *peer,
+			      unsigned long elapsed, int rc );
 extern int peerdisc_open ( struct peerdisc_client *peerdisc, const void *id,
 			   size_t len );
 extern void peerdisc_close ( struct peerdisc_client *peerdisc );
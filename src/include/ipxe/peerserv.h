@@ -0,0 +1,34 @@
+#ifndef _IPXE_PEERSERV_H
+#define _IPXE_PEERSERV_H
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content hosting
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <ipxe/timer.h>
+#include <ipxe/uri.h>
+#include <ipxe/pccrc.h>
+
+/** PeerDist retrieval protocol server port */
+#define PEERSERV_PORT 80
+
+/** Maximum number of hosted content items */
+#define PEERSERV_MAX_CONTENT 8
+
+/** Maximum retrieval protocol request length (including HTTP headers) */
+#define PEERSERV_MAX_REQUEST 4096
+
+/** Maximum HTTP response header length */
+#define PEERSERV_MAX_HEADER 128
+
+/** Retrieval protocol connection idle timeout */
+#define PEERSERV_TIMEOUT ( 30 * TICKS_PER_SEC )
+
+extern void peerserv_offer ( struct uri *uri,
+			     const struct peerdist_info *info );
+
+#endif /* _IPXE_PEERSERV_H */
@@ -120,6 +120,7 @@ extern void * __attribute__ (( pure ))
 process_object ( struct process *process );
 extern void process_add ( struct process *process );
 extern void process_del ( struct process *process );
+extern int process_runnable ( void );
 extern void step ( void );
 
 /**
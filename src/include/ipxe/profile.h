@@ -12,6 +12,24 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <bits/profile.h>
 #include <ipxe/tables.h>
 
+/** Number of histogram sub-buckets per power of two (as a power of two)
+ *
+ * Each histogram bucket covers at most a quarter of a power of two,
+ * so that reported percentiles are accurate to within 25%.
+ */
+#define PROFILE_HISTOGRAM_SUB_BITS 2
+
+/** Maximum significant bits of a sample recorded in the histogram
+ *
+ * Larger samples are recorded in the final bucket.
+ */
+#define PROFILE_HISTOGRAM_BITS 32
+
+/** Number of histogram buckets */
+#define PROFILE_HISTOGRAM_BUCKETS					\
+	( ( PROFILE_HISTOGRAM_BITS - PROFILE_HISTOGRAM_SUB_BITS + 1 )	\
+	  << PROFILE_HISTOGRAM_SUB_BITS )
+
 #ifndef PROFILING
 #ifdef NDEBUG
 #define PROFILING 0
@@ -48,6 +66,18 @@ struct profiler {
 	 * (i.e. one less than would be returned by flsll(raw_accvar)).
 	 */
 	unsigned int accvar_msb;
+	/** Maximum sample value */
+	unsigned long max;
+	/** Profiler is disabled */
+	int disabled;
+	/** Log-linear histogram of sample values
+	 *
+	 * Sample values below ( 1 << PROFILE_HISTOGRAM_SUB_BITS ) are
+	 * recorded exactly.  Larger sample values are recorded in a
+	 * bucket determined by the most significant bit and the
+	 * following PROFILE_HISTOGRAM_SUB_BITS bits.
+	 */
+	unsigned int histogram[PROFILE_HISTOGRAM_BUCKETS];
 };
 
 /** Profiler table */
@@ -66,6 +96,10 @@ extern void profile_update ( struct profiler *profiler, unsigned long sample );
 extern unsigned long profile_mean ( struct profiler *profiler );
 extern unsigned long profile_variance ( struct profiler *profiler );
 extern unsigned long profile_stddev ( struct profiler *profiler );
+extern unsigned long profile_percentile ( struct profiler *profiler,
+					  unsigned int percent );
+extern void profile_reset ( struct profiler *profiler );
+extern struct profiler * find_profiler ( const char *name );
 
 /**
  * Get start time
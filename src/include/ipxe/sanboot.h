@@ -61,6 +61,10 @@ struct san_device {
 	struct retry_timer timer;
 	/** Command status */
 	int command_rc;
+	/** List of asynchronous commands */
+	struct list_head commands;
+	/** Asynchronous command dispatch process */
+	struct process process;
 
 	/** Raw block device capacity */
 	struct block_device_capacity capacity;
@@ -240,6 +244,12 @@ extern int sandev_read ( struct san_device *sandev, uint64_t lba,
 			 unsigned int count, userptr_t buffer );
 extern int sandev_write ( struct san_device *sandev, uint64_t lba,
 			  unsigned int count, userptr_t buffer );
+extern int sandev_read_async ( struct san_device *sandev, uint64_t lba,
+			       unsigned int count, userptr_t buffer,
+			       struct interface *parent );
+extern int sandev_write_async ( struct san_device *sandev, uint64_t lba,
+				unsigned int count, userptr_t buffer,
+				struct interface *parent );
 extern struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 					  size_t priv_size );
 extern int register_sandev ( struct san_device *sandev, unsigned int drive,
@@ -10,6 +10,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <string.h>
 #include <ipxe/tables.h>
 #include <ipxe/list.h>
 #include <ipxe/refcnt.h>
@@ -291,6 +292,14 @@ extern const struct settings_scope ipv6_settings_scope;
 /** DHCPv6 setting scope */
 extern const struct settings_scope dhcpv6_scope;
 
+/** Number of hash buckets within a generic settings block
+ *
+ * Must be a power of two.
+ */
+#define GENERIC_SETTINGS_HASH_SIZE 16
+
+struct generic_setting;
+
 /**
  * A generic settings block
  *
@@ -300,6 +309,10 @@ struct generic_settings {
 	struct settings settings;
 	/** List of generic settings */
 	struct list_head list;
+	/** Generic settings hashed by tag */
+	struct generic_setting *tags[GENERIC_SETTINGS_HASH_SIZE];
+	/** Generic settings hashed by name */
+	struct generic_setting *names[GENERIC_SETTINGS_HASH_SIZE];
 };
 
 /** A child settings block locator function */
@@ -515,6 +528,8 @@ static inline void generic_settings_init ( struct generic_settings *generics,
 	settings_init ( &generics->settings, &generic_settings_operations,
 			refcnt, NULL );
 	INIT_LIST_HEAD ( &generics->list );
+	memset ( generics->tags, 0, sizeof ( generics->tags ) );
+	memset ( generics->names, 0, sizeof ( generics->names ) );
 }
 
 /**
@@ -12,6 +12,8 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <ipxe/tcpip.h>
+#include <ipxe/list.h>
+#include <ipxe/interface.h>
 
 /**
  * A TCP header
@@ -433,6 +435,38 @@ static inline int tcp_in_window ( uint32_t seq, uint32_t start,
  */
 #define TCP_FINISH_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** A TCP listening socket */
+struct tcp_listener {
+	/** List of listening sockets */
+	struct list_head list;
+	/** Local port */
+	unsigned int port;
+	/**
+	 * Accept incoming connection
+	 *
+	 * @v listener		TCP listening socket
+	 * @v xfer		Data transfer interface of new connection
+	 * @v peer		Peer socket address
+	 * @ret rc		Return status code
+	 *
+	 * The listener must attach its own data transfer interface to
+	 * the new connection's data transfer interface.
+	 */
+	int ( * accept ) ( struct tcp_listener *listener,
+			   struct interface *xfer,
+			   struct sockaddr_tcpip *peer );
+};
+
+/** TCP statistics */
+struct tcp_statistics {
+	/** Number of segments retransmitted following a timeout */
+	unsigned long retransmits;
+};
+
 extern struct tcpip_protocol tcp_protocol __tcpip_protocol;
+extern struct tcp_statistics tcp_stats;
+
+extern int tcp_listen ( struct tcp_listener *listener );
+extern void tcp_unlisten ( struct tcp_listener *listener );
 
 #endif /* _IPXE_TCP_H */
@@ -0,0 +1,71 @@
+#ifndef _IPXE_TIMELINE_H
+#define _IPXE_TIMELINE_H
+
+/** @file
+ *
+ * Boot timeline
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <config/general.h>
+
+/** Maximum length of timeline event detail (including NUL) */
+#define TIMELINE_DETAIL_LEN 48
+
+/** Number of timeline events retained
+ *
+ * Must be a power of two.
+ */
+#define TIMELINE_MAX_EVENTS 128
+
+/** A boot timeline event */
+struct timeline_event {
+	/** Sequence number */
+	unsigned long seq;
+	/** Timestamp (in profiling timestamp units) */
+	unsigned long timestamp;
+	/** Timestamp (in timer ticks) */
+	unsigned long ticks;
+	/** Event name */
+	const char *name;
+	/** Event detail */
+	char detail[TIMELINE_DETAIL_LEN];
+};
+
+#ifdef TIMELINE
+
+extern void timeline ( const char *name, const char *fmt, ... )
+	__attribute__ (( format ( printf, 2, 3 ) ));
+
+#else
+
+/**
+ * Record timeline event
+ *
+ * @v name		Event name (must be a static string)
+ * @v fmt		Format string for event detail
+ * @v ...		Arguments
+ */
+static inline __attribute__ (( always_inline, format ( printf, 2, 3 ) )) void
+timeline ( const char *name __unused, const char *fmt __unused, ... ) {
+	/* Do nothing */
+}
+
+#endif
+
+extern struct timeline_event * timeline_first ( void );
+extern struct timeline_event * timeline_next ( struct timeline_event *event );
+extern void timeline_clear ( void );
+
+/** Iterate over all retained timeline events (oldest first)
+ *
+ * @v event		Timeline event
+ */
+#define for_each_timeline_event( event )				\
+	for ( (event) = timeline_first() ; (event) ;			\
+	      (event) = timeline_next ( (event) ) )
+
+#endif /* _IPXE_TIMELINE_H */
@@ -403,7 +403,7 @@ struct tls_connection {
  * implementations (including OpenSSL) do not support it.  We must
  * therefore be prepared to receive records of up to 16kB in length.
  * The chance of an allocation of this size failing is non-negligible,
- * so we must split received data into smaller allocations.
+ * so we must split received application data into smaller allocations.
  */
 #define TLS_RX_BUFSIZE 4096
 
@@ -0,0 +1,195 @@
+#ifndef _IPXE_ZSTD_H
+#define _IPXE_ZSTD_H
+
+/** @file
+ *
+ * Zstandard compressed images
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/image.h>
+#include <ipxe/deflate.h>
+
+/** Zstandard frame magic number */
+#define ZSTD_MAGIC 0xfd2fb528UL
+
+/** Zstandard skippable frame magic number */
+#define ZSTD_SKIP_MAGIC 0x184d2a50UL
+
+/** Zstandard skippable frame magic number mask */
+#define ZSTD_SKIP_MASK 0xfffffff0UL
+
+/** Zstandard frame header descriptor */
+struct zstd_frame_header {
+	/** Magic number */
+	uint32_t magic;
+	/** Frame header descriptor */
+	uint8_t descriptor;
+} __attribute__ (( packed ));
+
+/** Frame content size field size */
+#define ZSTD_FCS_FLAG( descriptor ) ( (descriptor) >> 6 )
+
+/** Single segment flag */
+#define ZSTD_SINGLE_SEGMENT 0x20
+
+/** Reserved bit */
+#define ZSTD_RESERVED 0x08
+
+/** Content checksum flag */
+#define ZSTD_CHECKSUM 0x04
+
+/** Dictionary ID field size */
+#define ZSTD_DICT_FLAG( descriptor ) ( (descriptor) & 0x03 )
+
+/** Last block flag */
+#define ZSTD_BLOCK_LAST 0x01
+
+/** Block type */
+#define ZSTD_BLOCK_TYPE( header ) ( ( (header) >> 1 ) & 0x03 )
+
+/** Block size */
+#define ZSTD_BLOCK_SIZE( header ) ( (header) >> 3 )
+
+/** Zstandard block types */
+enum zstd_block_type {
+	/** Raw block */
+	ZSTD_BLOCK_RAW = 0,
+	/** Run-length encoded block */
+	ZSTD_BLOCK_RLE = 1,
+	/** Compressed block */
+	ZSTD_BLOCK_COMPRESSED = 2,
+};
+
+/** Maximum block size */
+#define ZSTD_BLOCK_MAX ( 128 * 1024 )
+
+/** Zstandard literals section types */
+enum zstd_literals_type {
+	/** Raw literals */
+	ZSTD_LITERALS_RAW = 0,
+	/** Run-length encoded literals */
+	ZSTD_LITERALS_RLE = 1,
+	/** Huffman compressed literals */
+	ZSTD_LITERALS_COMPRESSED = 2,
+	/** Huffman compressed literals using previous Huffman tree */
+	ZSTD_LITERALS_TREELESS = 3,
+};
+
+/** Zstandard sequence symbol compression modes */
+enum zstd_symbol_mode {
+	/** Predefined distribution */
+	ZSTD_MODE_PREDEFINED = 0,
+	/** Single repeated symbol */
+	ZSTD_MODE_RLE = 1,
+	/** FSE compressed distribution */
+	ZSTD_MODE_COMPRESSED = 2,
+	/** Repeat previous distribution */
+	ZSTD_MODE_REPEAT = 3,
+};
+
+/** Maximum Huffman code length */
+#define ZSTD_HUFFMAN_MAX_BITS 11
+
+/** Maximum FSE accuracy log for Huffman weights */
+#define ZSTD_WEIGHTS_MAX_LOG 6
+
+/** Maximum FSE accuracy log for literal lengths */
+#define ZSTD_LL_MAX_LOG 9
+
+/** Maximum FSE accuracy log for match lengths */
+#define ZSTD_ML_MAX_LOG 9
+
+/** Maximum FSE accuracy log for offsets */
+#define ZSTD_OF_MAX_LOG 8
+
+/** Maximum FSE accuracy log */
+#define ZSTD_FSE_MAX_LOG 9
+
+/** Number of literal length codes */
+#define ZSTD_LL_CODES 36
+
+/** Number of match length codes */
+#define ZSTD_ML_CODES 53
+
+/** Number of offset codes */
+#define ZSTD_OF_CODES 32
+
+/** Maximum number of FSE symbols */
+#define ZSTD_FSE_MAX_SYMBOLS ZSTD_ML_CODES
+
+/** An FSE decoding table entry */
+struct zstd_fse_entry {
+	/** Symbol */
+	uint8_t symbol;
+	/** Number of bits to read for next state */
+	uint8_t bits;
+	/** Base value for next state */
+	uint16_t base;
+};
+
+/** An FSE decoding table */
+struct zstd_fse {
+	/** Accuracy log */
+	unsigned int log;
+	/** Table entries */
+	struct zstd_fse_entry entry[ 1 << ZSTD_FSE_MAX_LOG ];
+};
+
+/** A Huffman decoding table entry */
+struct zstd_huffman_entry {
+	/** Symbol */
+	uint8_t symbol;
+	/** Number of bits */
+	uint8_t bits;
+};
+
+/** A Huffman decoding table */
+struct zstd_huffman {
+	/** Maximum code length */
+	unsigned int bits;
+	/** Table entries */
+	struct zstd_huffman_entry entry[ 1 << ZSTD_HUFFMAN_MAX_BITS ];
+};
+
+/** Number of repeated offsets */
+#define ZSTD_REPEATS 3
+
+/** A Zstandard decompressor */
+struct zstd {
+	/** Huffman table for literals */
+	struct zstd_huffman huffman;
+	/** Huffman table is valid */
+	int have_huffman;
+	/** FSE table for Huffman weights */
+	struct zstd_fse weights;
+	/** FSE table for literal lengths */
+	struct zstd_fse ll;
+	/** FSE table for offsets */
+	struct zstd_fse of;
+	/** FSE table for match lengths */
+	struct zstd_fse ml;
+	/** FSE tables are valid */
+	int have_fse;
+	/** Repeated offsets */
+	uint32_t repeat[ZSTD_REPEATS];
+
+	/** Output offset of start of current frame */
+	size_t frame;
+	/** Literals */
+	const uint8_t *literals;
+	/** Length of literals */
+	size_t literals_len;
+	/** Literals buffer */
+	uint8_t buffer[ZSTD_BLOCK_MAX];
+};
+
+extern int zstd_decompress ( struct deflate_chunk *in,
+			     struct deflate_chunk *out );
+
+extern struct image_type zstd_image_type __image_type ( PROBE_NORMAL );
+
+#endif /* _IPXE_ZSTD_H */
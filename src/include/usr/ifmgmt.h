@@ -16,6 +16,8 @@ extern int ifopen ( struct net_device *netdev );
 extern int ifconf ( struct net_device *netdev,
 		    struct net_device_configurator *configurator,
 		    unsigned long timeout );
+extern int ifconf_any ( int ( * usable ) ( struct net_device *netdev ),
+			unsigned long timeout, struct net_device **netdev );
 extern void ifclose ( struct net_device *netdev );
 extern void ifstat ( struct net_device *netdev );
 extern int iflinkwait ( struct net_device *netdev, unsigned long timeout,
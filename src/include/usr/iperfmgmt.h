@@ -0,0 +1,16 @@
+#ifndef _USR_IPERFMGMT_H
+#define _USR_IPERFMGMT_H
+
+/** @file
+ *
+ * iperf3 network throughput test management
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+struct iperf_parameters;
+
+extern int iperf ( const char *hostname, struct iperf_parameters *params );
+
+#endif /* _USR_IPERFMGMT_H */
@@ -9,6 +9,9 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+struct profiler;
+
+extern void profstat_profiler ( struct profiler *profiler );
 extern void profstat ( void );
 
 #endif /* _USR_PROFSTAT_H */
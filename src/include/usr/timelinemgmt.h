@@ -0,0 +1,15 @@
+#ifndef _USR_TIMELINEMGMT_H
+#define _USR_TIMELINEMGMT_H
+
+/** @file
+ *
+ * Boot timeline management
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern void timeline_dump ( void );
+extern void timeline_syslog ( void );
+
+#endif /* _USR_TIMELINEMGMT_H */
@@ -49,6 +49,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/acpi.h>
 #include <ipxe/efi/efi.h>
 #include <ipxe/efi/Protocol/BlockIo.h>
+#include <ipxe/efi/Protocol/BlockIo2.h>
 #include <ipxe/efi/Protocol/SimpleFileSystem.h>
 #include <ipxe/efi/Protocol/AcpiTable.h>
 #include <ipxe/efi/efi_driver.h>
@@ -65,6 +66,9 @@ EFI_REQUEST_PROTOCOL ( EFI_ACPI_TABLE_PROTOCOL, &acpi );
 /** Boot filename */
 static wchar_t efi_block_boot_filename[] = EFI_REMOVABLE_MEDIA_FILE_NAME;
 
+/** Asynchronous request polling interval (in units of 100ns) */
+#define EFI_BLOCK_POLL_INTERVAL 10000
+
 /** EFI SAN device private data */
 struct efi_block_data {
 	/** SAN device */
@@ -75,8 +79,28 @@ struct efi_block_data {
 	EFI_BLOCK_IO_MEDIA media;
 	/** Block I/O protocol */
 	EFI_BLOCK_IO_PROTOCOL block_io;
+	/** Block I/O2 protocol */
+	EFI_BLOCK_IO2_PROTOCOL block_io2;
 	/** Device path protocol */
 	EFI_DEVICE_PATH_PROTOCOL *path;
+	/** List of asynchronous requests */
+	struct list_head requests;
+	/** Asynchronous request polling timer event */
+	EFI_EVENT event;
+};
+
+/** An EFI block device asynchronous request */
+struct efi_block_request {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of asynchronous requests */
+	struct list_head list;
+	/** SAN device */
+	struct san_device *sandev;
+	/** SAN device command interface */
+	struct interface job;
+	/** Block I/O2 token */
+	EFI_BLOCK_IO2_TOKEN *token;
 };
 
 /**
@@ -208,6 +232,291 @@ efi_block_io_flush ( EFI_BLOCK_IO_PROTOCOL *block_io ) {
 	return 0;
 }
 
+/**
+ * Poll for asynchronous request completion (from timer event)
+ *
+ * @v event		EFI event
+ * @v context		EFI SAN device private data
+ */
+static VOID EFIAPI efi_block_timer ( EFI_EVENT event __unused,
+				     VOID *context __unused ) {
+
+	/* Allow SAN device commands to progress */
+	efi_snp_claim();
+	step();
+	efi_snp_release();
+}
+
+/**
+ * Free asynchronous request
+ *
+ * @v refcnt		Reference count
+ */
+static void efi_block_request_free ( struct refcnt *refcnt ) {
+	struct efi_block_request *req =
+		container_of ( refcnt, struct efi_block_request, refcnt );
+
+	sandev_put ( req->sandev );
+	free ( req );
+}
+
+/**
+ * Complete asynchronous request
+ *
+ * @v req		Asynchronous request
+ * @v rc		Reason for completion
+ */
+static void efi_block_request_close ( struct efi_block_request *req,
+				      int rc ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct san_device *sandev = req->sandev;
+	struct efi_block_data *block = sandev->priv;
+
+	DBGC2 ( sandev, "EFIBLK %#02x request %p complete: %s\n",
+		sandev->drive, req, strerror ( rc ) );
+
+	/* Shut down interface */
+	intf_shutdown ( &req->job, rc );
+
+	/* Remove from list of requests */
+	list_del ( &req->list );
+
+	/* Report completion to caller, and stop polling if idle */
+	if ( ! efi_shutdown_in_progress ) {
+		req->token->TransactionStatus = EFIRC ( rc );
+		bs->SignalEvent ( req->token->Event );
+		if ( list_empty ( &block->requests ) )
+			bs->SetTimer ( block->event, TimerCancel, 0 );
+	}
+
+	/* Drop list's reference */
+	ref_put ( &req->refcnt );
+}
+
+/** Asynchronous request job interface operations */
+static struct interface_operation efi_block_request_op[] = {
+	INTF_OP ( intf_close, struct efi_block_request *,
+		  efi_block_request_close ),
+};
+
+/** Asynchronous request job interface descriptor */
+static struct interface_descriptor efi_block_request_desc =
+	INTF_DESC ( struct efi_block_request, job, efi_block_request_op );
+
+/**
+ * Abort all asynchronous requests
+ *
+ * @v block		EFI SAN device private data
+ * @v rc		Reason for abort
+ */
+static void efi_block_abort ( struct efi_block_data *block, int rc ) {
+	struct efi_block_request *req;
+
+	while ( ( req = list_first_entry ( &block->requests,
+					   struct efi_block_request,
+					   list ) ) ) {
+		efi_block_request_close ( req, rc );
+	}
+}
+
+/**
+ * Read from or write to EFI block device asynchronously
+ *
+ * @v block		EFI SAN device private data
+ * @v lba		Starting LBA
+ * @v token		Block I/O2 token
+ * @v data		Data buffer
+ * @v len		Size of buffer
+ * @v sandev_rw		SAN device read/write method
+ * @v sandev_rw_async	SAN device asynchronous read/write method
+ * @ret rc		Return status code
+ */
+static int efi_block_rw_async ( struct efi_block_data *block, uint64_t lba,
+				EFI_BLOCK_IO2_TOKEN *token, void *data,
+				size_t len,
+				int ( * sandev_rw ) ( struct san_device *sandev,
+						      uint64_t lba,
+						      unsigned int count,
+						      userptr_t buffer ),
+				int ( * sandev_rw_async )
+					( struct san_device *sandev,
+					  uint64_t lba, unsigned int count,
+					  userptr_t buffer,
+					  struct interface *parent ) ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct san_device *sandev = block->sandev;
+	struct efi_block_request *req;
+	unsigned int count;
+	int rc;
+
+	/* Perform blocking I/O if no event is provided */
+	if ( ! ( token && token->Event ) ) {
+		efi_snp_claim();
+		rc = efi_block_rw ( sandev, lba, data, len, sandev_rw );
+		efi_snp_release();
+		if ( token )
+			token->TransactionStatus = EFIRC ( rc );
+		return rc;
+	}
+
+	/* Sanity check */
+	count = ( len / block->media.BlockSize );
+	if ( ( count * block->media.BlockSize ) != len ) {
+		DBGC ( sandev, "EFIBLK %#02x impossible length %#zx\n",
+		       sandev->drive, len );
+		return -EINVAL;
+	}
+
+	/* Allocate and initialise request */
+	req = zalloc ( sizeof ( *req ) );
+	if ( ! req )
+		return -ENOMEM;
+	ref_init ( &req->refcnt, efi_block_request_free );
+	intf_init ( &req->job, &efi_block_request_desc, &req->refcnt );
+	req->sandev = sandev_get ( sandev );
+	req->token = token;
+	token->TransactionStatus = EFI_NOT_READY;
+	DBGC2 ( sandev, "EFIBLK %#02x request %p LBA %#08llx+%#x\n",
+		sandev->drive, req, ( ( unsigned long long ) lba ), count );
+
+	/* Add to list of requests (which holds our reference), and
+	 * start polling if this is the first request.
+	 */
+	if ( list_empty ( &block->requests ) ) {
+		bs->SetTimer ( block->event, TimerPeriodic,
+			       EFI_BLOCK_POLL_INTERVAL );
+	}
+	list_add_tail ( &req->list, &block->requests );
+
+	/* Start command, falling back to blocking I/O if the device
+	 * is not immediately able to accept asynchronous commands.
+	 */
+	efi_snp_claim();
+	if ( ( rc = sandev_rw_async ( sandev, lba, count, virt_to_user ( data ),
+				      &req->job ) ) != 0 ) {
+		DBGC ( sandev, "EFIBLK %#02x request %p using blocking I/O: "
+		       "%s\n", sandev->drive, req, strerror ( rc ) );
+		rc = efi_block_rw ( sandev, lba, data, len, sandev_rw );
+		efi_block_request_close ( req, rc );
+	}
+	efi_snp_release();
+
+	return 0;
+}
+
+/**
+ * Reset EFI block device
+ *
+ * @v block_io2		Block I/O2 protocol
+ * @v verify		Perform extended verification
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_reset ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      BOOLEAN verify __unused ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev, "EFIBLK %#02x reset (async)\n", sandev->drive );
+	efi_snp_claim();
+	efi_block_abort ( block, -ECANCELED );
+	rc = sandev_reset ( sandev );
+	efi_snp_release();
+	return EFIRC ( rc );
+}
+
+/**
+ * Read from EFI block device asynchronously
+ *
+ * @v block_io2		Block I/O2 protocol
+ * @v media		Media identifier
+ * @v lba		Starting LBA
+ * @v token		Block I/O2 token
+ * @v len		Size of buffer
+ * @v data		Data buffer
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_read ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		     UINT32 media __unused, EFI_LBA lba,
+		     EFI_BLOCK_IO2_TOKEN *token, UINTN len, VOID *data ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev, "EFIBLK %#02x read LBA %#08llx to %p+%#08zx "
+		"(async)\n", sandev->drive, lba, data, ( ( size_t ) len ) );
+	rc = efi_block_rw_async ( block, lba, token, data, len,
+				  sandev_read, sandev_read_async );
+	return EFIRC ( rc );
+}
+
+/**
+ * Write to EFI block device asynchronously
+ *
+ * @v block_io2		Block I/O2 protocol
+ * @v media		Media identifier
+ * @v lba		Starting LBA
+ * @v token		Block I/O2 token
+ * @v len		Size of buffer
+ * @v data		Data buffer
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_write ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      UINT32 media __unused, EFI_LBA lba,
+		      EFI_BLOCK_IO2_TOKEN *token, UINTN len, VOID *data ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev, "EFIBLK %#02x write LBA %#08llx from %p+%#08zx "
+		"(async)\n", sandev->drive, lba, data, ( ( size_t ) len ) );
+	rc = efi_block_rw_async ( block, lba, token, data, len,
+				  sandev_write, sandev_write_async );
+	return EFIRC ( rc );
+}
+
+/**
+ * Flush data to EFI block device asynchronously
+ *
+ * @v block_io2		Block I/O2 protocol
+ * @v token		Block I/O2 token
+ * @ret efirc		EFI status code
+ *
+ * We have no write cache, so flushing requires only that any
+ * outstanding requests have completed.
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_flush ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      EFI_BLOCK_IO2_TOKEN *token ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+
+	DBGC2 ( sandev, "EFIBLK %#02x flush (async)\n", sandev->drive );
+
+	/* Wait for outstanding requests to complete */
+	efi_snp_claim();
+	while ( ! list_empty ( &block->requests ) )
+		step();
+	efi_snp_release();
+
+	/* Report completion */
+	if ( token ) {
+		token->TransactionStatus = 0;
+		if ( token->Event )
+			bs->SignalEvent ( token->Event );
+	}
+
+	return 0;
+}
+
 /**
  * Connect all possible drivers to EFI block device
  *
@@ -272,6 +581,22 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	block->block_io.ReadBlocks = efi_block_io_read;
 	block->block_io.WriteBlocks = efi_block_io_write;
 	block->block_io.FlushBlocks = efi_block_io_flush;
+	block->block_io2.Media = &block->media;
+	block->block_io2.Reset = efi_block_io2_reset;
+	block->block_io2.ReadBlocksEx = efi_block_io2_read;
+	block->block_io2.WriteBlocksEx = efi_block_io2_write;
+	block->block_io2.FlushBlocksEx = efi_block_io2_flush;
+	INIT_LIST_HEAD ( &block->requests );
+
+	/* Create asynchronous request polling timer event */
+	if ( ( efirc = bs->CreateEvent ( ( EVT_TIMER | EVT_NOTIFY_SIGNAL ),
+					 TPL_CALLBACK, efi_block_timer, block,
+					 &block->event ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( sandev, "EFIBLK %#02x could not create event: %s\n",
+		       drive, strerror ( rc ) );
+		goto err_event;
+	}
 
 	/* Register SAN device */
 	if ( ( rc = register_sandev ( sandev, drive, flags ) ) != 0 ) {
@@ -306,6 +631,7 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	if ( ( efirc = bs->InstallMultipleProtocolInterfaces (
 			&block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) {
 		rc = -EEFI ( efirc );
@@ -322,6 +648,7 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	if ( ( efirc = bs->UninstallMultipleProtocolInterfaces (
 			block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) {
 		DBGC ( sandev, "EFIBLK %#02x could not uninstall protocols: "
@@ -329,6 +656,7 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 		leak = 1;
 	}
 	efi_nullify_block ( &block->block_io );
+	efi_nullify_block2 ( &block->block_io2 );
  err_install:
 	if ( ! leak )  {
 		free ( block->path );
@@ -338,6 +666,8 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
  err_active:
 	unregister_sandev ( sandev );
  err_register:
+	bs->CloseEvent ( block->event );
+ err_event:
 	if ( ! leak )
 		sandev_put ( sandev );
  err_alloc:
@@ -374,6 +704,7 @@ static void efi_block_unhook ( unsigned int drive ) {
 	     ( ( efirc = bs->UninstallMultipleProtocolInterfaces (
 			block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) ) {
 		DBGC ( sandev, "EFIBLK %#02x could not uninstall protocols: "
@@ -381,6 +712,12 @@ static void efi_block_unhook ( unsigned int drive ) {
 		leak = 1;
 	}
 	efi_nullify_block ( &block->block_io );
+	efi_nullify_block2 ( &block->block_io2 );
+
+	/* Abort any asynchronous requests and stop polling */
+	efi_block_abort ( block, -ENODEV );
+	if ( ! efi_shutdown_in_progress )
+		bs->CloseEvent ( block->event );
 
 	/* Free device path */
 	if ( ! leak ) {
@@ -159,6 +159,8 @@ static void efi_snp_flush ( struct efi_snp_device *snpdev ) {
 	}
 }
 
+static struct efi_snp_device * efi_snp_demux ( struct net_device *netdev );
+
 /**
  * Poll net device and count received packets
  *
@@ -168,17 +170,102 @@ static void efi_snp_poll ( struct efi_snp_device *snpdev ) {
 	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
 	struct io_buffer *iobuf;
 
+	unsigned int received = 0;
+
 	/* Poll network device */
 	netdev_poll ( snpdev->netdev );
 
-	/* Retrieve any received packets */
+	/* Retrieve all received packets as a single batch */
 	while ( ( iobuf = netdev_rx_dequeue ( snpdev->netdev ) ) ) {
 		list_add_tail ( &iobuf->list, &snpdev->rx );
+		received++;
+	}
+
+	/* Notify caller of received packets */
+	if ( received ) {
 		snpdev->interrupts |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
 		bs->SignalEvent ( &snpdev->snp.WaitForPacket );
 	}
 }
 
+/**
+ * Borrow caller's buffer for transmission
+ *
+ * @v snpdev		SNP device
+ * @v data		Data buffer
+ * @v len		Length of data buffer
+ * @ret iobuf		I/O buffer, or NULL if buffer cannot be borrowed
+ *
+ * The caller's buffer may be transmitted directly (without copying)
+ * if the underlying network device does not need to add headers or
+ * padding, and if there is space in the transmit completion ring to
+ * report the buffer's eventual completion.
+ */
+static struct io_buffer * efi_snp_tx_borrow ( struct efi_snp_device *snpdev,
+					      void *data, size_t len ) {
+	struct io_buffer *iobuf;
+	unsigned int tx_fill;
+
+	/* Check that network device can transmit from borrowed buffers */
+	if ( ! ( snpdev->netdev->state & NETDEV_TX_ZERO_COPY ) )
+		return NULL;
+	if ( len < IOB_ZLEN )
+		return NULL;
+
+	/* Check for space in transmit completion ring */
+	tx_fill = ( snpdev->tx_prod - snpdev->tx_cons + snpdev->tx_borrowed );
+	if ( tx_fill >= EFI_SNP_NUM_TX )
+		return NULL;
+
+	/* Describe caller's buffer using an unused descriptor */
+	iobuf = list_first_entry ( &snpdev->tx_spare, struct io_buffer, list );
+	assert ( iobuf != NULL );
+	list_del ( &iobuf->list );
+	iob_populate ( iobuf, data, len, len );
+	snpdev->tx_borrowed++;
+	snpdev->tx_submit = iobuf;
+
+	return iobuf;
+}
+
+/**
+ * Reclaim borrowed transmit I/O buffer
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @v rc		Transmission status code
+ * @ret reclaimed	I/O buffer was borrowed and has been reclaimed
+ */
+static int efi_snp_tx_reclaim ( struct net_device *netdev,
+				struct io_buffer *iobuf, int rc ) {
+	struct efi_snp_device *snpdev;
+
+	/* Locate SNP device */
+	snpdev = efi_snp_demux ( netdev );
+	if ( ! snpdev )
+		return 0;
+
+	/* Ignore I/O buffers not borrowed from an SNP caller */
+	if ( ( iobuf < &snpdev->tx_iobufs[0] ) ||
+	     ( iobuf >= &snpdev->tx_iobufs[EFI_SNP_NUM_TX] ) )
+		return 0;
+
+	/* Return descriptor to spare list */
+	list_add_tail ( &iobuf->list, &snpdev->tx_spare );
+	assert ( snpdev->tx_borrowed > 0 );
+	snpdev->tx_borrowed--;
+
+	/* Record in transmit completion ring, unless the failure will
+	 * be reported by the transmit call that is still in progress.
+	 */
+	if ( ( rc != 0 ) && ( iobuf == snpdev->tx_submit ) )
+		return 1;
+	snpdev->tx[ snpdev->tx_prod++ % EFI_SNP_NUM_TX ] = iobuf->head;
+	snpdev->interrupts |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
+
+	return 1;
+}
+
 /**
  * Change SNP state from "stopped" to "started"
  *
@@ -565,8 +652,14 @@ efi_snp_get_status ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	/* Raise TPL */
 	efi_raise_tpl ( &tpl );
 
-	/* Poll the network device */
-	efi_snp_poll ( snpdev );
+	/* Poll the network device, unless we already have everything
+	 * that the caller is asking for.
+	 */
+	if ( ( ! ( interrupts || txbuf ) ) ||
+	     ( interrupts && ( ! snpdev->interrupts ) ) ||
+	     ( txbuf && ( snpdev->tx_prod == snpdev->tx_cons ) ) ) {
+		efi_snp_poll ( snpdev );
+	}
 
 	/* Interrupt status.  In practice, this seems to be used only
 	 * to detect TX completions.
@@ -618,6 +711,7 @@ efi_snp_transmit ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	struct io_buffer *iobuf;
 	size_t payload_len;
 	unsigned int tx_fill;
+	int borrowed;
 	int rc;
 
 	DBGC2 ( snpdev, "SNPDEV %p TRANSMIT %p+%lx", snpdev, data,
@@ -677,19 +771,27 @@ efi_snp_transmit ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 			ll_src = &snpdev->mode.CurrentAddress;
 	}
 
-	/* Allocate buffer */
-	payload_len = ( len - ll_protocol->ll_header_len );
-	iobuf = alloc_iob ( MAX_LL_HEADER_LEN + ( ( payload_len > IOB_ZLEN ) ?
-						  payload_len : IOB_ZLEN ) );
-	if ( ! iobuf ) {
-		DBGC ( snpdev, "SNPDEV %p TX could not allocate %ld-byte "
-		       "buffer\n", snpdev, ( ( unsigned long ) len ) );
-		rc = -ENOMEM;
-		goto err_alloc_iob;
+	/* Transmit directly from caller's buffer if possible,
+	 * otherwise allocate a buffer and copy the data.
+	 */
+	iobuf = efi_snp_tx_borrow ( snpdev, data, len );
+	borrowed = ( iobuf != NULL );
+	if ( ! borrowed ) {
+		payload_len = ( len - ll_protocol->ll_header_len );
+		iobuf = alloc_iob ( MAX_LL_HEADER_LEN +
+				    ( ( payload_len > IOB_ZLEN ) ?
+				      payload_len : IOB_ZLEN ) );
+		if ( ! iobuf ) {
+			DBGC ( snpdev, "SNPDEV %p TX could not allocate "
+			       "%ld-byte buffer\n", snpdev,
+			       ( ( unsigned long ) len ) );
+			rc = -ENOMEM;
+			goto err_alloc_iob;
+		}
+		iob_reserve ( iobuf, ( MAX_LL_HEADER_LEN -
+				       ll_protocol->ll_header_len ) );
+		memcpy ( iob_put ( iobuf, len ), data, len );
 	}
-	iob_reserve ( iobuf, ( MAX_LL_HEADER_LEN -
-			       ll_protocol->ll_header_len ) );
-	memcpy ( iob_put ( iobuf, len ), data, len );
 
 	/* Create link-layer header, if specified */
 	if ( ll_header_len ) {
@@ -704,29 +806,36 @@ efi_snp_transmit ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	}
 
 	/* Transmit packet */
-	if ( ( rc = netdev_tx ( snpdev->netdev, iob_disown ( iobuf ) ) ) != 0){
+	rc = netdev_tx ( snpdev->netdev, iob_disown ( iobuf ) );
+	snpdev->tx_submit = NULL;
+	if ( rc != 0 ) {
 		DBGC ( snpdev, "SNPDEV %p TX could not transmit: %s\n",
 		       snpdev, strerror ( rc ) );
 		goto err_tx;
 	}
 
-	/* Record in transmit completion ring.  If we run out of
-	 * space, report the failure even though we have already
-	 * transmitted the packet.
+	/* Record in transmit completion ring.  A borrowed buffer
+	 * will be recorded only when its transmission completes.  If
+	 * we run out of space, report the failure even though we
+	 * have already transmitted the packet.
 	 *
 	 * This allows us to report completions only for packets for
 	 * which we had reported successfully initiating transmission,
 	 * while continuing to support clients that never poll for
 	 * transmit completions.
 	 */
-	tx_fill = ( snpdev->tx_prod - snpdev->tx_cons );
-	if ( tx_fill >= EFI_SNP_NUM_TX ) {
-		DBGC ( snpdev, "SNPDEV %p TX completion ring full\n", snpdev );
-		rc = -ENOBUFS;
-		goto err_ring_full;
+	if ( ! borrowed ) {
+		tx_fill = ( snpdev->tx_prod - snpdev->tx_cons +
+			    snpdev->tx_borrowed );
+		if ( tx_fill >= EFI_SNP_NUM_TX ) {
+			DBGC ( snpdev, "SNPDEV %p TX completion ring full\n",
+			       snpdev );
+			rc = -ENOBUFS;
+			goto err_ring_full;
+		}
+		snpdev->tx[ snpdev->tx_prod++ % EFI_SNP_NUM_TX ] = data;
+		snpdev->interrupts |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
 	}
-	snpdev->tx[ snpdev->tx_prod++ % EFI_SNP_NUM_TX ] = data;
-	snpdev->interrupts |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
 
 	/* Restore TPL */
 	efi_restore_tpl ( &tpl );
@@ -736,7 +845,9 @@ efi_snp_transmit ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
  err_ring_full:
  err_tx:
  err_ll_push:
-	free_iob ( iobuf );
+	if ( iobuf && ! efi_snp_tx_reclaim ( snpdev->netdev, iobuf, rc ) )
+		free_iob ( iobuf );
+	snpdev->tx_submit = NULL;
  err_alloc_iob:
  err_sanity:
 	efi_restore_tpl ( &tpl );
@@ -785,8 +896,11 @@ efi_snp_receive ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	/* Raise TPL */
 	efi_raise_tpl ( &tpl );
 
-	/* Poll the network device */
-	efi_snp_poll ( snpdev );
+	/* Poll the network device, unless we still have packets
+	 * remaining from the most recently received batch.
+	 */
+	if ( list_empty ( &snpdev->rx ) )
+		efi_snp_poll ( snpdev );
 
 	/* Check for an available packet */
 	iobuf = list_first_entry ( &snpdev->rx, struct io_buffer, list );
@@ -1787,6 +1901,7 @@ static int efi_snp_probe ( struct net_device *netdev ) {
 	void *interface;
 	unsigned int tci;
 	char vlan_name[ 12 /* ", VLAN xxxx" + NUL */ ];
+	unsigned int i;
 	int leak = 0;
 	EFI_STATUS efirc;
 	int rc;
@@ -1808,6 +1923,11 @@ static int efi_snp_probe ( struct net_device *netdev ) {
 	snpdev->netdev = netdev_get ( netdev );
 	snpdev->efidev = efidev;
 	INIT_LIST_HEAD ( &snpdev->rx );
+	INIT_LIST_HEAD ( &snpdev->tx_spare );
+	for ( i = 0 ; i < EFI_SNP_NUM_TX ; i++ ) {
+		list_add_tail ( &snpdev->tx_iobufs[i].list,
+				&snpdev->tx_spare );
+	}
 
 	/* Sanity check */
 	if ( netdev->ll_protocol->ll_addr_len > sizeof ( EFI_MAC_ADDRESS ) ) {
@@ -1956,6 +2076,7 @@ static int efi_snp_probe ( struct net_device *netdev ) {
 
 	/* Add to list of SNP devices */
 	list_add ( &snpdev->list, &efi_snp_devices );
+	netdev->tx_reclaim = efi_snp_tx_reclaim;
 
 	/* Close device path */
 	bs->CloseProtocol ( efidev->device, &efi_device_path_protocol_guid,
@@ -1965,6 +2086,7 @@ static int efi_snp_probe ( struct net_device *netdev ) {
 	       snpdev, netdev->name, efi_handle_name ( snpdev->handle ) );
 	return 0;
 
+	netdev->tx_reclaim = NULL;
 	list_del ( &snpdev->list );
 	if ( snpdev->package_list )
 		leak |= efi_snp_hii_uninstall ( snpdev );
@@ -2057,6 +2179,7 @@ static void efi_snp_remove ( struct net_device *netdev ) {
 	}
 
 	/* Uninstall the SNP */
+	netdev->tx_reclaim = NULL;
 	list_del ( &snpdev->list );
 	if ( snpdev->package_list )
 		leak |= efi_snp_hii_uninstall ( snpdev );
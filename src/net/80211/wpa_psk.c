@@ -30,6 +30,71 @@ FILE_LICENCE ( GPL2_OR_LATER );
  * Frontend for WPA using a pre-shared key.
  */
 
+/** Maximum length of WPA passphrase */
+#define WPA_PSK_MAX_LEN 64
+
+/** Number of PBKDF2 iterations used to derive PMK from passphrase */
+#define WPA_PSK_ITERATIONS 4096
+
+/**
+ * Most recently derived PMK
+ *
+ * Deriving the PMK from the passphrase is computationally expensive,
+ * and the result depends only upon the passphrase and the ESSID.  We
+ * therefore retain the most recent result for reuse across
+ * reassociations and retries.  The cache is wiped when it is
+ * replaced, when the device is closed, and when an association ends
+ * without having been successfully authenticated.
+ */
+static struct {
+	/** ESSID */
+	char essid[IEEE80211_MAX_SSID_LEN + 1];
+	/** Passphrase (or empty if no PMK has been derived) */
+	char passphrase[WPA_PSK_MAX_LEN + 1];
+	/** Pairwise Master Key */
+	u8 pmk[WPA_PMK_LEN];
+} wpa_psk_cache;
+
+/**
+ * Wipe cached PMK
+ *
+ */
+static void wpa_psk_forget ( void )
+{
+	memset ( &wpa_psk_cache, 0, sizeof ( wpa_psk_cache ) );
+}
+
+/**
+ * Derive PMK from passphrase
+ *
+ * @v dev	802.11 device
+ * @v passphrase	Passphrase
+ * @v len	Length of passphrase
+ * @ret pmk	Pairwise Master Key
+ */
+static const u8 * wpa_psk_pmk ( struct net80211_device *dev,
+				const char *passphrase, size_t len )
+{
+	/* Use cached PMK, if applicable */
+	if ( ( strcmp ( wpa_psk_cache.passphrase, passphrase ) == 0 ) &&
+	     ( strcmp ( wpa_psk_cache.essid, dev->essid ) == 0 ) ) {
+		DBGC2 ( &wpa_psk_cache, "WPA-PSK using cached PMK for "
+			"`%s'\n", dev->essid );
+		return wpa_psk_cache.pmk;
+	}
+
+	/* Derive and cache PMK */
+	wpa_psk_forget();
+	pbkdf2_sha1 ( passphrase, len, dev->essid, strlen ( dev->essid ),
+		      WPA_PSK_ITERATIONS, wpa_psk_cache.pmk, WPA_PMK_LEN );
+	memcpy ( wpa_psk_cache.passphrase, passphrase, len );
+	wpa_psk_cache.passphrase[len] = '\0';
+	memcpy ( wpa_psk_cache.essid, dev->essid,
+		 sizeof ( wpa_psk_cache.essid ) );
+
+	return wpa_psk_cache.pmk;
+}
+
 /**
  * Initialise WPA-PSK state
  *
@@ -49,14 +114,14 @@ static int wpa_psk_init ( struct net80211_device *dev )
  */
 static int wpa_psk_start ( struct net80211_device *dev )
 {
-	char passphrase[64+1];
-	u8 pmk[WPA_PMK_LEN];
+	char passphrase[WPA_PSK_MAX_LEN + 1];
+	const u8 *pmk;
 	int len;
 	struct wpa_common_ctx *ctx = dev->handshaker->priv;
 
 	len = fetch_string_setting ( netdev_settings ( dev->netdev ),
 				     &net80211_key_setting, passphrase,
-				     64 + 1 );
+				     sizeof ( passphrase ) );
 
 	if ( len <= 0 ) {
 		DBGC ( ctx, "WPA-PSK %p: no passphrase provided!\n", ctx );
@@ -64,8 +129,13 @@ static int wpa_psk_start ( struct net80211_device *dev )
 		return -EACCES;
 	}
 
-	pbkdf2_sha1 ( passphrase, len, dev->essid, strlen ( dev->essid ),
-		      4096, pmk, WPA_PMK_LEN );
+	if ( len > WPA_PSK_MAX_LEN ) {
+		DBGC ( ctx, "WPA-PSK %p: passphrase too long!\n", ctx );
+		net80211_deauthenticate ( dev, -EINVAL );
+		return -EINVAL;
+	}
+
+	pmk = wpa_psk_pmk ( dev, passphrase, len );
 
 	DBGC ( ctx, "WPA-PSK %p: derived PMK from passphrase `%s':\n", ctx,
 	       passphrase );
@@ -112,6 +182,17 @@ static int wpa_psk_no_change_key ( struct net80211_device *dev __unused )
  */
 static void wpa_psk_stop ( struct net80211_device *dev )
 {
+	struct wpa_common_ctx *ctx = dev->handshaker->priv;
+
+	/* Wipe cached PMK unless we are merely reassociating using a
+	 * PMK that is known to work
+	 */
+	if ( ( ctx->state != WPA_SUCCESS ) ||
+	     ( ! netdev_is_open ( dev->netdev ) ) ) {
+		DBGC2 ( &wpa_psk_cache, "WPA-PSK wiping cached PMK\n" );
+		wpa_psk_forget();
+	}
+
 	wpa_stop ( dev );
 }
 
@@ -81,6 +81,11 @@ const struct setting mtu_setting __setting ( SETTING_NETDEV, mtu ) = {
 	.type = &setting_type_int16,
 	.tag = DHCP_MTU,
 };
+const struct setting rxfill_setting __setting ( SETTING_NETDEV, rxfill ) = {
+	.name = "rxfill",
+	.description = "Receive ring fill level",
+	.type = &setting_type_uint16,
+};
 
 /**
  * Store link-layer address setting
@@ -409,6 +414,39 @@ struct init_fn netdev_redirect_settings_init_fn __init_fn ( INIT_LATE ) = {
 	.initialise = netdev_redirect_settings_init,
 };
 
+/**
+ * Apply network device receive ring fill level setting
+ *
+ * @v netdev		Network device
+ * @v settings		Network device settings
+ */
+static void apply_netdev_rx_fill ( struct net_device *netdev,
+				   struct settings *settings ) {
+	unsigned int rx_fill;
+
+	/* Do nothing unless fill level is configurable and specified */
+	if ( ! netdev->max_rx_fill )
+		return;
+	rx_fill = fetch_uintz_setting ( settings, &rxfill_setting );
+	if ( ! rx_fill )
+		return;
+
+	/* Limit fill level to maximum supported by driver */
+	if ( rx_fill > netdev->max_rx_fill ) {
+		DBGC ( netdev, "NETDEV %s cannot support RX fill level %d "
+		       "(max %d)\n", netdev->name, rx_fill,
+		       netdev->max_rx_fill );
+		rx_fill = netdev->max_rx_fill;
+	}
+
+	/* Update fill level */
+	if ( rx_fill != netdev->rx_fill ) {
+		DBGC ( netdev, "NETDEV %s RX fill level is %d\n",
+		       netdev->name, rx_fill );
+		netdev->rx_fill = rx_fill;
+	}
+}
+
 /**
  * Apply network device settings
  *
@@ -429,6 +467,9 @@ static int apply_netdev_settings ( void ) {
 		/* Get network device settings */
 		settings = netdev_settings ( netdev );
 
+		/* Apply receive ring fill level */
+		apply_netdev_rx_fill ( netdev, settings );
+
 		/* Get MTU */
 		mtu = fetch_uintz_setting ( settings, &mtu_setting );
 
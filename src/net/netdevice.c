@@ -39,6 +39,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/device.h>
 #include <ipxe/errortab.h>
 #include <ipxe/profile.h>
+#include <ipxe/timeline.h>
 #include <ipxe/fault.h>
 #include <ipxe/vlan.h>
 #include <ipxe/netdevice.h>
@@ -55,6 +56,9 @@ struct list_head net_devices = LIST_HEAD_INIT ( net_devices );
 /** List of open network devices, in reverse order of opening */
 static struct list_head open_net_devices = LIST_HEAD_INIT ( open_net_devices );
 
+/** Networking stack process */
+extern struct process net_process;
+
 /** Network device index */
 static unsigned int netdev_index = 0;
 
@@ -165,6 +169,12 @@ void netdev_link_err ( struct net_device *netdev, int rc ) {
 	/* Stop link block timer */
 	stop_timer ( &netdev->link_block );
 
+	/* Record link state transitions in boot timeline */
+	if ( ( rc == 0 ) != ( netdev->link_rc == 0 ) ) {
+		timeline ( "link", "%s %s", netdev->name,
+			   ( ( rc == 0 ) ? "up" : "down" ) );
+	}
+
 	/* Record link state */
 	netdev->link_rc = rc;
 	if ( netdev->link_rc == 0 ) {
@@ -410,6 +420,11 @@ void netdev_tx_err ( struct net_device *netdev,
 	if ( iobuf && dma_mapped ( &iobuf->map ) )
 		iob_unmap ( iobuf );
 
+	/* Return borrowed I/O buffer to its owner, if applicable */
+	if ( iobuf && netdev->tx_reclaim &&
+	     netdev->tx_reclaim ( netdev, iobuf, rc ) )
+		return;
+
 	/* Discard packet */
 	free_iob ( iobuf );
 }
@@ -838,6 +853,9 @@ int netdev_open ( struct net_device *netdev ) {
 	/* Add to head of open devices list */
 	list_add ( &netdev->open_list, &open_net_devices );
 
+	/* Ensure that the networking stack process is running */
+	process_add ( &net_process );
+
 	/* Notify drivers of device state change */
 	netdev_notify ( netdev );
 
@@ -1165,9 +1183,18 @@ void net_poll ( void ) {
  * Single-step the network stack
  *
  * @v process		Network stack process
+ *
+ * The process stops itself when no network devices are open, and is
+ * restarted by netdev_open().
  */
-static void net_step ( struct process *process __unused ) {
+static void net_step ( struct process *process ) {
+
+	/* Poll network stack */
 	net_poll();
+
+	/* Stop process if there are no open network devices */
+	if ( list_empty ( &open_net_devices ) )
+		process_del ( process );
 }
 
 /**
@@ -48,6 +48,11 @@
 #define NFS_READLINK    5
 /** NFS READ procedure */
 #define NFS_READ        6
+/** NFS FSINFO procedure */
+#define NFS_FSINFO      19
+
+/** Size of NFS file attributes (fattr3) */
+#define NFS_FATTR_SIZE ( 5 * sizeof ( uint32_t ) + 8 * sizeof ( uint64_t ) )
 
 /**
  * Extract a file handle from the beginning of an I/O buffer
@@ -144,6 +149,24 @@ int nfs_read ( struct interface *intf, struct oncrpc_session *session,
 	return oncrpc_call ( intf, session, NFS_READ, fields );
 }
 
+/**
+ * Send a FSINFO request
+ *
+ * @v intf              Interface to send the request on
+ * @v session           ONC RPC session
+ * @v fh                The file handle of the file system root
+ * @ret rc              Return status code
+ */
+int nfs_fsinfo ( struct interface *intf, struct oncrpc_session *session,
+                 const struct nfs_fh *fh ) {
+	struct oncrpc_field fields[] = {
+		ONCRPC_SUBFIELD ( array, fh->size, &fh->fh ),
+		ONCRPC_FIELD_END,
+	};
+
+	return oncrpc_call ( intf, session, NFS_FSINFO, fields );
+}
+
 /**
  * Parse a LOOKUP reply
  *
@@ -183,8 +206,15 @@ int nfs_get_lookup_reply ( struct nfs_lookup_reply *lookup_reply,
 
 	nfs_iob_get_fh ( reply->data, &lookup_reply->fh );
 
-	if ( oncrpc_iob_get_int ( reply->data ) == 1 )
+	lookup_reply->attributes = ( oncrpc_iob_get_int ( reply->data ) == 1 );
+	if ( lookup_reply->attributes ) {
 		lookup_reply->ent_type = oncrpc_iob_get_int ( reply->data );
+		iob_pull ( reply->data, 4 * sizeof ( uint32_t ) );
+		lookup_reply->filesize = oncrpc_iob_get_int64 ( reply->data );
+	} else {
+		lookup_reply->ent_type = 0;
+		lookup_reply->filesize = 0;
+	}
 
 	return 0;
 }
@@ -286,3 +316,36 @@ int nfs_get_read_reply ( struct nfs_read_reply *read_reply,
 	return 0;
 }
 
+/**
+ * Parse a FSINFO reply
+ *
+ * @v fsinfo_reply      A structure where the data will be saved
+ * @v reply             The ONC RPC reply to get data from
+ * @ret rc              Return status code
+ */
+int nfs_get_fsinfo_reply ( struct nfs_fsinfo_reply *fsinfo_reply,
+                           struct oncrpc_reply *reply ) {
+	if ( ! fsinfo_reply || ! reply )
+		return -EINVAL;
+
+	fsinfo_reply->status = oncrpc_iob_get_int ( reply->data );
+	switch ( fsinfo_reply->status )
+	{
+	case NFS3_OK:
+		 break;
+	case NFS3ERR_STALE:
+		return -ESTALE;
+	case NFS3ERR_BADHANDLE:
+	case NFS3ERR_SERVERFAULT:
+	default:
+		return -EPROTO;
+	}
+
+	if ( oncrpc_iob_get_int ( reply->data ) == 1 )
+		iob_pull ( reply->data, NFS_FATTR_SIZE );
+
+	fsinfo_reply->rtmax  = oncrpc_iob_get_int ( reply->data );
+	fsinfo_reply->rtpref = oncrpc_iob_get_int ( reply->data );
+
+	return 0;
+}
@@ -50,8 +50,21 @@
 
 FEATURE ( FEATURE_PROTOCOL, "NFS", DHCP_EB_FEATURE_NFS, 1 );
 
+/** Default READ request size (if FSINFO is unsuccessful) */
 #define NFS_RSIZE 100000
 
+/** Maximum READ request size */
+#define NFS_RSIZE_MAX ( 1024 * 1024 )
+
+/** Maximum number of outstanding READ requests */
+#define NFS_READ_WINDOW 4
+
+/** Maximum length of a READ reply header (excluding data) */
+#define NFS_READ_HDR_MAX 512
+
+/** Maximum length of a reply other than a READ reply */
+#define NFS_REPLY_MAX 4096
+
 enum nfs_pm_state {
 	NFS_PORTMAP_NONE = 0,
 	NFS_PORTMAP_MOUNTPORT,
@@ -68,15 +81,31 @@ enum nfs_mount_state {
 
 enum nfs_state {
 	NFS_NONE = 0,
+	NFS_FSINFO,
+	NFS_FSINFO_SENT,
 	NFS_LOOKUP,
 	NFS_LOOKUP_SENT,
 	NFS_READLINK,
 	NFS_READLINK_SENT,
 	NFS_READ,
-	NFS_READ_SENT,
 	NFS_CLOSED,
 };
 
+/**
+ * An outstanding NFS READ request
+ *
+ */
+struct nfs_read_request {
+	/** ONC RPC transaction ID */
+	uint32_t                xid;
+	/** File offset */
+	uint64_t                offset;
+	/** Number of bytes requested (or zero if unused) */
+	uint32_t                count;
+	/** Request has been sent */
+	int                     sent;
+};
+
 /**
  * A NFS request
  *
@@ -108,8 +137,36 @@ struct nfs_request {
 	struct nfs_fh           current_fh;
 	uint64_t                file_offset;
 
-	size_t                  remaining;
-	int                     eof;
+	/** READ request size */
+	uint32_t                rsize;
+	/** Outstanding READ requests */
+	struct nfs_read_request reads[NFS_READ_WINDOW];
+	/** File size */
+	uint64_t                file_size;
+	/** File size is known */
+	int                     size_known;
+
+	/** Start of current reply record */
+	union {
+		uint32_t        words[2];
+		uint8_t         bytes[ONCRPC_RECORD_ID_LEN];
+	}                       rx_id;
+	/** Length of received start of current reply record */
+	size_t                  rx_id_len;
+	/** Length of current reply record */
+	size_t                  rx_len;
+	/** READ request matching current reply record, if any */
+	struct nfs_read_request *rx_read;
+	/** Accumulated header of current reply record */
+	struct io_buffer        *rx_hdr;
+	/** Length of header to accumulate */
+	size_t                  rx_hdr_len;
+	/** Remaining length of current reply record */
+	size_t                  rx_remaining;
+	/** Remaining length of READ data within current reply record */
+	size_t                  rx_data;
+	/** File offset of next READ data byte */
+	uint64_t                rx_offset;
 };
 
 static void nfs_step ( struct nfs_request *nfs );
@@ -127,6 +184,7 @@ static void nfs_free ( struct refcnt *refcnt ) {
 
 	nfs_uri_free ( &nfs->uri );
 
+	free_iob ( nfs->rx_hdr );
 	free ( nfs->hostname );
 	free ( nfs->auth_sys.hostname );
 	free ( nfs );
@@ -343,7 +401,7 @@ static int nfs_mount_deliver ( struct nfs_request *nfs,
 		}
 
 		nfs->current_fh = mnt_reply.fh;
-		nfs->nfs_state = NFS_LOOKUP;
+		nfs->nfs_state = NFS_FSINFO;
 		nfs_step ( nfs );
 
 		goto done;
@@ -364,13 +422,134 @@ done:
 	return 0;
 }
 
+/**
+ * Record file size
+ *
+ * @v nfs               NFS request
+ * @v size              File size (or upper bound on file size)
+ *
+ * A READ reply with the end-of-file flag set and no data may be for
+ * a request lying entirely beyond the end of the file, and so gives
+ * only an upper bound on the file size.  The recorded size is used
+ * only to avoid requesting data beyond the end of the file.
+ */
+static void nfs_set_size ( struct nfs_request *nfs, uint64_t size ) {
+
+	if ( nfs->size_known && ( size >= nfs->file_size ) )
+		return;
+
+	DBGC2 ( nfs, "NFS_OPEN %p size: %llu bytes\n", nfs, size );
+
+	nfs->file_size  = size;
+	nfs->size_known = 1;
+	if ( nfs->file_offset > size )
+		nfs->file_offset = size;
+}
+
+/**
+ * Complete file transfer
+ *
+ * @v nfs               NFS request
+ */
+static void nfs_read_finished ( struct nfs_request *nfs ) {
+
+	DBGC ( nfs, "NFS_OPEN %p READ complete\n", nfs );
+
+	intf_shutdown ( &nfs->nfs_intf, 0 );
+	nfs->nfs_state = NFS_CLOSED;
+	nfs->mount_state++;
+	nfs_mount_step ( nfs );
+}
+
+/**
+ * Send READ requests
+ *
+ * @v nfs               NFS request
+ * @ret rc              Return status code
+ *
+ * Up to NFS_READ_WINDOW READ requests are kept outstanding at any
+ * time, so that throughput is not bounded by the round-trip time.
+ */
+static int nfs_read_step ( struct nfs_request *nfs ) {
+	struct nfs_read_request *read;
+	unsigned int active = 0;
+	unsigned int i;
+	int rc;
+
+	for ( i = 0 ; i < NFS_READ_WINDOW ; i++ ) {
+		read = &nfs->reads[i];
+
+		/* Trim any unsent request to the end of file */
+		if ( read->count && ( ! read->sent ) && nfs->size_known ) {
+			if ( read->offset >= nfs->file_size ) {
+				read->count = 0;
+			} else if ( read->count > ( nfs->file_size -
+			                            read->offset ) ) {
+				read->count = ( nfs->file_size - read->offset );
+			}
+		}
+
+		/* Allocate a new request, if applicable */
+		if ( ! read->count ) {
+			if ( nfs->size_known &&
+			     ( nfs->file_offset >= nfs->file_size ) )
+				continue;
+			read->offset = nfs->file_offset;
+			read->count  = nfs->rsize;
+			read->sent   = 0;
+			if ( nfs->size_known &&
+			     ( read->count > ( nfs->file_size - read->offset ) ) )
+				read->count = ( nfs->file_size - read->offset );
+			nfs->file_offset += read->count;
+		}
+		active++;
+
+		/* Send request, if applicable */
+		if ( read->sent || ! xfer_window ( &nfs->nfs_intf ) )
+			continue;
+		DBGC ( nfs, "NFS_OPEN %p READ call (%#llx+%#x)\n",
+		       nfs, read->offset, read->count );
+		rc = nfs_read ( &nfs->nfs_intf, &nfs->nfs_session,
+		                &nfs->current_fh, read->offset, read->count );
+		if ( rc != 0 )
+			return rc;
+		read->xid  = nfs->nfs_session.rpc_id;
+		read->sent = 1;
+	}
+
+	/* Finish when all requests have completed */
+	if ( ( ! active ) && ( ! nfs->rx_remaining ) )
+		nfs_read_finished ( nfs );
+
+	return 0;
+}
+
 static void nfs_step ( struct nfs_request *nfs ) {
 	int     rc;
 	char    *path_component;
 
+	if ( nfs->nfs_state == NFS_READ ) {
+		rc = nfs_read_step ( nfs );
+		if ( rc != 0 )
+			goto err;
+		return;
+	}
+
 	if ( ! xfer_window ( &nfs->nfs_intf ) )
 		return;
 
+	if ( nfs->nfs_state == NFS_FSINFO ) {
+		DBGC ( nfs, "NFS_OPEN %p FSINFO call\n", nfs );
+
+		rc = nfs_fsinfo ( &nfs->nfs_intf, &nfs->nfs_session,
+		                  &nfs->current_fh );
+		if ( rc != 0 )
+			goto err;
+
+		nfs->nfs_state++;
+		return;
+	}
+
 	if ( nfs->nfs_state == NFS_LOOKUP ) {
 		path_component = nfs_uri_next_path_component ( &nfs->uri );
 
@@ -399,38 +578,186 @@ static void nfs_step ( struct nfs_request *nfs ) {
 		return;
 	}
 
-	if ( nfs->nfs_state == NFS_READ ) {
-		DBGC ( nfs, "NFS_OPEN %p READ call\n", nfs );
+	return;
+err:
+	nfs_done ( nfs, rc );
+}
 
-		rc = nfs_read ( &nfs->nfs_intf, &nfs->nfs_session,
-		                &nfs->current_fh, nfs->file_offset,
-		                NFS_RSIZE );
-		if ( rc != 0 )
-			goto err;
+/**
+ * Deliver READ data
+ *
+ * @v nfs               NFS request
+ * @v io_buf            I/O buffer
+ * @ret rc              Return status code
+ */
+static int nfs_rx_data ( struct nfs_request *nfs, struct io_buffer *io_buf ) {
+	struct xfer_metadata meta;
+	size_t len = iob_len ( io_buf );
+
+	/* Place data at its absolute offset, since replies may
+	 * complete out of order.
+	 */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags  = XFER_FL_ABS_OFFSET;
+	meta.offset = nfs->rx_offset;
+	nfs->rx_offset += len;
+	nfs->rx_data   -= len;
+
+	DBGC2 ( nfs, "NFS_OPEN %p got %zd bytes at %#llx\n",
+		nfs, len, ( ( unsigned long long ) meta.offset ) );
+
+	return xfer_deliver ( &nfs->xfer, io_buf, &meta );
+}
 
-		nfs->nfs_state++;
-		return;
+/**
+ * Deliver copy of READ data
+ *
+ * @v nfs               NFS request
+ * @v data              Data
+ * @v len               Length of data
+ * @ret rc              Return status code
+ */
+static int nfs_rx_data_copy ( struct nfs_request *nfs, const void *data,
+			      size_t len ) {
+	struct io_buffer *io_buf;
+
+	io_buf = xfer_alloc_iob ( &nfs->xfer, len );
+	if ( ! io_buf )
+		return -ENOMEM;
+	memcpy ( iob_put ( io_buf, len ), data, len );
+
+	return nfs_rx_data ( nfs, io_buf );
+}
+
+/**
+ * Handle READ reply header
+ *
+ * @v nfs               NFS request
+ * @v read              READ request
+ * @v io_buf            Start of reply record
+ * @ret rc              Return status code
+ */
+static int nfs_rx_read ( struct nfs_request *nfs,
+			 struct nfs_read_request *read,
+			 struct io_buffer *io_buf ) {
+	struct oncrpc_reply     reply;
+	struct nfs_read_reply   read_reply;
+	size_t                  len;
+	int                     rc;
+
+	DBGC2 ( nfs, "NFS_OPEN %p got READ reply (%#llx+%#x)\n",
+		nfs, read->offset, read->count );
+
+	oncrpc_get_reply ( &nfs->nfs_session, &reply, io_buf );
+	if ( reply.accept_state != 0 )
+		return -EPROTO;
+
+	rc = nfs_get_read_reply ( &read_reply, &reply );
+	if ( rc != 0 )
+		return rc;
+
+	/* Sanity checks */
+	if ( ( io_buf->data > io_buf->tail ) ||
+	     ( read_reply.count > read->count ) ||
+	     ( read_reply.count > ( iob_len ( io_buf ) +
+	                            nfs->rx_remaining ) ) )
+		return -EPROTO;
+
+	/* Prepare to stream data */
+	nfs->rx_offset = read->offset;
+	nfs->rx_data   = read_reply.count;
+
+	/* Record end of file, or re-request remainder of a short read */
+	if ( read_reply.eof ) {
+		nfs_set_size ( nfs, ( read->offset + read_reply.count ) );
+		read->count = 0;
+	} else if ( read_reply.count < read->count ) {
+		if ( ! read_reply.count )
+			return -EPROTO;
+		read->offset += read_reply.count;
+		read->count  -= read_reply.count;
+		read->sent    = 0;
+	} else {
+		read->count = 0;
 	}
 
-	return;
-err:
-	nfs_done ( nfs, rc );
+	/* Deliver any data already received */
+	len = iob_len ( io_buf );
+	if ( len > nfs->rx_data )
+		len = nfs->rx_data;
+	if ( len && ( ( rc = nfs_rx_data_copy ( nfs, io_buf->data,
+	                                         len ) ) != 0 ) )
+		return rc;
+
+	return 0;
 }
 
-static int nfs_deliver ( struct nfs_request *nfs,
-                         struct io_buffer *io_buf,
-                         struct xfer_metadata *meta __unused ) {
+/**
+ * Handle FSINFO reply
+ *
+ * @v nfs               NFS request
+ * @v reply             ONC RPC reply
+ */
+static void nfs_rx_fsinfo ( struct nfs_request *nfs,
+			    struct oncrpc_reply *reply ) {
+	struct nfs_fsinfo_reply fsinfo_reply;
+	uint32_t                rsize;
+	int                     rc;
+
+	DBGC ( nfs, "NFS_OPEN %p got FSINFO reply\n", nfs );
+
+	/* Use the server's preferred READ size, if available */
+	if ( reply->accept_state != 0 ) {
+		rc = -EPROTO;
+	} else {
+		rc = nfs_get_fsinfo_reply ( &fsinfo_reply, reply );
+	}
+	if ( rc == 0 ) {
+		rsize = fsinfo_reply.rtpref;
+		if ( ( ! rsize ) || ( fsinfo_reply.rtmax &&
+		                      ( rsize > fsinfo_reply.rtmax ) ) )
+			rsize = fsinfo_reply.rtmax;
+		if ( rsize > NFS_RSIZE_MAX )
+			rsize = NFS_RSIZE_MAX;
+		if ( rsize )
+			nfs->rsize = rsize;
+	} else {
+		DBGC ( nfs, "NFS_OPEN %p FSINFO failed: %s\n",
+		       nfs, strerror ( rc ) );
+	}
+	DBGC ( nfs, "NFS_OPEN %p using READ size %d\n", nfs, nfs->rsize );
+
+	nfs->nfs_state = NFS_LOOKUP;
+	nfs_step ( nfs );
+}
+
+/**
+ * Handle reply other than a READ reply
+ *
+ * @v nfs               NFS request
+ * @v io_buf            Reply record
+ * @ret rc              Return status code
+ */
+static int nfs_rx_reply ( struct nfs_request *nfs,
+			  struct io_buffer *io_buf ) {
 	int                     rc;
 	struct oncrpc_reply     reply;
 
-	if ( nfs->remaining == 0 ) {
-		oncrpc_get_reply ( &nfs->nfs_session, &reply, io_buf );
-		if ( reply.accept_state != 0 ) {
-			rc = -EPROTO;
-			goto err;
-		}
+	oncrpc_get_reply ( &nfs->nfs_session, &reply, io_buf );
+	if ( reply.rpc_id != nfs->nfs_session.rpc_id ) {
+		DBGC ( nfs, "NFS_OPEN %p ignoring unexpected reply %#08x\n",
+		       nfs, reply.rpc_id );
+		return 0;
+	}
+
+	if ( nfs->nfs_state == NFS_FSINFO_SENT ) {
+		nfs_rx_fsinfo ( nfs, &reply );
+		return 0;
 	}
 
+	if ( reply.accept_state != 0 )
+		return -EPROTO;
+
 	if ( nfs->nfs_state == NFS_LOOKUP_SENT ) {
 		struct nfs_lookup_reply lookup_reply;
 
@@ -438,7 +765,7 @@ static int nfs_deliver ( struct nfs_request *nfs,
 
 		rc = nfs_get_lookup_reply ( &lookup_reply, &reply );
 		if ( rc != 0 )
-			goto err;
+			return rc;
 
 		if ( lookup_reply.ent_type == NFS_ATTR_SYMLINK ) {
 			nfs->readlink_fh = lookup_reply.fh;
@@ -446,14 +773,22 @@ static int nfs_deliver ( struct nfs_request *nfs,
 		} else {
 			nfs->current_fh = lookup_reply.fh;
 
-			if ( nfs->uri.lookup_pos[0] == '\0' )
+			if ( nfs->uri.lookup_pos[0] == '\0' ) {
 				nfs->nfs_state = NFS_READ;
-			else
+				if ( lookup_reply.attributes ) {
+					nfs_set_size ( nfs,
+					               lookup_reply.filesize );
+					/* Presize the receive buffer */
+					xfer_seek ( &nfs->xfer,
+					            lookup_reply.filesize );
+				}
+			} else {
 				nfs->nfs_state--;
+			}
 		}
 
 		nfs_step ( nfs );
-		goto done;
+		return 0;
 	}
 
 	if ( nfs->nfs_state == NFS_READLINK_SENT ) {
@@ -464,20 +799,14 @@ static int nfs_deliver ( struct nfs_request *nfs,
 
 		rc = nfs_get_readlink_reply ( &readlink_reply, &reply );
 		if ( rc != 0 )
-			goto err;
+			return rc;
 
 		if ( readlink_reply.path_len == 0 )
-		{
-			rc = -EINVAL;
-			goto err;
-		}
+			return -EINVAL;
 
 		if ( ! ( path = strndup ( readlink_reply.path,
 		                          readlink_reply.path_len ) ) )
-		{
-			rc = -ENOMEM;
-			goto err;
-		}
+			return -ENOMEM;
 
 		nfs_uri_symlink ( &nfs->uri, path );
 		free ( path );
@@ -487,64 +816,159 @@ static int nfs_deliver ( struct nfs_request *nfs,
 
 		nfs->nfs_state = NFS_LOOKUP;
 		nfs_step ( nfs );
-		goto done;
+		return 0;
 	}
 
-	if ( nfs->nfs_state == NFS_READ_SENT ) {
-		if ( nfs->remaining == 0 ) {
-			DBGC ( nfs, "NFS_OPEN %p got READ reply\n", nfs );
+	return -EPROTO;
+}
 
-			struct nfs_read_reply read_reply;
+/**
+ * Start receiving a reply record
+ *
+ * @v nfs               NFS request
+ * @ret rc              Return status code
+ */
+static int nfs_rx_start ( struct nfs_request *nfs ) {
+	struct nfs_read_request *read;
+	uint32_t                xid;
+	unsigned int            i;
+	int                     rc;
 
-			rc = nfs_get_read_reply ( &read_reply, &reply );
-			if ( rc != 0 )
-				goto err;
+	/* Identify record */
+	rc = oncrpc_record_id ( nfs->rx_id.bytes, &nfs->rx_len, &xid );
+	if ( rc != 0 )
+		return rc;
 
-			if ( nfs->file_offset == 0 ) {
-				DBGC2 ( nfs, "NFS_OPEN %p size: %llu bytes\n",
-				        nfs, read_reply.filesize );
+	/* Match against outstanding READ requests */
+	nfs->rx_read = NULL;
+	for ( i = 0 ; i < NFS_READ_WINDOW ; i++ ) {
+		read = &nfs->reads[i];
+		if ( read->count && read->sent && ( read->xid == xid ) )
+			nfs->rx_read = read;
+	}
 
-				xfer_seek ( &nfs->xfer, read_reply.filesize );
-				xfer_seek ( &nfs->xfer, 0 );
-			}
+	/* Accumulate only the header of a READ reply, and the whole
+	 * of any other reply.
+	 */
+	nfs->rx_hdr_len = nfs->rx_len;
+	if ( nfs->rx_read ) {
+		if ( nfs->rx_hdr_len > NFS_READ_HDR_MAX )
+			nfs->rx_hdr_len = NFS_READ_HDR_MAX;
+	} else if ( nfs->rx_hdr_len > NFS_REPLY_MAX ) {
+		return -ERANGE;
+	}
 
-			nfs->file_offset += read_reply.count;
-			nfs->remaining    = read_reply.count;
-			nfs->eof          = read_reply.eof;
-		}
+	nfs->rx_hdr = alloc_iob ( nfs->rx_hdr_len );
+	if ( ! nfs->rx_hdr )
+		return -ENOMEM;
+	memcpy ( iob_put ( nfs->rx_hdr, sizeof ( nfs->rx_id ) ),
+	         nfs->rx_id.bytes, sizeof ( nfs->rx_id ) );
 
-		size_t len = iob_len ( io_buf );
-		if ( len > nfs->remaining )
-			iob_unput ( io_buf, len - nfs->remaining );
+	return 0;
+}
 
-		nfs->remaining -= iob_len ( io_buf );
+/**
+ * Handle accumulated start of reply record
+ *
+ * @v nfs               NFS request
+ * @ret rc              Return status code
+ */
+static int nfs_rx_header ( struct nfs_request *nfs ) {
+	struct io_buffer        *io_buf = nfs->rx_hdr;
+	int                     rc;
 
-		DBGC ( nfs, "NFS_OPEN %p got %zd bytes\n", nfs,
-		       iob_len ( io_buf ) );
+	nfs->rx_hdr       = NULL;
+	nfs->rx_id_len    = 0;
+	nfs->rx_remaining = ( nfs->rx_len - iob_len ( io_buf ) );
+	nfs->rx_data      = 0;
 
-		rc = xfer_deliver_iob ( &nfs->xfer, iob_disown ( io_buf ) );
-		if ( rc != 0 )
-			goto err;
+	if ( nfs->rx_read ) {
+		rc = nfs_rx_read ( nfs, nfs->rx_read, io_buf );
+	} else {
+		rc = nfs_rx_reply ( nfs, io_buf );
+	}
+	free_iob ( io_buf );
 
-		if ( nfs->remaining == 0 ) {
-			if ( ! nfs->eof ) {
-				nfs->nfs_state--;
-				nfs_step ( nfs );
+	return rc;
+}
+
+static int nfs_deliver ( struct nfs_request *nfs,
+                         struct io_buffer *io_buf,
+                         struct xfer_metadata *meta __unused ) {
+	int                     rc;
+	size_t                  len;
+	size_t                  data_len;
+
+	while ( io_buf && iob_len ( io_buf ) &&
+	        ( nfs->nfs_state != NFS_CLOSED ) ) {
+
+		/* Stream remainder of READ reply, discarding padding */
+		if ( nfs->rx_remaining ) {
+			len = iob_len ( io_buf );
+			if ( len > nfs->rx_remaining )
+				len = nfs->rx_remaining;
+			data_len = len;
+			if ( data_len > nfs->rx_data )
+				data_len = nfs->rx_data;
+			nfs->rx_remaining -= len;
+			if ( data_len == iob_len ( io_buf ) ) {
+				rc = nfs_rx_data ( nfs, iob_disown ( io_buf ) );
 			} else {
-				intf_shutdown ( &nfs->nfs_intf, 0 );
-				nfs->nfs_state++;
-				nfs->mount_state++;
-				nfs_mount_step ( nfs );
+				rc = ( data_len ?
+				       nfs_rx_data_copy ( nfs, io_buf->data,
+				                          data_len ) : 0 );
+				iob_pull ( io_buf, len );
 			}
+			if ( rc != 0 )
+				goto err;
+			if ( ( ! nfs->rx_remaining ) &&
+			     ( nfs->nfs_state == NFS_READ ) )
+				nfs_step ( nfs );
+			continue;
 		}
 
-		return 0;
+		/* Accumulate enough of record to identify it */
+		if ( nfs->rx_id_len < sizeof ( nfs->rx_id ) ) {
+			len = ( sizeof ( nfs->rx_id ) - nfs->rx_id_len );
+			if ( len > iob_len ( io_buf ) )
+				len = iob_len ( io_buf );
+			memcpy ( &nfs->rx_id.bytes[nfs->rx_id_len],
+			         io_buf->data, len );
+			iob_pull ( io_buf, len );
+			nfs->rx_id_len += len;
+			if ( ( nfs->rx_id_len == sizeof ( nfs->rx_id ) ) &&
+			     ( ( rc = nfs_rx_start ( nfs ) ) != 0 ) )
+				goto err;
+			if ( nfs->rx_hdr &&
+			     ( iob_len ( nfs->rx_hdr ) < nfs->rx_hdr_len ) )
+				continue;
+		} else {
+			/* Accumulate start of record */
+			len = ( nfs->rx_hdr_len - iob_len ( nfs->rx_hdr ) );
+			if ( len > iob_len ( io_buf ) )
+				len = iob_len ( io_buf );
+			memcpy ( iob_put ( nfs->rx_hdr, len ), io_buf->data,
+			         len );
+			iob_pull ( io_buf, len );
+			if ( iob_len ( nfs->rx_hdr ) < nfs->rx_hdr_len )
+				continue;
+		}
+
+		/* Handle accumulated start of record */
+		if ( nfs->rx_hdr ) {
+			if ( ( rc = nfs_rx_header ( nfs ) ) != 0 )
+				goto err;
+			if ( ( ! nfs->rx_remaining ) &&
+			     ( nfs->nfs_state == NFS_READ ) )
+				nfs_step ( nfs );
+		}
 	}
 
-	rc = -EPROTO;
+	free_iob ( io_buf );
+	return 0;
+
 err:
 	nfs_done ( nfs, rc );
-done:
 	free_iob ( io_buf );
 	return 0;
 }
@@ -643,6 +1067,8 @@ static int nfs_open ( struct interface *xfer, struct uri *uri ) {
 	if ( rc != 0 )
 		goto err_cred;
 
+	nfs->rsize = NFS_RSIZE;
+
 	ref_init ( &nfs->refcnt, nfs_free );
 	intf_init ( &nfs->xfer, &nfs_xfer_desc, &nfs->refcnt );
 	intf_init ( &nfs->pm_intf, &nfs_pm_desc, &nfs->refcnt );
@@ -165,14 +165,26 @@ static char * peerdist_discovery_reply_values ( char *data, size_t len,
 	char *out;
 	char c;
 
-	/* Locate opening tag */
-	snprintf ( buf, sizeof ( buf ), "<%s>", name );
-	open = peerdist_discovery_reply_tag ( data, len, buf );
-	if ( ! open )
+	/* Locate opening tag, which may include attributes */
+	snprintf ( buf, sizeof ( buf ), "<%s", name );
+	do {
+		open = peerdist_discovery_reply_tag ( data, len, buf );
+		if ( ! open )
+			return NULL;
+		start = ( open + strlen ( buf ) );
+		len -= ( start - data );
+		data = start;
+	} while ( len && ( *data != '>' ) && ( ! isspace ( *data ) ) );
+
+	/* Skip any attributes */
+	while ( len && ( *data != '>' ) ) {
+		data++;
+		len--;
+	}
+	if ( ! len )
 		return NULL;
-	start = ( open + strlen ( buf ) );
-	len -= ( start - data );
-	data = start;
+	start = ++data;
+	len--;
 
 	/* Locate closing tag */
 	snprintf ( buf, sizeof ( buf ), "</%s>", name );
@@ -284,3 +296,144 @@ int peerdist_discovery_reply ( char *data, size_t len,
 
 	return 0;
 }
+
+/**
+ * Parse discovery probe
+ *
+ * @v data		Probe data (not NUL-terminated, will be modified)
+ * @v len		Length of probe data
+ * @v probe		Discovery probe to fill in
+ * @ret rc		Return status code
+ *
+ * The discovery probe includes pointers to strings within the
+ * modified probe data.
+ */
+int peerdist_discovery_probe ( char *data, size_t len,
+			       struct peerdist_discovery_probe *probe ) {
+	char *types;
+	char *message;
+	char *scopes;
+
+	/* Find <wsd:Types> tag */
+	types = peerdist_discovery_reply_values ( data, len, "wsd:Types" );
+	if ( ! types ) {
+		DBGC ( probe, "PCCRD %p missing <wsd:Types> tag\n", probe );
+		return -ENOENT;
+	}
+
+	/* Check for a PeerDist probe */
+	for ( ; *types ; types += ( strlen ( types ) + 1 /* NUL */ ) ) {
+		if ( strcmp ( types, "PeerDist:PeerDistData" ) == 0 )
+			break;
+	}
+	if ( ! *types ) {
+		DBGC ( probe, "PCCRD %p not a PeerDist probe\n", probe );
+		return -ENOTTY;
+	}
+
+	/* Find <wsa:MessageID> tag */
+	message = peerdist_discovery_reply_values ( data, len,
+						    "wsa:MessageID" );
+	if ( ! ( message && *message ) ) {
+		DBGC ( probe, "PCCRD %p missing <wsa:MessageID> tag\n",
+		       probe );
+		return -ENOENT;
+	}
+
+	/* Find <wsd:Scopes> tag */
+	scopes = peerdist_discovery_reply_values ( data, len, "wsd:Scopes" );
+	if ( ! scopes ) {
+		DBGC ( probe, "PCCRD %p missing <wsd:Scopes> tag\n", probe );
+		return -ENOENT;
+	}
+
+	/* Fill in discovery probe */
+	probe->message = message;
+	probe->ids = scopes;
+
+	return 0;
+}
+
+/** Discovery probe match format */
+#define PEERDIST_DISCOVERY_MATCH					      \
+	"<?xml version=\"1.0\" encoding=\"utf-8\"?>"			      \
+	"<soap:Envelope "						      \
+	    "xmlns:soap=\"http://www.w3.org/2003/05/soap-envelope\" "	      \
+	    "xmlns:wsa=\"http://schemas.xmlsoap.org/ws/2004/08/addressing\" " \
+	    "xmlns:wsd=\"http://schemas.xmlsoap.org/ws/2005/04/discovery\" "  \
+	    "xmlns:PeerDist=\"http://schemas.microsoft.com/p2p/"	      \
+			     "2007/09/PeerDistributionDiscovery\">"	      \
+	  "<soap:Header>"						      \
+	    "<wsa:To>"							      \
+	      "http://schemas.xmlsoap.org/ws/2004/08/addressing/role/"	      \
+	      "anonymous"						      \
+	    "</wsa:To>"							      \
+	    "<wsa:Action>"						      \
+	      "http://schemas.xmlsoap.org/ws/2005/04/discovery/ProbeMatches"  \
+	    "</wsa:Action>"						      \
+	    "<wsa:MessageID>"						      \
+	      "urn:uuid:%s"						      \
+	    "</wsa:MessageID>"						      \
+	    "<wsa:RelatesTo>"						      \
+	      "%s"							      \
+	    "</wsa:RelatesTo>"						      \
+	    "<wsd:AppSequence InstanceId=\"1\" MessageNumber=\"1\"/>"	      \
+	  "</soap:Header>"						      \
+	  "<soap:Body>"							      \
+	    "<wsd:ProbeMatches>"					      \
+	      "<wsd:ProbeMatch>"					      \
+		"<wsa:EndpointReference>"				      \
+		  "<wsa:Address>"					      \
+		    "urn:uuid:%s"					      \
+		  "</wsa:Address>"					      \
+		"</wsa:EndpointReference>"				      \
+		"<wsd:Types>"						      \
+		  "PeerDist:PeerDistData"				      \
+		"</wsd:Types>"						      \
+		"<wsd:Scopes>"						      \
+		  "%s"							      \
+		"</wsd:Scopes>"						      \
+		"<wsd:XAddrs>"						      \
+		  "%s"							      \
+		"</wsd:XAddrs>"						      \
+		"<wsd:MetadataVersion>"					      \
+		  "1"							      \
+		"</wsd:MetadataVersion>"				      \
+		"<PeerDist:PeerData>"					      \
+		  "<PeerDist:BlockCount>"				      \
+		    "%s"						      \
+		  "</PeerDist:BlockCount>"				      \
+		"</PeerDist:PeerData>"					      \
+	      "</wsd:ProbeMatch>"					      \
+	    "</wsd:ProbeMatches>"					      \
+	  "</soap:Body>"						      \
+	"</soap:Envelope>"
+
+/**
+ * Construct discovery probe match
+ *
+ * @v uuid		Message UUID string
+ * @v relates		Message ID of discovery probe
+ * @v endpoint		Endpoint UUID string
+ * @v ids		Space-separated list of segment identifier strings
+ * @v counts		Concatenated list of block counts
+ * @v location		Peer location
+ * @ret match		Discovery probe match, or NULL on failure
+ *
+ * The probe match is dynamically allocated; the caller must
+ * eventually free() the probe match.
+ */
+char * peerdist_discovery_match ( const char *uuid, const char *relates,
+				  const char *endpoint, const char *ids,
+				  const char *counts, const char *location ) {
+	char *match;
+	int len;
+
+	/* Construct probe match */
+	len = asprintf ( &match, PEERDIST_DISCOVERY_MATCH, uuid, relates,
+			 endpoint, ids, location, counts );
+	if ( len < 0 )
+		return NULL;
+
+	return match;
+}
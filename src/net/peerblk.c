@@ -102,6 +102,22 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define PEERBLK_MAX_ATTEMPT_CYCLES 4
 
+/** PeerDist straggler threshold (as a multiple of the peer's latency)
+ *
+ * A retrieval protocol download attempt that takes significantly
+ * longer than the peer's smoothed latency is abandoned in favour of
+ * the next peer, provided that other peers are available.
+ *
+ * This is a policy decision.
+ */
+#define PEERBLK_STRAGGLER_SCALE 4
+
+/** PeerDist minimum straggler threshold
+ *
+ * This is a policy decision.
+ */
+#define PEERBLK_STRAGGLER_MIN ( 1 * TICKS_PER_SEC )
+
 /** PeerDist block download profiler */
 static struct profiler peerblk_download_profiler __profiler =
 	{ .name = "peerblk.download" };
@@ -179,6 +195,14 @@ static void peerblk_reset ( struct peerdist_block *peerblk, int rc ) {
 	if ( peerblk->queue )
 		peerblk_dequeue ( peerblk );
 
+	/* Record attempt outcome against peer, if applicable */
+	if ( peerblk->active ) {
+		peerdisc_finish ( peerblk->active,
+				  ( currticks() - peerblk->attempted ), rc );
+		peerblk->active = NULL;
+	}
+	peerblk->deadline = 0;
+
 	/* Empty received data buffer */
 	xferbuf_free ( &peerblk->buffer );
 	peerblk->pos = 0;
@@ -574,6 +598,29 @@ static struct peerdist_block_queue peerblk_raw_queue = {
  ******************************************************************************
  */
 
+/**
+ * Calculate retrieval protocol download attempt timeout
+ *
+ * @v peerblk		PeerDist block download
+ * @v timeout		Progress timeout
+ * @ret timeout		Progress timeout, limited by any straggler deadline
+ */
+static unsigned long peerblk_retrieval_timeout ( struct peerdist_block *peerblk,
+						 unsigned long timeout ) {
+	unsigned long remaining;
+
+	/* Use progress timeout if there is no straggler deadline */
+	if ( ! peerblk->deadline )
+		return timeout;
+
+	/* Expire (almost) immediately if deadline has already passed */
+	remaining = ( peerblk->deadline - currticks() );
+	if ( ( ( signed long ) remaining ) <= 0 )
+		return 1;
+
+	return ( ( remaining < timeout ) ? remaining : timeout );
+}
+
 /**
  * Construct PeerDist retrieval protocol URI
  *
@@ -656,7 +703,9 @@ static int peerblk_retrieval_open ( struct peerdist_block *peerblk,
 
 	/* Start download attempt timer */
 	peerblk->rc = -ETIMEDOUT;
-	start_timer_fixed ( &peerblk->timer, PEERBLK_RETRIEVAL_OPEN_TIMEOUT );
+	start_timer_fixed ( &peerblk->timer,
+			    peerblk_retrieval_timeout ( peerblk,
+					PEERBLK_RETRIEVAL_OPEN_TIMEOUT ) );
 
  err_open:
 	uri_put ( uri );
@@ -763,7 +812,9 @@ static int peerblk_retrieval_rx ( struct peerdist_block *peerblk,
 	peerblk->pos = end;
 
 	/* Extend download attempt timer */
-	start_timer_fixed ( &peerblk->timer, PEERBLK_RETRIEVAL_RX_TIMEOUT );
+	start_timer_fixed ( &peerblk->timer,
+			    peerblk_retrieval_timeout ( peerblk,
+					PEERBLK_RETRIEVAL_RX_TIMEOUT ) );
 
 	/* Stall download attempt (for testing) if applicable */
 	if ( ( start < peerblk->end ) && ( end >= peerblk->end ) &&
@@ -1269,6 +1320,71 @@ static void peerblk_retrieval_close ( struct peerdist_block *peerblk, int rc ) {
  ******************************************************************************
  */
 
+/**
+ * Move to next peer within current attempt cycle
+ *
+ * @v peerblk		PeerDist block download
+ * @ret peer		Next peer, or NULL at end of cycle
+ *
+ * Each cycle starts with the currently preferred peer (as chosen by
+ * peerdisc_select()) and continues around the list of peers, so that
+ * concurrent block downloads are striped across all peers rather
+ * than all starting with the first discovered peer.
+ */
+static struct peerdisc_peer * peerblk_next ( struct peerdist_block *peerblk ) {
+	struct peerdisc_segment *segment = peerblk->discovery.segment;
+	struct peerdisc_peer *head;
+	struct peerdisc_peer *peer;
+
+	/* Start a new cycle, or move to the next peer in this cycle */
+	head = list_entry ( &segment->peers, struct peerdisc_peer, list );
+	peer = peerblk->peer;
+	if ( ( peer == NULL ) || ( peer == head ) ) {
+		peer = peerdisc_select ( segment );
+		peerblk->first = peer;
+	} else {
+		peer = list_next_entry ( peer, &segment->peers, list );
+		if ( ! peer ) {
+			peer = list_first_entry ( &segment->peers,
+						  struct peerdisc_peer, list );
+		}
+		if ( peer == peerblk->first )
+			peer = NULL;
+	}
+
+	/* Record position (using the list head to indicate the end
+	 * of the cycle, i.e. a raw download attempt).
+	 */
+	peerblk->peer = ( peer ? peer : head );
+	return peer;
+}
+
+/**
+ * Calculate straggler deadline for retrieval protocol download attempt
+ *
+ * @v peerblk		PeerDist block download
+ * @v peer		Peer
+ * @ret deadline	Straggler deadline, or zero for no deadline
+ */
+static unsigned long peerblk_deadline ( struct peerdist_block *peerblk,
+					struct peerdisc_peer *peer ) {
+	struct peerdisc_segment *segment = peerblk->discovery.segment;
+	unsigned long limit;
+
+	/* Never abandon the only available peer, or a peer whose
+	 * latency has not yet been measured.
+	 */
+	if ( list_is_singular ( &segment->peers ) || ( ! peer->samples ) )
+		return 0;
+
+	/* Allow a multiple of the peer's smoothed latency */
+	limit = ( PEERBLK_STRAGGLER_SCALE * peer->latency );
+	if ( limit < PEERBLK_STRAGGLER_MIN )
+		limit = PEERBLK_STRAGGLER_MIN;
+
+	return ( peerblk->attempted + limit );
+}
+
 /**
  * Handle PeerDist retry timer expiry
  *
@@ -1280,8 +1396,8 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		container_of ( timer, struct peerdist_block, timer );
 	struct peerdisc_segment *segment = peerblk->discovery.segment;
 	struct peerdisc_peer *head;
+	struct peerdisc_peer *peer;
 	unsigned long now = peerblk_timestamp();
-	const char *location;
 	int rc;
 
 	/* Profile discovery timeout, if applicable */
@@ -1306,7 +1422,7 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 	peerblk_reset ( peerblk, -ETIMEDOUT );
 
 	/* Record attempt start time */
-	peerblk->attempted = now;
+	peerblk->attempted = currticks();
 
 	/* If we have exceeded our maximum number of attempt cycles
 	 * (each cycle comprising a retrieval protocol download from
@@ -1321,26 +1437,23 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		goto err;
 	}
 
-	/* If we have not yet made any download attempts, then move to
-	 * the start of the peer list.
-	 */
-	if ( peerblk->peer == NULL )
-		peerblk->peer = head;
-
 	/* Attempt retrieval protocol download from next usable peer */
-	list_for_each_entry_continue ( peerblk->peer, &segment->peers, list ) {
+	while ( ( peer = peerblk_next ( peerblk ) ) != NULL ) {
 
 		/* Attempt retrieval protocol download from this peer */
-		location = peerblk->peer->location;
+		peerblk->deadline = peerblk_deadline ( peerblk, peer );
 		if ( ( rc = peerblk_retrieval_open ( peerblk,
-						     location ) ) != 0 ) {
+						     peer->location ) ) != 0 ) {
 			/* Non-fatal: continue to try next peer */
 			continue;
 		}
 
 		/* Peer download started */
+		peerblk->active = peer;
+		peerdisc_start ( peer );
 		return;
 	}
+	peerblk->deadline = 0;
 
 	/* Add to raw download queue */
 	peerblk_enqueue ( peerblk, &peerblk_raw_queue );
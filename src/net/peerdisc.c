@@ -56,6 +56,18 @@ static LIST_HEAD ( peerdisc_segments );
 /** Time between repeated discovery attempts */
 #define PEERDISC_REPEAT_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** Maximum failure penalty (as a power of two)
+ *
+ * This is a policy decision.
+ */
+#define PEERDISC_MAX_STRIKES 8
+
+/** Smoothed latency weighting (as a reciprocal)
+ *
+ * This is a policy decision.
+ */
+#define PEERDISC_LATENCY_WEIGHT 8
+
 /** Default discovery timeout (in seconds) */
 #define PEERDISC_DEFAULT_TIMEOUT_SECS 2
 
@@ -113,6 +125,116 @@ void peerdisc_stat ( struct interface *intf, struct peerdisc_peer *peer,
 	intf_put ( dest );
 }
 
+/******************************************************************************
+ *
+ * Peer selection
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Calculate estimated cost of using a peer
+ *
+ * @v peer		PeerDist discovery peer
+ * @ret cost		Estimated cost
+ *
+ * The cost is an estimate of the time at which a newly assigned block
+ * download would complete, given the number of attempts already in
+ * progress and the smoothed latency of previous attempts.  Choosing
+ * the lowest-cost peer therefore stripes blocks across all peers in
+ * proportion to their observed throughput.
+ */
+static unsigned long peerdisc_cost ( struct peerdisc_peer *peer ) {
+	unsigned long cost;
+	unsigned int strikes;
+
+	/* Probe peers with no measured latency one attempt at a time */
+	if ( ! peer->samples ) {
+		if ( peer->busy )
+			return ~0UL;
+		cost = 1;
+	} else {
+		cost = ( ( peer->busy + 1 ) * ( peer->latency + 1 ) );
+	}
+
+	/* Penalise peers with recent failures */
+	strikes = peer->strikes;
+	if ( strikes > PEERDISC_MAX_STRIKES )
+		strikes = PEERDISC_MAX_STRIKES;
+	if ( cost > ( ~0UL >> strikes ) )
+		return ~0UL;
+	return ( cost << strikes );
+}
+
+/**
+ * Select preferred peer
+ *
+ * @v segment		PeerDist discovery segment
+ * @ret peer		Preferred peer, or NULL if no peers are available
+ */
+struct peerdisc_peer * peerdisc_select ( struct peerdisc_segment *segment ) {
+	struct peerdisc_peer *peer;
+	struct peerdisc_peer *best = NULL;
+	unsigned long best_cost = 0;
+	unsigned long cost;
+
+	/* Find lowest-cost peer (preferring earlier peers on a tie) */
+	list_for_each_entry ( peer, &segment->peers, list ) {
+		cost = peerdisc_cost ( peer );
+		if ( ( ! best ) || ( cost < best_cost ) ) {
+			best = peer;
+			best_cost = cost;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Record start of block download attempt from peer
+ *
+ * @v peer		PeerDist discovery peer
+ */
+void peerdisc_start ( struct peerdisc_peer *peer ) {
+
+	peer->busy++;
+}
+
+/**
+ * Record completion of block download attempt from peer
+ *
+ * @v peer		PeerDist discovery peer
+ * @v elapsed		Duration of attempt (in ticks)
+ * @v rc		Attempt status code
+ */
+void peerdisc_finish ( struct peerdisc_peer *peer, unsigned long elapsed,
+		       int rc ) {
+
+	/* Sanity check */
+	assert ( peer->busy > 0 );
+	peer->busy--;
+
+	/* Record failures */
+	if ( rc != 0 ) {
+		peer->strikes++;
+		DBGC2 ( peer, "PEERDISC %s failed after %ld ticks (%d strikes)"
+			"\n", peer->location, elapsed, peer->strikes );
+		return;
+	}
+
+	/* Update smoothed latency and forgive earlier failures */
+	if ( peer->samples++ ) {
+		peer->latency = ( ( ( PEERDISC_LATENCY_WEIGHT - 1 ) *
+				    peer->latency + elapsed ) /
+				  PEERDISC_LATENCY_WEIGHT );
+	} else {
+		peer->latency = elapsed;
+	}
+	peer->strikes /= 2;
+	DBGC2 ( peer, "PEERDISC %s completed in %ld ticks (latency %ld)\n",
+		peer->location, elapsed, peer->latency );
+}
+
 /******************************************************************************
  *
  * Discovery sockets
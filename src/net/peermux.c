@@ -31,6 +31,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/job.h>
 #include <ipxe/peerblk.h>
 #include <ipxe/peermux.h>
+#include <ipxe/peerserv.h>
 
 /** @file
  *
@@ -38,6 +39,17 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/**
+ * Offer downloaded content for hosting (when hosting is not present)
+ *
+ * @v uri		Original URI
+ * @v info		Content information
+ */
+__weak void peerserv_offer ( struct uri *uri __unused,
+			     const struct peerdist_info *info __unused ) {
+	/* Nothing to do */
+}
+
 /**
  * Free PeerDist download multiplexer
  *
@@ -209,8 +221,10 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 		 */
 		if ( next_segment >= info->segments ) {
 			process_del ( &peermux->process );
-			if ( list_empty ( &peermux->busy ) )
+			if ( list_empty ( &peermux->busy ) ) {
+				peerserv_offer ( peermux->uri, info );
 				peermux_close ( peermux, 0 );
+			}
 			return;
 		}
 
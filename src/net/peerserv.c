@@ -0,0 +1,1258 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/image.h>
+#include <ipxe/uuid.h>
+#include <ipxe/base16.h>
+#include <ipxe/retry.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/settings.h>
+#include <ipxe/udp.h>
+#include <ipxe/tcp.h>
+#include <ipxe/in.h>
+#include <ipxe/aes.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/pccrr.h>
+#include <ipxe/peerserv.h>
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content hosting
+ *
+ * Content that has been downloaded via PeerDist may be served to
+ * other peers.  The content information for each completed download
+ * is retained, and any registered image with the same URI is used as
+ * the source of the segment data.  We answer discovery probes for any
+ * segments that we are able to serve, and serve retrieval protocol
+ * requests via a minimal HTTP server.
+ *
+ * Content hosting is disabled unless explicitly enabled via the
+ * "peerserve" setting.
+ */
+
+/** A PeerDist hosted content item */
+struct peerserv_content {
+	/** List of hosted content */
+	struct list_head list;
+	/** Original URI string */
+	char *uri;
+	/** Content information */
+	struct peerdist_info info;
+};
+
+/** A PeerDist hosted segment */
+struct peerserv_segment {
+	/** Content information segment */
+	struct peerdist_info_segment segment;
+	/** Image providing segment data */
+	struct image *image;
+	/** First available block */
+	unsigned int first;
+	/** Number of available blocks */
+	unsigned int count;
+};
+
+/** A PeerDist retrieval protocol connection */
+struct peerserv_connection {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Request buffer */
+	struct xfer_buffer buffer;
+	/** Idle timer */
+	struct retry_timer timer;
+};
+
+/** A PeerDist retrieval protocol response message header */
+struct peerserv_msg_header {
+	/** Transport header */
+	struct peerdist_msg_transport_header transport;
+	/** Message header */
+	struct peerdist_msg_header msg;
+} __attribute__ (( packed ));
+
+/** List of hosted content */
+static LIST_HEAD ( peerserv_contents );
+
+/** Number of hosted content items */
+static unsigned int peerserv_count;
+
+/** Content hosting is enabled */
+static long peerserv_enabled;
+
+/** Content hosting is running */
+static int peerserv_running;
+
+/** Endpoint UUID */
+static union uuid peerserv_uuid;
+
+static struct interface peerserv_disc;
+static struct tcp_listener peerserv_listener;
+
+/******************************************************************************
+ *
+ * Hosted content
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Free hosted content item
+ *
+ * @v content		Hosted content item
+ */
+static void peerserv_free ( struct peerserv_content *content ) {
+
+	list_del ( &content->list );
+	peerserv_count--;
+	ufree ( content->info.raw.data );
+	free ( content->uri );
+	free ( content );
+}
+
+/**
+ * Offer downloaded content for hosting
+ *
+ * @v uri		Original URI
+ * @v info		Content information
+ */
+void peerserv_offer ( struct uri *uri, const struct peerdist_info *info ) {
+	struct peerserv_content *content;
+	struct peerserv_content *tmp;
+	size_t len = info->raw.len;
+	userptr_t data;
+	char *uri_string;
+	int rc;
+
+	/* Do nothing unless content hosting is enabled */
+	if ( ! peerserv_enabled )
+		return;
+
+	/* Construct URI string */
+	uri_string = format_uri_alloc ( uri );
+	if ( ! uri_string )
+		goto err_uri;
+
+	/* Discard any existing content with the same URI */
+	list_for_each_entry_safe ( content, tmp, &peerserv_contents, list ) {
+		if ( strcmp ( content->uri, uri_string ) == 0 )
+			peerserv_free ( content );
+	}
+
+	/* Discard oldest content, if applicable */
+	if ( peerserv_count >= PEERSERV_MAX_CONTENT ) {
+		content = list_last_entry ( &peerserv_contents,
+					    struct peerserv_content, list );
+		assert ( content != NULL );
+		peerserv_free ( content );
+	}
+
+	/* Allocate and initialise structure */
+	content = zalloc ( sizeof ( *content ) );
+	if ( ! content )
+		goto err_alloc;
+	content->uri = uri_string;
+	uri_string = NULL;
+
+	/* Copy and reparse content information */
+	data = umalloc ( len );
+	if ( ! data )
+		goto err_umalloc;
+	memcpy_user ( data, 0, info->raw.data, 0, len );
+	if ( ( rc = peerdist_info ( data, len, &content->info ) ) != 0 ) {
+		DBGC ( content, "PEERSERV %p could not parse content "
+		       "information: %s\n", content, strerror ( rc ) );
+		goto err_info;
+	}
+
+	/* Add to list of hosted content */
+	list_add ( &content->list, &peerserv_contents );
+	peerserv_count++;
+	DBGC ( content, "PEERSERV %p hosting %d segments of %s\n",
+	       content, content->info.segments, content->uri );
+
+	return;
+
+ err_info:
+	ufree ( data );
+ err_umalloc:
+	free ( content->uri );
+	free ( content );
+ err_alloc:
+	free ( uri_string );
+ err_uri:
+	return;
+}
+
+/**
+ * Find image providing hosted content
+ *
+ * @v content		Hosted content item
+ * @ret image		Image, or NULL if not found
+ */
+static struct image * peerserv_image ( struct peerserv_content *content ) {
+	struct peerdist_info *info = &content->info;
+	struct image *image;
+	char *uri_string;
+	int match;
+
+	/* Find a registered image with the same URI and length */
+	for_each_image ( image ) {
+		if ( ! image->uri )
+			continue;
+		if ( image->len != ( info->trim.end - info->trim.start ) )
+			continue;
+		uri_string = format_uri_alloc ( image->uri );
+		if ( ! uri_string )
+			continue;
+		match = ( strcmp ( uri_string, content->uri ) == 0 );
+		free ( uri_string );
+		if ( match )
+			return image;
+	}
+
+	return NULL;
+}
+
+/**
+ * Identify available blocks within hosted segment
+ *
+ * @v hosted		Hosted segment
+ * @ret rc		Return status code
+ *
+ * Only blocks lying entirely within the trimmed content range are
+ * available, since the image contains only the trimmed content.
+ */
+static int peerserv_available ( struct peerserv_segment *hosted ) {
+	struct peerdist_info_segment *segment = &hosted->segment;
+	struct peerdist_info_block block;
+	unsigned int i;
+	int rc;
+
+	/* Count available blocks */
+	hosted->first = 0;
+	hosted->count = 0;
+	for ( i = 0 ; i < segment->blocks ; i++ ) {
+		if ( ( rc = peerdist_info_block ( segment, &block, i ) ) != 0 )
+			return rc;
+		if ( ( block.trim.start != block.range.start ) ||
+		     ( block.trim.end != block.range.end ) ||
+		     ( block.range.start == block.range.end ) )
+			continue;
+		if ( ! hosted->count )
+			hosted->first = i;
+		hosted->count++;
+	}
+
+	return 0;
+}
+
+/**
+ * Find hosted segment
+ *
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ * @v hosted		Hosted segment to fill in
+ * @ret rc		Return status code
+ */
+static int peerserv_find ( const void *id, size_t digestsize,
+			   struct peerserv_segment *hosted ) {
+	struct peerdist_info_segment *segment = &hosted->segment;
+	struct peerserv_content *content;
+	struct peerdist_info *info;
+	struct image *image;
+	unsigned int i;
+	int rc;
+
+	/* Check each hosted content item */
+	list_for_each_entry ( content, &peerserv_contents, list ) {
+
+		/* Skip content with a different digest size */
+		info = &content->info;
+		if ( info->digestsize != digestsize )
+			continue;
+
+		/* Skip content with no corresponding image */
+		image = peerserv_image ( content );
+		if ( ! image )
+			continue;
+
+		/* Check each segment */
+		for ( i = 0 ; i < info->segments ; i++ ) {
+			if ( ( rc = peerdist_info_segment ( info, segment,
+							    i ) ) != 0 )
+				return rc;
+			if ( memcmp ( segment->id, id, digestsize ) == 0 ) {
+				hosted->image = image;
+				return peerserv_available ( hosted );
+			}
+		}
+	}
+
+	return -ENOENT;
+}
+
+/******************************************************************************
+ *
+ * Discovery protocol
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Construct our location as seen by a peer
+ *
+ * @v peer		Peer address
+ * @v location		Location buffer to fill in
+ * @v len		Length of location buffer
+ * @ret rc		Return status code
+ */
+static int peerserv_location ( struct sockaddr_in *peer, char *location,
+			       size_t len ) {
+	struct net_device *netdev;
+	struct settings *settings;
+	struct in_addr address;
+	struct in_addr netmask;
+
+	/* Find an IPv4 address on the same subnet as the peer */
+	for_each_netdev ( netdev ) {
+		settings = netdev_settings ( netdev );
+		if ( fetch_ipv4_setting ( settings, &ip_setting,
+					  &address ) < 0 )
+			continue;
+		if ( fetch_ipv4_setting ( settings, &netmask_setting,
+					  &netmask ) < 0 )
+			continue;
+		if ( ( address.s_addr ^ peer->sin_addr.s_addr ) &
+		     netmask.s_addr )
+			continue;
+		snprintf ( location, len, "%s:%d",
+			   inet_ntoa ( address ), PEERSERV_PORT );
+		return 0;
+	}
+
+	return -ENETUNREACH;
+}
+
+/**
+ * Receive discovery probe
+ *
+ * @v intf		Interface
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserv_disc_deliver ( struct interface *intf __unused,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta ) {
+	struct sockaddr_in *peer = ( ( struct sockaddr_in * ) meta->src );
+	struct peerdist_discovery_probe probe;
+	struct peerserv_segment hosted;
+	struct xfer_metadata reply_meta;
+	struct io_buffer *reply;
+	char location[ 16 /* "xxx.xxx.xxx.xxx" */ + 7 /* ":xxxxx" + NUL */ ];
+	char endpoint[ 37 /* "00000000-0000-0000-0000-000000000000" */ ];
+	union {
+		union uuid uuid;
+		uint32_t dword[ sizeof ( union uuid ) / sizeof ( uint32_t ) ];
+	} random_uuid;
+	uint8_t id[PEERDIST_DIGEST_MAX_SIZE];
+	char *ids;
+	char *ids_out;
+	char *counts;
+	char *counts_out;
+	char *match;
+	char *in;
+	unsigned int matches = 0;
+	unsigned int i;
+	int len;
+	int rc;
+
+	/* Ignore non-IPv4 probes */
+	if ( ( ! peer ) || ( peer->sin_family != AF_INET ) ) {
+		rc = -ENOTSUP;
+		goto err_peer;
+	}
+
+	/* Parse probe */
+	if ( ( rc = peerdist_discovery_probe ( iobuf->data, iob_len ( iobuf ),
+					       &probe ) ) != 0 )
+		goto err_probe;
+
+	/* Allocate segment ID and block count lists */
+	for ( i = 0, in = probe.ids ; *in ; i++ )
+		in += ( strlen ( in ) + 1 /* NUL */ );
+	ids = malloc ( ( in - probe.ids ) + 1 /* NUL */ );
+	counts = malloc ( ( i * sizeof ( struct peerdist_discovery_block_count ) )
+			  + 1 /* NUL */ );
+	if ( ! ( ids && counts ) ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ids_out = ids;
+	counts_out = counts;
+
+	/* Identify hosted segments */
+	for ( in = probe.ids ; *in ; in += ( strlen ( in ) + 1 /* NUL */ ) ) {
+		len = base16_decode ( in, id, sizeof ( id ) );
+		if ( len <= 0 )
+			continue;
+		if ( peerserv_find ( id, len, &hosted ) != 0 )
+			continue;
+		if ( ! hosted.count )
+			continue;
+		ids_out += sprintf ( ids_out, "%s%s",
+				     ( matches ? " " : "" ), in );
+		counts_out += sprintf ( counts_out, "%08X", hosted.count );
+		matches++;
+	}
+	*ids_out = '\0';
+	*counts_out = '\0';
+	if ( ! matches ) {
+		rc = 0;
+		goto no_match;
+	}
+
+	/* Construct our location */
+	if ( ( rc = peerserv_location ( peer, location,
+					sizeof ( location ) ) ) != 0 ) {
+		DBGC ( &peerserv_disc, "PEERSERV could not identify location "
+		       "for %s: %s\n", inet_ntoa ( peer->sin_addr ),
+		       strerror ( rc ) );
+		goto err_location;
+	}
+
+	/* Generate a random message UUID.  This does not require high
+	 * quality randomness.
+	 */
+	for ( i = 0 ; i < ( sizeof ( random_uuid.dword ) /
+			    sizeof ( random_uuid.dword[0] ) ) ; i++ )
+		random_uuid.dword[i] = random();
+	snprintf ( endpoint, sizeof ( endpoint ), "%s",
+		   uuid_ntoa ( &peerserv_uuid ) );
+
+	/* Construct probe match */
+	match = peerdist_discovery_match ( uuid_ntoa ( &random_uuid.uuid ),
+					   probe.message, endpoint, ids,
+					   counts, location );
+	if ( ! match ) {
+		rc = -ENOMEM;
+		goto err_match;
+	}
+	DBGC2 ( &peerserv_disc, "PEERSERV offering %s to %s as %s\n",
+		ids, inet_ntoa ( peer->sin_addr ), location );
+
+	/* Transmit probe match */
+	len = strlen ( match );
+	reply = xfer_alloc_iob ( &peerserv_disc, len );
+	if ( ! reply ) {
+		rc = -ENOMEM;
+		goto err_alloc_iob;
+	}
+	memcpy ( iob_put ( reply, len ), match, len );
+	memset ( &reply_meta, 0, sizeof ( reply_meta ) );
+	reply_meta.dest = meta->src;
+	if ( ( rc = xfer_deliver ( &peerserv_disc, iob_disown ( reply ),
+				   &reply_meta ) ) != 0 ) {
+		DBGC ( &peerserv_disc, "PEERSERV could not deliver probe "
+		       "match: %s\n", strerror ( rc ) );
+		goto err_deliver;
+	}
+
+ err_deliver:
+ err_alloc_iob:
+	free ( match );
+ err_match:
+ err_location:
+ no_match:
+ err_alloc:
+	free ( counts );
+	free ( ids );
+ err_probe:
+ err_peer:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** Discovery socket interface operations */
+static struct interface_operation peerserv_disc_operations[] = {
+	INTF_OP ( xfer_deliver, struct interface *, peerserv_disc_deliver ),
+};
+
+/** Discovery socket interface descriptor */
+static struct interface_descriptor peerserv_disc_desc =
+	INTF_DESC_PURE ( peerserv_disc_operations );
+
+/** Discovery socket interface */
+static struct interface peerserv_disc = INTF_INIT ( peerserv_disc_desc );
+
+/******************************************************************************
+ *
+ * Retrieval protocol
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Consume data from retrieval protocol request
+ *
+ * @v data		Request data pointer
+ * @v remaining		Remaining length
+ * @v len		Length to consume
+ * @ret ptr		Pointer to consumed data, or NULL if too short
+ */
+static const void * peerserv_pull ( const void **data, size_t *remaining,
+				    size_t len ) {
+	const void *ptr = *data;
+
+	if ( len > *remaining )
+		return NULL;
+	*data += len;
+	*remaining -= len;
+	return ptr;
+}
+
+/**
+ * Append data to retrieval protocol response
+ *
+ * @v iobuf		I/O buffer
+ * @v data		Data
+ * @v len		Length of data
+ */
+static void peerserv_put ( struct io_buffer *iobuf, const void *data,
+			   size_t len ) {
+
+	memcpy ( iob_put ( iobuf, len ), data, len );
+}
+
+/**
+ * Append 32-bit value to retrieval protocol response
+ *
+ * @v iobuf		I/O buffer
+ * @v value		Value (in host byte order)
+ */
+static void peerserv_put32 ( struct io_buffer *iobuf, uint32_t value ) {
+	uint32_t *dest = iob_put ( iobuf, sizeof ( *dest ) );
+
+	*dest = htonl ( value );
+}
+
+/**
+ * Append segment identifier to retrieval protocol response
+ *
+ * @v iobuf		I/O buffer
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ */
+static void peerserv_put_segment ( struct io_buffer *iobuf, const void *id,
+				   size_t digestsize ) {
+
+	peerserv_put32 ( iobuf, digestsize );
+	peerserv_put ( iobuf, id, digestsize );
+	memset ( iob_put ( iobuf, ( -digestsize & 0x3 ) ), 0,
+		 ( -digestsize & 0x3 ) );
+}
+
+/**
+ * Start retrieval protocol response message
+ *
+ * @v iobuf		I/O buffer
+ * @v version		Message version
+ * @v type		Message type
+ * @v algorithm		Cryptographic algorithm
+ * @ret hdr		Response message header
+ */
+static struct peerserv_msg_header *
+peerserv_msg_start ( struct io_buffer *iobuf, uint32_t version, uint32_t type,
+		     uint32_t algorithm ) {
+	struct peerserv_msg_header *hdr;
+
+	hdr = iob_put ( iobuf, sizeof ( *hdr ) );
+	hdr->msg.version.raw = htonl ( version );
+	hdr->msg.type = htonl ( type );
+	hdr->msg.algorithm = htonl ( algorithm );
+	return hdr;
+}
+
+/**
+ * Complete retrieval protocol response message
+ *
+ * @v iobuf		I/O buffer
+ * @v hdr		Response message header
+ */
+static void peerserv_msg_finish ( struct io_buffer *iobuf,
+				  struct peerserv_msg_header *hdr ) {
+	size_t len = ( iobuf->tail - ( ( void * ) &hdr->msg ) );
+
+	hdr->transport.len = htonl ( len );
+	hdr->msg.len = htonl ( len );
+}
+
+/**
+ * Handle negotiation request
+ *
+ * @v iobuf		I/O buffer for response
+ * @ret rc		Return status code
+ */
+static int peerserv_nego ( struct io_buffer *iobuf ) {
+	struct peerserv_msg_header *hdr;
+
+	/* Construct response supporting only version 1.0 */
+	hdr = peerserv_msg_start ( iobuf, PEERDIST_MSG_NEGO_RESP_VERSION,
+				   PEERDIST_MSG_NEGO_RESP_TYPE,
+				   PEERDIST_MSG_PLAINTEXT );
+	peerserv_put32 ( iobuf, PEERDIST_MSG_VERSION_1_0 );
+	peerserv_put32 ( iobuf, PEERDIST_MSG_VERSION_1_0 );
+	peerserv_msg_finish ( iobuf, hdr );
+
+	return 0;
+}
+
+/**
+ * Parse segment identifier and block ranges from request
+ *
+ * @v data		Request data pointer
+ * @v remaining		Remaining length
+ * @v id		Segment identifier to fill in
+ * @v digestsize	Length of segment identifier to fill in
+ * @v ranges		Block ranges to fill in
+ * @v count		Number of block ranges to fill in
+ * @ret rc		Return status code
+ */
+static int peerserv_parse_ranges ( const void **data, size_t *remaining,
+				   const uint8_t **id, size_t *digestsize,
+				   const struct peerdist_msg_range **ranges,
+				   unsigned int *count ) {
+	const uint32_t *len;
+
+	/* Parse segment identifier */
+	len = peerserv_pull ( data, remaining, sizeof ( *len ) );
+	if ( ! len )
+		return -EINVAL;
+	*digestsize = ntohl ( *len );
+	if ( *digestsize > PEERDIST_DIGEST_MAX_SIZE )
+		return -ERANGE;
+	*id = peerserv_pull ( data, remaining,
+			      ( *digestsize + ( -*digestsize & 0x3 ) ) );
+	if ( ! *id )
+		return -EINVAL;
+
+	/* Parse block ranges */
+	len = peerserv_pull ( data, remaining, sizeof ( *len ) );
+	if ( ! len )
+		return -EINVAL;
+	*count = ntohl ( *len );
+	if ( *count > ( *remaining / sizeof ( **ranges ) ) )
+		return -EINVAL;
+	*ranges = peerserv_pull ( data, remaining,
+				  ( *count * sizeof ( **ranges ) ) );
+
+	return 0;
+}
+
+/**
+ * Handle block list request
+ *
+ * @v iobuf		I/O buffer for response
+ * @v data		Request data
+ * @v remaining		Remaining length
+ * @ret rc		Return status code
+ */
+static int peerserv_getblklist ( struct io_buffer *iobuf, const void *data,
+				 size_t remaining ) {
+	const struct peerdist_msg_range *ranges;
+	struct peerserv_msg_header *hdr;
+	struct peerserv_segment hosted;
+	const uint8_t *id;
+	size_t digestsize;
+	unsigned int count;
+	unsigned int first;
+	unsigned int last;
+	unsigned int i;
+	uint32_t *out_count;
+	int rc;
+
+	/* Parse request */
+	if ( ( rc = peerserv_parse_ranges ( &data, &remaining, &id,
+					    &digestsize, &ranges,
+					    &count ) ) != 0 )
+		return rc;
+
+	/* Find segment */
+	if ( peerserv_find ( id, digestsize, &hosted ) != 0 )
+		hosted.count = 0;
+
+	/* Construct response containing the intersection of the
+	 * requested ranges with the available blocks.
+	 */
+	if ( iob_tailroom ( iobuf ) < ( sizeof ( *hdr ) + digestsize + 16 +
+					( count * sizeof ( *ranges ) ) ) )
+		return -ERANGE;
+	hdr = peerserv_msg_start ( iobuf, PEERDIST_MSG_BLKLIST_VERSION,
+				   PEERDIST_MSG_BLKLIST_TYPE,
+				   PEERDIST_MSG_PLAINTEXT );
+	peerserv_put_segment ( iobuf, id, digestsize );
+	out_count = iob_put ( iobuf, sizeof ( *out_count ) );
+	*out_count = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		first = ntohl ( ranges[i].first );
+		last = ( first + ntohl ( ranges[i].count ) );
+		if ( first < hosted.first )
+			first = hosted.first;
+		if ( last > ( hosted.first + hosted.count ) )
+			last = ( hosted.first + hosted.count );
+		if ( first >= last )
+			continue;
+		peerserv_put32 ( iobuf, first );
+		peerserv_put32 ( iobuf, ( last - first ) );
+		*out_count = htonl ( ntohl ( *out_count ) + 1 );
+	}
+	peerserv_put32 ( iobuf, 0 );
+	peerserv_msg_finish ( iobuf, hdr );
+
+	return 0;
+}
+
+/**
+ * Handle block fetch request
+ *
+ * @v iobuf		I/O buffer for response (or NULL to calculate length)
+ * @v data		Request data
+ * @v remaining		Remaining length
+ * @v len		Required response length to fill in
+ * @ret rc		Return status code
+ */
+static int peerserv_getblks ( struct io_buffer *iobuf, const void *data,
+			      size_t remaining, size_t *len ) {
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	const struct peerdist_msg_range *ranges;
+	struct peerdist_info_segment *segment;
+	struct peerserv_msg_header *hdr;
+	struct peerserv_segment hosted;
+	struct peerdist_info_block block;
+	const uint8_t *id;
+	size_t digestsize;
+	size_t block_len;
+	size_t data_len;
+	unsigned int count;
+	unsigned int index;
+	unsigned int next;
+	uint8_t ctx[cipher->ctxsize];
+	uint8_t iv[cipher->blocksize];
+	void *ciphertext;
+	unsigned int i;
+	int rc;
+
+	/* Parse request */
+	if ( ( rc = peerserv_parse_ranges ( &data, &remaining, &id,
+					    &digestsize, &ranges,
+					    &count ) ) != 0 )
+		return rc;
+	if ( ! count )
+		return -EINVAL;
+	index = ntohl ( ranges[0].first );
+
+	/* Find block, if available */
+	segment = &hosted.segment;
+	block_len = 0;
+	if ( ( peerserv_find ( id, digestsize, &hosted ) == 0 ) &&
+	     ( index >= hosted.first ) &&
+	     ( index < ( hosted.first + hosted.count ) ) &&
+	     ( peerdist_info_block ( segment, &block, index ) == 0 ) ) {
+		block_len = ( block.range.end - block.range.start );
+	}
+	data_len = ( ( block_len + cipher->blocksize - 1 ) &
+		     ~( cipher->blocksize - 1 ) );
+
+	/* Calculate (or check) response length */
+	*len = ( sizeof ( *hdr ) + 4 /* segment */ + digestsize + 3 /* pad */ +
+		 4 /* index */ + 4 /* next */ + 4 /* block */ + data_len +
+		 4 /* vrf */ + 4 /* iv */ + sizeof ( iv ) );
+	if ( ! iobuf )
+		return 0;
+	if ( iob_tailroom ( iobuf ) < *len )
+		return -ERANGE;
+
+	/* Construct response header */
+	hdr = peerserv_msg_start ( iobuf, PEERDIST_MSG_BLK_VERSION,
+				   PEERDIST_MSG_BLK_TYPE,
+				   ( block_len ? PEERDIST_MSG_AES_128_CBC :
+				     PEERDIST_MSG_PLAINTEXT ) );
+	peerserv_put_segment ( iobuf, id, digestsize );
+	next = ( index + 1 );
+	if ( ( ! block_len ) || ( next >= ( hosted.first + hosted.count ) ) )
+		next = 0;
+	peerserv_put32 ( iobuf, index );
+	peerserv_put32 ( iobuf, next );
+
+	/* Report missing block, if applicable */
+	peerserv_put32 ( iobuf, data_len );
+	if ( ! block_len ) {
+		DBGC ( &peerserv_listener, "PEERSERV has no block %d\n",
+		       index );
+		peerserv_put32 ( iobuf, 0 );
+		peerserv_put32 ( iobuf, 0 );
+		goto done;
+	}
+
+	/* Copy block data, padded to a multiple of the cipher block size */
+	ciphertext = iob_put ( iobuf, data_len );
+	copy_from_user ( ciphertext, hosted.image->data,
+			 ( block.range.start - segment->info->trim.start ),
+			 block_len );
+	memset ( ( ciphertext + block_len ), 0, ( data_len - block_len ) );
+
+	/* Encrypt block data using the segment secret */
+	for ( i = 0 ; i < sizeof ( iv ) ; i++ )
+		iv[i] = random();
+	if ( ( rc = cipher_setkey ( cipher, ctx, segment->secret,
+				    ( 128 / 8 ) ) ) != 0 )
+		return rc;
+	cipher_setiv ( cipher, ctx, iv, sizeof ( iv ) );
+	cipher_encrypt ( cipher, ctx, ciphertext, ciphertext, data_len );
+	DBGC2 ( &peerserv_listener, "PEERSERV serving block %d "
+		"[%08zx,%08zx)\n", index, block.range.start, block.range.end );
+
+	/* Append (empty) VRF data and initialisation vector */
+	peerserv_put32 ( iobuf, 0 );
+	peerserv_put32 ( iobuf, sizeof ( iv ) );
+	peerserv_put ( iobuf, iv, sizeof ( iv ) );
+
+ done:
+	peerserv_msg_finish ( iobuf, hdr );
+	return 0;
+}
+
+/**
+ * Free retrieval protocol connection
+ *
+ * @v refcnt		Reference count
+ */
+static void peerserv_conn_free ( struct refcnt *refcnt ) {
+	struct peerserv_connection *conn =
+		container_of ( refcnt, struct peerserv_connection, refcnt );
+
+	xferbuf_free ( &conn->buffer );
+	free ( conn );
+}
+
+/**
+ * Close retrieval protocol connection
+ *
+ * @v conn		Retrieval protocol connection
+ * @v rc		Reason for close
+ */
+static void peerserv_conn_close ( struct peerserv_connection *conn, int rc ) {
+
+	stop_timer ( &conn->timer );
+	intf_shutdown ( &conn->xfer, rc );
+}
+
+/**
+ * Send HTTP response
+ *
+ * @v conn		Retrieval protocol connection
+ * @v status		HTTP status line
+ * @v iobuf		I/O buffer containing response body (or NULL)
+ * @ret rc		Return status code
+ */
+static int peerserv_respond ( struct peerserv_connection *conn,
+			      const char *status, struct io_buffer *iobuf ) {
+	char header[PEERSERV_MAX_HEADER];
+	size_t len;
+
+	/* Allocate empty I/O buffer, if applicable */
+	if ( ! iobuf ) {
+		iobuf = xfer_alloc_iob ( &conn->xfer, sizeof ( header ) );
+		if ( ! iobuf )
+			return -ENOMEM;
+		iob_reserve ( iobuf, sizeof ( header ) );
+	}
+
+	/* Construct HTTP header */
+	len = snprintf ( header, sizeof ( header ),
+			 "HTTP/1.1 %s\r\n"
+			 "Content-Length: %zd\r\n"
+			 "Connection: close\r\n"
+			 "\r\n", status, iob_len ( iobuf ) );
+	assert ( len < sizeof ( header ) );
+	assert ( iob_headroom ( iobuf ) >= len );
+	memcpy ( iob_push ( iobuf, len ), header, len );
+
+	/* Send response */
+	return xfer_deliver_iob ( &conn->xfer, iobuf );
+}
+
+/**
+ * Handle retrieval protocol request
+ *
+ * @v conn		Retrieval protocol connection
+ * @v body		Request body
+ * @v len		Length of request body
+ * @ret rc		Return status code
+ */
+static int peerserv_request ( struct peerserv_connection *conn,
+			      const void *body, size_t len ) {
+	const struct peerdist_msg_header *hdr;
+	struct io_buffer *iobuf;
+	size_t rsp_len = PEERSERV_MAX_REQUEST;
+	int rc;
+
+	/* Parse message header */
+	hdr = peerserv_pull ( &body, &len, sizeof ( *hdr ) );
+	if ( ! hdr ) {
+		DBGC ( conn, "PEERSERV %p underlength request\n", conn );
+		return peerserv_respond ( conn, "400 Bad Request", NULL );
+	}
+
+	/* Calculate response length for block fetch requests */
+	if ( ( hdr->type == htonl ( PEERDIST_MSG_GETBLKS_TYPE ) ) &&
+	     ( ( rc = peerserv_getblks ( NULL, body, len, &rsp_len ) ) != 0 ))
+		return peerserv_respond ( conn, "400 Bad Request", NULL );
+
+	/* Allocate response buffer */
+	iobuf = xfer_alloc_iob ( &conn->xfer,
+				 ( PEERSERV_MAX_HEADER + rsp_len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+	iob_reserve ( iobuf, PEERSERV_MAX_HEADER );
+
+	/* Construct response */
+	switch ( hdr->type ) {
+	case htonl ( PEERDIST_MSG_NEGO_REQ_TYPE ) :
+		rc = peerserv_nego ( iobuf );
+		break;
+	case htonl ( PEERDIST_MSG_GETBLKLIST_TYPE ) :
+		rc = peerserv_getblklist ( iobuf, body, len );
+		break;
+	case htonl ( PEERDIST_MSG_GETBLKS_TYPE ) :
+		rc = peerserv_getblks ( iobuf, body, len, &rsp_len );
+		break;
+	default:
+		DBGC ( conn, "PEERSERV %p unsupported message type %#08x\n",
+		       conn, ntohl ( hdr->type ) );
+		rc = -ENOTSUP;
+		break;
+	}
+	if ( rc != 0 ) {
+		free_iob ( iobuf );
+		return peerserv_respond ( conn, "400 Bad Request", NULL );
+	}
+
+	return peerserv_respond ( conn, "200 OK", iob_disown ( iobuf ) );
+}
+
+/**
+ * Parse HTTP request
+ *
+ * @v conn		Retrieval protocol connection
+ * @ret rc		Return status code, or -EINPROGRESS if incomplete
+ */
+static int peerserv_parse ( struct peerserv_connection *conn ) {
+	static const char post[] = "POST " PEERDIST_MAGIC_PATH;
+	static const char content_length[] = "\r\nContent-Length:";
+	const char *data = conn->buffer.data;
+	size_t len = conn->buffer.len;
+	size_t header_len;
+	size_t body_len = 0;
+	char *header;
+	char *line;
+	int rc;
+
+	/* Locate end of HTTP header */
+	for ( header_len = 0 ; ( header_len + 4 ) <= len ; header_len++ ) {
+		if ( memcmp ( &data[header_len], "\r\n\r\n", 4 ) == 0 )
+			break;
+	}
+	if ( ( header_len + 4 ) > len )
+		return -EINPROGRESS;
+
+	/* Create NUL-terminated copy of HTTP header */
+	header = strndup ( data, header_len );
+	if ( ! header )
+		return -ENOMEM;
+
+	/* Parse content length, if present */
+	for ( line = header ; ( line = strchr ( line, '\r' ) ) ; line++ ) {
+		if ( strncasecmp ( line, content_length,
+				   ( sizeof ( content_length ) - 1 ) ) == 0 ) {
+			body_len = strtoul ( ( line + sizeof ( content_length )
+					       - 1 ), NULL, 10 );
+			break;
+		}
+	}
+
+	/* Wait for complete request body */
+	if ( ( len - header_len - 4 ) < body_len ) {
+		rc = ( ( body_len > PEERSERV_MAX_REQUEST ) ?
+		       -ERANGE : -EINPROGRESS );
+		goto done;
+	}
+	stop_timer ( &conn->timer );
+
+	/* Check request method and path */
+	if ( strncasecmp ( header, post, ( sizeof ( post ) - 1 ) ) != 0 ) {
+		if ( ( line = strchr ( header, '\r' ) ) )
+			*line = '\0';
+		DBGC ( conn, "PEERSERV %p unsupported request \"%s\"\n",
+		       conn, header );
+		rc = peerserv_respond ( conn, "404 Not Found", NULL );
+		goto done;
+	}
+
+	/* Handle request */
+	rc = peerserv_request ( conn, ( data + header_len + 4 ), body_len );
+
+ done:
+	free ( header );
+	return rc;
+}
+
+/**
+ * Receive retrieval protocol request data
+ *
+ * @v conn		Retrieval protocol connection
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserv_conn_deliver ( struct peerserv_connection *conn,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta ) {
+	int rc;
+
+	/* Ignore any further data once the request has been handled */
+	if ( ! timer_running ( &conn->timer ) ) {
+		free_iob ( iobuf );
+		return 0;
+	}
+
+	/* Add data to request buffer */
+	if ( ( rc = xferbuf_deliver ( &conn->buffer, iob_disown ( iobuf ),
+				      meta ) ) != 0 )
+		goto err;
+	if ( conn->buffer.len > PEERSERV_MAX_REQUEST ) {
+		rc = -ERANGE;
+		goto err;
+	}
+
+	/* Parse and handle request, if complete */
+	rc = peerserv_parse ( conn );
+	if ( rc == -EINPROGRESS )
+		return 0;
+	if ( rc != 0 )
+		goto err;
+
+	/* Close connection once response has been sent */
+	peerserv_conn_close ( conn, 0 );
+	return 0;
+
+ err:
+	DBGC ( conn, "PEERSERV %p failed: %s\n", conn, strerror ( rc ) );
+	peerserv_conn_close ( conn, rc );
+	return rc;
+}
+
+/**
+ * Handle retrieval protocol connection idle timeout
+ *
+ * @v timer		Idle timer
+ * @v over		Failure indicator
+ */
+static void peerserv_conn_expired ( struct retry_timer *timer,
+				    int over __unused ) {
+	struct peerserv_connection *conn =
+		container_of ( timer, struct peerserv_connection, timer );
+
+	DBGC ( conn, "PEERSERV %p timed out\n", conn );
+	peerserv_conn_close ( conn, -ETIMEDOUT );
+}
+
+/** Retrieval protocol connection interface operations */
+static struct interface_operation peerserv_conn_operations[] = {
+	INTF_OP ( xfer_deliver, struct peerserv_connection *,
+		  peerserv_conn_deliver ),
+	INTF_OP ( intf_close, struct peerserv_connection *,
+		  peerserv_conn_close ),
+};
+
+/** Retrieval protocol connection interface descriptor */
+static struct interface_descriptor peerserv_conn_desc =
+	INTF_DESC ( struct peerserv_connection, xfer,
+		    peerserv_conn_operations );
+
+/**
+ * Accept retrieval protocol connection
+ *
+ * @v listener		TCP listening socket
+ * @v xfer		Data transfer interface of new connection
+ * @v peer		Peer socket address
+ * @ret rc		Return status code
+ */
+static int peerserv_accept ( struct tcp_listener *listener __unused,
+			     struct interface *xfer,
+			     struct sockaddr_tcpip *peer ) {
+	struct peerserv_connection *conn;
+
+	/* Allocate and initialise structure */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn )
+		return -ENOMEM;
+	ref_init ( &conn->refcnt, peerserv_conn_free );
+	intf_init ( &conn->xfer, &peerserv_conn_desc, &conn->refcnt );
+	xferbuf_malloc_init ( &conn->buffer );
+	timer_init ( &conn->timer, peerserv_conn_expired, &conn->refcnt );
+	start_timer_fixed ( &conn->timer, PEERSERV_TIMEOUT );
+	DBGC ( conn, "PEERSERV %p accepted connection from %s\n",
+	       conn, sock_ntoa ( ( struct sockaddr * ) peer ) );
+
+	/* Attach to connection, mortalise self, and return */
+	intf_plug_plug ( &conn->xfer, xfer );
+	ref_put ( &conn->refcnt );
+	return 0;
+}
+
+/** Retrieval protocol listening socket */
+static struct tcp_listener peerserv_listener = {
+	.port = PEERSERV_PORT,
+	.accept = peerserv_accept,
+};
+
+/******************************************************************************
+ *
+ * Settings
+ *
+ ******************************************************************************
+ */
+
+/** PeerDist content hosting setting */
+const struct setting peerserve_setting __setting ( SETTING_MISC, peerserve ) = {
+	.name = "peerserve",
+	.description = "PeerDist content hosting",
+	.type = &setting_type_int8,
+};
+
+/**
+ * Start content hosting
+ *
+ * @ret rc		Return status code
+ */
+static int peerserv_start ( void ) {
+	struct sockaddr_in local;
+	unsigned int i;
+	int rc;
+
+	/* Generate a random endpoint UUID.  This does not require
+	 * high quality randomness.
+	 */
+	for ( i = 0 ; i < sizeof ( peerserv_uuid.raw ) ; i++ )
+		peerserv_uuid.raw[i] = random();
+
+	/* Open discovery socket */
+	memset ( &local, 0, sizeof ( local ) );
+	local.sin_family = AF_INET;
+	local.sin_port = htons ( PEERDIST_DISCOVERY_PORT );
+	if ( ( rc = udp_open ( &peerserv_disc, NULL,
+			       ( struct sockaddr * ) &local ) ) != 0 ) {
+		DBGC ( &peerserv_disc, "PEERSERV could not open discovery "
+		       "socket: %s\n", strerror ( rc ) );
+		goto err_disc;
+	}
+
+	/* Listen for retrieval protocol connections */
+	if ( ( rc = tcp_listen ( &peerserv_listener ) ) != 0 )
+		goto err_listen;
+
+	DBGC ( &peerserv_disc, "PEERSERV started as %s\n",
+	       uuid_ntoa ( &peerserv_uuid ) );
+	peerserv_running = 1;
+	return 0;
+
+	tcp_unlisten ( &peerserv_listener );
+ err_listen:
+	intf_restart ( &peerserv_disc, rc );
+ err_disc:
+	return rc;
+}
+
+/**
+ * Stop content hosting
+ *
+ */
+static void peerserv_stop ( void ) {
+	struct peerserv_content *content;
+	struct peerserv_content *tmp;
+
+	/* Stop listening and close discovery socket */
+	tcp_unlisten ( &peerserv_listener );
+	intf_restart ( &peerserv_disc, 0 );
+	peerserv_running = 0;
+
+	/* Discard all hosted content */
+	list_for_each_entry_safe ( content, tmp, &peerserv_contents, list )
+		peerserv_free ( content );
+	DBGC ( &peerserv_disc, "PEERSERV stopped\n" );
+}
+
+/**
+ * Apply PeerDist content hosting settings
+ *
+ * @ret rc		Return status code
+ */
+static int apply_peerserv_settings ( void ) {
+	int rc;
+
+	/* Fetch content hosting setting */
+	if ( fetch_int_setting ( NULL, &peerserve_setting,
+				 &peerserv_enabled ) < 0 ) {
+		peerserv_enabled = 0;
+	}
+
+	/* Start or stop content hosting as applicable */
+	if ( peerserv_enabled && ! peerserv_running ) {
+		if ( ( rc = peerserv_start() ) != 0 )
+			return rc;
+	} else if ( peerserv_running && ! peerserv_enabled ) {
+		peerserv_stop();
+	}
+
+	return 0;
+}
+
+/** PeerDist content hosting settings applicator */
+struct settings_applicator peerserv_applicator __settings_applicator = {
+	.apply = apply_peerserv_settings,
+};
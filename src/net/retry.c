@@ -51,6 +51,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** List of running timers */
 static LIST_HEAD ( timers );
 
+/** Retry timer process */
+extern struct process retry_process;
+
 /**
  * Start timer with a specified timeout
  *
@@ -70,6 +73,9 @@ void start_timer_fixed ( struct retry_timer *timer, unsigned long timeout ) {
 		timer->running = 1;
 	}
 
+	/* Ensure that the retry timer process is running */
+	process_add ( &retry_process );
+
 	/* Record start time */
 	timer->start = currticks();
 
@@ -217,9 +223,18 @@ void retry_poll ( void ) {
  * Single-step the retry timer list
  *
  * @v process		Retry timer process
+ *
+ * The process stops itself when no timers are running, and is
+ * restarted by start_timer_fixed().
  */
-static void retry_step ( struct process *process __unused ) {
+static void retry_step ( struct process *process ) {
+
+	/* Poll timer list */
 	retry_poll();
+
+	/* Stop process if there are no running timers */
+	if ( list_empty ( &timers ) )
+		process_del ( process );
 }
 
 /** Retry timer process */
@@ -20,6 +20,7 @@
 #include <ipxe/job.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/tcp.h>
+#include <ipxe/timeline.h>
 
 /** @file
  *
@@ -135,6 +136,8 @@ enum tcp_flags {
 	TCP_ACK_PENDING = 0x0004,
 	/** TCP selective acknowledgement is enabled */
 	TCP_SACK_ENABLED = 0x0008,
+	/** TCP connection was accepted from a listening socket */
+	TCP_PASSIVE = 0x0010,
 };
 
 /** TCP internal header
@@ -167,6 +170,14 @@ struct tcp_rx_queued_header {
  */
 static LIST_HEAD ( tcp_conns );
 
+/**
+ * List of registered TCP listening sockets
+ */
+static LIST_HEAD ( tcp_listeners );
+
+/** TCP statistics */
+struct tcp_statistics tcp_stats;
+
 /** Transmit profiler */
 static struct profiler tcp_tx_profiler __profiler = { .name = "tcp.tx" };
 
@@ -182,7 +193,8 @@ static struct interface_descriptor tcp_xfer_desc;
 static void tcp_expired ( struct retry_timer *timer, int over );
 static void tcp_keepalive_expired ( struct retry_timer *timer, int over );
 static void tcp_wait_expired ( struct retry_timer *timer, int over );
-static struct tcp_connection * tcp_demux ( unsigned int local_port );
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer );
 static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 			uint32_t win );
 
@@ -258,26 +270,28 @@ tcp_dump_flags ( struct tcp_connection *tcp, unsigned int flags ) {
  * @ret port		Local port number, or negative error
  */
 static int tcp_port_available ( int port ) {
+	struct tcp_listener *listener;
+
+	/* Check for listening sockets bound to this port */
+	list_for_each_entry ( listener, &tcp_listeners, list ) {
+		if ( listener->port == ( unsigned int ) port )
+			return -EADDRINUSE;
+	}
 
-	return ( tcp_demux ( port ) ? -EADDRINUSE : port );
+	return ( tcp_demux ( port, NULL ) ? -EADDRINUSE : port );
 }
 
 /**
- * Open a TCP connection
+ * Allocate and initialise a TCP connection
  *
- * @v xfer		Data transfer interface
  * @v peer		Peer socket address
- * @v local		Local socket address, or NULL
+ * @v tcpp		TCP connection to fill in
  * @ret rc		Return status code
  */
-static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
-		      struct sockaddr *local ) {
-	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
-	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+static int tcp_alloc ( struct sockaddr_tcpip *peer,
+		       struct tcp_connection **tcpp ) {
 	struct tcp_connection *tcp;
 	size_t mtu;
-	int port;
-	int rc;
 
 	/* Allocate and initialise structure */
 	tcp = zalloc ( sizeof ( *tcp ) );
@@ -296,18 +310,42 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	tcp->snd_seq = random();
 	INIT_LIST_HEAD ( &tcp->tx_queue );
 	INIT_LIST_HEAD ( &tcp->rx_queue );
-	memcpy ( &tcp->peer, st_peer, sizeof ( tcp->peer ) );
+	memcpy ( &tcp->peer, peer, sizeof ( tcp->peer ) );
 
 	/* Calculate MSS */
 	mtu = tcpip_mtu ( &tcp->peer );
 	if ( ! mtu ) {
 		DBGC ( tcp, "TCP %p has no route to %s\n",
-		       tcp, sock_ntoa ( peer ) );
-		rc = -ENETUNREACH;
-		goto err;
+		       tcp, sock_ntoa ( ( struct sockaddr * ) peer ) );
+		ref_put ( &tcp->refcnt );
+		return -ENETUNREACH;
 	}
 	tcp->mss = ( mtu - sizeof ( struct tcp_header ) );
 
+	*tcpp = tcp;
+	return 0;
+}
+
+/**
+ * Open a TCP connection
+ *
+ * @v xfer		Data transfer interface
+ * @v peer		Peer socket address
+ * @v local		Local socket address, or NULL
+ * @ret rc		Return status code
+ */
+static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
+		      struct sockaddr *local ) {
+	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
+	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+	struct tcp_connection *tcp;
+	int port;
+	int rc;
+
+	/* Allocate and initialise structure */
+	if ( ( rc = tcp_alloc ( st_peer, &tcp ) ) != 0 )
+		return rc;
+
 	/* Bind to local port */
 	port = tcpip_bind ( st_local, tcp_port_available );
 	if ( port < 0 ) {
@@ -318,6 +356,8 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	}
 	tcp->local_port = port;
 	DBGC ( tcp, "TCP %p bound to port %d\n", tcp, tcp->local_port );
+	timeline ( "tcp-connect", "%s:%d", sock_ntoa ( peer ),
+		   ntohs ( st_peer->st_port ) );
 
 	/* Start timer to initiate SYN */
 	start_timer_nodelay ( &tcp->timer );
@@ -416,6 +456,92 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 	}
 }
 
+/**
+ * Register TCP listening socket
+ *
+ * @v listener		TCP listening socket
+ * @ret rc		Return status code
+ */
+int tcp_listen ( struct tcp_listener *listener ) {
+	int port;
+
+	/* Check that port is available */
+	port = tcp_port_available ( listener->port );
+	if ( port < 0 ) {
+		DBGC ( listener, "TCP %p could not listen on port %d: %s\n",
+		       listener, listener->port, strerror ( port ) );
+		return port;
+	}
+
+	/* Add to list of listening sockets */
+	list_add ( &listener->list, &tcp_listeners );
+	DBGC ( listener, "TCP %p listening on port %d\n",
+	       listener, listener->port );
+
+	return 0;
+}
+
+/**
+ * Unregister TCP listening socket
+ *
+ * @v listener		TCP listening socket
+ *
+ * Any connections that have already been accepted are unaffected.
+ */
+void tcp_unlisten ( struct tcp_listener *listener ) {
+
+	list_del ( &listener->list );
+	DBGC ( listener, "TCP %p stopped listening on port %d\n",
+	       listener, listener->port );
+}
+
+/**
+ * Accept incoming TCP connection
+ *
+ * @v local_port	Local port
+ * @v peer		Peer socket address
+ * @ret tcp		TCP connection, or NULL
+ */
+static struct tcp_connection * tcp_accept ( unsigned int local_port,
+					    struct sockaddr_tcpip *peer ) {
+	struct tcp_listener *listener;
+	struct tcp_connection *tcp;
+	int rc;
+
+	/* Identify listening socket */
+	list_for_each_entry ( listener, &tcp_listeners, list ) {
+		if ( listener->port == local_port )
+			goto found;
+	}
+	return NULL;
+ found:
+
+	/* Allocate and initialise structure */
+	if ( ( rc = tcp_alloc ( peer, &tcp ) ) != 0 )
+		return NULL;
+	tcp->flags |= TCP_PASSIVE;
+	tcp->local_port = local_port;
+	DBGC ( tcp, "TCP %p accepted on port %d from %s:%d\n", tcp,
+	       tcp->local_port, sock_ntoa ( ( struct sockaddr * ) peer ),
+	       ntohs ( peer->st_port ) );
+
+	/* Hand connection to listener */
+	if ( ( rc = listener->accept ( listener, &tcp->xfer, peer ) ) != 0 ) {
+		DBGC ( tcp, "TCP %p rejected by listener: %s\n",
+		       tcp, strerror ( rc ) );
+		intf_shutdown ( &tcp->xfer, rc );
+		ref_put ( &tcp->refcnt );
+		return NULL;
+	}
+
+	/* Add a pending operation for the SYN */
+	pending_get ( &tcp->pending_flags );
+
+	/* Transfer reference to connection list and return */
+	list_add ( &tcp->list, &tcp_conns );
+	return tcp;
+}
+
 /***************************************************************************
  *
  * Transmit data path
@@ -617,6 +743,7 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	struct tcp_sack_block *sack;
 	void *payload;
 	unsigned int flags;
+	unsigned int offer;
 	unsigned int sack_count;
 	unsigned int i;
 	size_t len = 0;
@@ -685,24 +812,32 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	if ( tcp->rcv_win < max_rcv_win )
 		tcp->rcv_win = max_rcv_win;
 
-	/* Fill up the TCP header */
+	/* Fill up the TCP header.  An accepted connection may include
+	 * options in its SYN only if the peer included them in its SYN.
+	 */
 	payload = iobuf->data;
+	offer = ( ( flags & TCP_SYN ) && ! ( tcp->flags & TCP_PASSIVE ) );
 	if ( flags & TCP_SYN ) {
 		mssopt = iob_push ( iobuf, sizeof ( *mssopt ) );
 		mssopt->kind = TCP_OPTION_MSS;
 		mssopt->length = sizeof ( *mssopt );
 		mssopt->mss = htons ( tcp->mss );
+	}
+	if ( ( flags & TCP_SYN ) && ( offer || tcp->rcv_win_scale ) ) {
 		wsopt = iob_push ( iobuf, sizeof ( *wsopt ) );
 		wsopt->nop = TCP_OPTION_NOP;
 		wsopt->wsopt.kind = TCP_OPTION_WS;
 		wsopt->wsopt.length = sizeof ( wsopt->wsopt );
 		wsopt->wsopt.scale = TCP_RX_WINDOW_SCALE;
+	}
+	if ( ( flags & TCP_SYN ) &&
+	     ( offer || ( tcp->flags & TCP_SACK_ENABLED ) ) ) {
 		spopt = iob_push ( iobuf, sizeof ( *spopt ) );
 		memset ( spopt->nop, TCP_OPTION_NOP, sizeof ( spopt->nop ) );
 		spopt->spopt.kind = TCP_OPTION_SACK_PERMITTED;
 		spopt->spopt.length = sizeof ( spopt->spopt );
 	}
-	if ( ( flags & TCP_SYN ) || ( tcp->flags & TCP_TS_ENABLED ) ) {
+	if ( offer || ( tcp->flags & TCP_TS_ENABLED ) ) {
 		tsopt = iob_push ( iobuf, sizeof ( *tsopt ) );
 		memset ( tsopt->nop, TCP_OPTION_NOP, sizeof ( tsopt->nop ) );
 		tsopt->tsopt.kind = TCP_OPTION_TS;
@@ -806,6 +941,7 @@ static void tcp_expired ( struct retry_timer *timer, int over ) {
 		tcp_close ( tcp, -ETIMEDOUT );
 	} else {
 		/* Otherwise, retransmit the packet */
+		tcp_stats.retransmits++;
 		tcp_xmit ( tcp );
 	}
 }
@@ -924,14 +1060,23 @@ static int tcp_xmit_reset ( struct tcp_connection *tcp,
  * Identify TCP connection by local port number
  *
  * @v local_port	Local port
+ * @v peer		Peer socket address, or NULL to match any peer
  * @ret tcp		TCP connection, or NULL
+ *
+ * Accepted connections share the local port of the listening socket,
+ * and are distinguished by the peer socket address.
  */
-static struct tcp_connection * tcp_demux ( unsigned int local_port ) {
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer ) {
 	struct tcp_connection *tcp;
 
 	list_for_each_entry ( tcp, &tcp_conns, list ) {
-		if ( tcp->local_port == local_port )
-			return tcp;
+		if ( tcp->local_port != local_port )
+			continue;
+		if ( ( tcp->flags & TCP_PASSIVE ) && peer &&
+		     ( memcmp ( &tcp->peer, peer, sizeof ( tcp->peer ) ) != 0 ))
+			continue;
+		return tcp;
 	}
 	return NULL;
 }
@@ -1088,6 +1233,9 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 		       ( ( tcp->flags & TCP_SACK_ENABLED ) ? "" : "no " ),
 		       ( 1 << tcp->snd_win_scale ),
 		       ( 1 << tcp->rcv_win_scale ) );
+		timeline ( "tcp-established", "%s:%d",
+			   sock_ntoa ( ( struct sockaddr * ) &tcp->peer ),
+			   ntohs ( tcp->peer.st_port ) );
 	}
 
 	/* Ignore duplicate SYN */
@@ -1445,11 +1593,16 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	}
 	
 	/* Parse parameters from header and strip header */
-	tcp = tcp_demux ( ntohs ( tcphdr->dest ) );
+	st_src->st_port = tcphdr->src;
+	tcp = tcp_demux ( ntohs ( tcphdr->dest ), st_src );
 	seq = ntohl ( tcphdr->seq );
 	ack = ntohl ( tcphdr->ack );
 	raw_win = ntohs ( tcphdr->win );
 	flags = tcphdr->flags;
+	if ( ( ! tcp ) && ( ( flags & ( TCP_SYN | TCP_ACK | TCP_RST ) ) ==
+			    TCP_SYN ) ) {
+		tcp = tcp_accept ( ntohs ( tcphdr->dest ), st_src );
+	}
 	if ( ( rc = tcp_rx_opts ( tcp, tcphdr, hlen, &options ) ) != 0 )
 		goto discard;
 	if ( tcp && options.tsopt )
@@ -0,0 +1,943 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/process.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/iperf.h>
+
+/** @file
+ *
+ * iperf3 network throughput test client
+ *
+ * The iperf3 protocol uses a TCP control connection, over which the
+ * server drives the client through a sequence of single-byte state
+ * changes.  Test parameters and results are exchanged as
+ * length-prefixed JSON objects.  A single data stream (TCP or UDP) is
+ * opened to the same server port, and identified to the server using
+ * the session cookie (for TCP) or a fixed connection message (for
+ * UDP).
+ *
+ */
+
+/** Control connection has been opened */
+#define IPERF_CONTROL_OPEN 0x0001
+
+/** Data stream has been opened */
+#define IPERF_DATA_OPEN 0x0002
+
+/** Test is running */
+#define IPERF_RUNNING 0x0004
+
+/** Test has ended */
+#define IPERF_ENDED 0x0008
+
+/** Client has been closed */
+#define IPERF_CLOSED 0x0010
+
+/** Control connection is awaiting a state change */
+#define IPERF_RX_STATE 0
+
+/** Control connection is awaiting a results length */
+#define IPERF_RX_LENGTH 1
+
+/** Control connection is awaiting results */
+#define IPERF_RX_RESULTS 2
+
+/** Maximum number of UDP datagrams to transmit per process step */
+#define IPERF_UDP_BURST 16
+
+/** An iperf3 client */
+struct iperf_client {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Job control interface */
+	struct interface job;
+	/** Control connection */
+	struct interface control;
+	/** Data stream */
+	struct interface data;
+	/** Data transmission process */
+	struct process process;
+	/** Reporting interval timer */
+	struct retry_timer timer;
+
+	/** Server name */
+	const char *hostname;
+	/** Server address */
+	union {
+		struct sockaddr_tcpip st;
+		struct sockaddr sa;
+	} server;
+	/** Test parameters */
+	struct iperf_parameters params;
+	/** Report callback */
+	void ( * callback ) ( struct iperf_report *report );
+	/** Session cookie */
+	char cookie[IPERF_COOKIE_LEN];
+	/** Flags */
+	unsigned int flags;
+
+	/** Control connection receive state */
+	unsigned int rx_state;
+	/** Received results length */
+	union {
+		uint32_t len;
+		uint8_t bytes[4];
+	} rx_len;
+	/** Received results */
+	char *rx_results;
+	/** Received length within current field */
+	size_t rx_offset;
+
+	/** Test start time (in ticks) */
+	unsigned long started;
+	/** Cumulative local statistics */
+	struct iperf_report total;
+	/** Current interval statistics */
+	struct iperf_report interval;
+	/** Statistics reported by server */
+	struct iperf_report peer;
+	/** TCP retransmission count at start of test */
+	unsigned long retransmits;
+	/** UDP sequence number (last transmitted or highest received) */
+	unsigned long sequence;
+};
+
+/**
+ * Free iperf3 client
+ *
+ * @v refcnt		Reference count
+ */
+static void iperf_free ( struct refcnt *refcnt ) {
+	struct iperf_client *iperf =
+		container_of ( refcnt, struct iperf_client, refcnt );
+
+	free ( iperf->rx_results );
+	free ( iperf );
+}
+
+/**
+ * Close iperf3 client
+ *
+ * @v iperf		iperf3 client
+ * @v rc		Reason for close
+ */
+static void iperf_close ( struct iperf_client *iperf, int rc ) {
+
+	/* Mark as closed */
+	iperf->flags |= IPERF_CLOSED;
+
+	/* Stop timer and process */
+	stop_timer ( &iperf->timer );
+	process_del ( &iperf->process );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &iperf->data, rc );
+	intf_shutdown ( &iperf->control, rc );
+	intf_shutdown ( &iperf->job, rc );
+}
+
+/**
+ * Get time elapsed since start of test
+ *
+ * @v iperf		iperf3 client
+ * @ret elapsed		Elapsed time (in ticks)
+ */
+static unsigned long iperf_elapsed ( struct iperf_client *iperf ) {
+
+	return ( currticks() - iperf->started );
+}
+
+/**
+ * Send state change to server
+ *
+ * @v iperf		iperf3 client
+ * @v state		State
+ * @ret rc		Return status code
+ */
+static int iperf_send_state ( struct iperf_client *iperf, uint8_t state ) {
+	int rc;
+
+	DBGC2 ( iperf, "IPERF %p sending state %d\n", iperf, state );
+	if ( ( rc = xfer_deliver_raw ( &iperf->control, &state,
+				       sizeof ( state ) ) ) != 0 ) {
+		DBGC ( iperf, "IPERF %p could not send state %d: %s\n",
+		       iperf, state, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Send JSON object to server
+ *
+ * @v iperf		iperf3 client
+ * @v json		JSON object
+ * @ret rc		Return status code
+ */
+static int iperf_send_json ( struct iperf_client *iperf, const char *json ) {
+	struct io_buffer *iobuf;
+	size_t len = strlen ( json );
+	uint32_t *len_be;
+	int rc;
+
+	DBGC2 ( iperf, "IPERF %p sending %s\n", iperf, json );
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &iperf->control,
+				 ( sizeof ( *len_be ) + len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct length-prefixed object */
+	len_be = iob_put ( iobuf, sizeof ( *len_be ) );
+	*len_be = htonl ( len );
+	memcpy ( iob_put ( iobuf, len ), json, len );
+
+	/* Send object */
+	if ( ( rc = xfer_deliver_iob ( &iperf->control, iobuf ) ) != 0 ) {
+		DBGC ( iperf, "IPERF %p could not send JSON: %s\n",
+		       iperf, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Send test parameters
+ *
+ * @v iperf		iperf3 client
+ * @ret rc		Return status code
+ */
+static int iperf_send_params ( struct iperf_client *iperf ) {
+	struct iperf_parameters *params = &iperf->params;
+	int udp = ( params->flags & IPERF_FL_UDP );
+	char json[256];
+
+	snprintf ( json, sizeof ( json ), "{\"%s\":true,\"omit\":0,"
+		   "\"time\":%d,\"num\":0,\"blockcount\":0,\"parallel\":1,"
+		   "\"len\":%zd,\"bandwidth\":%ld,%s\"client_version\":"
+		   "\"iPXE\"}", ( udp ? "udp" : "tcp" ), params->duration,
+		   params->len, ( udp ? params->bandwidth : 0 ),
+		   ( ( params->flags & IPERF_FL_REVERSE ) ?
+		     "\"reverse\":true," : "" ) );
+	return iperf_send_json ( iperf, json );
+}
+
+/**
+ * Send test results
+ *
+ * @v iperf		iperf3 client
+ * @ret rc		Return status code
+ */
+static int iperf_send_results ( struct iperf_client *iperf ) {
+	struct iperf_report *total = &iperf->total;
+	int tcp_sender = ( ! ( iperf->params.flags &
+			       ( IPERF_FL_UDP | IPERF_FL_REVERSE ) ) );
+	unsigned long sec = ( total->end / TICKS_PER_SEC );
+	unsigned long usec = ( ( ( total->end % TICKS_PER_SEC ) * 1000000 ) /
+			       TICKS_PER_SEC );
+	char json[320];
+
+	snprintf ( json, sizeof ( json ), "{\"cpu_util_total\":0,"
+		   "\"cpu_util_user\":0,\"cpu_util_system\":0,"
+		   "\"sender_has_retransmits\":%d,\"streams\":[{\"id\":1,"
+		   "\"bytes\":%lld,\"retransmits\":%ld,\"jitter\":0,"
+		   "\"errors\":%ld,\"packets\":%ld,\"start_time\":0,"
+		   "\"end_time\":%ld.%06ld}]}", ( tcp_sender ? 1 : 0 ),
+		   total->bytes, total->retransmits, total->lost,
+		   total->packets, sec, usec );
+	return iperf_send_json ( iperf, json );
+}
+
+/**
+ * Extract integer value from results
+ *
+ * @v json		Results JSON object
+ * @v key		Key name
+ * @ret value		Value (or zero if absent or negative)
+ */
+static unsigned long long iperf_result ( const char *json, const char *key ) {
+	char quoted[16];
+	const char *value;
+
+	/* Find key */
+	snprintf ( quoted, sizeof ( quoted ), "\"%s\"", key );
+	value = strstr ( json, quoted );
+	if ( ! value )
+		return 0;
+
+	/* Skip separator and parse value */
+	value += strlen ( quoted );
+	while ( isspace ( *value ) || ( *value == ':' ) )
+		value++;
+	if ( *value == '-' )
+		return 0;
+	return strtoull ( value, NULL, 10 );
+}
+
+/**
+ * Parse results received from server
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_parse_results ( struct iperf_client *iperf ) {
+	struct iperf_report *peer = &iperf->peer;
+	const char *json = iperf->rx_results;
+
+	DBGC2 ( iperf, "IPERF %p received %s\n", iperf, json );
+	peer->bytes = iperf_result ( json, "bytes" );
+	peer->retransmits = iperf_result ( json, "retransmits" );
+	peer->lost = iperf_result ( json, "errors" );
+	peer->packets = iperf_result ( json, "packets" );
+}
+
+/**
+ * Record transferred data
+ *
+ * @v iperf		iperf3 client
+ * @v len		Length of data
+ */
+static void iperf_record ( struct iperf_client *iperf, size_t len ) {
+
+	iperf->total.bytes += len;
+	iperf->total.packets++;
+	iperf->interval.bytes += len;
+	iperf->interval.packets++;
+}
+
+/**
+ * Report interval statistics
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_report_interval ( struct iperf_client *iperf ) {
+	struct iperf_report *interval = &iperf->interval;
+	unsigned long retransmits = ( tcp_stats.retransmits -
+				      iperf->retransmits );
+
+	/* Report interval */
+	interval->end = iperf_elapsed ( iperf );
+	if ( ! ( iperf->params.flags & ( IPERF_FL_UDP | IPERF_FL_REVERSE ) ) ) {
+		interval->retransmits = ( retransmits -
+					  iperf->total.retransmits );
+		iperf->total.retransmits = retransmits;
+	}
+	if ( ! ( iperf->params.flags & IPERF_FL_UDP ) )
+		interval->packets = 0;
+	iperf->callback ( interval );
+
+	/* Start new interval */
+	interval->start = interval->end;
+	interval->bytes = 0;
+	interval->packets = 0;
+	interval->retransmits = 0;
+}
+
+/**
+ * Report summary statistics
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_report_summary ( struct iperf_client *iperf ) {
+	struct iperf_report *sender;
+	struct iperf_report *receiver;
+
+	/* Identify sender and receiver */
+	if ( iperf->params.flags & IPERF_FL_REVERSE ) {
+		sender = &iperf->peer;
+		receiver = &iperf->total;
+	} else {
+		sender = &iperf->total;
+		receiver = &iperf->peer;
+	}
+	sender->summary = "sender";
+	receiver->summary = "receiver";
+	iperf->peer.end = iperf->total.end;
+
+	/* Report summaries */
+	iperf->callback ( sender );
+	iperf->callback ( receiver );
+}
+
+/**
+ * Open data stream
+ *
+ * @v iperf		iperf3 client
+ * @ret rc		Return status code
+ */
+static int iperf_create_stream ( struct iperf_client *iperf ) {
+	int semantics = ( ( iperf->params.flags & IPERF_FL_UDP ) ?
+			  SOCK_DGRAM : SOCK_STREAM );
+	int rc;
+
+	DBGC ( iperf, "IPERF %p creating %s stream\n",
+	       iperf, socket_semantics_name ( semantics ) );
+	if ( ( rc = xfer_open_named_socket ( &iperf->data, semantics,
+					     &iperf->server.sa, iperf->hostname,
+					     NULL ) ) != 0 ) {
+		DBGC ( iperf, "IPERF %p could not open data stream: %s\n",
+		       iperf, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Start test
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_start ( struct iperf_client *iperf ) {
+
+	DBGC ( iperf, "IPERF %p starting test\n", iperf );
+	iperf->started = currticks();
+	iperf->retransmits = tcp_stats.retransmits;
+	start_timer_fixed ( &iperf->timer, TICKS_PER_SEC );
+}
+
+/**
+ * Mark test as running
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_run ( struct iperf_client *iperf ) {
+
+	DBGC ( iperf, "IPERF %p test running\n", iperf );
+	iperf->flags |= IPERF_RUNNING;
+	if ( ! ( iperf->params.flags & IPERF_FL_REVERSE ) )
+		process_add ( &iperf->process );
+}
+
+/**
+ * End test
+ *
+ * @v iperf		iperf3 client
+ * @ret rc		Return status code
+ */
+static int iperf_end ( struct iperf_client *iperf ) {
+	struct iperf_report *total = &iperf->total;
+
+	DBGC ( iperf, "IPERF %p ending test\n", iperf );
+
+	/* Stop transferring data */
+	iperf->flags &= ~IPERF_RUNNING;
+	iperf->flags |= IPERF_ENDED;
+	process_del ( &iperf->process );
+
+	/* Finalise local statistics */
+	total->end = iperf_elapsed ( iperf );
+	if ( ! ( iperf->params.flags & IPERF_FL_UDP ) ) {
+		total->packets = 0;
+	} else if ( iperf->params.flags & IPERF_FL_REVERSE ) {
+		if ( iperf->sequence > total->packets )
+			total->lost = ( iperf->sequence - total->packets );
+		total->packets = iperf->sequence;
+	}
+
+	/* Notify server */
+	return iperf_send_state ( iperf, IPERF_TEST_END );
+}
+
+/**
+ * Handle state change received from server
+ *
+ * @v iperf		iperf3 client
+ * @v state		State
+ * @ret rc		Return status code
+ */
+static int iperf_state ( struct iperf_client *iperf, uint8_t state ) {
+	int rc;
+
+	DBGC2 ( iperf, "IPERF %p received state %d\n", iperf, state );
+	switch ( state ) {
+	case IPERF_PARAM_EXCHANGE:
+		return iperf_send_params ( iperf );
+	case IPERF_CREATE_STREAMS:
+		return iperf_create_stream ( iperf );
+	case IPERF_TEST_START:
+		iperf_start ( iperf );
+		return 0;
+	case IPERF_TEST_RUNNING:
+		iperf_run ( iperf );
+		return 0;
+	case IPERF_EXCHANGE_RESULTS:
+		if ( ( rc = iperf_send_results ( iperf ) ) != 0 )
+			return rc;
+		iperf->rx_state = IPERF_RX_LENGTH;
+		iperf->rx_offset = 0;
+		return 0;
+	case IPERF_DISPLAY_RESULTS:
+		iperf_report_summary ( iperf );
+		if ( ( rc = iperf_send_state ( iperf, IPERF_DONE ) ) != 0 )
+			return rc;
+		iperf_close ( iperf, 0 );
+		return 0;
+	case IPERF_ACCESS_DENIED:
+		DBGC ( iperf, "IPERF %p server is busy\n", iperf );
+		return -EBUSY;
+	case IPERF_SERVER_ERROR:
+	case IPERF_SERVER_TERMINATE:
+		DBGC ( iperf, "IPERF %p server aborted test\n", iperf );
+		return -ECONNABORTED;
+	default:
+		DBGC ( iperf, "IPERF %p unexpected state %d\n", iperf, state );
+		return -EPROTO;
+	}
+}
+
+/**
+ * Receive data from control connection
+ *
+ * @v iperf		iperf3 client
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int iperf_control_deliver ( struct iperf_client *iperf,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta __unused ) {
+	size_t len;
+	int rc;
+
+	while ( iob_len ( iobuf ) && ! ( iperf->flags & IPERF_CLOSED ) ) {
+		switch ( iperf->rx_state ) {
+
+		case IPERF_RX_STATE:
+			len = 1;
+			if ( ( rc = iperf_state ( iperf,
+						  *( ( uint8_t * )
+						     iobuf->data ) ) ) != 0 )
+				goto err;
+			break;
+
+		case IPERF_RX_LENGTH:
+			len = ( sizeof ( iperf->rx_len ) - iperf->rx_offset );
+			if ( len > iob_len ( iobuf ) )
+				len = iob_len ( iobuf );
+			memcpy ( &iperf->rx_len.bytes[iperf->rx_offset],
+				 iobuf->data, len );
+			iperf->rx_offset += len;
+			if ( iperf->rx_offset < sizeof ( iperf->rx_len ) )
+				break;
+			if ( ntohl ( iperf->rx_len.len ) >
+			     IPERF_MAX_RESULTS_LEN ) {
+				DBGC ( iperf, "IPERF %p results too long\n",
+				       iperf );
+				rc = -ERANGE;
+				goto err;
+			}
+			free ( iperf->rx_results );
+			iperf->rx_results =
+				zalloc ( ntohl ( iperf->rx_len.len ) + 1 );
+			if ( ! iperf->rx_results ) {
+				rc = -ENOMEM;
+				goto err;
+			}
+			iperf->rx_state = IPERF_RX_RESULTS;
+			iperf->rx_offset = 0;
+			break;
+
+		case IPERF_RX_RESULTS:
+			len = ( ntohl ( iperf->rx_len.len ) - iperf->rx_offset );
+			if ( len > iob_len ( iobuf ) )
+				len = iob_len ( iobuf );
+			memcpy ( ( iperf->rx_results + iperf->rx_offset ),
+				 iobuf->data, len );
+			iperf->rx_offset += len;
+			if ( iperf->rx_offset < ntohl ( iperf->rx_len.len ) )
+				break;
+			iperf_parse_results ( iperf );
+			iperf->rx_state = IPERF_RX_STATE;
+			break;
+
+		default:
+			assert ( 0 );
+			rc = -EINVAL;
+			goto err;
+		}
+		iob_pull ( iobuf, len );
+	}
+
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	iperf_close ( iperf, rc );
+	return rc;
+}
+
+/**
+ * Handle control connection window change
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_control_window_changed ( struct iperf_client *iperf ) {
+	int rc;
+
+	/* Send cookie once connection is established */
+	if ( ( iperf->flags & IPERF_CONTROL_OPEN ) ||
+	     ( ! xfer_window ( &iperf->control ) ) )
+		return;
+	iperf->flags |= IPERF_CONTROL_OPEN;
+	DBGC ( iperf, "IPERF %p connected with cookie %s\n",
+	       iperf, iperf->cookie );
+	if ( ( rc = xfer_deliver_raw ( &iperf->control, iperf->cookie,
+				       sizeof ( iperf->cookie ) ) ) != 0 )
+		iperf_close ( iperf, rc );
+}
+
+/**
+ * Handle control connection close
+ *
+ * @v iperf		iperf3 client
+ * @v rc		Reason for close
+ */
+static void iperf_control_close ( struct iperf_client *iperf, int rc ) {
+
+	DBGC ( iperf, "IPERF %p control connection closed: %s\n",
+	       iperf, strerror ( rc ) );
+	iperf_close ( iperf, ( rc ? rc : -ECONNRESET ) );
+}
+
+/** Control connection interface operations */
+static struct interface_operation iperf_control_op[] = {
+	INTF_OP ( xfer_deliver, struct iperf_client *, iperf_control_deliver ),
+	INTF_OP ( xfer_window_changed, struct iperf_client *,
+		  iperf_control_window_changed ),
+	INTF_OP ( intf_close, struct iperf_client *, iperf_control_close ),
+};
+
+/** Control connection interface descriptor */
+static struct interface_descriptor iperf_control_desc =
+	INTF_DESC_PASSTHRU ( struct iperf_client, control, iperf_control_op,
+			     job );
+
+/**
+ * Receive data from data stream
+ *
+ * @v iperf		iperf3 client
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int iperf_data_deliver ( struct iperf_client *iperf,
+				struct io_buffer *iobuf,
+				struct xfer_metadata *meta __unused ) {
+	struct iperf_udp_header *udphdr;
+	unsigned long sequence;
+
+	/* Ignore data unless we are receiving a running test */
+	if ( ! ( ( iperf->flags & IPERF_RUNNING ) &&
+		 ( iperf->params.flags & IPERF_FL_REVERSE ) ) )
+		goto done;
+
+	/* Track UDP sequence numbers */
+	if ( iperf->params.flags & IPERF_FL_UDP ) {
+		if ( iob_len ( iobuf ) < sizeof ( *udphdr ) )
+			goto done;
+		udphdr = iobuf->data;
+		sequence = ntohl ( udphdr->count );
+		if ( sequence > iperf->sequence )
+			iperf->sequence = sequence;
+	}
+
+	/* Record received data */
+	iperf_record ( iperf, iob_len ( iobuf ) );
+
+ done:
+	free_iob ( iobuf );
+	return 0;
+}
+
+/**
+ * Handle data stream window change
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_data_window_changed ( struct iperf_client *iperf ) {
+	uint32_t msg;
+	int rc;
+
+	/* Identify stream to server once stream is open */
+	if ( ( iperf->flags & IPERF_DATA_OPEN ) ||
+	     ( ! xfer_window ( &iperf->data ) ) )
+		return;
+	iperf->flags |= IPERF_DATA_OPEN;
+	DBGC ( iperf, "IPERF %p data stream connected\n", iperf );
+	if ( iperf->params.flags & IPERF_FL_UDP ) {
+		msg = cpu_to_le32 ( IPERF_UDP_CONNECT_MSG );
+		rc = xfer_deliver_raw ( &iperf->data, &msg, sizeof ( msg ) );
+	} else {
+		rc = xfer_deliver_raw ( &iperf->data, iperf->cookie,
+					sizeof ( iperf->cookie ) );
+	}
+	if ( rc != 0 )
+		iperf_close ( iperf, rc );
+}
+
+/**
+ * Handle data stream close
+ *
+ * @v iperf		iperf3 client
+ * @v rc		Reason for close
+ */
+static void iperf_data_close ( struct iperf_client *iperf, int rc ) {
+
+	DBGC ( iperf, "IPERF %p data stream closed: %s\n",
+	       iperf, strerror ( rc ) );
+
+	/* Server may close the data stream once the test has ended */
+	if ( iperf->flags & IPERF_ENDED ) {
+		intf_restart ( &iperf->data, rc );
+		return;
+	}
+
+	iperf_close ( iperf, ( rc ? rc : -ECONNRESET ) );
+}
+
+/** Data stream interface operations */
+static struct interface_operation iperf_data_op[] = {
+	INTF_OP ( xfer_deliver, struct iperf_client *, iperf_data_deliver ),
+	INTF_OP ( xfer_window_changed, struct iperf_client *,
+		  iperf_data_window_changed ),
+	INTF_OP ( intf_close, struct iperf_client *, iperf_data_close ),
+};
+
+/** Data stream interface descriptor */
+static struct interface_descriptor iperf_data_desc =
+	INTF_DESC ( struct iperf_client, data, iperf_data_op );
+
+/** Job control interface operations */
+static struct interface_operation iperf_job_op[] = {
+	INTF_OP ( intf_close, struct iperf_client *, iperf_close ),
+};
+
+/** Job control interface descriptor */
+static struct interface_descriptor iperf_job_desc =
+	INTF_DESC_PASSTHRU ( struct iperf_client, job, iperf_job_op, control );
+
+/**
+ * Transmit data block
+ *
+ * @v iperf		iperf3 client
+ * @v len		Length of block
+ * @ret rc		Return status code
+ */
+static int iperf_transmit ( struct iperf_client *iperf, size_t len ) {
+	struct iperf_udp_header *udphdr;
+	struct io_buffer *iobuf;
+	unsigned long elapsed;
+	int rc;
+
+	/* Allocate and populate I/O buffer */
+	iobuf = xfer_alloc_iob ( &iperf->data, len );
+	if ( ! iobuf )
+		return -ENOMEM;
+	memset ( iob_put ( iobuf, len ), 0, len );
+
+	/* Construct UDP header, if applicable */
+	if ( iperf->params.flags & IPERF_FL_UDP ) {
+		elapsed = iperf_elapsed ( iperf );
+		udphdr = iobuf->data;
+		udphdr->sec = htonl ( elapsed / TICKS_PER_SEC );
+		udphdr->usec = htonl ( ( ( elapsed % TICKS_PER_SEC ) *
+					 1000000 ) / TICKS_PER_SEC );
+		udphdr->count = htonl ( ++iperf->sequence );
+	}
+
+	/* Transmit block */
+	if ( ( rc = xfer_deliver_iob ( &iperf->data, iobuf ) ) != 0 )
+		return rc;
+
+	/* Record transmitted data */
+	iperf_record ( iperf, len );
+
+	return 0;
+}
+
+/**
+ * Transmit data
+ *
+ * @v iperf		iperf3 client
+ */
+static void iperf_step ( struct iperf_client *iperf ) {
+	struct iperf_parameters *params = &iperf->params;
+	unsigned long long target;
+	unsigned int burst;
+	size_t len;
+	int rc;
+
+	/* Transmit UDP datagrams at the requested bandwidth */
+	if ( params->flags & IPERF_FL_UDP ) {
+		target = ( ( ( ( unsigned long long ) params->bandwidth ) *
+			     iperf_elapsed ( iperf ) ) /
+			   ( 8 * TICKS_PER_SEC ) );
+		for ( burst = IPERF_UDP_BURST ;
+		      burst && ( iperf->total.bytes < target ) ; burst-- ) {
+			/* Transmission failures are counted as losses */
+			iperf_transmit ( iperf, params->len );
+		}
+		return;
+	}
+
+	/* Transmit as much TCP data as the window allows */
+	len = xfer_window ( &iperf->data );
+	if ( ! len )
+		return;
+	if ( len > params->len )
+		len = params->len;
+	if ( ( rc = iperf_transmit ( iperf, len ) ) != 0 ) {
+		DBGC ( iperf, "IPERF %p could not transmit: %s\n",
+		       iperf, strerror ( rc ) );
+		iperf_close ( iperf, rc );
+	}
+}
+
+/** Data transmission process descriptor */
+static struct process_descriptor iperf_process_desc =
+	PROC_DESC ( struct iperf_client, process, iperf_step );
+
+/**
+ * Handle reporting interval timer expiry
+ *
+ * @v timer		Reporting interval timer
+ * @v fail		Failure indicator
+ */
+static void iperf_expired ( struct retry_timer *timer, int fail __unused ) {
+	struct iperf_client *iperf =
+		container_of ( timer, struct iperf_client, timer );
+	unsigned long duration = ( iperf->params.duration * TICKS_PER_SEC );
+	int rc;
+
+	/* Report interval statistics */
+	iperf_report_interval ( iperf );
+
+	/* End test or start next interval */
+	if ( iperf_elapsed ( iperf ) >= duration ) {
+		if ( ( rc = iperf_end ( iperf ) ) != 0 )
+			iperf_close ( iperf, rc );
+	} else {
+		start_timer_fixed ( &iperf->timer, TICKS_PER_SEC );
+	}
+}
+
+/**
+ * Start iperf3 client
+ *
+ * @v job		Job control interface
+ * @v hostname		Server name
+ * @v params		Test parameters
+ * @v callback		Report callback
+ * @ret rc		Return status code
+ */
+int start_iperf ( struct interface *job, const char *hostname,
+		  struct iperf_parameters *params,
+		  void ( * callback ) ( struct iperf_report *report ) ) {
+	struct iperf_client *iperf;
+	size_t hostname_len = ( strlen ( hostname ) + 1 /* NUL */ );
+	unsigned int i;
+	int rc;
+
+	/* Allocate and initialise structure */
+	iperf = zalloc ( sizeof ( *iperf ) + hostname_len );
+	if ( ! iperf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &iperf->refcnt, iperf_free );
+	intf_init ( &iperf->job, &iperf_job_desc, &iperf->refcnt );
+	intf_init ( &iperf->control, &iperf_control_desc, &iperf->refcnt );
+	intf_init ( &iperf->data, &iperf_data_desc, &iperf->refcnt );
+	process_init_stopped ( &iperf->process, &iperf_process_desc,
+			       &iperf->refcnt );
+	timer_init ( &iperf->timer, iperf_expired, &iperf->refcnt );
+	iperf->hostname = memcpy ( ( ( ( void * ) iperf ) + sizeof ( *iperf ) ),
+				   hostname, hostname_len );
+	iperf->callback = callback;
+
+	/* Apply default parameters */
+	memcpy ( &iperf->params, params, sizeof ( iperf->params ) );
+	if ( ! iperf->params.port )
+		iperf->params.port = IPERF_PORT;
+	if ( ! iperf->params.duration )
+		iperf->params.duration = IPERF_DURATION;
+	if ( ! iperf->params.len ) {
+		iperf->params.len = ( ( params->flags & IPERF_FL_UDP ) ?
+				      IPERF_UDP_LEN : IPERF_TCP_LEN );
+	}
+	if ( ! iperf->params.bandwidth )
+		iperf->params.bandwidth = IPERF_UDP_BANDWIDTH;
+	if ( ( params->flags & IPERF_FL_UDP ) &&
+	     ( iperf->params.len < sizeof ( struct iperf_udp_header ) ) ) {
+		iperf->params.len = sizeof ( struct iperf_udp_header );
+	}
+
+	/* Construct session cookie */
+	for ( i = 0 ; i < ( sizeof ( iperf->cookie ) - 1 /* NUL */ ) ; i++ ) {
+		iperf->cookie[i] = IPERF_COOKIE_CHARS[ random() %
+			( sizeof ( IPERF_COOKIE_CHARS ) - 1 /* NUL */ ) ];
+	}
+
+	/* Open control connection */
+	iperf->server.st.st_port = htons ( iperf->params.port );
+	if ( ( rc = xfer_open_named_socket ( &iperf->control, SOCK_STREAM,
+					     &iperf->server.sa, hostname,
+					     NULL ) ) != 0 ) {
+		DBGC ( iperf, "IPERF %p could not open control connection: "
+		       "%s\n", iperf, strerror ( rc ) );
+		goto err_open;
+	}
+
+	/* Attach parent interface, mortalise self, and return */
+	intf_plug_plug ( &iperf->job, job );
+	ref_put ( &iperf->refcnt );
+	return 0;
+
+ err_open:
+	iperf_close ( iperf, rc );
+	ref_put ( &iperf->refcnt );
+ err_alloc:
+	return rc;
+}
@@ -45,10 +45,6 @@
  *
  */
 
-/** Set most significant bit to 1. */
-#define SET_LAST_FRAME( x ) ( (x) | 1 << 31 )
-#define GET_FRAME_SIZE( x ) ( (x) & ~( 1 << 31 ) )
-
 #define ONCRPC_CALL     0
 #define ONCRPC_REPLY    1
 
@@ -206,6 +202,36 @@ size_t oncrpc_compute_size ( const struct oncrpc_field fields[] ) {
 	return size;
 }
 
+/**
+ * Identify an ONC RPC record
+ *
+ * @v data              Start of record (at least ONCRPC_RECORD_ID_LEN bytes)
+ * @v len               Length of record (including record mark) to fill in
+ * @v xid               Transaction ID to fill in
+ * @ret rc              Return status code
+ *
+ * This allows a receiver to match a reply to its call (and so decide
+ * how to handle the remainder of the record) before the whole record
+ * has been received.
+ */
+int oncrpc_record_id ( const void *data, size_t *len, uint32_t *xid ) {
+	const uint32_t *header = data;
+	uint32_t mark = ntohl ( header[0] );
+
+	/* iPXE never sends multi-fragment records, and no server
+	 * ever seems to send them either.
+	 */
+	if ( ! ( mark & SET_LAST_FRAME ( 0 ) ) )
+		return -ENOTSUP;
+
+	*len = ( sizeof ( header[0] ) + GET_FRAME_SIZE ( mark ) );
+	if ( *len < ONCRPC_RECORD_ID_LEN )
+		return -EPROTO;
+	*xid = ntohl ( header[1] );
+
+	return 0;
+}
+
 /**
  * Parse an I/O buffer to extract a ONC RPC REPLY
  * @v session	        ONC RPC session
@@ -51,6 +51,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/job.h>
 #include <ipxe/dhe.h>
 #include <ipxe/tls.h>
+#include <ipxe/timeline.h>
 #include <config/crypto.h>
 
 /* Disambiguate the various error causes */
@@ -138,10 +139,6 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_ENOMEM_RX_DATA						\
 	__einfo_uniqify ( EINFO_ENOMEM, 0x07,				\
 			  "Not enough space for received data" )
-#define ENOMEM_RX_CONCAT __einfo_error ( EINFO_ENOMEM_RX_CONCAT )
-#define EINFO_ENOMEM_RX_CONCAT						\
-	__einfo_uniqify ( EINFO_ENOMEM, 0x08,				\
-			  "Not enough space to concatenate received data" )
 #define ENOTSUP_CIPHER __einfo_error ( EINFO_ENOTSUP_CIPHER )
 #define EINFO_ENOTSUP_CIPHER						\
 	__einfo_uniqify ( EINFO_ENOTSUP, 0x01,				\
@@ -1236,6 +1233,7 @@ static int tls_client_hello ( struct tls_connection *tls,
  */
 static int tls_send_client_hello ( struct tls_connection *tls ) {
 
+	timeline ( "tls-client-hello", "%s", tls->session->name );
 	return tls_client_hello ( tls, tls_send_handshake );
 }
 
@@ -2427,6 +2425,8 @@ static int tls_new_handshake ( struct tls_connection *tls,
 		}
 		payload = &handshake->payload;
 		record_len = ( sizeof ( *handshake ) + payload_len );
+		timeline ( "tls-handshake", "%s type %d", tls->session->name,
+			   handshake->type );
 
 		/* Handle payload */
 		switch ( handshake->type ) {
@@ -2520,13 +2520,11 @@ static int tls_new_record ( struct tls_connection *tls, unsigned int type,
 		return 0;
 	}
 
-	/* For all other records, merge into a single I/O buffer */
-	iobuf = iob_concatenate ( rx_data );
-	if ( ! iobuf ) {
-		DBGC ( tls, "TLS %p could not concatenate non-data record "
-		       "type %d\n", tls, type );
-		return -ENOMEM_RX_CONCAT;
-	}
+	/* All other records are received into a single I/O buffer */
+	iobuf = list_first_entry ( rx_data, struct io_buffer, list );
+	assert ( iobuf != NULL );
+	assert ( list_is_singular ( rx_data ) );
+	list_del ( &iobuf->list );
 
 	/* Determine handler */
 	switch ( type ) {
@@ -3054,6 +3052,7 @@ static int tls_newdata_process_header ( struct tls_connection *tls ) {
 	size_t iv_len = cipherspec->suite->record_iv_len;
 	size_t data_len = ntohs ( tls->rx_header.length );
 	size_t remaining = data_len;
+	size_t max_len;
 	size_t frag_len;
 	size_t reserve;
 	struct io_buffer *iobuf;
@@ -3067,6 +3066,15 @@ static int tls_newdata_process_header ( struct tls_connection *tls ) {
 	reserve = ( ( -iv_len ) & ( cipher->alignsize - 1 ) );
 	remaining += reserve;
 
+	/* Application data is decrypted in place and delivered as a
+	 * list of fragments, and so may be split into smaller
+	 * allocations.  All other records are parsed as a single
+	 * block, and so are received into a single buffer to avoid
+	 * the need to concatenate fragments later.
+	 */
+	max_len = ( ( tls->rx_header.type == TLS_TYPE_DATA ) ?
+		    TLS_RX_BUFSIZE : remaining );
+
 	/* Allocate data buffers now that we know the length */
 	assert ( list_empty ( &tls->rx_data ) );
 	while ( remaining ) {
@@ -3076,8 +3084,8 @@ static int tls_newdata_process_header ( struct tls_connection *tls ) {
 		 * allocation length if necessary).
 		 */
 		frag_len = remaining;
-		if ( frag_len > TLS_RX_BUFSIZE )
-			frag_len = TLS_RX_BUFSIZE;
+		if ( frag_len > max_len )
+			frag_len = max_len;
 		remaining -= frag_len;
 		if ( remaining < TLS_RX_MIN_BUFSIZE ) {
 			frag_len += remaining;
@@ -3271,6 +3279,7 @@ static void tls_validator_done ( struct tls_connection *tls, int rc ) {
 
 	/* Mark validation as complete */
 	pending_put ( &tls->validation );
+	timeline ( "tls-validated", "%s rc %d", session->name, rc );
 
 	/* Close validator interface */
 	intf_restart ( &tls->validator, rc );
@@ -48,6 +48,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/dhcppkt.h>
 #include <ipxe/dhcp_arch.h>
 #include <ipxe/features.h>
+#include <ipxe/timeline.h>
 #include <config/dhcp.h>
 
 /** @file
@@ -88,6 +89,7 @@ static uint8_t dhcp_request_options_data[] = {
 	DHCP_STRING ( DHCP_VENDOR_PXECLIENT ( DHCP_ARCH_CLIENT_ARCHITECTURE,
 					      DHCP_ARCH_CLIENT_NDI ) ),
 	DHCP_USER_CLASS_ID, DHCP_STRING ( 'i', 'P', 'X', 'E' ),
+	DHCP_RAPID_COMMIT, 0 /* no data */,
 	DHCP_PARAMETER_REQUEST_LIST,
 	DHCP_OPTION ( DHCP_SUBNET_MASK, DHCP_ROUTERS, DHCP_DNS_SERVERS,
 		      DHCP_LOG_SERVERS, DHCP_HOST_NAME, DHCP_DOMAIN_NAME,
@@ -229,6 +231,9 @@ struct dhcp_session {
 	/** ProxyDHCP offer priority */
 	int proxy_priority;
 
+	/** Rapid commit DHCPACK for the selected offer, if any */
+	struct dhcp_packet *rapid_ack;
+
 	/** PXE Boot Server type */
 	uint16_t pxe_type;
 	/** List of PXE Boot Servers to attempt */
@@ -255,6 +260,7 @@ static void dhcp_free ( struct refcnt *refcnt ) {
 
 	netdev_put ( dhcp->netdev );
 	dhcppkt_put ( dhcp->proxy_offer );
+	dhcppkt_put ( dhcp->rapid_ack );
 	free ( dhcp );
 }
 
@@ -266,6 +272,9 @@ static void dhcp_free ( struct refcnt *refcnt ) {
  */
 static void dhcp_finished ( struct dhcp_session *dhcp, int rc ) {
 
+	/* Record completion in boot timeline */
+	timeline ( "dhcp-done", "%s rc %d", dhcp->netdev->name, rc );
+
 	/* Stop retry timer */
 	stop_timer ( &dhcp->timer );
 
@@ -284,6 +293,7 @@ static void dhcp_set_state ( struct dhcp_session *dhcp,
 			     struct dhcp_session_state *state ) {
 
 	DBGC ( dhcp, "DHCP %p entering %s state\n", dhcp, state->name );
+	timeline ( "dhcp", "%s %s", dhcp->netdev->name, state->name );
 	dhcp->state = state;
 	dhcp->start = currticks();
 	stop_timer ( &dhcp->timer );
@@ -322,6 +332,80 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
  *
  */
 
+/**
+ * Use acknowledged DHCP lease
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCPACK packet
+ */
+static void dhcp_acknowledged ( struct dhcp_session *dhcp,
+				struct dhcp_packet *dhcppkt ) {
+	struct settings *parent;
+	struct settings *settings;
+	int rc;
+
+	/* Record assigned address */
+	dhcp->local.sin_addr = dhcppkt->dhcphdr->yiaddr;
+
+	/* Register settings */
+	parent = netdev_settings ( dhcp->netdev );
+	settings = &dhcppkt->settings;
+	if ( ( rc = register_settings ( settings, parent,
+					DHCP_SETTINGS_NAME ) ) != 0 ) {
+		DBGC ( dhcp, "DHCP %p could not register settings: %s\n",
+		       dhcp, strerror ( rc ) );
+		dhcp_finished ( dhcp, rc );
+		return;
+	}
+
+	/* Perform ProxyDHCP if applicable */
+	if ( dhcp->proxy_offer /* Have ProxyDHCP offer */ &&
+	     ( ! dhcp->no_pxedhcp ) /* ProxyDHCP not disabled */ ) {
+		if ( dhcp_has_pxeopts ( dhcp->proxy_offer ) ) {
+			/* PXE options already present; register settings
+			 * without performing a ProxyDHCPREQUEST
+			 */
+			settings = &dhcp->proxy_offer->settings;
+			if ( ( rc = register_settings ( settings, NULL,
+					   PROXYDHCP_SETTINGS_NAME ) ) != 0 ) {
+				DBGC ( dhcp, "DHCP %p could not register "
+				       "proxy settings: %s\n",
+				       dhcp, strerror ( rc ) );
+				dhcp_finished ( dhcp, rc );
+				return;
+			}
+		} else {
+			/* PXE options not present; use a ProxyDHCPREQUEST */
+			dhcp_set_state ( dhcp, &dhcp_state_proxy );
+			return;
+		}
+	}
+
+	/* Terminate DHCP */
+	dhcp_finished ( dhcp, 0 );
+}
+
+/**
+ * Complete DHCP discovery
+ *
+ * @v dhcp		DHCP session
+ *
+ * If the selected offer was a rapid commit DHCPACK, then the lease
+ * is already ours and no DHCPREQUEST is required.
+ */
+static void dhcp_discovery_done ( struct dhcp_session *dhcp ) {
+
+	/* Use rapid commit DHCPACK, if applicable */
+	if ( dhcp->rapid_ack ) {
+		DBGC ( dhcp, "DHCP %p using rapid commit DHCPACK\n", dhcp );
+		dhcp_acknowledged ( dhcp, dhcp->rapid_ack );
+		return;
+	}
+
+	/* Transition to DHCPREQUEST */
+	dhcp_set_state ( dhcp, &dhcp_state_request );
+}
+
 /**
  * Construct transmitted packet for DHCP discovery
  *
@@ -364,6 +448,7 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	int8_t priority = 0;
 	uint8_t no_pxedhcp = 0;
 	unsigned long elapsed;
+	int rapid;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
 	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
@@ -400,16 +485,26 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 			sizeof ( no_pxedhcp ) );
 	if ( no_pxedhcp )
 		DBGC ( dhcp, " nopxe" );
+
+	/* Identify rapid commit DHCPACK */
+	rapid = ( ( msgtype == DHCPACK ) &&
+		  ( dhcppkt_fetch ( dhcppkt, DHCP_RAPID_COMMIT,
+				    NULL, 0 ) >= 0 ) );
+	if ( rapid )
+		DBGC ( dhcp, " rapid" );
 	DBGC ( dhcp, "\n" );
 
 	/* Select as DHCP offer, if applicable */
 	if ( ip.s_addr && ( peer->sin_port == htons ( BOOTPS_PORT ) ) &&
-	     ( ( msgtype == DHCPOFFER ) || ( ! msgtype /* BOOTP */ ) ) &&
+	     ( ( msgtype == DHCPOFFER ) || ( ! msgtype /* BOOTP */ ) ||
+	       rapid ) &&
 	     ( priority >= dhcp->priority ) ) {
 		dhcp->offer = ip;
 		dhcp->server = server_id;
 		dhcp->priority = priority;
 		dhcp->no_pxedhcp = no_pxedhcp;
+		dhcppkt_put ( dhcp->rapid_ack );
+		dhcp->rapid_ack = ( rapid ? dhcppkt_get ( dhcppkt ) : NULL );
 	}
 
 	/* Select as ProxyDHCP offer, if applicable */
@@ -439,8 +534,8 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) )
 		return;
 
-	/* Transition to DHCPREQUEST */
-	dhcp_set_state ( dhcp, &dhcp_state_request );
+	/* Complete discovery */
+	dhcp_discovery_done ( dhcp );
 }
 
 /**
@@ -474,7 +569,7 @@ static void dhcp_discovery_expired ( struct dhcp_session *dhcp ) {
 	/* Give up waiting for ProxyDHCP before we reach the failure point */
 	if ( dhcp->offer.s_addr &&
 	     ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) {
-		dhcp_set_state ( dhcp, &dhcp_state_request );
+		dhcp_discovery_done ( dhcp );
 		return;
 	}
 
@@ -548,9 +643,6 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 			      struct in_addr server_id,
 			      struct in_addr pseudo_id ) {
 	struct in_addr ip;
-	struct settings *parent;
-	struct settings *settings;
-	int rc;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
 	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
@@ -585,45 +677,8 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 	if ( ip.s_addr != dhcp->offer.s_addr )
 		return;
 
-	/* Record assigned address */
-	dhcp->local.sin_addr = ip;
-
-	/* Register settings */
-	parent = netdev_settings ( dhcp->netdev );
-	settings = &dhcppkt->settings;
-	if ( ( rc = register_settings ( settings, parent,
-					DHCP_SETTINGS_NAME ) ) != 0 ) {
-		DBGC ( dhcp, "DHCP %p could not register settings: %s\n",
-		       dhcp, strerror ( rc ) );
-		dhcp_finished ( dhcp, rc );
-		return;
-	}
-
-	/* Perform ProxyDHCP if applicable */
-	if ( dhcp->proxy_offer /* Have ProxyDHCP offer */ &&
-	     ( ! dhcp->no_pxedhcp ) /* ProxyDHCP not disabled */ ) {
-		if ( dhcp_has_pxeopts ( dhcp->proxy_offer ) ) {
-			/* PXE options already present; register settings
-			 * without performing a ProxyDHCPREQUEST
-			 */
-			settings = &dhcp->proxy_offer->settings;
-			if ( ( rc = register_settings ( settings, NULL,
-					   PROXYDHCP_SETTINGS_NAME ) ) != 0 ) {
-				DBGC ( dhcp, "DHCP %p could not register "
-				       "proxy settings: %s\n",
-				       dhcp, strerror ( rc ) );
-				dhcp_finished ( dhcp, rc );
-				return;
-			}
-		} else {
-			/* PXE options not present; use a ProxyDHCPREQUEST */
-			dhcp_set_state ( dhcp, &dhcp_state_proxy );
-			return;
-		}
-	}
-
-	/* Terminate DHCP */
-	dhcp_finished ( dhcp, 0 );
+	/* Use acknowledged lease */
+	dhcp_acknowledged ( dhcp, dhcppkt );
 }
 
 /**
@@ -1021,6 +1076,15 @@ int dhcp_create_request ( struct dhcp_packet *dhcppkt,
 		goto err_create_packet;
 	}
 
+	/* Rapid commit may be requested only within a DHCPDISCOVER */
+	if ( ( msgtype != DHCPDISCOVER ) &&
+	     ( ( rc = dhcppkt_store ( dhcppkt, DHCP_RAPID_COMMIT,
+				      NULL, 0 ) ) != 0 ) ) {
+		DBG ( "DHCP could not remove rapid commit option: %s\n",
+		      strerror ( rc ) );
+		goto err_store_rapid;
+	}
+
 	/* Set client IP address */
 	dhcppkt->dhcphdr->ciaddr = ciaddr;
 
@@ -1097,6 +1161,7 @@ int dhcp_create_request ( struct dhcp_packet *dhcppkt,
  err_store_client_id:
  err_store_busid:
  err_store_features:
+ err_store_rapid:
  err_create_packet:
 	return rc;
 }
@@ -29,16 +29,20 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
 #include <byteswap.h>
+#include <ipxe/list.h>
 #include <ipxe/refcnt.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/resolv.h>
 #include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/malloc.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/settings.h>
 #include <ipxe/features.h>
@@ -46,6 +50,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/dhcp.h>
 #include <ipxe/dhcpv6.h>
 #include <ipxe/dns.h>
+#include <ipxe/timeline.h>
 
 /** @file
  *
@@ -90,6 +95,50 @@ static unsigned int dns_count;
 /** The DNS search list */
 static struct dns_name dns_search;
 
+/** A DNS cache entry */
+struct dns_cache_entry {
+	/** List of DNS cache entries */
+	struct list_head list;
+	/** Resolved address (if resolution succeeded) */
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+		struct sockaddr_in6 sin6;
+	} address;
+	/** Resolution status code */
+	int rc;
+	/** Requested address family (or zero for any) */
+	sa_family_t family;
+	/** Time at which this entry was created */
+	unsigned long created;
+	/** Lifetime of this entry (in ticks) */
+	unsigned long lifetime;
+	/** Name as originally requested */
+	char name[0];
+};
+
+/** Maximum number of DNS cache entries */
+#define DNS_CACHE_MAX_ENTRIES 16
+
+/** Maximum lifetime of a DNS cache entry (in seconds)
+ *
+ * This is a policy decision, which also avoids overflow when
+ * converting to ticks.
+ */
+#define DNS_CACHE_MAX_TTL ( 60 * 60 )
+
+/** Lifetime of a negative DNS cache entry (in seconds)
+ *
+ * This is a policy decision.
+ */
+#define DNS_CACHE_NEGATIVE_TTL 30
+
+/** DNS cache */
+static LIST_HEAD ( dns_cache );
+
+/** Number of DNS cache entries */
+static unsigned int dns_cache_count;
+
 /**
  * Encode a DNS name using RFC1035 encoding
  *
@@ -448,6 +497,186 @@ static const char * dns_type ( uint16_t type ) {
 	}
 }
 
+/**
+ * Delete DNS cache entry
+ *
+ * @v entry		DNS cache entry
+ */
+static void dns_cache_del ( struct dns_cache_entry *entry ) {
+
+	DBGC2 ( &dns_cache, "DNS cache discarding \"%s\"\n", entry->name );
+	list_del ( &entry->list );
+	dns_cache_count--;
+	free ( entry );
+}
+
+/**
+ * Find DNS cache entry
+ *
+ * @v name		Name as originally requested
+ * @v family		Requested address family (or zero for any)
+ * @ret entry		DNS cache entry, or NULL if not found
+ */
+static struct dns_cache_entry * dns_cache_find ( const char *name,
+						 sa_family_t family ) {
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry *tmp;
+	unsigned long now = currticks();
+
+	list_for_each_entry_safe ( entry, tmp, &dns_cache, list ) {
+
+		/* Discard expired entries */
+		if ( ( now - entry->created ) >= entry->lifetime ) {
+			dns_cache_del ( entry );
+			continue;
+		}
+
+		/* Check for matching name and address family */
+		if ( entry->family != family )
+			continue;
+		if ( strcasecmp ( entry->name, name ) != 0 )
+			continue;
+
+		/* Move to head of list to maintain LRU ordering */
+		list_del ( &entry->list );
+		list_add ( &entry->list, &dns_cache );
+		return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add DNS cache entry
+ *
+ * @v name		Name as originally requested
+ * @v family		Requested address family (or zero for any)
+ * @v sa		Resolved address (if resolution succeeded)
+ * @v rc		Resolution status code
+ * @v ttl		Time to live (in seconds)
+ */
+static void dns_cache_add ( const char *name, sa_family_t family,
+			    struct sockaddr *sa, int rc, unsigned long ttl ) {
+	struct dns_cache_entry *entry;
+	size_t name_len = ( strlen ( name ) + 1 /* NUL */ );
+
+	/* Do not cache uncacheable answers */
+	if ( ! ttl )
+		return;
+	if ( ttl > DNS_CACHE_MAX_TTL )
+		ttl = DNS_CACHE_MAX_TTL;
+
+	/* Discard any existing entry for this name */
+	if ( ( entry = dns_cache_find ( name, family ) ) )
+		dns_cache_del ( entry );
+
+	/* Discard least recently used entry if cache is full */
+	if ( dns_cache_count >= DNS_CACHE_MAX_ENTRIES ) {
+		entry = list_last_entry ( &dns_cache, struct dns_cache_entry,
+					  list );
+		assert ( entry != NULL );
+		dns_cache_del ( entry );
+	}
+
+	/* Allocate and populate entry */
+	entry = zalloc ( sizeof ( *entry ) + name_len );
+	if ( ! entry )
+		return;
+	if ( sa ) {
+		entry->address.sa.sa_family = sa->sa_family;
+		if ( sa->sa_family == AF_INET6 ) {
+			memcpy ( &entry->address.sin6.sin6_addr,
+				 &( ( struct sockaddr_in6 * ) sa )->sin6_addr,
+				 sizeof ( entry->address.sin6.sin6_addr ) );
+		} else {
+			entry->address.sin.sin_addr =
+				( ( struct sockaddr_in * ) sa )->sin_addr;
+		}
+	}
+	entry->rc = rc;
+	entry->family = family;
+	entry->created = currticks();
+	entry->lifetime = ( ttl * TICKS_PER_SEC );
+	memcpy ( entry->name, name, name_len );
+
+	/* Add to cache */
+	list_add ( &entry->list, &dns_cache );
+	dns_cache_count++;
+	DBGC2 ( &dns_cache, "DNS cache added \"%s\" (%s) for %lds\n",
+		name, ( sa ? sock_ntoa ( sa ) : strerror ( rc ) ), ttl );
+}
+
+/**
+ * Flush DNS cache
+ *
+ */
+static void dns_cache_flush ( void ) {
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry *tmp;
+
+	list_for_each_entry_safe ( entry, tmp, &dns_cache, list )
+		dns_cache_del ( entry );
+}
+
+/**
+ * Describe DNS cache entry
+ *
+ * @v index		Index of unexpired entry (most recently used first)
+ * @v info		Description to fill in
+ * @ret rc		Return status code
+ *
+ * The description remains valid only until the DNS cache is next
+ * modified.
+ */
+int dns_cache_describe ( unsigned int index, struct dns_cache_info *info ) {
+	struct dns_cache_entry *entry;
+	unsigned long now = currticks();
+	unsigned long age;
+
+	list_for_each_entry ( entry, &dns_cache, list ) {
+
+		/* Skip expired entries */
+		age = ( now - entry->created );
+		if ( age >= entry->lifetime )
+			continue;
+
+		/* Skip preceding entries */
+		if ( index-- )
+			continue;
+
+		/* Describe entry */
+		info->name = entry->name;
+		info->sa = &entry->address.sa;
+		info->rc = entry->rc;
+		info->remaining = ( entry->lifetime - age );
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+/**
+ * Discard some cached DNS data
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int dns_cache_discard ( void ) {
+	struct dns_cache_entry *entry;
+
+	/* Discard least recently used entry */
+	entry = list_last_entry ( &dns_cache, struct dns_cache_entry, list );
+	if ( ! entry )
+		return 0;
+	dns_cache_del ( entry );
+
+	return 1;
+}
+
+/** DNS cache discarder */
+struct cache_discarder dns_cache_discarder __cache_discarder ( CACHE_CHEAP ) = {
+	.discard = dns_cache_discard,
+};
+
 /** A DNS request */
 struct dns_request {
 	/** Reference counter */
@@ -490,6 +719,14 @@ struct dns_request {
 	unsigned int index;
 	/** Recursion counter */
 	unsigned int recursion;
+	/** Minimum time to live of answers used (in seconds) */
+	unsigned long ttl;
+	/** Name as originally requested */
+	char *requested;
+	/** Address family to resolve (or zero for any) */
+	sa_family_t family;
+	/** Result was obtained from the DNS cache */
+	int cached;
 };
 
 /**
@@ -500,6 +737,9 @@ struct dns_request {
  */
 static void dns_done ( struct dns_request *dns, int rc ) {
 
+	/* Record completion in boot timeline */
+	timeline ( "dns-done", "%s rc %d", dns->requested, rc );
+
 	/* Stop the retry timer */
 	stop_timer ( &dns->timer );
 
@@ -516,8 +756,15 @@ static void dns_done ( struct dns_request *dns, int rc ) {
  */
 static void dns_resolved ( struct dns_request *dns ) {
 
-	DBGC ( dns, "DNS %p found address %s\n",
-	       dns, sock_ntoa ( &dns->address.sa ) );
+	DBGC ( dns, "DNS %p found %saddress %s\n", dns,
+	       ( dns->cached ? "cached " : "" ),
+	       sock_ntoa ( &dns->address.sa ) );
+
+	/* Add to cache, if applicable */
+	if ( ! dns->cached ) {
+		dns_cache_add ( dns->requested, dns->family,
+				&dns->address.sa, 0, dns->ttl );
+	}
 
 	/* Return resolved address */
 	resolv_done ( &dns->resolv, &dns->address.sa );
@@ -648,6 +895,12 @@ static void dns_timer_expired ( struct retry_timer *timer, int fail ) {
 		return;
 	}
 
+	/* Return cached result, if applicable */
+	if ( dns->cached ) {
+		dns_resolved ( dns );
+		return;
+	}
+
 	/* Move to next DNS server if this is a retransmission */
 	if ( dns->buf.query.id )
 		dns->index++;
@@ -761,6 +1014,10 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			continue;
 		}
 
+		/* Record minimum time to live of answers used */
+		if ( dns->ttl > ntohl ( rr->common.ttl ) )
+			dns->ttl = ntohl ( rr->common.ttl );
+
 		/* Handle answer */
 		switch ( rr->common.type ) {
 
@@ -843,10 +1100,17 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 
 	case htons ( DNS_TYPE_AAAA ):
 		/* We asked for an AAAA record and got nothing; try
-		 * the A.
+		 * the A (unless only IPv6 addresses are wanted).
 		 */
-		DBGC ( dns, "DNS %p found no AAAA record; trying A\n", dns );
-		dns->question->qtype = htons ( DNS_TYPE_A );
+		if ( dns->family == AF_INET6 ) {
+			DBGC ( dns, "DNS %p found no AAAA record; trying "
+			       "CNAME\n", dns );
+			dns->question->qtype = htons ( DNS_TYPE_CNAME );
+		} else {
+			DBGC ( dns, "DNS %p found no AAAA record; trying A\n",
+			       dns );
+			dns->question->qtype = htons ( DNS_TYPE_A );
+		}
 		dns_send_packet ( dns );
 		rc = 0;
 		goto done;
@@ -878,6 +1142,8 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 		if ( dns->search.offset == dns->search.len ) {
 			DBGC ( dns, "DNS %p found no CNAME record\n", dns );
 			rc = -ENXIO_NO_RECORD;
+			dns_cache_add ( dns->requested, dns->family, NULL,
+					rc, DNS_CACHE_NEGATIVE_TTL );
 			dns_done ( dns, rc );
 			goto done;
 		}
@@ -976,7 +1242,9 @@ static int dns_resolv ( struct interface *resolv,
 			const char *name, struct sockaddr *sa ) {
 	struct dns_request *dns;
 	struct dns_header *query;
+	struct dns_cache_entry *entry;
 	size_t search_len;
+	size_t requested_len;
 	int name_len;
 	int rc;
 
@@ -992,7 +1260,8 @@ static int dns_resolv ( struct interface *resolv,
 	search_len = ( strchr ( name, '.' ) ? 0 : dns_search.len );
 
 	/* Allocate DNS structure */
-	dns = zalloc ( sizeof ( *dns ) + search_len );
+	requested_len = ( strlen ( name ) + 1 /* NUL */ );
+	dns = zalloc ( sizeof ( *dns ) + search_len + requested_len );
 	if ( ! dns ) {
 		rc = -ENOMEM;
 		goto err_alloc_dns;
@@ -1005,10 +1274,28 @@ static int dns_resolv ( struct interface *resolv,
 	dns->search.data = ( ( ( void * ) dns ) + sizeof ( *dns ) );
 	dns->search.len = search_len;
 	memcpy ( dns->search.data, dns_search.data, search_len );
-
-	/* Determine initial query type */
-	dns->qtype = ( ( dns6.count != 0 ) ?
-		       htons ( DNS_TYPE_AAAA ) : htons ( DNS_TYPE_A ) );
+	dns->requested = ( dns->search.data + search_len );
+	memcpy ( dns->requested, name, requested_len );
+	dns->ttl = DNS_CACHE_MAX_TTL;
+	timeline ( "dns-query", "%s", name );
+
+	/* Determine initial query type.  If no address family is
+	 * specified, then try AAAA first only if we have IPv6 name
+	 * servers.
+	 */
+	dns->family = sa->sa_family;
+	switch ( dns->family ) {
+	case AF_INET:
+		dns->qtype = htons ( DNS_TYPE_A );
+		break;
+	case AF_INET6:
+		dns->qtype = htons ( DNS_TYPE_AAAA );
+		break;
+	default:
+		dns->qtype = ( ( dns6.count != 0 ) ?
+			       htons ( DNS_TYPE_AAAA ) : htons ( DNS_TYPE_A ) );
+		break;
+	}
 
 	/* Construct query */
 	query = &dns->buf.query;
@@ -1027,9 +1314,29 @@ static int dns_resolv ( struct interface *resolv,
 	if ( ( rc = dns_question ( dns ) ) != 0 )
 		goto err_question;
 
-	/* Open UDP connection */
-	if ( ( rc = xfer_open_socket ( &dns->socket, SOCK_DGRAM,
-				       NULL, NULL ) ) != 0 ) {
+	/* Use cached result, if available */
+	if ( ( entry = dns_cache_find ( name, dns->family ) ) ) {
+		if ( ( rc = entry->rc ) != 0 ) {
+			DBGC ( dns, "DNS %p found cached failure for %s: %s\n",
+			       dns, name, strerror ( rc ) );
+			goto err_cached;
+		}
+		dns->address.sa.sa_family = entry->address.sa.sa_family;
+		if ( entry->address.sa.sa_family == AF_INET6 ) {
+			memcpy ( &dns->address.sin6.sin6_addr,
+				 &entry->address.sin6.sin6_addr,
+				 sizeof ( dns->address.sin6.sin6_addr ) );
+		} else {
+			dns->address.sin.sin_addr =
+				entry->address.sin.sin_addr;
+		}
+		dns->cached = 1;
+	}
+
+	/* Open UDP connection, if applicable */
+	if ( ( ! dns->cached ) &&
+	     ( ( rc = xfer_open_socket ( &dns->socket, SOCK_DGRAM,
+					 NULL, NULL ) ) != 0 ) ) {
 		DBGC ( dns, "DNS %p could not open socket: %s\n",
 		       dns, strerror ( rc ) );
 		goto err_open_socket;
@@ -1044,6 +1351,7 @@ static int dns_resolv ( struct interface *resolv,
 	return 0;	
 
  err_open_socket:
+ err_cached:
  err_question:
  err_encode:
 	ref_put ( &dns->refcnt );
@@ -1143,13 +1451,15 @@ const struct setting dnssl_setting __setting ( SETTING_IP_EXTRA, dnssl ) = {
 /**
  * Apply DNS server addresses
  *
+ * @ret changed		DNS server addresses have changed
  */
-static void apply_dns_servers ( void ) {
+static int apply_dns_servers ( void ) {
+	struct dns_server old4 = dns4;
+	struct dns_server old6 = dns6;
+	int changed;
 	int len;
 
-	/* Free existing server addresses */
-	free ( dns4.data );
-	free ( dns6.data );
+	/* Clear existing server addresses */
 	dns4.data = NULL;
 	dns6.data = NULL;
 	dns4.count = 0;
@@ -1163,25 +1473,39 @@ static void apply_dns_servers ( void ) {
 	if ( len >= 0 )
 		dns6.count = ( len / sizeof ( dns6.in6[0] ) );
 	dns_count = ( dns4.count + dns6.count );
+
+	/* Check for changes and free old server addresses */
+	changed = ( ( dns4.count != old4.count ) ||
+		    ( dns6.count != old6.count ) ||
+		    ( memcmp ( dns4.in, old4.in,
+			       ( dns4.count * sizeof ( dns4.in[0] ) ) ) ) ||
+		    ( memcmp ( dns6.in6, old6.in6,
+			       ( dns6.count * sizeof ( dns6.in6[0] ) ) ) ) );
+	free ( old4.data );
+	free ( old6.data );
+
+	return changed;
 }
 
 /**
  * Apply DNS search list
  *
+ * @ret changed		DNS search list has changed
  */
-static void apply_dns_search ( void ) {
+static int apply_dns_search ( void ) {
+	struct dns_name old = dns_search;
 	char *localdomain;
+	int changed;
 	int len;
 
-	/* Free existing search list */
-	free ( dns_search.data );
+	/* Clear existing search list */
 	memset ( &dns_search, 0, sizeof ( dns_search ) );
 
 	/* Fetch DNS search list */
 	len = fetch_raw_setting_copy ( NULL, &dnssl_setting, &dns_search.data );
 	if ( len >= 0 ) {
 		dns_search.len = len;
-		return;
+		goto done;
 	}
 
 	/* If no DNS search list exists, try to fetch the local domain */
@@ -1196,8 +1520,15 @@ static void apply_dns_search ( void ) {
 			}
 		}
 		free ( localdomain );
-		return;
 	}
+
+ done:
+	/* Check for changes and free old search list */
+	changed = ( ( dns_search.len != old.len ) ||
+		    ( memcmp ( dns_search.data, old.data, old.len ) != 0 ) );
+	free ( old.data );
+
+	return changed;
 }
 
 /**
@@ -1207,9 +1538,10 @@ static void apply_dns_search ( void ) {
  */
 static int apply_dns_settings ( void ) {
 	void *dbgcol = &dns_count;
+	int changed;
 
 	/* Fetch DNS server address */
-	apply_dns_servers();
+	changed = apply_dns_servers();
 	if ( DBG_EXTRA && ( dns_count != 0 ) ) {
 		union {
 			struct sockaddr sa;
@@ -1234,7 +1566,7 @@ static int apply_dns_settings ( void ) {
 	}
 
 	/* Fetch DNS search list */
-	apply_dns_search();
+	changed |= apply_dns_search();
 	if ( DBG_EXTRA && ( dns_search.len != 0 ) ) {
 		struct dns_name name;
 		int offset;
@@ -1251,6 +1583,10 @@ static int apply_dns_settings ( void ) {
 		DBGC2 ( dbgcol, "\n" );
 	}
 
+	/* Flush DNS cache if servers or search list have changed */
+	if ( changed )
+		dns_cache_flush();
+
 	return 0;
 }
 
@@ -33,6 +33,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/features.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/bitmap.h>
+#include <ipxe/list.h>
+#include <ipxe/erasure.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
@@ -83,6 +85,28 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *  ....
  *  Nul
  *
+ * An extended "x-slam-fec" mode adds forward error correction, so
+ * that clients can recover from packet loss without sending NACKs.
+ * The transfer is divided into groups of consecutive blocks, and
+ * the server additionally transmits a number of Reed-Solomon repair
+ * blocks for each group.  Any sufficiently large subset of the
+ * source and repair blocks within a group allows the whole group to
+ * be reconstructed (see core/erasure.c).  The final block in the
+ * transfer is treated as being zero-padded to the full block size
+ * for the purpose of constructing repair blocks.  The final group
+ * in the transfer may contain fewer than the full number of source
+ * blocks; its repair blocks are constructed using only the source
+ * blocks actually present.  In this mode, the
+ * packet header is extended with two further fields:
+ *
+ *  Int : Number of source blocks per group.
+ *
+ *  Int : Number of repair blocks per group.
+ *
+ * Repair packets are numbered sequentially following the last data
+ * packet, so that repair block j within group g has the packet
+ * sequence number ( num_blocks + g * repair_blocks + j ).
+ *
  */
 
 FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
@@ -99,7 +123,8 @@ FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
 
 /** Maximum SLAM header length */
 #define SLAM_MAX_HEADER_LEN ( 7 /* transaction id */ + 7 /* total_bytes */ + \
-			      7 /* block_size */ )
+			      7 /* block_size */ + 7 /* group_size */ +	   \
+			      7 /* group_repair */ )
 
 /** Maximum number of blocks to request per NACK
  *
@@ -118,6 +143,30 @@ FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
 /** SLAM slave timeout */
 #define SLAM_SLAVE_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** Maximum number of FEC groups under reconstruction
+ *
+ * This is a policy decision that limits the amount of memory
+ * consumed by buffering partially received groups.  Any blocks lost
+ * from a group that is evicted will be recovered via NACKs.
+ */
+#define SLAM_FEC_MAX_GROUPS 4
+
+/** A SLAM FEC group under reconstruction */
+struct slam_group {
+	/** List of groups */
+	struct list_head list;
+	/** Group number */
+	unsigned long group;
+	/** Number of source blocks in this group */
+	unsigned int count;
+	/** Number of blocks received */
+	unsigned int received;
+	/** Indices of received blocks within group */
+	unsigned int *index;
+	/** Received blocks */
+	void **blocks;
+};
+
 /** A SLAM request */
 struct slam_request {
 	/** Reference counter */
@@ -149,8 +198,245 @@ struct slam_request {
 	struct bitmap bitmap;
 	/** NACK sent flag */
 	int nack_sent;
+
+	/** Forward error correction is in use */
+	int fec;
+	/** Number of source blocks per FEC group */
+	unsigned long group_size;
+	/** Number of repair blocks per FEC group */
+	unsigned long group_repair;
+	/** Number of FEC groups in transfer */
+	unsigned long num_groups;
+	/** FEC groups under reconstruction (most recent first) */
+	struct list_head groups;
+	/** Number of FEC groups under reconstruction */
+	unsigned int groups_len;
 };
 
+/****************************************************************************
+ *
+ * Forward error correction
+ *
+ */
+
+/**
+ * Free SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		FEC group
+ */
+static void slam_fec_free ( struct slam_request *slam,
+			    struct slam_group *group ) {
+
+	list_del ( &group->list );
+	slam->groups_len--;
+	free ( group );
+}
+
+/**
+ * Discard all SLAM FEC groups
+ *
+ * @v slam		SLAM request
+ */
+static void slam_fec_flush ( struct slam_request *slam ) {
+	struct slam_group *group;
+	struct slam_group *tmp;
+
+	list_for_each_entry_safe ( group, tmp, &slam->groups, list )
+		slam_fec_free ( slam, group );
+}
+
+/**
+ * Get number of source blocks within SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		Group number
+ * @ret count		Number of source blocks
+ */
+static unsigned int slam_fec_count ( struct slam_request *slam,
+				     unsigned long group ) {
+	unsigned long first = ( group * slam->group_size );
+	unsigned long count = slam->group_size;
+
+	/* The final group may be short */
+	if ( count > ( slam->num_blocks - first ) )
+		count = ( slam->num_blocks - first );
+	return count;
+}
+
+/**
+ * Count missing source blocks within SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		Group number
+ * @ret missing		Number of missing source blocks
+ */
+static unsigned int slam_fec_missing ( struct slam_request *slam,
+				       unsigned long group ) {
+	unsigned long first = ( group * slam->group_size );
+	unsigned long last = ( first + slam_fec_count ( slam, group ) );
+	unsigned long block;
+	unsigned int missing = 0;
+
+	for ( block = first ; block < last ; block++ ) {
+		if ( ! bitmap_test ( &slam->bitmap, block ) )
+			missing++;
+	}
+	return missing;
+}
+
+/**
+ * Record received block within SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group_num		Group number
+ * @v index		Block index within group
+ * @v data		Block data
+ * @v len		Length of block data
+ * @ret group		FEC group, or NULL if reconstruction is not required
+ *
+ * Source blocks that have not yet been marked as received in the
+ * block bitmap are counted as missing by this function; the caller
+ * must ensure that the block is marked as received (or delivered via
+ * reconstruction) before the group is next examined.
+ */
+static struct slam_group * slam_fec_add ( struct slam_request *slam,
+					  unsigned long group_num,
+					  unsigned int index,
+					  const void *data, size_t len ) {
+	struct slam_group *group;
+	unsigned int count;
+	unsigned int missing;
+	unsigned int i;
+	size_t block_len;
+	void *block;
+
+	/* Calculate group parameters */
+	count = slam_fec_count ( slam, group_num );
+	block_len = slam->block_size;
+	assert ( len <= block_len );
+
+	/* Find existing group, if any */
+	list_for_each_entry ( group, &slam->groups, list ) {
+		if ( group->group == group_num )
+			goto found;
+	}
+	group = NULL;
+
+ found:
+	/* If all other source blocks have already been received,
+	 * then no reconstruction will be required.
+	 */
+	missing = slam_fec_missing ( slam, group_num );
+	if ( ( index < count ) ? ( missing <= 1 ) : ( missing == 0 ) ) {
+		if ( group )
+			slam_fec_free ( slam, group );
+		return NULL;
+	}
+
+	/* Create group, if necessary */
+	if ( ! group ) {
+
+		/* Evict least recently created group, if necessary */
+		if ( slam->groups_len >= SLAM_FEC_MAX_GROUPS ) {
+			group = list_last_entry ( &slam->groups,
+						  struct slam_group, list );
+			DBGC ( slam, "SLAM %p evicting FEC group %ld\n",
+			       slam, group->group );
+			slam_fec_free ( slam, group );
+		}
+
+		/* Allocate and populate group */
+		group = zalloc ( sizeof ( *group ) +
+				 ( count * sizeof ( group->index[0] ) ) +
+				 ( count * sizeof ( group->blocks[0] ) ) +
+				 ( count * block_len ) );
+		if ( ! group ) {
+			/* Not fatal; fall back to using NACKs */
+			DBGC ( slam, "SLAM %p could not allocate FEC group "
+			       "%ld\n", slam, group_num );
+			return NULL;
+		}
+		group->group = group_num;
+		group->count = count;
+		group->blocks = ( ( void * ) ( group + 1 ) );
+		group->index = ( ( void * ) ( group->blocks + count ) );
+		block = ( group->index + count );
+		for ( i = 0 ; i < count ; i++ ) {
+			group->blocks[i] = block;
+			block += block_len;
+		}
+		list_add ( &group->list, &slam->groups );
+		slam->groups_len++;
+	}
+
+	/* Ignore duplicate blocks */
+	for ( i = 0 ; i < group->received ; i++ ) {
+		if ( group->index[i] == index )
+			return NULL;
+	}
+
+	/* Record block.  The group buffer was zeroed on allocation,
+	 * so a short final block is implicitly zero-padded.
+	 */
+	assert ( group->received < group->count );
+	group->index[group->received] = index;
+	memcpy ( group->blocks[group->received], data, len );
+	group->received++;
+
+	/* Report whether or not the group is ready for reconstruction */
+	return ( ( group->received == group->count ) ? group : NULL );
+}
+
+/**
+ * Reconstruct SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		FEC group
+ * @ret rc		Return status code
+ */
+static int slam_fec_recover ( struct slam_request *slam,
+			      struct slam_group *group ) {
+	struct xfer_metadata meta;
+	unsigned long block;
+	unsigned int i;
+	size_t len;
+	int rc;
+
+	/* Reconstruct source blocks */
+	if ( ( rc = erasure_decode ( group->count, group->index, group->blocks,
+				     slam->block_size ) ) != 0 ) {
+		DBGC ( slam, "SLAM %p could not reconstruct FEC group %ld: "
+		       "%s\n", slam, group->group, strerror ( rc ) );
+		goto err_decode;
+	}
+
+	/* Deliver any missing blocks */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags = XFER_FL_ABS_OFFSET;
+	for ( i = 0 ; i < group->count ; i++ ) {
+		block = ( ( group->group * slam->group_size ) + i );
+		if ( bitmap_test ( &slam->bitmap, block ) )
+			continue;
+		DBGC2 ( slam, "SLAM %p reconstructed block %ld\n",
+			slam, block );
+		meta.offset = ( block * slam->block_size );
+		len = ( slam->total_bytes - meta.offset );
+		if ( len > slam->block_size )
+			len = slam->block_size;
+		if ( ( rc = xfer_deliver_raw_meta ( &slam->xfer,
+						    group->blocks[i], len,
+						    &meta ) ) != 0 )
+			goto err_deliver;
+		bitmap_set ( &slam->bitmap, block );
+	}
+
+ err_deliver:
+ err_decode:
+	slam_fec_free ( slam, group );
+	return rc;
+}
+
 /**
  * Free a SLAM request
  *
@@ -160,6 +446,7 @@ static void slam_free ( struct refcnt *refcnt ) {
 	struct slam_request *slam =
 		container_of ( refcnt, struct slam_request, refcnt );
 
+	slam_fec_flush ( slam );
 	bitmap_free ( &slam->bitmap );
 	free ( slam );
 }
@@ -427,6 +714,8 @@ static int slam_pull_header ( struct slam_request *slam,
 	void *header = iobuf->data;
 	unsigned long total_bytes;
 	unsigned long block_size;
+	unsigned long group_size = 0;
+	unsigned long group_repair = 0;
 	int rc;
 
 	/* If header matches cached header, just pull it and return */
@@ -448,11 +737,29 @@ static int slam_pull_header ( struct slam_request *slam,
 	if ( ( rc = slam_pull_value ( slam, iobuf, &block_size ) ) != 0 )
 		return rc;
 
+	/* Read and strip FEC group parameters, if applicable */
+	if ( slam->fec ) {
+		if ( ( rc = slam_pull_value ( slam, iobuf,
+					      &group_size ) ) != 0 )
+			return rc;
+		if ( ( rc = slam_pull_value ( slam, iobuf,
+					      &group_repair ) ) != 0 )
+			return rc;
+	}
+
 	/* Sanity check */
 	if ( block_size == 0 ) {
 		DBGC ( slam, "SLAM %p ignoring zero block size\n", slam );
 		return -EINVAL;
 	}
+	if ( slam->fec &&
+	     ( ( group_size == 0 ) ||
+	       ( group_size > ERASURE_MAX_BLOCKS ) ||
+	       ( group_repair > ( ERASURE_MAX_BLOCKS - group_size ) ) ) ) {
+		DBGC ( slam, "SLAM %p ignoring invalid FEC group size "
+		       "%ld+%ld\n", slam, group_size, group_repair );
+		return -EINVAL;
+	}
 
 	/* Update the cached header */
 	slam->header_len = ( iobuf->data - header );
@@ -467,6 +774,18 @@ static int slam_pull_header ( struct slam_request *slam,
 	       "blocks %ld\n", slam, slam->total_bytes, slam->block_size,
 	       slam->num_blocks );
 
+	/* Calculate number of FEC groups, if applicable */
+	slam_fec_flush ( slam );
+	if ( slam->fec ) {
+		slam->group_size = group_size;
+		slam->group_repair = group_repair;
+		slam->num_groups = ( ( slam->num_blocks + group_size - 1 ) /
+				     group_size );
+		DBGC ( slam, "SLAM %p has %ld FEC groups of %ld+%ld blocks\n",
+		       slam, slam->num_groups, slam->group_size,
+		       slam->group_repair );
+	}
+
 	/* Discard and reset the bitmap */
 	bitmap_free ( &slam->bitmap );
 	memset ( &slam->bitmap, 0, sizeof ( slam->bitmap ) );
@@ -488,6 +807,61 @@ static int slam_pull_header ( struct slam_request *slam,
 	return 0;
 }
 
+/**
+ * Receive SLAM FEC repair packet
+ *
+ * @v slam		SLAM request
+ * @v repair		Repair packet number
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int slam_fec_rx_repair ( struct slam_request *slam,
+				unsigned long repair,
+				struct io_buffer *iobuf ) {
+	struct slam_group *group;
+	unsigned long group_num;
+	unsigned int index;
+	int rc;
+
+	/* Sanity checks */
+	if ( ( slam->group_repair == 0 ) ||
+	     ( repair >= ( slam->num_groups * slam->group_repair ) ) ) {
+		DBGC ( slam, "SLAM %p received out-of-range repair packet "
+		       "%ld\n", slam, repair );
+		rc = -EINVAL;
+		goto err;
+	}
+	if ( iob_len ( iobuf ) != slam->block_size ) {
+		DBGC ( slam, "SLAM %p received repair packet of %zd bytes "
+		       "(block_size=%ld)\n", slam, iob_len ( iobuf ),
+		       slam->block_size );
+		rc = -EINVAL;
+		goto err;
+	}
+
+	/* Record repair block */
+	group_num = ( repair / slam->group_repair );
+	index = erasure_repair_index ( slam_fec_count ( slam, group_num ),
+				       ( repair % slam->group_repair ) );
+	group = slam_fec_add ( slam, group_num, index, iobuf->data,
+			       iob_len ( iobuf ) );
+	free_iob ( iobuf );
+
+	/* Reconstruct FEC group, if now possible */
+	if ( group && ( ( rc = slam_fec_recover ( slam, group ) ) != 0 ) )
+		return rc;
+
+	/* If we have received all blocks, terminate */
+	if ( bitmap_full ( &slam->bitmap ) )
+		slam_finished ( slam, 0 );
+
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
 /**
  * Receive SLAM data packet
  *
@@ -499,6 +873,7 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 				    struct io_buffer *iobuf,
 				    struct xfer_metadata *rx_meta __unused ) {
 	struct xfer_metadata meta;
+	struct slam_group *group = NULL;
 	unsigned long packet;
 	size_t len;
 	int rc;
@@ -516,6 +891,11 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 	if ( ( rc = slam_pull_value ( slam, iobuf, &packet ) ) != 0 )
 		goto err_discard;
 
+	/* Hand off repair packets, if applicable */
+	if ( slam->fec && ( packet >= slam->num_blocks ) )
+		return slam_fec_rx_repair ( slam, ( packet - slam->num_blocks ),
+					    iobuf );
+
 	/* Sanity check packet number */
 	if ( packet >= slam->num_blocks ) {
 		DBGC ( slam, "SLAM %p received out-of-range packet %ld "
@@ -545,16 +925,27 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 		goto discard;
 	}
 
+	/* Record block for reconstruction, if applicable */
+	if ( slam->fec ) {
+		group = slam_fec_add ( slam, ( packet / slam->group_size ),
+				       ( packet % slam->group_size ),
+				       iobuf->data, len );
+	}
+
 	/* Pass to recipient */
 	memset ( &meta, 0, sizeof ( meta ) );
 	meta.flags = XFER_FL_ABS_OFFSET;
 	meta.offset = ( packet * slam->block_size );
 	if ( ( rc = xfer_deliver ( &slam->xfer, iobuf, &meta ) ) != 0 )
-		goto err;
+		goto err_deliver;
 
 	/* Mark block as received */
 	bitmap_set ( &slam->bitmap, packet );
 
+	/* Reconstruct FEC group, if now possible */
+	if ( group && ( ( rc = slam_fec_recover ( slam, group ) ) != 0 ) )
+		goto err;
+
 	/* If we have received all blocks, terminate */
 	if ( bitmap_full ( &slam->bitmap ) )
 		slam_finished ( slam, 0 );
@@ -566,6 +957,11 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 	free_iob ( iobuf );
  err:
 	return rc;
+
+ err_deliver:
+	if ( group )
+		slam_fec_free ( slam, group );
+	return rc;
 }
 
 /**
@@ -705,9 +1101,11 @@ static int slam_parse_multicast_address ( struct slam_request *slam,
  *
  * @v xfer		Data transfer interface
  * @v uri		Uniform Resource Identifier
+ * @v fec		Use forward error correction
  * @ret rc		Return status code
  */
-static int slam_open ( struct interface *xfer, struct uri *uri ) {
+static int slam_open_uri ( struct interface *xfer, struct uri *uri,
+			   int fec ) {
 	static const struct sockaddr_in default_multicast = {
 		.sin_family = AF_INET,
 		.sin_port = htons ( SLAM_DEFAULT_MULTICAST_PORT ),
@@ -734,6 +1132,8 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 		     &slam->refcnt );
 	timer_init ( &slam->slave_timer, slam_slave_timer_expired,
 		     &slam->refcnt );
+	INIT_LIST_HEAD ( &slam->groups );
+	slam->fec = fec;
 	/* Fake an invalid cached header of { 0x00, ... } */
 	slam->header_len = 1;
 	/* Fake parameters for initial NACK */
@@ -784,8 +1184,38 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 	return rc;
 }
 
+/**
+ * Initiate a SLAM request
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int slam_open ( struct interface *xfer, struct uri *uri ) {
+
+	return slam_open_uri ( xfer, uri, 0 );
+}
+
+/**
+ * Initiate a SLAM request with forward error correction
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int slam_fec_open ( struct interface *xfer, struct uri *uri ) {
+
+	return slam_open_uri ( xfer, uri, 1 );
+}
+
 /** SLAM URI opener */
 struct uri_opener slam_uri_opener __uri_opener = {
 	.scheme	= "x-slam",
 	.open	= slam_open,
 };
+
+/** SLAM with forward error correction URI opener */
+struct uri_opener slam_fec_uri_opener __uri_opener = {
+	.scheme	= "x-slam-fec",
+	.open	= slam_fec_open,
+};
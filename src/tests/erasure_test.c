@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Reed-Solomon erasure coding tests
+ *
+ * Each test acts as a reference sender: it constructs a group of
+ * source blocks, generates the corresponding repair blocks, and then
+ * verifies that the source blocks can be reconstructed from the
+ * specified subset of received blocks.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ipxe/erasure.h>
+#include <ipxe/test.h>
+
+/** Define inline received block indices */
+#define RECEIVED(...) { __VA_ARGS__ }
+
+/** An erasure coding test */
+struct erasure_test {
+	/** Number of source blocks */
+	unsigned int count;
+	/** Number of repair blocks */
+	unsigned int repair;
+	/** Length of each block */
+	size_t len;
+	/** Indices of received blocks */
+	const unsigned int *received;
+};
+
+/**
+ * Define an erasure coding test
+ *
+ * @v name		Test name
+ * @v COUNT		Number of source blocks
+ * @v REPAIR		Number of repair blocks
+ * @v LEN		Length of each block
+ * @v RECEIVED		Indices of received blocks
+ * @ret test		Erasure coding test
+ */
+#define ERASURE_TEST( name, COUNT, REPAIR, LEN, RECEIVED )		\
+	static const unsigned int name ## _received[COUNT] = RECEIVED;	\
+	static struct erasure_test name = {				\
+		.count = COUNT,						\
+		.repair = REPAIR,					\
+		.len = LEN,						\
+		.received = name ## _received,				\
+	}
+
+/** All source blocks received */
+ERASURE_TEST ( all_source, 4, 2, 64, RECEIVED ( 0, 1, 2, 3 ) );
+
+/** Single source block lost */
+ERASURE_TEST ( single_loss, 4, 2, 64, RECEIVED ( 0, 1, 3, 4 ) );
+
+/** Maximum recoverable loss */
+ERASURE_TEST ( max_loss, 3, 3, 100, RECEIVED ( 3, 4, 5 ) );
+
+/** Out-of-order reception */
+ERASURE_TEST ( shuffled, 8, 4, 1024,
+	       RECEIVED ( 11, 0, 9, 2, 3, 10, 5, 7 ) );
+
+/** Repair blocks only */
+ERASURE_TEST ( repair_only, 16, 16, 1466,
+	       RECEIVED ( 31, 30, 29, 28, 27, 26, 25, 24,
+			  23, 22, 21, 20, 19, 18, 17, 16 ) );
+
+/** Short final group (e.g. 11 blocks in SLAM groups of 4) recovered
+ * using only repair blocks beyond the full group size
+ */
+ERASURE_TEST ( short_group, 3, 4, 512, RECEIVED ( 1, 5, 6 ) );
+
+/** Highest possible block index */
+ERASURE_TEST ( highest, 1, 255, 7, RECEIVED ( 255 ) );
+
+/**
+ * Report an erasure coding test result
+ *
+ * @v test		Erasure coding test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void erasure_okx ( struct erasure_test *test, const char *file,
+			  unsigned int line ) {
+	unsigned int total = ( test->count + test->repair );
+	const void *source[total];
+	unsigned int index[test->count];
+	void *blocks[test->count];
+	uint8_t *sent;
+	uint8_t *rcvd;
+	uint8_t *data;
+	unsigned int i;
+	size_t offset;
+
+	/* Allocate sent and received blocks */
+	sent = malloc ( total * test->len );
+	okx ( sent != NULL, file, line );
+	rcvd = malloc ( test->count * test->len );
+	okx ( rcvd != NULL, file, line );
+
+	/* Construct source blocks */
+	for ( i = 0 ; i < test->count ; i++ ) {
+		data = ( sent + ( i * test->len ) );
+		for ( offset = 0 ; offset < test->len ; offset++ )
+			data[offset] = ( ( i * 37 ) + ( offset * 11 ) + 1 );
+		source[i] = data;
+	}
+
+	/* Construct repair blocks */
+	for ( i = 0 ; i < test->repair ; i++ ) {
+		data = ( sent + ( erasure_repair_index ( test->count, i ) *
+				  test->len ) );
+		erasure_encode ( test->count, i, source, data, test->len );
+	}
+
+	/* Receive blocks */
+	for ( i = 0 ; i < test->count ; i++ ) {
+		okx ( test->received[i] < total, file, line );
+		index[i] = test->received[i];
+		blocks[i] = ( rcvd + ( i * test->len ) );
+		memcpy ( blocks[i], ( sent + ( index[i] * test->len ) ),
+			 test->len );
+	}
+
+	/* Reconstruct source blocks */
+	okx ( erasure_decode ( test->count, index, blocks,
+			       test->len ) == 0, file, line );
+	for ( i = 0 ; i < test->count ; i++ ) {
+		okx ( index[i] == i, file, line );
+		okx ( memcmp ( blocks[i], source[i], test->len ) == 0,
+		      file, line );
+	}
+
+	free ( rcvd );
+	free ( sent );
+}
+#define erasure_ok( test ) erasure_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform erasure coding self-tests
+ *
+ */
+static void erasure_test_exec ( void ) {
+	unsigned int index[2] = { 2, 2 };
+	uint8_t data[2][4];
+	void *blocks[2] = { data[0], data[1] };
+
+	/* Reconstruction tests */
+	erasure_ok ( &all_source );
+	erasure_ok ( &single_loss );
+	erasure_ok ( &max_loss );
+	erasure_ok ( &shuffled );
+	erasure_ok ( &repair_only );
+	erasure_ok ( &short_group );
+	erasure_ok ( &highest );
+
+	/* Duplicate blocks must be rejected */
+	memset ( data, 0, sizeof ( data ) );
+	ok ( erasure_decode ( 2, index, blocks, sizeof ( data[0] ) ) != 0 );
+	index[0] = index[1] = 0;
+	ok ( erasure_decode ( 2, index, blocks, sizeof ( data[0] ) ) != 0 );
+}
+
+/** Erasure coding self-test */
+struct self_test erasure_test __self_test = {
+	.name = "erasure",
+	.exec = erasure_test_exec,
+};
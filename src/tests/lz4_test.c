@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * LZ4 image tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <ipxe/image.h>
+#include <ipxe/lz4.h>
+#include <ipxe/test.h>
+
+/** An LZ4 test */
+struct lz4_test {
+	/** Compressed filename */
+	const char *compressed_name;
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed name */
+	const char *expected_name;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an LZ4 test */
+#define LZ4( name, COMPRESSED, EXPECTED )					\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct lz4_test name = {					\
+		.compressed_name = #name ".lz4",			\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected_name = #name,					\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** "Hello world" */
+LZ4 ( hello_world,
+      DATA ( 0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x0b, 0x00, 0x00,
+	     0x80, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72,
+	     0x6c, 0x64, 0x00, 0x00, 0x00, 0x00, 0x37, 0xd4, 0x05, 0x97 ),
+      DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	     0x64 ) );
+
+/** Content size and block checksums */
+LZ4 ( gpl_preamble,
+      DATA ( 0x04, 0x22, 0x4d, 0x18, 0x7c, 0x40, 0x9d, 0x01, 0x00, 0x00,
+	     0x00, 0x00, 0x00, 0x00, 0xf8, 0x3f, 0x01, 0x00, 0x00, 0xf3,
+	     0x25, 0x54, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47,
+	     0x65, 0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62,
+	     0x6c, 0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73,
+	     0x65, 0x20, 0x69, 0x73, 0x20, 0x61, 0x20, 0x66, 0x72, 0x65,
+	     0x65, 0x2c, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x6c, 0x65, 0x66,
+	     0x74, 0x20, 0x6c, 0x1c, 0x00, 0xf0, 0x19, 0x66, 0x6f, 0x72,
+	     0x0a, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x20,
+	     0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x20,
+	     0x6b, 0x69, 0x6e, 0x64, 0x73, 0x20, 0x6f, 0x66, 0x20, 0x77,
+	     0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x63, 0x00, 0x03,
+	     0x34, 0x00, 0xb4, 0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x6d,
+	     0x6f, 0x73, 0x74, 0x20, 0x3a, 0x00, 0x16, 0x0a, 0x3a, 0x00,
+	     0x92, 0x70, 0x72, 0x61, 0x63, 0x74, 0x69, 0x63, 0x61, 0x6c,
+	     0x3b, 0x00, 0x10, 0x20, 0x58, 0x00, 0xf1, 0x0b, 0x64, 0x65,
+	     0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x74, 0x6f, 0x20,
+	     0x74, 0x61, 0x6b, 0x65, 0x20, 0x61, 0x77, 0x61, 0x79, 0x20,
+	     0x79, 0x6f, 0x75, 0x72, 0x97, 0x00, 0x90, 0x64, 0x6f, 0x6d,
+	     0x20, 0x74, 0x6f, 0x0a, 0x73, 0x68, 0x2c, 0x00, 0x00, 0x4a,
+	     0x00, 0xa2, 0x63, 0x68, 0x61, 0x6e, 0x67, 0x65, 0x20, 0x74,
+	     0x68, 0x65, 0x45, 0x00, 0xf1, 0x00, 0x2e, 0x20, 0x20, 0x42,
+	     0x79, 0x20, 0x63, 0x6f, 0x6e, 0x74, 0x72, 0x61, 0x73, 0x74,
+	     0x2c, 0x19, 0x00, 0x0e, 0xf0, 0x00, 0x17, 0x0a, 0xf0, 0x00,
+	     0x62, 0x69, 0x6e, 0x74, 0x65, 0x6e, 0x64, 0x72, 0x00, 0x9c,
+	     0x67, 0x75, 0x61, 0x72, 0x61, 0x6e, 0x74, 0x65, 0x65, 0x72,
+	     0x00, 0x1d, 0x20, 0x72, 0x00, 0xb1, 0x61, 0x6c, 0x6c, 0x0a,
+	     0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0xfe, 0x00, 0xf0,
+	     0x00, 0x61, 0x20, 0x70, 0x72, 0x6f, 0x67, 0x72, 0x61, 0x6d,
+	     0x2d, 0x2d, 0x74, 0x6f, 0x20, 0x6d, 0xbb, 0x00, 0xf1, 0x00,
+	     0x73, 0x75, 0x72, 0x65, 0x20, 0x69, 0x74, 0x20, 0x72, 0x65,
+	     0x6d, 0x61, 0x69, 0x6e, 0x73, 0xc1, 0x00, 0x05, 0x08, 0x01,
+	     0x01, 0x1a, 0x01, 0x00, 0x45, 0x00, 0xb0, 0x69, 0x74, 0x73,
+	     0x20, 0x75, 0x73, 0x65, 0x72, 0x73, 0x2e, 0x0a, 0xba, 0x5e,
+	     0xbe, 0x98, 0x00, 0x00, 0x00, 0x00, 0xbb, 0x62, 0xf5, 0x2f ),
+      DATA ( 0x54, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	     0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	     0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x20, 0x69, 0x73, 0x20, 0x61, 0x20, 0x66, 0x72, 0x65, 0x65,
+	     0x2c, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x6c, 0x65, 0x66, 0x74,
+	     0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65, 0x20, 0x66,
+	     0x6f, 0x72, 0x0a, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72,
+	     0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65,
+	     0x72, 0x20, 0x6b, 0x69, 0x6e, 0x64, 0x73, 0x20, 0x6f, 0x66,
+	     0x20, 0x77, 0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x54,
+	     0x68, 0x65, 0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x6d, 0x6f, 0x73, 0x74,
+	     0x20, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x0a,
+	     0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x20,
+	     0x70, 0x72, 0x61, 0x63, 0x74, 0x69, 0x63, 0x61, 0x6c, 0x20,
+	     0x77, 0x6f, 0x72, 0x6b, 0x73, 0x20, 0x61, 0x72, 0x65, 0x20,
+	     0x64, 0x65, 0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x74,
+	     0x6f, 0x20, 0x74, 0x61, 0x6b, 0x65, 0x20, 0x61, 0x77, 0x61,
+	     0x79, 0x20, 0x79, 0x6f, 0x75, 0x72, 0x20, 0x66, 0x72, 0x65,
+	     0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74, 0x6f, 0x0a, 0x73, 0x68,
+	     0x61, 0x72, 0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x63, 0x68,
+	     0x61, 0x6e, 0x67, 0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x77,
+	     0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x42, 0x79, 0x20,
+	     0x63, 0x6f, 0x6e, 0x74, 0x72, 0x61, 0x73, 0x74, 0x2c, 0x20,
+	     0x74, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	     0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	     0x69, 0x63, 0x0a, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x20, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x74, 0x65, 0x6e, 0x64,
+	     0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x67, 0x75, 0x61, 0x72,
+	     0x61, 0x6e, 0x74, 0x65, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x72,
+	     0x20, 0x66, 0x72, 0x65, 0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74,
+	     0x6f, 0x20, 0x73, 0x68, 0x61, 0x72, 0x65, 0x20, 0x61, 0x6e,
+	     0x64, 0x20, 0x63, 0x68, 0x61, 0x6e, 0x67, 0x65, 0x20, 0x61,
+	     0x6c, 0x6c, 0x0a, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e,
+	     0x73, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x20, 0x70, 0x72, 0x6f,
+	     0x67, 0x72, 0x61, 0x6d, 0x2d, 0x2d, 0x74, 0x6f, 0x20, 0x6d,
+	     0x61, 0x6b, 0x65, 0x20, 0x73, 0x75, 0x72, 0x65, 0x20, 0x69,
+	     0x74, 0x20, 0x72, 0x65, 0x6d, 0x61, 0x69, 0x6e, 0x73, 0x20,
+	     0x66, 0x72, 0x65, 0x65, 0x20, 0x73, 0x6f, 0x66, 0x74, 0x77,
+	     0x61, 0x72, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x61, 0x6c,
+	     0x6c, 0x0a, 0x69, 0x74, 0x73, 0x20, 0x75, 0x73, 0x65, 0x72,
+	     0x73, 0x2e, 0x0a ) );
+
+/** Legacy frame format */
+LZ4 ( gpl_legacy,
+      DATA ( 0x02, 0x21, 0x4c, 0x18, 0x3f, 0x01, 0x00, 0x00, 0xf3, 0x25,
+	     0x54, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	     0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	     0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x20, 0x69, 0x73, 0x20, 0x61, 0x20, 0x66, 0x72, 0x65, 0x65,
+	     0x2c, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x6c, 0x65, 0x66, 0x74,
+	     0x20, 0x6c, 0x1c, 0x00, 0xf0, 0x19, 0x66, 0x6f, 0x72, 0x0a,
+	     0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x20, 0x61,
+	     0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x20, 0x6b,
+	     0x69, 0x6e, 0x64, 0x73, 0x20, 0x6f, 0x66, 0x20, 0x77, 0x6f,
+	     0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x63, 0x00, 0x03, 0x34,
+	     0x00, 0xb4, 0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x6d, 0x6f,
+	     0x73, 0x74, 0x20, 0x3a, 0x00, 0x16, 0x0a, 0x3a, 0x00, 0x92,
+	     0x70, 0x72, 0x61, 0x63, 0x74, 0x69, 0x63, 0x61, 0x6c, 0x3b,
+	     0x00, 0x10, 0x20, 0x58, 0x00, 0xf1, 0x0b, 0x64, 0x65, 0x73,
+	     0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x74,
+	     0x61, 0x6b, 0x65, 0x20, 0x61, 0x77, 0x61, 0x79, 0x20, 0x79,
+	     0x6f, 0x75, 0x72, 0x97, 0x00, 0x90, 0x64, 0x6f, 0x6d, 0x20,
+	     0x74, 0x6f, 0x0a, 0x73, 0x68, 0x2c, 0x00, 0x00, 0x4a, 0x00,
+	     0xa2, 0x63, 0x68, 0x61, 0x6e, 0x67, 0x65, 0x20, 0x74, 0x68,
+	     0x65, 0x45, 0x00, 0xf1, 0x00, 0x2e, 0x20, 0x20, 0x42, 0x79,
+	     0x20, 0x63, 0x6f, 0x6e, 0x74, 0x72, 0x61, 0x73, 0x74, 0x2c,
+	     0x19, 0x00, 0x0e, 0xf0, 0x00, 0x17, 0x0a, 0xf0, 0x00, 0x62,
+	     0x69, 0x6e, 0x74, 0x65, 0x6e, 0x64, 0x72, 0x00, 0x9c, 0x67,
+	     0x75, 0x61, 0x72, 0x61, 0x6e, 0x74, 0x65, 0x65, 0x72, 0x00,
+	     0x1d, 0x20, 0x72, 0x00, 0xb1, 0x61, 0x6c, 0x6c, 0x0a, 0x76,
+	     0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0xfe, 0x00, 0xf0, 0x00,
+	     0x61, 0x20, 0x70, 0x72, 0x6f, 0x67, 0x72, 0x61, 0x6d, 0x2d,
+	     0x2d, 0x74, 0x6f, 0x20, 0x6d, 0xbb, 0x00, 0xf1, 0x00, 0x73,
+	     0x75, 0x72, 0x65, 0x20, 0x69, 0x74, 0x20, 0x72, 0x65, 0x6d,
+	     0x61, 0x69, 0x6e, 0x73, 0xc1, 0x00, 0x05, 0x08, 0x01, 0x01,
+	     0x1a, 0x01, 0x00, 0x45, 0x00, 0xb0, 0x69, 0x74, 0x73, 0x20,
+	     0x75, 0x73, 0x65, 0x72, 0x73, 0x2e, 0x0a ),
+      DATA ( 0x54, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	     0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	     0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x20, 0x69, 0x73, 0x20, 0x61, 0x20, 0x66, 0x72, 0x65, 0x65,
+	     0x2c, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x6c, 0x65, 0x66, 0x74,
+	     0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65, 0x20, 0x66,
+	     0x6f, 0x72, 0x0a, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72,
+	     0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65,
+	     0x72, 0x20, 0x6b, 0x69, 0x6e, 0x64, 0x73, 0x20, 0x6f, 0x66,
+	     0x20, 0x77, 0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x54,
+	     0x68, 0x65, 0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x6d, 0x6f, 0x73, 0x74,
+	     0x20, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x0a,
+	     0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x20,
+	     0x70, 0x72, 0x61, 0x63, 0x74, 0x69, 0x63, 0x61, 0x6c, 0x20,
+	     0x77, 0x6f, 0x72, 0x6b, 0x73, 0x20, 0x61, 0x72, 0x65, 0x20,
+	     0x64, 0x65, 0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x74,
+	     0x6f, 0x20, 0x74, 0x61, 0x6b, 0x65, 0x20, 0x61, 0x77, 0x61,
+	     0x79, 0x20, 0x79, 0x6f, 0x75, 0x72, 0x20, 0x66, 0x72, 0x65,
+	     0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74, 0x6f, 0x0a, 0x73, 0x68,
+	     0x61, 0x72, 0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x63, 0x68,
+	     0x61, 0x6e, 0x67, 0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x77,
+	     0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x42, 0x79, 0x20,
+	     0x63, 0x6f, 0x6e, 0x74, 0x72, 0x61, 0x73, 0x74, 0x2c, 0x20,
+	     0x74, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	     0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	     0x69, 0x63, 0x0a, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	     0x20, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x74, 0x65, 0x6e, 0x64,
+	     0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x67, 0x75, 0x61, 0x72,
+	     0x61, 0x6e, 0x74, 0x65, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x72,
+	     0x20, 0x66, 0x72, 0x65, 0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74,
+	     0x6f, 0x20, 0x73, 0x68, 0x61, 0x72, 0x65, 0x20, 0x61, 0x6e,
+	     0x64, 0x20, 0x63, 0x68, 0x61, 0x6e, 0x67, 0x65, 0x20, 0x61,
+	     0x6c, 0x6c, 0x0a, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e,
+	     0x73, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x20, 0x70, 0x72, 0x6f,
+	     0x67, 0x72, 0x61, 0x6d, 0x2d, 0x2d, 0x74, 0x6f, 0x20, 0x6d,
+	     0x61, 0x6b, 0x65, 0x20, 0x73, 0x75, 0x72, 0x65, 0x20, 0x69,
+	     0x74, 0x20, 0x72, 0x65, 0x6d, 0x61, 0x69, 0x6e, 0x73, 0x20,
+	     0x66, 0x72, 0x65, 0x65, 0x20, 0x73, 0x6f, 0x66, 0x74, 0x77,
+	     0x61, 0x72, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x61, 0x6c,
+	     0x6c, 0x0a, 0x69, 0x74, 0x73, 0x20, 0x75, 0x73, 0x65, 0x72,
+	     0x73, 0x2e, 0x0a ) );
+
+/**
+ * Report LZ4 test result
+ *
+ * @v test		LZ4 test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void lz4_okx ( struct lz4_test *test, const char *file,
+		       unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name,
+			       virt_to_user ( test->compressed ),
+			       test->compressed_len );
+	okx ( image != NULL, file, line );
+	okx ( image->len == test->compressed_len, file, line );
+
+	/* Check type detection */
+	okx ( image->type == &lz4_image_type, file, line );
+
+	/* Extract archive image */
+	okx ( image_extract ( image, NULL, &extracted ) == 0, file, line );
+
+	/* Verify extracted image content */
+	okx ( extracted->len == test->expected_len, file, line );
+	okx ( memcmp_user ( extracted->data, 0,
+			    virt_to_user ( test->expected ), 0,
+			    test->expected_len ) == 0, file, line );
+
+	/* Verify extracted image name */
+	okx ( strcmp ( extracted->name, test->expected_name ) == 0,
+	      file, line );
+
+	/* Unregister images */
+	unregister_image ( extracted );
+	unregister_image ( image );
+}
+#define lz4_ok( test ) lz4_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform LZ4 self-test
+ *
+ */
+static void lz4_test_exec ( void ) {
+
+	lz4_ok ( &hello_world );
+	lz4_ok ( &gpl_preamble );
+	lz4_ok ( &gpl_legacy );
+}
+
+/** LZ4 self-test */
+struct self_test lz4_test __self_test = {
+	.name = "lz4",
+	.exec = lz4_test_exec,
+};
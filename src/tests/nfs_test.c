@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * NFS and ONC RPC reply parsing tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/oncrpc.h>
+#include <ipxe/nfs.h>
+#include <ipxe/test.h>
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an XDR unsigned integer */
+#define XDR_INT( value )						\
+	( ( (value) >> 24 ) & 0xff ), ( ( (value) >> 16 ) & 0xff ),	\
+	( ( (value) >> 8 ) & 0xff ), ( ( (value) >> 0 ) & 0xff )
+
+/** Define an XDR unsigned hyper integer */
+#define XDR_HYPER( value )						\
+	XDR_INT ( ( ( ( uint64_t ) (value) ) >> 32 ) ),		\
+	XDR_INT ( ( ( uint64_t ) (value) ) )
+
+/** Define NFS file attributes (fattr3) */
+#define FATTR( type, size )						\
+	XDR_INT ( type ), XDR_INT ( 0644 ), XDR_INT ( 1 ),		\
+	XDR_INT ( 0 ), XDR_INT ( 0 ), XDR_HYPER ( size ),		\
+	XDR_HYPER ( 0x2000ULL ), XDR_INT ( 0 ), XDR_INT ( 0 ),		\
+	XDR_HYPER ( 0x1234ULL ), XDR_HYPER ( 0x5678ULL ),		\
+	XDR_INT ( 1 ), XDR_INT ( 2 ), XDR_INT ( 3 ), XDR_INT ( 4 ),	\
+	XDR_INT ( 5 ), XDR_INT ( 6 )
+
+/** Regular file type */
+#define NF3REG 1
+
+/** Directory type */
+#define NF3DIR 2
+
+/** An ONC RPC record identification test */
+struct oncrpc_record_test {
+	/** Start of record */
+	const void *data;
+	/** Record is expected to be accepted */
+	int accepted;
+	/** Expected length of record (including record mark) */
+	size_t len;
+	/** Expected transaction ID */
+	uint32_t xid;
+};
+
+/**
+ * Define an ONC RPC record identification test
+ *
+ * @v name		Test name
+ * @v DATA		Start of record
+ * @v ACCEPTED		Record is expected to be accepted
+ * @v LEN		Expected length of record
+ * @v XID		Expected transaction ID
+ * @ret test		ONC RPC record identification test
+ */
+#define ONCRPC_RECORD( name, DATA, ACCEPTED, LEN, XID )			\
+	static const uint8_t name ## _data[ONCRPC_RECORD_ID_LEN] = DATA; \
+	static struct oncrpc_record_test name = {			\
+		.data = name ## _data,					\
+		.accepted = ACCEPTED,					\
+		.len = LEN,						\
+		.xid = XID,						\
+	}
+
+/** An NFS LOOKUP reply test */
+struct nfs_lookup_test {
+	/** Reply data */
+	const void *data;
+	/** Length of reply data */
+	size_t len;
+	/** Reply is expected to be accepted */
+	int accepted;
+	/** Expected file handle */
+	const void *fh;
+	/** Length of expected file handle */
+	size_t fh_len;
+	/** Attributes are expected to be present */
+	int attributes;
+	/** Expected entity type */
+	unsigned int ent_type;
+	/** Expected file size */
+	uint64_t filesize;
+};
+
+/**
+ * Define an NFS LOOKUP reply test
+ *
+ * @v name		Test name
+ * @v DATA		Reply data
+ * @v ACCEPTED		Reply is expected to be accepted
+ * @v FH		Expected file handle
+ * @v ATTRIBUTES	Attributes are expected to be present
+ * @v ENT_TYPE		Expected entity type
+ * @v FILESIZE		Expected file size
+ * @ret test		NFS LOOKUP reply test
+ */
+#define NFS_LOOKUP( name, DATA, ACCEPTED, FH, ATTRIBUTES, ENT_TYPE,	\
+		    FILESIZE )						\
+	static const uint8_t name ## _data[] = DATA;			\
+	static const uint8_t name ## _fh[] = FH;			\
+	static struct nfs_lookup_test name = {				\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.accepted = ACCEPTED,					\
+		.fh = name ## _fh,					\
+		.fh_len = sizeof ( name ## _fh ),			\
+		.attributes = ATTRIBUTES,				\
+		.ent_type = ENT_TYPE,					\
+		.filesize = FILESIZE,					\
+	}
+
+/** An NFS FSINFO reply test */
+struct nfs_fsinfo_test {
+	/** Reply data */
+	const void *data;
+	/** Length of reply data */
+	size_t len;
+	/** Reply is expected to be accepted */
+	int accepted;
+	/** Expected maximum READ request size */
+	uint32_t rtmax;
+	/** Expected preferred READ request size */
+	uint32_t rtpref;
+};
+
+/**
+ * Define an NFS FSINFO reply test
+ *
+ * @v name		Test name
+ * @v DATA		Reply data
+ * @v ACCEPTED		Reply is expected to be accepted
+ * @v RTMAX		Expected maximum READ request size
+ * @v RTPREF		Expected preferred READ request size
+ * @ret test		NFS FSINFO reply test
+ */
+#define NFS_FSINFO( name, DATA, ACCEPTED, RTMAX, RTPREF )		\
+	static const uint8_t name ## _data[] = DATA;			\
+	static struct nfs_fsinfo_test name = {				\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.accepted = ACCEPTED,					\
+		.rtmax = RTMAX,						\
+		.rtpref = RTPREF,					\
+	}
+
+/** Final fragment */
+ONCRPC_RECORD ( record_last,
+	DATA ( 0x80, 0x00, 0x00, 0x7c, 0xde, 0xad, 0xbe, 0xef ),
+	1, ( 4 + 0x7c ), 0xdeadbeef );
+
+/** Smallest record that contains a transaction ID */
+ONCRPC_RECORD ( record_minimal,
+	DATA ( 0x80, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01 ),
+	1, 8, 0x00000001 );
+
+/** Largest possible fragment */
+ONCRPC_RECORD ( record_largest,
+	DATA ( 0xff, 0xff, 0xff, 0xff, 0x12, 0x34, 0x56, 0x78 ),
+	1, ( 4 + 0x7fffffffUL ), 0x12345678 );
+
+/** Non-final fragment */
+ONCRPC_RECORD ( record_not_last,
+	DATA ( 0x00, 0x00, 0x00, 0x7c, 0xde, 0xad, 0xbe, 0xef ),
+	0, 0, 0 );
+
+/** Record too short to contain a transaction ID */
+ONCRPC_RECORD ( record_undersized,
+	DATA ( 0x80, 0x00, 0x00, 0x03, 0xde, 0xad, 0xbe, 0xef ),
+	0, 0, 0 );
+
+/** Empty record */
+ONCRPC_RECORD ( record_empty,
+	DATA ( 0x80, 0x00, 0x00, 0x00, 0xde, 0xad, 0xbe, 0xef ),
+	0, 0, 0 );
+
+/** LOOKUP of a regular file larger than 4GB, with attributes */
+NFS_LOOKUP ( lookup_attributes,
+	DATA ( XDR_INT ( 0 ),
+	       XDR_INT ( 8 ), 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	       XDR_INT ( 1 ), FATTR ( NF3REG, 0x123456789ULL ),
+	       XDR_INT ( 0 ) ),
+	1, DATA ( 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 ),
+	1, NF3REG, 0x123456789ULL );
+
+/** LOOKUP of a symbolic link, with object and directory attributes */
+NFS_LOOKUP ( lookup_symlink,
+	DATA ( XDR_INT ( 0 ),
+	       XDR_INT ( 4 ), 0xaa, 0xbb, 0xcc, 0xdd,
+	       XDR_INT ( 1 ), FATTR ( NFS_ATTR_SYMLINK, 12 ),
+	       XDR_INT ( 1 ), FATTR ( NF3DIR, 4096 ) ),
+	1, DATA ( 0xaa, 0xbb, 0xcc, 0xdd ),
+	1, NFS_ATTR_SYMLINK, 12 );
+
+/** LOOKUP without attributes */
+NFS_LOOKUP ( lookup_no_attributes,
+	DATA ( XDR_INT ( 0 ),
+	       XDR_INT ( 8 ), 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+	       XDR_INT ( 0 ),
+	       XDR_INT ( 0 ) ),
+	1, DATA ( 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 ),
+	0, 0, 0 );
+
+/** LOOKUP of a nonexistent file */
+NFS_LOOKUP ( lookup_noent,
+	DATA ( XDR_INT ( NFS3ERR_NOENT ),
+	       XDR_INT ( 0 ) ),
+	0, DATA(), 0, 0, 0 );
+
+/** FSINFO with attributes */
+NFS_FSINFO ( fsinfo_attributes,
+	DATA ( XDR_INT ( 0 ),
+	       XDR_INT ( 1 ), FATTR ( NF3DIR, 4096 ),
+	       XDR_INT ( 0x100000 ), XDR_INT ( 0x10000 ), XDR_INT ( 4096 ),
+	       XDR_INT ( 0x100000 ), XDR_INT ( 0x10000 ), XDR_INT ( 4096 ),
+	       XDR_INT ( 4096 ), XDR_HYPER ( 0x7fffffffffffffffULL ),
+	       XDR_INT ( 0 ), XDR_INT ( 1 ), XDR_INT ( 0x1b ) ),
+	1, 0x100000, 0x10000 );
+
+/** FSINFO without attributes */
+NFS_FSINFO ( fsinfo_no_attributes,
+	DATA ( XDR_INT ( 0 ),
+	       XDR_INT ( 0 ),
+	       XDR_INT ( 8192 ), XDR_INT ( 4096 ), XDR_INT ( 512 ),
+	       XDR_INT ( 8192 ), XDR_INT ( 4096 ), XDR_INT ( 512 ),
+	       XDR_INT ( 4096 ), XDR_HYPER ( 0xffffffffULL ),
+	       XDR_INT ( 1 ), XDR_INT ( 0 ), XDR_INT ( 0x1b ) ),
+	1, 8192, 4096 );
+
+/** FSINFO with a stale file handle */
+NFS_FSINFO ( fsinfo_stale,
+	DATA ( XDR_INT ( NFS3ERR_STALE ),
+	       XDR_INT ( 0 ) ),
+	0, 0, 0 );
+
+/**
+ * Report an ONC RPC record identification test result
+ *
+ * @v test		ONC RPC record identification test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void oncrpc_record_okx ( struct oncrpc_record_test *test,
+				const char *file, unsigned int line ) {
+	size_t len = 0;
+	uint32_t xid = 0;
+	int rc;
+
+	rc = oncrpc_record_id ( test->data, &len, &xid );
+	if ( test->accepted ) {
+		okx ( rc == 0, file, line );
+		okx ( len == test->len, file, line );
+		okx ( xid == test->xid, file, line );
+	} else {
+		okx ( rc != 0, file, line );
+	}
+}
+#define oncrpc_record_ok( test ) oncrpc_record_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Report an NFS LOOKUP reply test result
+ *
+ * @v test		NFS LOOKUP reply test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void nfs_lookup_okx ( struct nfs_lookup_test *test, const char *file,
+			     unsigned int line ) {
+	struct nfs_lookup_reply lookup_reply;
+	struct oncrpc_reply reply;
+	struct io_buffer iobuf;
+	uint8_t data[test->len];
+	int rc;
+
+	/* Parse reply */
+	memcpy ( data, test->data, sizeof ( data ) );
+	iob_populate ( &iobuf, data, sizeof ( data ), sizeof ( data ) );
+	memset ( &reply, 0, sizeof ( reply ) );
+	reply.data = &iobuf;
+	memset ( &lookup_reply, 0xff, sizeof ( lookup_reply ) );
+	rc = nfs_get_lookup_reply ( &lookup_reply, &reply );
+
+	/* Check result */
+	if ( ! test->accepted ) {
+		okx ( rc != 0, file, line );
+		return;
+	}
+	okx ( rc == 0, file, line );
+	okx ( lookup_reply.status == NFS3_OK, file, line );
+	okx ( lookup_reply.fh.size == test->fh_len, file, line );
+	okx ( memcmp ( lookup_reply.fh.fh, test->fh, test->fh_len ) == 0,
+	      file, line );
+	okx ( lookup_reply.attributes == test->attributes, file, line );
+	okx ( lookup_reply.ent_type == test->ent_type, file, line );
+	okx ( lookup_reply.filesize == test->filesize, file, line );
+
+	/* Check that the directory attributes have not been consumed */
+	okx ( iob_len ( &iobuf ) >= sizeof ( uint32_t ), file, line );
+}
+#define nfs_lookup_ok( test ) nfs_lookup_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Report an NFS FSINFO reply test result
+ *
+ * @v test		NFS FSINFO reply test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void nfs_fsinfo_okx ( struct nfs_fsinfo_test *test, const char *file,
+			     unsigned int line ) {
+	struct nfs_fsinfo_reply fsinfo_reply;
+	struct oncrpc_reply reply;
+	struct io_buffer iobuf;
+	uint8_t data[test->len];
+	int rc;
+
+	/* Parse reply */
+	memcpy ( data, test->data, sizeof ( data ) );
+	iob_populate ( &iobuf, data, sizeof ( data ), sizeof ( data ) );
+	memset ( &reply, 0, sizeof ( reply ) );
+	reply.data = &iobuf;
+	memset ( &fsinfo_reply, 0xff, sizeof ( fsinfo_reply ) );
+	rc = nfs_get_fsinfo_reply ( &fsinfo_reply, &reply );
+
+	/* Check result */
+	if ( ! test->accepted ) {
+		okx ( rc != 0, file, line );
+		return;
+	}
+	okx ( rc == 0, file, line );
+	okx ( fsinfo_reply.status == NFS3_OK, file, line );
+	okx ( fsinfo_reply.rtmax == test->rtmax, file, line );
+	okx ( fsinfo_reply.rtpref == test->rtpref, file, line );
+}
+#define nfs_fsinfo_ok( test ) nfs_fsinfo_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform NFS and ONC RPC reply parsing self-tests
+ *
+ */
+static void nfs_test_exec ( void ) {
+
+	/* ONC RPC record identification */
+	oncrpc_record_ok ( &record_last );
+	oncrpc_record_ok ( &record_minimal );
+	oncrpc_record_ok ( &record_largest );
+	oncrpc_record_ok ( &record_not_last );
+	oncrpc_record_ok ( &record_undersized );
+	oncrpc_record_ok ( &record_empty );
+
+	/* LOOKUP replies */
+	nfs_lookup_ok ( &lookup_attributes );
+	nfs_lookup_ok ( &lookup_symlink );
+	nfs_lookup_ok ( &lookup_no_attributes );
+	nfs_lookup_ok ( &lookup_noent );
+
+	/* FSINFO replies */
+	nfs_fsinfo_ok ( &fsinfo_attributes );
+	nfs_fsinfo_ok ( &fsinfo_no_attributes );
+	nfs_fsinfo_ok ( &fsinfo_stale );
+}
+
+/** NFS and ONC RPC reply parsing self-test */
+struct self_test nfs_test __self_test = {
+	.name = "nfs",
+	.exec = nfs_test_exec,
+};
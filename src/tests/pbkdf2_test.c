@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * PBKDF2-HMAC-SHA1 self-tests
+ *
+ * Test vectors are taken from RFC 6070 and from IEEE 802.11i Annex
+ * H.4.
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <string.h>
+#include <ipxe/sha1.h>
+#include <ipxe/test.h>
+
+/** Define inline expected key */
+#define EXPECTED(...) { __VA_ARGS__ }
+
+/** A PBKDF2 test */
+struct pbkdf2_test {
+	/** Passphrase */
+	const char *passphrase;
+	/** Salt */
+	const char *salt;
+	/** Number of iterations */
+	int iterations;
+	/** Expected key */
+	const void *expected;
+	/** Length of expected key */
+	size_t expected_len;
+};
+
+/**
+ * Define a PBKDF2 test
+ *
+ * @v name		Test name
+ * @v PASSPHRASE	Passphrase
+ * @v SALT		Salt
+ * @v ITERATIONS	Number of iterations
+ * @v EXPECTED		Expected key
+ * @ret test		PBKDF2 test
+ */
+#define PBKDF2_TEST( name, PASSPHRASE, SALT, ITERATIONS, EXPECTED )	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct pbkdf2_test name = {				\
+		.passphrase = PASSPHRASE,				\
+		.salt = SALT,						\
+		.iterations = ITERATIONS,				\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	}
+
+/**
+ * Report a PBKDF2 test result
+ *
+ * @v test		PBKDF2 test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void pbkdf2_okx ( struct pbkdf2_test *test, const char *file,
+			 unsigned int line ) {
+	uint8_t key[test->expected_len];
+
+	/* Derive key */
+	pbkdf2_sha1 ( test->passphrase, strlen ( test->passphrase ),
+		      test->salt, strlen ( test->salt ), test->iterations,
+		      key, sizeof ( key ) );
+	DBGC ( test, "PBKDF2 \"%s\" \"%s\" x%d:\n",
+	       test->passphrase, test->salt, test->iterations );
+	DBGC_HDA ( test, 0, key, sizeof ( key ) );
+
+	/* Compare against expected result */
+	okx ( memcmp ( key, test->expected, sizeof ( key ) ) == 0,
+	      file, line );
+}
+#define pbkdf2_ok( test ) pbkdf2_okx ( test, __FILE__, __LINE__ )
+
+/* RFC 6070 test case 1 */
+PBKDF2_TEST ( pbkdf2_rfc6070_1, "password", "salt", 1,
+	      EXPECTED ( 0x0c, 0x60, 0xc8, 0x0f, 0x96, 0x1f, 0x0e, 0x71, 0xf3,
+			 0xa9, 0xb5, 0x24, 0xaf, 0x60, 0x12, 0x06, 0x2f, 0xe0,
+			 0x37, 0xa6 ) );
+
+/* RFC 6070 test case 2 */
+PBKDF2_TEST ( pbkdf2_rfc6070_2, "password", "salt", 2,
+	      EXPECTED ( 0xea, 0x6c, 0x01, 0x4d, 0xc7, 0x2d, 0x6f, 0x8c, 0xcd,
+			 0x1e, 0xd9, 0x2a, 0xce, 0x1d, 0x41, 0xf0, 0xd8, 0xde,
+			 0x89, 0x57 ) );
+
+/* RFC 6070 test case 3 */
+PBKDF2_TEST ( pbkdf2_rfc6070_3, "password", "salt", 4096,
+	      EXPECTED ( 0x4b, 0x00, 0x79, 0x01, 0xb7, 0x65, 0x48, 0x9a, 0xbe,
+			 0xad, 0x49, 0xd9, 0x26, 0xf7, 0x21, 0xd0, 0x65, 0xa4,
+			 0x29, 0xc1 ) );
+
+/* RFC 6070 test case 5 (multiple output blocks) */
+PBKDF2_TEST ( pbkdf2_rfc6070_5, "passwordPASSWORDpassword",
+	      "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096,
+	      EXPECTED ( 0x3d, 0x2e, 0xec, 0x4f, 0xe4, 0x1c, 0x84, 0x9b, 0x80,
+			 0xc8, 0xd8, 0x36, 0x62, 0xc0, 0xe4, 0x4a, 0x8b, 0x29,
+			 0x1a, 0x96, 0x4c, 0xf2, 0xf0, 0x70, 0x38 ) );
+
+/* IEEE 802.11i passphrase-to-PSK mapping */
+PBKDF2_TEST ( pbkdf2_wpa, "password", "IEEE", 4096,
+	      EXPECTED ( 0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef, 0x9e,
+			 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90, 0x2e, 0x83,
+			 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2, 0x3a, 0xed, 0x76,
+			 0x2e, 0x97, 0x10, 0xa1, 0x2e ) );
+
+/* Passphrase longer than the SHA-1 block size */
+PBKDF2_TEST ( pbkdf2_overlen,
+	      "ThisIsAVeryLongPassphraseThatIsLongerThanTheSHA1BlockSize"
+	      "OfSixtyFourBytes", "ThisIsASSID", 4096,
+	      EXPECTED ( 0xf4, 0xb1, 0xcf, 0xb3, 0x79, 0xed, 0x97, 0x3e, 0x0f,
+			 0x0b, 0xbf, 0x52, 0x68, 0x85, 0x2e, 0x60, 0x4a, 0x21,
+			 0x03, 0xe2, 0x33, 0x58, 0x61, 0x0d, 0xe7, 0x6f, 0x6a,
+			 0xc1, 0xbe, 0xf5, 0xb2, 0x1b ) );
+
+/**
+ * Perform PBKDF2 self-tests
+ *
+ */
+static void pbkdf2_test_exec ( void ) {
+
+	pbkdf2_ok ( &pbkdf2_rfc6070_1 );
+	pbkdf2_ok ( &pbkdf2_rfc6070_2 );
+	pbkdf2_ok ( &pbkdf2_rfc6070_3 );
+	pbkdf2_ok ( &pbkdf2_rfc6070_5 );
+	pbkdf2_ok ( &pbkdf2_wpa );
+	pbkdf2_ok ( &pbkdf2_overlen );
+}
+
+/** PBKDF2 self-tests */
+struct self_test pbkdf2_test __self_test = {
+	.name = "pbkdf2",
+	.exec = pbkdf2_test_exec,
+};
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval: Discovery Protocol [MS-PCCRD] tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/test.h>
+
+/** Message UUID */
+#define MESSAGE_UUID "8c5b6cf9-2e3d-4a1f-9b7e-3c4d5e6f7a8b"
+
+/** Endpoint UUID */
+#define ENDPOINT_UUID "1a2b3c4d-5e6f-4071-8293-a4b5c6d7e8f9"
+
+/** Segment ID */
+#define SEGMENT_ID							\
+	"3A3B95E7D6C4C4BE0A2A2B0E7B34E3A8"				\
+	"70EF1E7F07A8C4E2F5A8C7C1CF8D0F4B"
+
+/** Peer location */
+#define LOCATION "192.168.0.2:80"
+
+/**
+ * Perform discovery protocol self-tests
+ *
+ */
+static void peerdist_discovery_test_exec ( void ) {
+	struct peerdist_discovery_probe probe;
+	struct peerdist_discovery_reply reply;
+	char *request;
+	char *match;
+
+	/* Parse our own discovery request as a probe */
+	request = peerdist_discovery_request ( MESSAGE_UUID, SEGMENT_ID );
+	ok ( request != NULL );
+	ok ( peerdist_discovery_probe ( request, strlen ( request ),
+					&probe ) == 0 );
+	ok ( strcmp ( probe.message, "urn:uuid:" MESSAGE_UUID ) == 0 );
+	ok ( strcmp ( probe.ids, SEGMENT_ID ) == 0 );
+	ok ( probe.ids[ strlen ( probe.ids ) + 1 ] == '\0' );
+
+	/* Construct a probe match and parse it as a reply */
+	match = peerdist_discovery_match ( ENDPOINT_UUID, probe.message,
+					   ENDPOINT_UUID, SEGMENT_ID,
+					   "00000002", LOCATION );
+	ok ( match != NULL );
+	ok ( peerdist_discovery_reply ( match, strlen ( match ),
+					&reply ) == 0 );
+	ok ( strcmp ( reply.ids, SEGMENT_ID ) == 0 );
+	ok ( reply.ids[ strlen ( reply.ids ) + 1 ] == '\0' );
+	ok ( strcmp ( reply.locations, LOCATION ) == 0 );
+	ok ( reply.locations[ strlen ( reply.locations ) + 1 ] == '\0' );
+
+	free ( match );
+	free ( request );
+}
+
+/** Discovery protocol self-test */
+struct self_test peerdist_discovery_test __self_test = {
+	.name = "pccrd",
+	.exec = peerdist_discovery_test_exec,
+};
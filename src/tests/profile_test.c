@@ -121,6 +121,55 @@ static void profile_okx ( struct profile_test *test, const char *file,
 }
 #define profile_ok( test ) profile_okx ( test, __FILE__, __LINE__ )
 
+/**
+ * Report a profiling percentile test result
+ *
+ * @v test		Profiling test
+ * @v p50		Expected median
+ * @v p90		Expected 90th percentile
+ * @v p99		Expected 99th percentile
+ * @v max		Expected maximum
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void profile_percentile_okx ( struct profile_test *test,
+				     unsigned long p50, unsigned long p90,
+				     unsigned long p99, unsigned long max,
+				     const char *file, unsigned int line ) {
+	struct profiler profiler;
+	unsigned int i;
+
+	/* Initialise profiler */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+
+	/* Record sample values */
+	for ( i = 0 ; i < test->count ; i++ )
+		profile_update ( &profiler, test->samples[i] );
+
+	/* Check resulting percentiles */
+	okx ( profile_percentile ( &profiler, 50 ) == p50, file, line );
+	okx ( profile_percentile ( &profiler, 90 ) == p90, file, line );
+	okx ( profile_percentile ( &profiler, 99 ) == p99, file, line );
+	okx ( profile_percentile ( &profiler, 100 ) == max, file, line );
+	okx ( profiler.max == max, file, line );
+
+	/* Check that reset discards all samples */
+	profile_reset ( &profiler );
+	okx ( profile_mean ( &profiler ) == 0, file, line );
+	okx ( profile_percentile ( &profiler, 100 ) == 0, file, line );
+	okx ( profiler.max == 0, file, line );
+
+	/* Check that a disabled profiler ignores samples */
+	profiler.disabled = 1;
+	for ( i = 0 ; i < test->count ; i++ )
+		profile_update ( &profiler, test->samples[i] );
+	okx ( profile_mean ( &profiler ) == 0, file, line );
+	okx ( profile_percentile ( &profiler, 100 ) == 0, file, line );
+}
+#define profile_percentile_ok( test, p50, p90, p99, max )		\
+	profile_percentile_okx ( test, p50, p90, p99, max,		\
+				 __FILE__, __LINE__ )
+
 /**
  * Perform profiling self-tests
  *
@@ -135,6 +184,12 @@ static void profile_test_exec ( void ) {
 	profile_ok ( &small );
 	profile_ok ( &random );
 	profile_ok ( &large );
+
+	/* Perform percentile tests */
+	profile_percentile_ok ( &empty, 0, 0, 0, 0 );
+	profile_percentile_ok ( &single, 42, 42, 42, 42 );
+	profile_percentile_ok ( &small, 4, 9, 9, 9 );
+	profile_percentile_ok ( &random, 71078, 71078, 71078, 71078 );
 }
 
 /** Profiling self-test */
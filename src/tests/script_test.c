@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * iPXE script self-tests
+ *
+ * Each test script records its progress by appending characters to
+ * the "script_trace" setting.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdlib.h>
+#include <string.h>
+#include <ipxe/image.h>
+#include <ipxe/settings.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/test.h>
+
+/** A script test */
+struct script_test {
+	/** Script */
+	const char *script;
+	/** Expected trace */
+	const char *trace;
+	/** Script is expected to succeed */
+	int success;
+};
+
+/**
+ * Define a script test
+ *
+ * @v name		Test name
+ * @v SCRIPT		Script
+ * @v TRACE		Expected trace
+ * @v SUCCESS		Script is expected to succeed
+ * @ret test		Script test
+ */
+#define SCRIPT_TEST( name, SCRIPT, TRACE, SUCCESS )			\
+	static struct script_test name = {				\
+		.script = SCRIPT,					\
+		.trace = TRACE,						\
+		.success = SUCCESS,					\
+	}
+
+/** Script trace setting */
+static struct setting script_trace_setting = {
+	.name = "script_trace",
+	.type = &setting_type_string,
+};
+
+/** Script loop counter setting */
+static struct setting script_count_setting = {
+	.name = "script_count",
+	.type = &setting_type_string,
+};
+
+/** Forward jump */
+SCRIPT_TEST ( forward, "#!ipxe\n"
+	      "set script_trace ${script_trace}a\n"
+	      "goto skip\n"
+	      "set script_trace ${script_trace}X\n"
+	      ":skip\n"
+	      "set script_trace ${script_trace}b\n", "ab", 1 );
+
+/** Backward jump */
+SCRIPT_TEST ( backward, "#!ipxe\n"
+	      ":loop\n"
+	      "set script_trace ${script_trace}a\n"
+	      "inc script_count\n"
+	      "iseq ${script_count} 3 || goto loop\n"
+	      "set script_trace ${script_trace}b\n", "aaab", 1 );
+
+/** Duplicate labels (first occurrence takes precedence) */
+SCRIPT_TEST ( duplicate, "#!ipxe\n"
+	      "goto dup\n"
+	      ":dup\n"
+	      "set script_trace ${script_trace}a\n"
+	      "goto end\n"
+	      ":dup\n"
+	      "set script_trace ${script_trace}X\n"
+	      ":end\n", "a", 1 );
+
+/** Label sharing a line with a command */
+SCRIPT_TEST ( inline_label, "#!ipxe\n"
+	      "goto label\n"
+	      "set script_trace ${script_trace}X\n"
+	      ":label set script_trace ${script_trace}a\n", "a", 1 );
+
+/** Missing label (handled) */
+SCRIPT_TEST ( missing, "#!ipxe\n"
+	      "goto nosuch || set script_trace ${script_trace}a\n"
+	      "set script_trace ${script_trace}b\n", "ab", 1 );
+
+/** Missing label (unhandled) */
+SCRIPT_TEST ( missing_fail, "#!ipxe\n"
+	      "set script_trace ${script_trace}a\n"
+	      "goto nosuch\n"
+	      "set script_trace ${script_trace}X\n", "a", 0 );
+
+/** Label on last line, without terminating newline */
+SCRIPT_TEST ( last, "#!ipxe\n"
+	      "set script_trace ${script_trace}a\n"
+	      "goto last\n"
+	      "set script_trace ${script_trace}X\n"
+	      ":last", "a", 1 );
+
+/** Backslash continuations and CRLF line endings */
+SCRIPT_TEST ( continuation, "#!ipxe\r\n"
+	      "set script_trace ${script_trace}a\\\r\n"
+	      "b\r\n"
+	      "goto label\r\n"
+	      "set script_trace ${script_trace}X\r\n"
+	      ":label\r\n"
+	      "set script_trace ${script_trace}c\r\n", "abc", 1 );
+
+/** Incomplete final line */
+SCRIPT_TEST ( incomplete, "#!ipxe\n"
+	      "set script_trace ${script_trace}a\n"
+	      "set script_trace ${script_trace}X \\", "a", 0 );
+
+/**
+ * Report a script test result
+ *
+ * @v test		Script test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void script_okx ( struct script_test *test, const char *file,
+			 unsigned int line ) {
+	char trace[ strlen ( test->trace ) + 2 /* overflow, NUL */ ];
+	struct image *image;
+	int rc;
+
+	/* Reset trace and loop counter */
+	delete_setting ( NULL, &script_trace_setting );
+	delete_setting ( NULL, &script_count_setting );
+
+	/* Create script image */
+	image = image_memory ( "script_test", virt_to_user ( test->script ),
+			       strlen ( test->script ) );
+	okx ( image != NULL, file, line );
+	if ( ! image )
+		return;
+	image_get ( image );
+
+	/* Execute script */
+	rc = image_exec ( image );
+	okx ( ( rc == 0 ) == test->success, file, line );
+
+	/* Check trace */
+	memset ( trace, 0, sizeof ( trace ) );
+	fetch_string_setting ( NULL, &script_trace_setting, trace,
+			       sizeof ( trace ) );
+	DBGC ( test, "SCRIPT trace \"%s\" (expected \"%s\")\n",
+	       trace, test->trace );
+	okx ( strcmp ( trace, test->trace ) == 0, file, line );
+
+	/* Free script image */
+	if ( image->flags & IMAGE_REGISTERED )
+		unregister_image ( image );
+	image_put ( image );
+
+	/* Clean up */
+	delete_setting ( NULL, &script_trace_setting );
+	delete_setting ( NULL, &script_count_setting );
+}
+#define script_ok( test ) script_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform script self-tests
+ *
+ */
+static void script_test_exec ( void ) {
+
+	/* Label handling */
+	script_ok ( &forward );
+	script_ok ( &backward );
+	script_ok ( &duplicate );
+	script_ok ( &inline_label );
+	script_ok ( &missing );
+	script_ok ( &missing_fail );
+	script_ok ( &last );
+
+	/* Line parsing */
+	script_ok ( &continuation );
+	script_ok ( &incomplete );
+
+	/* "goto" is not permitted outside of a script */
+	ok ( system ( "goto nosuch" ) != 0 );
+}
+
+/** Script self-test */
+struct self_test script_test __self_test = {
+	.name = "script",
+	.exec = script_test_exec,
+};
+
+/* Include script support and the commands used by the test scripts */
+REQUIRING_SYMBOL ( script_test );
+REQUIRE_OBJECT ( script );
+REQUIRE_OBJECT ( nvo_cmd );
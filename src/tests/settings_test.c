@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /* Forcibly enable assertions */
 #undef NDEBUG
 
+#include <stdio.h>
 #include <string.h>
 #include <ipxe/settings.h>
 #include <ipxe/test.h>
@@ -262,6 +263,105 @@ static struct setting test_busdevfn_setting = {
 	.type = &setting_type_busdevfn,
 };
 
+/** Test tagged setting */
+static struct setting test_tagged_setting = {
+	.name = "test_tagged",
+	.type = &setting_type_string,
+	.tag = 0x1234,
+};
+
+/** Test setting with the same tag as the test tagged setting */
+static struct setting test_alias_setting = {
+	.name = "test_alias",
+	.type = &setting_type_string,
+	.tag = 0x1234,
+};
+
+/** Number of settings used for lookup tests */
+#define TEST_LOOKUP_COUNT 64
+
+/**
+ * Report a setting lookup test result
+ *
+ * @v _settings		Settings block
+ * @v _setting		Setting
+ * @v _expected		Expected formatted value, or NULL if not present
+ */
+#define lookup_ok( _settings, _setting, _expected ) do {		\
+	const char *expected = (_expected);				\
+	char actual[32];						\
+	int len;							\
+									\
+	len = fetchf_setting ( _settings, _setting, NULL, NULL, actual,	\
+			       sizeof ( actual ) );			\
+	if ( expected ) {						\
+		ok ( len == ( int ) strlen ( expected ) );		\
+		ok ( strcmp ( actual, expected ) == 0 );		\
+	} else {							\
+		ok ( len < 0 );						\
+	}								\
+	} while ( 0 )
+
+/**
+ * Perform setting lookup self-tests
+ *
+ */
+static void settings_lookup_test ( void ) {
+	struct setting setting;
+	char name[32];
+	char value[32];
+	unsigned int i;
+
+	/* Populate many settings */
+	memset ( &setting, 0, sizeof ( setting ) );
+	setting.name = name;
+	setting.type = &setting_type_string;
+	for ( i = 0 ; i < TEST_LOOKUP_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_lookup%d", i );
+		snprintf ( value, sizeof ( value ), "value%d", i );
+		ok ( storef_setting ( &test_settings, &setting, value ) == 0 );
+	}
+
+	/* Fetch each setting twice (to exercise the cache) */
+	for ( i = 0 ; i < TEST_LOOKUP_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_lookup%d", i );
+		snprintf ( value, sizeof ( value ), "value%d", i );
+		lookup_ok ( &test_settings, &setting, value );
+		lookup_ok ( &test_settings, &setting, value );
+	}
+
+	/* Overwrite odd-numbered settings and delete even-numbered
+	 * settings
+	 */
+	for ( i = 0 ; i < TEST_LOOKUP_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_lookup%d", i );
+		snprintf ( value, sizeof ( value ), "new%d", i );
+		ok ( storef_setting ( &test_settings, &setting,
+				      ( ( i & 1 ) ? value : NULL ) ) == 0 );
+	}
+	for ( i = 0 ; i < TEST_LOOKUP_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_lookup%d", i );
+		snprintf ( value, sizeof ( value ), "new%d", i );
+		lookup_ok ( &test_settings, &setting,
+			    ( ( i & 1 ) ? value : NULL ) );
+	}
+
+	/* Settings with matching tags are the same setting */
+	ok ( storef_setting ( &test_settings, &test_tagged_setting,
+			      "tagged" ) == 0 );
+	lookup_ok ( &test_settings, &test_alias_setting, "tagged" );
+	lookup_ok ( &test_settings, &test_alias_setting, "tagged" );
+	ok ( storef_setting ( &test_settings, &test_alias_setting,
+			      "alias" ) == 0 );
+	lookup_ok ( &test_settings, &test_tagged_setting, "alias" );
+
+	/* Clearing the settings block removes all settings */
+	clear_settings ( &test_settings );
+	lookup_ok ( &test_settings, &test_tagged_setting, NULL );
+	snprintf ( name, sizeof ( name ), "test_lookup%d", 1 );
+	lookup_ok ( &test_settings, &setting, NULL );
+}
+
 /**
  * Perform settings self-tests
  *
@@ -436,6 +536,9 @@ static void settings_test_exec ( void ) {
 	fetchf_ok ( &test_settings, &test_busdevfn_setting,
 		    RAW ( 0x00, 0x02, 0x0a, 0x21 ), "0002:0a:04.1" );
 
+	/* Setting lookup */
+	settings_lookup_test();
+
 	/* Clear and unregister test settings block */
 	clear_settings ( &test_settings );
 	unregister_settings ( &test_settings );
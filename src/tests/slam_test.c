@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * SLAM forward error correction tests
+ *
+ * Each test acts as a reference "x-slam-fec" sender: it constructs
+ * an image, and then transmits the specified sequence of data and
+ * repair packets to the SLAM multicast socket via the UDP receive
+ * path.  Any blocks that cannot be reconstructed are then
+ * retransmitted, as they would be by a server in response to NACKs.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/in.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/ipstat.h>
+#include <ipxe/udp.h>
+#include <ipxe/erasure.h>
+#include <ipxe/test.h>
+
+/** SLAM test URI */
+#define SLAM_TEST_URI "x-slam-fec://192.168.0.1/"
+
+/** SLAM test multicast address (the SLAM default) */
+#define SLAM_TEST_MULTICAST_IP \
+	( ( 239 << 24 ) | ( 255 << 16 ) | ( 1 << 8 ) | ( 1 << 0 ) )
+
+/** SLAM test multicast port (the SLAM default) */
+#define SLAM_TEST_MULTICAST_PORT 10000
+
+/** SLAM test transaction ID */
+#define SLAM_TEST_TRANSACTION 0x1234
+
+/** Maximum number of blocks in a SLAM test image */
+#define SLAM_TEST_MAX_BLOCKS 32
+
+/** Maximum length of a SLAM test packet header */
+#define SLAM_TEST_MAX_HEADER_LEN ( 6 * 7 )
+
+/** Define inline packet sequence numbers */
+#define PACKETS(...) { __VA_ARGS__ }
+
+/** Define inline block numbers */
+#define BLOCKS(...) { __VA_ARGS__ }
+
+/** A SLAM forward error correction test */
+struct slam_test {
+	/** Image length */
+	size_t len;
+	/** Block size */
+	size_t block_size;
+	/** Number of source blocks per group */
+	unsigned int group_size;
+	/** Number of repair blocks per group */
+	unsigned int group_repair;
+	/** Transmitted packet sequence numbers */
+	const unsigned int *packets;
+	/** Number of transmitted packets */
+	unsigned int count;
+	/** Blocks expected to require retransmission */
+	const unsigned int *nacked;
+	/** Number of blocks expected to require retransmission */
+	unsigned int nacked_count;
+};
+
+/**
+ * Define a SLAM forward error correction test
+ *
+ * @v name		Test name
+ * @v LEN		Image length
+ * @v BLOCK_SIZE	Block size
+ * @v GROUP_SIZE	Number of source blocks per group
+ * @v GROUP_REPAIR	Number of repair blocks per group
+ * @v PACKETS		Transmitted packet sequence numbers
+ * @v NACKED		Blocks expected to require retransmission
+ * @ret test		SLAM forward error correction test
+ */
+#define SLAM_TEST( name, LEN, BLOCK_SIZE, GROUP_SIZE, GROUP_REPAIR,	\
+		   PACKETS, NACKED )					\
+	static const unsigned int name ## _packets[] = PACKETS;		\
+	static const unsigned int name ## _nacked[] = NACKED;		\
+	static struct slam_test name = {				\
+		.len = LEN,						\
+		.block_size = BLOCK_SIZE,				\
+		.group_size = GROUP_SIZE,				\
+		.group_repair = GROUP_REPAIR,				\
+		.packets = name ## _packets,				\
+		.count = ( sizeof ( name ## _packets ) /		\
+			   sizeof ( name ## _packets[0] ) ),		\
+		.nacked = name ## _nacked,				\
+		.nacked_count = ( sizeof ( name ## _nacked ) /		\
+				  sizeof ( name ## _nacked[0] ) ),	\
+	}
+
+/** A SLAM test receiver */
+struct slam_test_receiver {
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Received image */
+	uint8_t *data;
+	/** Length of received image buffer */
+	size_t len;
+	/** Block size */
+	size_t block_size;
+	/** Announced image length */
+	size_t announced;
+	/** Number of times each block has been delivered */
+	unsigned int delivered[SLAM_TEST_MAX_BLOCKS];
+	/** Delivery was out of range */
+	int overrun;
+	/** Transfer has completed */
+	int done;
+	/** Completion status code */
+	int rc;
+};
+
+/**
+ * Receive data
+ *
+ * @v receiver		SLAM test receiver
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int slam_test_deliver ( struct slam_test_receiver *receiver,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta ) {
+	size_t offset = meta->offset;
+	size_t len = iob_len ( iobuf );
+
+	/* Record announced length, or check and record data */
+	if ( ! ( meta->flags & XFER_FL_ABS_OFFSET ) ) {
+		receiver->overrun = 1;
+	} else if ( ! len ) {
+		receiver->announced = offset;
+	} else if ( ( offset > receiver->len ) ||
+		    ( len > ( receiver->len - offset ) ) ||
+		    ( offset % receiver->block_size ) ) {
+		receiver->overrun = 1;
+	} else {
+		memcpy ( ( receiver->data + offset ), iobuf->data, len );
+		receiver->delivered[ offset / receiver->block_size ]++;
+	}
+
+	free_iob ( iobuf );
+	return 0;
+}
+
+/**
+ * Handle transfer completion
+ *
+ * @v receiver		SLAM test receiver
+ * @v rc		Reason for completion
+ */
+static void slam_test_close ( struct slam_test_receiver *receiver, int rc ) {
+
+	intf_restart ( &receiver->xfer, rc );
+	receiver->done = 1;
+	receiver->rc = rc;
+}
+
+/** SLAM test receiver interface operations */
+static struct interface_operation slam_test_xfer_operations[] = {
+	INTF_OP ( xfer_deliver, struct slam_test_receiver *,
+		  slam_test_deliver ),
+	INTF_OP ( intf_close, struct slam_test_receiver *, slam_test_close ),
+};
+
+/** SLAM test receiver interface descriptor */
+static struct interface_descriptor slam_test_xfer_desc =
+	INTF_DESC ( struct slam_test_receiver, xfer,
+		    slam_test_xfer_operations );
+
+/**
+ * Append variable-length value to SLAM test packet
+ *
+ * @v iobuf		I/O buffer
+ * @v value		Value
+ */
+static void slam_test_put_value ( struct io_buffer *iobuf,
+				  unsigned long value ) {
+	size_t len = ( ( flsl ( value ) + 10 ) / 8 );
+	uint8_t *data = iob_put ( iobuf, len );
+	unsigned int i;
+
+	for ( i = len ; i-- ; ) {
+		data[i] = value;
+		value >>= 8;
+	}
+	*data |= ( len << 5 );
+}
+
+/**
+ * Transmit SLAM test packet
+ *
+ * @v test		SLAM forward error correction test
+ * @v image		Image, zero-padded to a whole number of blocks
+ * @v packet		Packet sequence number
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void slam_test_tx ( struct slam_test *test, const uint8_t *image,
+			   unsigned int packet, const char *file,
+			   unsigned int line ) {
+	struct sockaddr_in src;
+	struct sockaddr_in dest;
+	struct ip_statistics stats;
+	struct io_buffer *iobuf;
+	struct udp_header *udphdr;
+	const void *blocks[test->group_size];
+	unsigned int num_blocks;
+	unsigned int repair;
+	unsigned int group;
+	unsigned int count;
+	unsigned int i;
+	size_t offset;
+	size_t len;
+
+	/* Allocate packet */
+	iobuf = alloc_iob ( sizeof ( *udphdr ) + SLAM_TEST_MAX_HEADER_LEN +
+			    test->block_size );
+	okx ( iobuf != NULL, file, line );
+	iob_reserve ( iobuf, sizeof ( *udphdr ) );
+
+	/* Construct SLAM header */
+	slam_test_put_value ( iobuf, SLAM_TEST_TRANSACTION );
+	slam_test_put_value ( iobuf, test->len );
+	slam_test_put_value ( iobuf, test->block_size );
+	slam_test_put_value ( iobuf, test->group_size );
+	slam_test_put_value ( iobuf, test->group_repair );
+	slam_test_put_value ( iobuf, packet );
+
+	/* Construct data or repair block */
+	num_blocks = ( ( test->len + test->block_size - 1 ) /
+		       test->block_size );
+	if ( packet < num_blocks ) {
+		offset = ( packet * test->block_size );
+		len = ( test->len - offset );
+		if ( len > test->block_size )
+			len = test->block_size;
+		memcpy ( iob_put ( iobuf, len ), ( image + offset ), len );
+	} else {
+		repair = ( packet - num_blocks );
+		group = ( repair / test->group_repair );
+		count = ( num_blocks - ( group * test->group_size ) );
+		if ( count > test->group_size )
+			count = test->group_size;
+		for ( i = 0 ; i < count ; i++ ) {
+			blocks[i] = ( image + ( ( ( group * test->group_size )
+						  + i ) * test->block_size ) );
+		}
+		erasure_encode ( count, ( repair % test->group_repair ), blocks,
+				 iob_put ( iobuf, test->block_size ),
+				 test->block_size );
+	}
+
+	/* Construct UDP header, with no checksum */
+	udphdr = iob_push ( iobuf, sizeof ( *udphdr ) );
+	udphdr->src = htons ( SLAM_TEST_MULTICAST_PORT );
+	udphdr->dest = htons ( SLAM_TEST_MULTICAST_PORT );
+	udphdr->len = htons ( iob_len ( iobuf ) );
+	udphdr->chksum = 0;
+
+	/* Hand off to UDP */
+	memset ( &src, 0, sizeof ( src ) );
+	src.sin_family = AF_INET;
+	src.sin_addr.s_addr = htonl ( 0xc0a80001 );
+	memset ( &dest, 0, sizeof ( dest ) );
+	dest.sin_family = AF_INET;
+	dest.sin_addr.s_addr = htonl ( SLAM_TEST_MULTICAST_IP );
+	memset ( &stats, 0, sizeof ( stats ) );
+	okx ( tcpip_rx ( iobuf, NULL, IP_UDP,
+			 ( ( struct sockaddr_tcpip * ) &src ),
+			 ( ( struct sockaddr_tcpip * ) &dest ), 0,
+			 &stats ) == 0, file, line );
+}
+
+/**
+ * Check if block is expected to require retransmission
+ *
+ * @v test		SLAM forward error correction test
+ * @v block		Block number
+ * @ret nacked		Block is expected to require retransmission
+ */
+static int slam_test_nacked ( struct slam_test *test, unsigned int block ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < test->nacked_count ; i++ ) {
+		if ( test->nacked[i] == block )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Report a SLAM forward error correction test result
+ *
+ * @v test		SLAM forward error correction test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void slam_okx ( struct slam_test *test, const char *file,
+		       unsigned int line ) {
+	struct slam_test_receiver receiver;
+	unsigned int num_blocks;
+	unsigned int expected;
+	unsigned int i;
+	uint8_t *image;
+	size_t padded;
+	size_t offset;
+
+	/* Construct image, zero-padded to a whole number of blocks */
+	num_blocks = ( ( test->len + test->block_size - 1 ) /
+		       test->block_size );
+	okx ( num_blocks <= SLAM_TEST_MAX_BLOCKS, file, line );
+	padded = ( num_blocks * test->block_size );
+	image = zalloc ( padded );
+	okx ( image != NULL, file, line );
+	for ( offset = 0 ; offset < test->len ; offset++ )
+		image[offset] = ( ( offset * 7 ) + ( offset >> 8 ) + 1 );
+
+	/* Open SLAM transfer */
+	memset ( &receiver, 0, sizeof ( receiver ) );
+	intf_init ( &receiver.xfer, &slam_test_xfer_desc, NULL );
+	receiver.len = test->len;
+	receiver.block_size = test->block_size;
+	receiver.data = zalloc ( test->len );
+	okx ( receiver.data != NULL, file, line );
+	okx ( xfer_open_uri_string ( &receiver.xfer, SLAM_TEST_URI ) == 0,
+	      file, line );
+
+	/* Transmit data and repair packets */
+	for ( i = 0 ; i < test->count ; i++ )
+		slam_test_tx ( test, image, test->packets[i], file, line );
+
+	/* Check that exactly the expected blocks are still missing */
+	for ( i = 0 ; i < num_blocks ; i++ ) {
+		expected = ( ! slam_test_nacked ( test, i ) );
+		okx ( receiver.delivered[i] == expected, file, line );
+	}
+	okx ( receiver.done == ( test->nacked_count == 0 ), file, line );
+
+	/* Retransmit missing blocks, as if in response to NACKs.  A
+	 * retransmitted block may complete a partially received group,
+	 * in which case the remaining blocks will be reconstructed.
+	 */
+	for ( i = 0 ; ( ( i < test->nacked_count ) && ! receiver.done ) ;
+	      i++ ) {
+		slam_test_tx ( test, image, test->nacked[i], file, line );
+	}
+
+	/* Check reconstructed image */
+	okx ( receiver.done, file, line );
+	okx ( receiver.rc == 0, file, line );
+	okx ( ! receiver.overrun, file, line );
+	okx ( receiver.announced == test->len, file, line );
+	for ( i = 0 ; i < num_blocks ; i++ )
+		okx ( receiver.delivered[i] == 1, file, line );
+	okx ( memcmp ( receiver.data, image, test->len ) == 0, file, line );
+
+	/* Close transfer, if still open */
+	intf_shutdown ( &receiver.xfer, 0 );
+
+	free ( receiver.data );
+	free ( image );
+}
+#define slam_ok( test ) slam_okx ( test, __FILE__, __LINE__ )
+
+/** Losses within full groups and within a short final group
+ *
+ * Ten blocks (the last being a short block) in groups of four
+ * source blocks plus two repair blocks.  The final group contains
+ * only two source blocks, and loses its short final block.  Repair
+ * packets are numbered from 10 (group 0) onwards.
+ */
+SLAM_TEST ( losses, ( ( 9 * 64 ) + 23 ), 64, 4, 2,
+	    PACKETS ( 0, 3, 3, 10, 10, 11, 4, 5, 6, 7, 8, 15 ),
+	    BLOCKS () );
+
+/** Out-of-order reception using several repair blocks per group */
+SLAM_TEST ( shuffled, 1000, 100, 5, 3,
+	    PACKETS ( 14, 3, 0, 13, 11, 15, 8, 12, 10, 5 ),
+	    BLOCKS () );
+
+/** Group evicted before it could be reconstructed
+ *
+ * Twelve blocks in groups of two source blocks plus one repair
+ * block.  Receiving the first block of each of groups 0-4 exceeds
+ * the limit on groups under reconstruction, and causes group 0 to be
+ * evicted.  The repair block for group 0 alone is then insufficient,
+ * and so block 1 must be obtained via a NACK.
+ */
+SLAM_TEST ( evicted, ( 12 * 32 ), 32, 2, 1,
+	    PACKETS ( 0, 2, 4, 6, 8, 13, 14, 15, 16, 10, 11, 12 ),
+	    BLOCKS ( 1 ) );
+
+/** Insufficient repair blocks */
+SLAM_TEST ( insufficient, 300, 50, 3, 1,
+	    PACKETS ( 0, 6, 3, 4, 5, 7 ),
+	    BLOCKS ( 1, 2 ) );
+
+/**
+ * Perform SLAM forward error correction self-tests
+ *
+ */
+static void slam_test_exec ( void ) {
+
+	slam_ok ( &losses );
+	slam_ok ( &shuffled );
+	slam_ok ( &evicted );
+	slam_ok ( &insufficient );
+}
+
+/** SLAM forward error correction self-test */
+struct self_test slam_test __self_test = {
+	.name = "slam",
+	.exec = slam_test_exec,
+};
+
+/* Include SLAM and the IPv4 address family */
+REQUIRING_SYMBOL ( slam_test );
+REQUIRE_OBJECT ( slam );
+REQUIRE_OBJECT ( ipv4 );
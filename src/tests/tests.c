@@ -67,6 +67,7 @@ REQUIRE_OBJECT ( uri_test );
 REQUIRE_OBJECT ( profile_test );
 REQUIRE_OBJECT ( setjmp_test );
 REQUIRE_OBJECT ( pccrc_test );
+REQUIRE_OBJECT ( pccrd_test );
 REQUIRE_OBJECT ( linebuf_test );
 REQUIRE_OBJECT ( iobuf_test );
 REQUIRE_OBJECT ( bitops_test );
@@ -75,8 +76,16 @@ REQUIRE_OBJECT ( pem_test );
 REQUIRE_OBJECT ( ntlm_test );
 REQUIRE_OBJECT ( zlib_test );
 REQUIRE_OBJECT ( gzip_test );
+REQUIRE_OBJECT ( zstd_test );
+REQUIRE_OBJECT ( lz4_test );
 REQUIRE_OBJECT ( utf8_test );
 REQUIRE_OBJECT ( acpi_test );
 REQUIRE_OBJECT ( hmac_test );
+REQUIRE_OBJECT ( pbkdf2_test );
 REQUIRE_OBJECT ( dhe_test );
 REQUIRE_OBJECT ( gcm_test );
+REQUIRE_OBJECT ( erasure_test );
+REQUIRE_OBJECT ( timeline_test );
+REQUIRE_OBJECT ( script_test );
+REQUIRE_OBJECT ( slam_test );
+REQUIRE_OBJECT ( nfs_test );
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Boot timeline tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+/* Forcibly enable boot timeline */
+#define TIMELINE
+
+#include <string.h>
+#include <ipxe/timeline.h>
+#include <ipxe/test.h>
+
+/**
+ * Perform boot timeline self-tests
+ *
+ */
+static void timeline_test_exec ( void ) {
+	struct timeline_event *event;
+	char detail[ 2 * TIMELINE_DETAIL_LEN ];
+	unsigned long seq;
+	unsigned int count;
+	unsigned int i;
+
+	/* Cleared timeline is empty */
+	timeline_clear();
+	ok ( timeline_first() == NULL );
+
+	/* Events are retained in order */
+	timeline ( "first", "%d", 1 );
+	timeline ( "second", "%s", "two" );
+	event = timeline_first();
+	ok ( event != NULL );
+	ok ( strcmp ( event->name, "first" ) == 0 );
+	ok ( strcmp ( event->detail, "1" ) == 0 );
+	seq = event->seq;
+	event = timeline_next ( event );
+	ok ( event != NULL );
+	ok ( strcmp ( event->name, "second" ) == 0 );
+	ok ( strcmp ( event->detail, "two" ) == 0 );
+	ok ( event->seq == ( seq + 1 ) );
+	ok ( timeline_next ( event ) == NULL );
+
+	/* Overlong detail is truncated */
+	timeline_clear();
+	memset ( detail, 'x', ( sizeof ( detail ) - 1 ) );
+	detail[ sizeof ( detail ) - 1 ] = '\0';
+	timeline ( "long", "%s", detail );
+	event = timeline_first();
+	ok ( event != NULL );
+	ok ( strlen ( event->detail ) == ( TIMELINE_DETAIL_LEN - 1 ) );
+
+	/* Oldest events are overwritten when ring is full */
+	timeline_clear();
+	for ( i = 0 ; i < ( TIMELINE_MAX_EVENTS + 5 ) ; i++ )
+		timeline ( "wrap", "%d", i );
+	count = 0;
+	for_each_timeline_event ( event )
+		count++;
+	ok ( count == TIMELINE_MAX_EVENTS );
+	event = timeline_first();
+	ok ( event != NULL );
+	ok ( strcmp ( event->detail, "5" ) == 0 );
+	timeline_clear();
+}
+
+/** Boot timeline self-test */
+struct self_test timeline_test __self_test = {
+	.name = "timeline",
+	.exec = timeline_test_exec,
+};
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard image tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <ipxe/image.h>
+#include <ipxe/zstd.h>
+#include <ipxe/test.h>
+
+/** A Zstandard test */
+struct zstd_test {
+	/** Compressed filename */
+	const char *compressed_name;
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed name */
+	const char *expected_name;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define a Zstandard test */
+#define ZSTD( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct zstd_test name = {				\
+		.compressed_name = #name ".zst",				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected_name = #name,					\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** "Hello world" */
+ZSTD ( hello_world,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	      0xd8, 0x76, 0xb3, 0x12 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
+/** Skippable frame followed by run-length encoded block */
+ZSTD ( hello_rle,
+       DATA ( 0x50, 0x2a, 0x4d, 0x18, 0x04, 0x00, 0x00, 0x00, 0x69, 0x50,
+	      0x58, 0x45, 0x28, 0xb5, 0x2f, 0xfd, 0x20, 0x10, 0x83, 0x00,
+	      0x00, 0x78 ),
+       DATA ( 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+	      0x78, 0x78, 0x78, 0x78, 0x78, 0x78 ) );
+
+/** Overlapping repeated match */
+ZSTD ( hello_repeat,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x78, 0x55, 0x00, 0x00, 0x18,
+	      0x61, 0x62, 0x63, 0x01, 0x00, 0xd2, 0xd4, 0x0d, 0x01, 0xe5,
+	      0x99, 0xdb, 0xf8 ),
+       DATA ( 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61,
+	      0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62,
+	      0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63,
+	      0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61,
+	      0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62,
+	      0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63,
+	      0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61,
+	      0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62,
+	      0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63,
+	      0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61,
+	      0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62,
+	      0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63, 0x61, 0x62, 0x63 ) );
+
+/** Concatenated frames */
+ZSTD ( hello_concat,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	      0xd8, 0x76, 0xb3, 0x12, 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b,
+	      0x59, 0x00, 0x00, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77,
+	      0x6f, 0x72, 0x6c, 0x64, 0xd8, 0x76, 0xb3, 0x12 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72,
+	      0x6c, 0x64 ) );
+
+/** Huffman compressed literals */
+ZSTD ( gpl_preamble,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x9d, 0x00, 0x15, 0x07, 0x00,
+	      0x16, 0x90, 0x2c, 0x17, 0x80, 0x4d, 0x1b, 0xc0, 0x70, 0x4d,
+	      0xa2, 0x48, 0xd1, 0x68, 0xcf, 0x3e, 0xe5, 0x2a, 0xa4, 0xa9,
+	      0x05, 0xab, 0x44, 0xed, 0xa0, 0x73, 0x7b, 0x26, 0x00, 0x25,
+	      0x00, 0x26, 0x00, 0xcf, 0x45, 0xaa, 0x99, 0x32, 0xb0, 0xca,
+	      0xdc, 0x9b, 0xa5, 0xab, 0x22, 0x5d, 0x0f, 0x32, 0x97, 0x1d,
+	      0xcf, 0xed, 0xc9, 0x2f, 0x57, 0x33, 0xbe, 0x9a, 0x5b, 0x24,
+	      0xe4, 0x0e, 0x37, 0x5f, 0x16, 0x57, 0x8e, 0xe2, 0xe9, 0x24,
+	      0x01, 0x67, 0xf2, 0x35, 0x8d, 0x93, 0x79, 0x2e, 0xde, 0xe1,
+	      0x6a, 0xbd, 0x70, 0x23, 0xe0, 0xcd, 0x0a, 0x7d, 0x95, 0x9d,
+	      0xd3, 0x49, 0xfe, 0x81, 0x9f, 0x55, 0xea, 0x4c, 0xcf, 0xcc,
+	      0x6b, 0xcf, 0x37, 0x9d, 0xd6, 0x33, 0x0f, 0x03, 0xd9, 0x0f,
+	      0x17, 0xa5, 0x86, 0x79, 0xd9, 0xaf, 0x01, 0xfd, 0xa0, 0x19,
+	      0xb7, 0x9f, 0xae, 0x57, 0x44, 0x3a, 0xfd, 0x6c, 0x1e, 0x3a,
+	      0xcb, 0x61, 0x40, 0xfb, 0x90, 0x32, 0x2b, 0x69, 0xf5, 0x0a,
+	      0x29, 0x7c, 0x3e, 0xd8, 0xd7, 0x0e, 0xc0, 0xc0, 0x9b, 0x2c,
+	      0x9d, 0xbb, 0xad, 0xb2, 0xf3, 0x6b, 0x08, 0xe5, 0xbe, 0xdb,
+	      0x73, 0x25, 0x7e, 0x3e, 0x08, 0x5d, 0x5b, 0x10, 0x20, 0xdc,
+	      0x46, 0x37, 0x3a, 0x3e, 0x6d, 0xbc, 0x39, 0x01, 0xce, 0xe1,
+	      0x33, 0x11, 0x00, 0x48, 0x88, 0x29, 0xda, 0xba, 0x92, 0xe2,
+	      0x5e, 0xc0, 0x6a, 0x1d, 0xcc, 0x0c, 0x90, 0xac, 0xc3, 0x80,
+	      0x60, 0x08, 0x73, 0xfb, 0x6a, 0x60, 0x05, 0x1d, 0x8c, 0xce,
+	      0x1a, 0x73, 0x9d, 0x57, 0xe3, 0xc0, 0xbe, 0x5d, 0x11, 0xbf,
+	      0xab, 0x48, 0xa1, 0xcf, 0xe6, 0x1e, 0x8e, 0x54, 0xa9, 0x06 ),
+       DATA ( 0x54, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	      0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	      0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	      0x20, 0x69, 0x73, 0x20, 0x61, 0x20, 0x66, 0x72, 0x65, 0x65,
+	      0x2c, 0x20, 0x63, 0x6f, 0x70, 0x79, 0x6c, 0x65, 0x66, 0x74,
+	      0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65, 0x20, 0x66,
+	      0x6f, 0x72, 0x0a, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72,
+	      0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65,
+	      0x72, 0x20, 0x6b, 0x69, 0x6e, 0x64, 0x73, 0x20, 0x6f, 0x66,
+	      0x20, 0x77, 0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x54,
+	      0x68, 0x65, 0x20, 0x6c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	      0x73, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x6d, 0x6f, 0x73, 0x74,
+	      0x20, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x0a,
+	      0x61, 0x6e, 0x64, 0x20, 0x6f, 0x74, 0x68, 0x65, 0x72, 0x20,
+	      0x70, 0x72, 0x61, 0x63, 0x74, 0x69, 0x63, 0x61, 0x6c, 0x20,
+	      0x77, 0x6f, 0x72, 0x6b, 0x73, 0x20, 0x61, 0x72, 0x65, 0x20,
+	      0x64, 0x65, 0x73, 0x69, 0x67, 0x6e, 0x65, 0x64, 0x20, 0x74,
+	      0x6f, 0x20, 0x74, 0x61, 0x6b, 0x65, 0x20, 0x61, 0x77, 0x61,
+	      0x79, 0x20, 0x79, 0x6f, 0x75, 0x72, 0x20, 0x66, 0x72, 0x65,
+	      0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74, 0x6f, 0x0a, 0x73, 0x68,
+	      0x61, 0x72, 0x65, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x63, 0x68,
+	      0x61, 0x6e, 0x67, 0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x77,
+	      0x6f, 0x72, 0x6b, 0x73, 0x2e, 0x20, 0x20, 0x42, 0x79, 0x20,
+	      0x63, 0x6f, 0x6e, 0x74, 0x72, 0x61, 0x73, 0x74, 0x2c, 0x20,
+	      0x74, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47, 0x65,
+	      0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62, 0x6c,
+	      0x69, 0x63, 0x0a, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65,
+	      0x20, 0x69, 0x73, 0x20, 0x69, 0x6e, 0x74, 0x65, 0x6e, 0x64,
+	      0x65, 0x64, 0x20, 0x74, 0x6f, 0x20, 0x67, 0x75, 0x61, 0x72,
+	      0x61, 0x6e, 0x74, 0x65, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x72,
+	      0x20, 0x66, 0x72, 0x65, 0x65, 0x64, 0x6f, 0x6d, 0x20, 0x74,
+	      0x6f, 0x20, 0x73, 0x68, 0x61, 0x72, 0x65, 0x20, 0x61, 0x6e,
+	      0x64, 0x20, 0x63, 0x68, 0x61, 0x6e, 0x67, 0x65, 0x20, 0x61,
+	      0x6c, 0x6c, 0x0a, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e,
+	      0x73, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x20, 0x70, 0x72, 0x6f,
+	      0x67, 0x72, 0x61, 0x6d, 0x2d, 0x2d, 0x74, 0x6f, 0x20, 0x6d,
+	      0x61, 0x6b, 0x65, 0x20, 0x73, 0x75, 0x72, 0x65, 0x20, 0x69,
+	      0x74, 0x20, 0x72, 0x65, 0x6d, 0x61, 0x69, 0x6e, 0x73, 0x20,
+	      0x66, 0x72, 0x65, 0x65, 0x20, 0x73, 0x6f, 0x66, 0x74, 0x77,
+	      0x61, 0x72, 0x65, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x61, 0x6c,
+	      0x6c, 0x0a, 0x69, 0x74, 0x73, 0x20, 0x75, 0x73, 0x65, 0x72,
+	      0x73, 0x2e, 0x0a ) );
+
+/**
+ * Report Zstandard test result
+ *
+ * @v test		Zstandard test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void zstd_okx ( struct zstd_test *test, const char *file,
+		       unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name,
+			       virt_to_user ( test->compressed ),
+			       test->compressed_len );
+	okx ( image != NULL, file, line );
+	okx ( image->len == test->compressed_len, file, line );
+
+	/* Check type detection */
+	okx ( image->type == &zstd_image_type, file, line );
+
+	/* Extract archive image */
+	okx ( image_extract ( image, NULL, &extracted ) == 0, file, line );
+
+	/* Verify extracted image content */
+	okx ( extracted->len == test->expected_len, file, line );
+	okx ( memcmp_user ( extracted->data, 0,
+			    virt_to_user ( test->expected ), 0,
+			    test->expected_len ) == 0, file, line );
+
+	/* Verify extracted image name */
+	okx ( strcmp ( extracted->name, test->expected_name ) == 0,
+	      file, line );
+
+	/* Unregister images */
+	unregister_image ( extracted );
+	unregister_image ( image );
+}
+#define zstd_ok( test ) zstd_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform Zstandard self-test
+ *
+ */
+static void zstd_test_exec ( void ) {
+
+	zstd_ok ( &hello_world );
+	zstd_ok ( &hello_rle );
+	zstd_ok ( &hello_repeat );
+	zstd_ok ( &hello_concat );
+	zstd_ok ( &gpl_preamble );
+}
+
+/** Zstandard self-test */
+struct self_test zstd_test __self_test = {
+	.name = "zstd",
+	.exec = zstd_test_exec,
+};
@@ -377,30 +377,17 @@ static int have_pxe_menu ( void ) {
 }
 
 /**
- * Boot from a network device
+ * Boot from a configured network device
  *
  * @v netdev		Network device
  * @ret rc		Return status code
  */
-int netboot ( struct net_device *netdev ) {
+static int netboot_configured ( struct net_device *netdev ) {
 	struct uri *filename;
 	struct uri *root_path;
 	char *san_filename;
 	int rc;
 
-	/* Close all other network devices */
-	close_other_netdevs ( netdev );
-
-	/* Open device and display device status */
-	if ( ( rc = ifopen ( netdev ) ) != 0 )
-		goto err_ifopen;
-	ifstat ( netdev );
-
-	/* Configure device */
-	if ( ( rc = ifconf ( netdev, NULL, 0 ) ) != 0 )
-		goto err_dhcp;
-	route();
-
 	/* Try PXE menu boot, if applicable */
 	if ( have_pxe_menu() ) {
 		printf ( "Booting from PXE menu\n" );
@@ -448,11 +435,95 @@ int netboot ( struct net_device *netdev ) {
 	uri_put ( root_path );
 	uri_put ( filename );
  err_pxe_menu_boot:
+	return rc;
+}
+
+/**
+ * Boot from a network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int netboot ( struct net_device *netdev ) {
+	int rc;
+
+	/* Close all other network devices */
+	close_other_netdevs ( netdev );
+
+	/* Open device and display device status */
+	if ( ( rc = ifopen ( netdev ) ) != 0 )
+		goto err_ifopen;
+	ifstat ( netdev );
+
+	/* Configure device */
+	if ( ( rc = ifconf ( netdev, NULL, 0 ) ) != 0 )
+		goto err_dhcp;
+	route();
+
+	/* Boot from configured device */
+	if ( ( rc = netboot_configured ( netdev ) ) != 0 )
+		goto err_boot;
+
+ err_boot:
  err_dhcp:
  err_ifopen:
 	return rc;
 }
 
+/**
+ * Check if configured network device has something to boot
+ *
+ * @v netdev		Network device
+ * @ret is_bootable	Network device has something to boot
+ */
+static int netboot_usable ( struct net_device *netdev ) {
+	struct settings *settings = netdev_settings ( netdev );
+
+	return ( setting_exists ( settings, &filename_setting ) ||
+		 setting_exists ( settings, &root_path_setting ) );
+}
+
+/**
+ * Boot from the first of several network devices to be configured
+ *
+ * @ret rc		Return status code
+ *
+ * All candidate network devices are opened and configured
+ * concurrently, and we boot from the first device to obtain
+ * something bootable.  Any devices that are still being configured
+ * at that point are closed.
+ */
+static int netboot_parallel ( void ) {
+	struct net_device *netdev;
+	int rc;
+
+	/* Open all candidate devices and close all others */
+	for_each_netdev ( netdev ) {
+		if ( is_autoboot_device && ( ! is_autoboot_device ( netdev ) ) ) {
+			ifclose ( netdev );
+			continue;
+		}
+		ifopen ( netdev );
+	}
+
+	/* Configure all devices concurrently */
+	if ( ( rc = ifconf_any ( netboot_usable, 0, &netdev ) ) != 0 )
+		goto err_ifconf;
+
+	/* Close late finishers and display device status */
+	close_other_netdevs ( netdev );
+	ifstat ( netdev );
+	route();
+
+	/* Boot from configured device */
+	if ( ( rc = netboot_configured ( netdev ) ) != 0 )
+		goto err_boot;
+
+ err_boot:
+ err_ifconf:
+	return rc;
+}
+
 /**
  * Test if network device matches the autoboot device bus type and location
  *
@@ -522,6 +593,13 @@ static int autoboot ( void ) {
 	struct net_device *netdev;
 	int rc = -ENODEV;
 
+	/* Configure all devices concurrently, if applicable */
+	if ( AUTOBOOT_PARALLEL ) {
+		rc = netboot_parallel();
+		printf ( "No more network devices\n" );
+		return rc;
+	}
+
 	/* Try booting from each network device.  If we have a
 	 * specified autoboot device location, then use only devices
 	 * matching that location.
@@ -27,6 +27,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/console.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/device.h>
@@ -122,6 +123,10 @@ void ifstat ( struct net_device *netdev ) {
 		printf ( "  [Link status: %s]\n",
 			 strerror ( netdev->link_rc ) );
 	}
+	if ( netdev->rx_stats.overflow ) {
+		printf ( "  [RX ring overflows: %d (fill level %d)]\n",
+			 netdev->rx_stats.overflow, netdev->rx_fill );
+	}
 	ifstat_errors ( &netdev->tx_stats, "TXE" );
 	ifstat_errors ( &netdev->rx_stats, "RXE" );
 }
@@ -141,6 +146,13 @@ struct ifpoller {
 	 * @ret ongoing_rc	Ongoing job status code (if known)
 	 */
 	int ( * progress ) ( struct ifpoller *ifpoller );
+	/**
+	 * Check usability of configured network device (if applicable)
+	 *
+	 * @v netdev		Network device
+	 * @ret is_usable	Network device is usable
+	 */
+	int ( * usable ) ( struct net_device *netdev );
 };
 
 /**
@@ -171,12 +183,14 @@ static struct interface_descriptor ifpoller_job_desc =
  *
  * @v netdev		Network device
  * @v configurator	Network device configurator (if applicable)
+ * @v usable		Method to check usability (if applicable)
  * @v timeout		Timeout period, in ticks
  * @v progress		Method to check progress
  * @ret rc		Return status code
  */
 static int ifpoller_wait ( struct net_device *netdev,
 			   struct net_device_configurator *configurator,
+			   int ( * usable ) ( struct net_device *netdev ),
 			   unsigned long timeout,
 			   int ( * progress ) ( struct ifpoller *ifpoller ) ) {
 	static struct ifpoller ifpoller = {
@@ -185,6 +199,7 @@ static int ifpoller_wait ( struct net_device *netdev,
 
 	ifpoller.netdev = netdev;
 	ifpoller.configurator = configurator;
+	ifpoller.usable = usable;
 	ifpoller.progress = progress;
 	intf_plug_plug ( &monojob, &ifpoller.job );
 	return monojob_wait ( "", timeout );
@@ -231,7 +246,8 @@ int iflinkwait ( struct net_device *netdev, unsigned long timeout,
 
 	/* Wait for link-up */
 	printf ( "Waiting for link-up on %s", netdev->name );
-	return ifpoller_wait ( netdev, NULL, timeout, iflinkwait_progress );
+	return ifpoller_wait ( netdev, NULL, NULL, timeout,
+			       iflinkwait_progress );
 }
 
 /**
@@ -302,5 +318,101 @@ int ifconf ( struct net_device *netdev,
 		 ( configurator ? configurator->name : "" ),
 		 ( configurator ? "] " : "" ),
 		 netdev->name, netdev->ll_protocol->ntoa ( netdev->ll_addr ) );
-	return ifpoller_wait ( netdev, configurator, timeout, ifconf_progress );
+	return ifpoller_wait ( netdev, configurator, NULL, timeout,
+			       ifconf_progress );
+}
+
+/**
+ * Find first usable configured network device
+ *
+ * @v usable		Method to check usability
+ * @ret netdev		Network device, or NULL if none are usable
+ */
+static struct net_device *
+ifconf_any_usable ( int ( * usable ) ( struct net_device *netdev ) ) {
+	struct net_device *netdev;
+
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) &&
+		     ( ! netdev_configuration_in_progress ( netdev ) ) &&
+		     netdev_configuration_ok ( netdev ) &&
+		     usable ( netdev ) )
+			return netdev;
+	}
+	return NULL;
+}
+
+/**
+ * Check concurrent configuration progress
+ *
+ * @v ifpoller		Network device poller
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int ifconf_any_progress ( struct ifpoller *ifpoller ) {
+	struct net_device *netdev;
+
+	/* Terminate successfully as soon as any device is usable */
+	if ( ifconf_any_usable ( ifpoller->usable ) ) {
+		intf_close ( &ifpoller->job, 0 );
+		return 0;
+	}
+
+	/* Do nothing while any configuration remains in progress */
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) &&
+		     netdev_configuration_in_progress ( netdev ) )
+			return 0;
+	}
+
+	/* All configurations have completed without a usable device */
+	intf_close ( &ifpoller->job, -EADDRNOTAVAIL_CONFIG );
+	return -EADDRNOTAVAIL_CONFIG;
+}
+
+/**
+ * Configure all open network devices concurrently
+ *
+ * @v usable		Method to check usability of a configured device
+ * @v timeout		Timeout period, in ticks
+ * @v netdev		Network device to fill in
+ * @ret rc		Return status code
+ *
+ * All open network devices are configured in parallel, and the first
+ * device to complete configuration in a usable state is returned.
+ * Configuration of the remaining devices is left running; the caller
+ * may close them once it has committed to the returned device.
+ */
+int ifconf_any ( int ( * usable ) ( struct net_device *netdev ),
+		 unsigned long timeout, struct net_device **netdev ) {
+	struct net_device *other;
+	unsigned int count = 0;
+	int rc;
+
+	/* Start configuration on all open devices */
+	for_each_netdev ( other ) {
+		if ( ! netdev_is_open ( other ) )
+			continue;
+		if ( ( rc = netdev_configure_all ( other ) ) != 0 ) {
+			printf ( "Could not configure %s: %s\n",
+				 other->name, strerror ( rc ) );
+			continue;
+		}
+		printf ( "Configuring %s (%s)\n", other->name,
+			 other->ll_protocol->ntoa ( other->ll_addr ) );
+		count++;
+	}
+	if ( ! count )
+		return -ENODEV;
+
+	/* Wait for the first usable device */
+	printf ( "Waiting for configuration" );
+	if ( ( rc = ifpoller_wait ( NULL, NULL, usable, timeout,
+				    ifconf_any_progress ) ) != 0 )
+		return rc;
+
+	/* Identify usable device */
+	*netdev = ifconf_any_usable ( usable );
+	assert ( *netdev != NULL );
+
+	return 0;
 }
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/iperf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/monojob.h>
+#include <ipxe/timer.h>
+#include <usr/iperfmgmt.h>
+
+/** @file
+ *
+ * iperf3 network throughput test management
+ *
+ */
+
+/** Network device statistics snapshot */
+struct iperf_netdev_stats {
+	/** Network device */
+	struct net_device *netdev;
+	/** Successful transmissions */
+	unsigned int tx_good;
+	/** Failed transmissions */
+	unsigned int tx_bad;
+	/** Successful receptions */
+	unsigned int rx_good;
+	/** Failed receptions */
+	unsigned int rx_bad;
+	/** Receive ring overflows */
+	unsigned int rx_overflow;
+};
+
+/**
+ * Display iperf3 report
+ *
+ * @v report		Throughput report
+ */
+static void iperf_callback ( struct iperf_report *report ) {
+	unsigned long start = ( ( report->start * 100 ) / TICKS_PER_SEC );
+	unsigned long end = ( ( report->end * 100 ) / TICKS_PER_SEC );
+	unsigned long duration = ( report->end - report->start );
+	unsigned long long rate = 0;
+
+	/* Calculate throughput in units of 10kbps */
+	if ( duration ) {
+		rate = ( ( report->bytes * 8 * TICKS_PER_SEC ) /
+			 ( duration * 10000ULL ) );
+	}
+
+	/* Display report */
+	printf ( "[%3ld.%02ld-%3ld.%02ld sec] %lld bytes %lld.%02lld Mbits/sec",
+		 ( start / 100 ), ( start % 100 ), ( end / 100 ), ( end % 100 ),
+		 report->bytes, ( rate / 100 ), ( rate % 100 ) );
+	if ( report->packets && report->summary ) {
+		printf ( " %ld/%ld lost", report->lost, report->packets );
+	} else if ( report->packets ) {
+		printf ( " %ld packets", report->packets );
+	} else {
+		printf ( " %ld retr", report->retransmits );
+	}
+	if ( report->summary )
+		printf ( " %s", report->summary );
+	printf ( "\n" );
+}
+
+/**
+ * Run iperf3 network throughput test
+ *
+ * @v hostname		Server name
+ * @v params		Test parameters
+ * @ret rc		Return status code
+ */
+int iperf ( const char *hostname, struct iperf_parameters *params ) {
+	struct iperf_netdev_stats *stats;
+	struct iperf_netdev_stats *stat;
+	struct net_device *netdev;
+	unsigned int count = 0;
+	unsigned int i;
+	int rc;
+
+	/* Record network device statistics */
+	for_each_netdev ( netdev )
+		count++;
+	stats = zalloc ( ( count + 1 ) * sizeof ( stats[0] ) );
+	if ( ! stats ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	stat = stats;
+	for_each_netdev ( netdev ) {
+		stat->netdev = netdev_get ( netdev );
+		stat->tx_good = netdev->tx_stats.good;
+		stat->tx_bad = netdev->tx_stats.bad;
+		stat->rx_good = netdev->rx_stats.good;
+		stat->rx_bad = netdev->rx_stats.bad;
+		stat->rx_overflow = netdev->rx_stats.overflow;
+		stat++;
+	}
+
+	/* Start test */
+	if ( ( rc = start_iperf ( &monojob, hostname, params,
+				  iperf_callback ) ) != 0 ) {
+		printf ( "Could not start iperf: %s\n", strerror ( rc ) );
+		goto err_start;
+	}
+
+	/* Wait for test to complete */
+	if ( ( rc = monojob_wait ( NULL, 0 ) ) != 0 )
+		printf ( "Finished: %s\n", strerror ( rc ) );
+
+	/* Display network device statistics */
+	for ( i = 0 ; i < count ; i++ ) {
+		stat = &stats[i];
+		netdev = stat->netdev;
+		if ( ! netdev_is_open ( netdev ) )
+			continue;
+		printf ( "%s: TX:%d TXE:%d RX:%d RXE:%d overflows:%d\n",
+			 netdev->name,
+			 ( netdev->tx_stats.good - stat->tx_good ),
+			 ( netdev->tx_stats.bad - stat->tx_bad ),
+			 ( netdev->rx_stats.good - stat->rx_good ),
+			 ( netdev->rx_stats.bad - stat->rx_bad ),
+			 ( netdev->rx_stats.overflow - stat->rx_overflow ) );
+	}
+
+ err_start:
+	for ( i = 0 ; i < count ; i++ )
+		netdev_put ( stats[i].netdev );
+	free ( stats );
+ err_alloc:
+	return rc;
+}
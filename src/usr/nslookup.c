@@ -27,6 +27,8 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/tcpip.h>
 #include <ipxe/monojob.h>
 #include <ipxe/settings.h>
+#include <ipxe/timer.h>
+#include <ipxe/dns.h>
 #include <usr/nslookup.h>
 
 /** @file
@@ -201,3 +203,19 @@ int nslookup ( const char *name, const char *setting_name ) {
 
 	return 0;
 }
+
+/**
+ * Print DNS cache
+ *
+ */
+void nslookup_cache ( void ) {
+	struct dns_cache_info info;
+	unsigned int i;
+
+	for ( i = 0 ; dns_cache_describe ( i, &info ) == 0 ; i++ ) {
+		printf ( "%s is %s (expires in %lds)\n", info.name,
+			 ( info.rc ? strerror ( info.rc ) :
+			   sock_ntoa ( info.sa ) ),
+			 ( info.remaining / TICKS_PER_SEC ) );
+	}
+}
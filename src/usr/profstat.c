@@ -33,6 +33,25 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/**
+ * Print profiling statistics for a single profiler
+ *
+ * @v profiler		Profiler
+ */
+void profstat_profiler ( struct profiler *profiler ) {
+
+	printf ( "%s: %ld +/- %ld ticks (%d samples)%s\n",
+		 profiler->name, profile_mean ( profiler ),
+		 profile_stddev ( profiler ), profiler->count,
+		 ( profiler->disabled ? " [disabled]" : "" ) );
+	if ( profiler->count ) {
+		printf ( "  p50 %ld p90 %ld p99 %ld max %ld ticks\n",
+			 profile_percentile ( profiler, 50 ),
+			 profile_percentile ( profiler, 90 ),
+			 profile_percentile ( profiler, 99 ), profiler->max );
+	}
+}
+
 /**
  * Print profiling statistics
  *
@@ -40,9 +59,6 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 void profstat ( void ) {
 	struct profiler *profiler;
 
-	for_each_table_entry ( profiler, PROFILERS ) {
-		printf ( "%s: %ld +/- %ld ticks (%d samples)\n",
-			 profiler->name, profile_mean ( profiler ),
-			 profile_stddev ( profiler ), profiler->count );
-	}
+	for_each_table_entry ( profiler, PROFILERS )
+		profstat_profiler ( profiler );
 }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <syslog.h>
+#include <ipxe/timer.h>
+#include <ipxe/vsprintf.h>
+#include <ipxe/timeline.h>
+#include <usr/timelinemgmt.h>
+
+/** @file
+ *
+ * Boot timeline management
+ *
+ */
+
+/** Maximum length of a formatted timeline event
+ *
+ * Allows for every detail character to require a six-character
+ * "\u00XX" escape sequence.
+ */
+#define TIMELINE_JSON_LEN ( 128 + ( 6 * TIMELINE_DETAIL_LEN ) )
+
+/**
+ * Format JSON string
+ *
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @v string		String
+ * @ret len		Length of formatted string
+ */
+static size_t timeline_json_string ( char *buf, ssize_t len,
+				     const char *string ) {
+	size_t used = 0;
+	char c;
+
+	used += ssnprintf ( ( buf + used ), ( len - used ), "\"" );
+	while ( ( c = *(string++) ) ) {
+		if ( ( c == '"' ) || ( c == '\\' ) ) {
+			used += ssnprintf ( ( buf + used ), ( len - used ),
+					    "\\%c", c );
+		} else if ( ( c < 0x20 ) || ( c >= 0x7f ) ) {
+			used += ssnprintf ( ( buf + used ), ( len - used ),
+					    "\\u%04x", ( c & 0xff ) );
+		} else {
+			used += ssnprintf ( ( buf + used ), ( len - used ),
+					    "%c", c );
+		}
+	}
+	used += ssnprintf ( ( buf + used ), ( len - used ), "\"" );
+	return used;
+}
+
+/**
+ * Format timeline event as a JSON object
+ *
+ * @v event		Timeline event
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of formatted event
+ */
+static size_t timeline_json ( struct timeline_event *event, char *buf,
+			      ssize_t len ) {
+	unsigned long ms;
+	size_t used = 0;
+
+	/* Convert ticks to milliseconds without overflowing */
+	ms = ( ( ( event->ticks / TICKS_PER_SEC ) * 1000 ) +
+	       ( ( ( event->ticks % TICKS_PER_SEC ) * 1000 ) /
+		 TICKS_PER_SEC ) );
+
+	/* Construct JSON object */
+	used += ssnprintf ( ( buf + used ), ( len - used ),
+			    "{\"seq\":%lu,\"timestamp\":%lu,\"ms\":%lu,"
+			    "\"event\":", event->seq, event->timestamp, ms );
+	used += timeline_json_string ( ( buf + used ), ( len - used ),
+				       event->name );
+	used += ssnprintf ( ( buf + used ), ( len - used ), ",\"detail\":" );
+	used += timeline_json_string ( ( buf + used ), ( len - used ),
+				       event->detail );
+	used += ssnprintf ( ( buf + used ), ( len - used ), "}" );
+	return used;
+}
+
+/**
+ * Print boot timeline as JSON
+ *
+ */
+void timeline_dump ( void ) {
+	struct timeline_event *event;
+	char buf[TIMELINE_JSON_LEN];
+	const char *sep = "";
+
+	printf ( "[" );
+	for_each_timeline_event ( event ) {
+		timeline_json ( event, buf, sizeof ( buf ) );
+		printf ( "%s\n  %s", sep, buf );
+		sep = ",";
+	}
+	printf ( "\n]\n" );
+}
+
+/**
+ * Send boot timeline to system log
+ *
+ * Each event is sent as a separate JSON object, so that the timeline
+ * may be reassembled from any syslog or syslogs server.  The events
+ * are sent irrespective of the configured LOG_LEVEL, since the user
+ * has explicitly requested them.
+ */
+void timeline_syslog ( void ) {
+	struct timeline_event *event;
+	char buf[TIMELINE_JSON_LEN];
+
+	for_each_timeline_event ( event ) {
+		timeline_json ( event, buf, sizeof ( buf ) );
+		log_printf ( "timeline %s\n", buf );
+	}
+}